@@ -0,0 +1,231 @@
+/*
+ AdcIngest.hpp
+ Conversion of raw digitizer samples (int8, int16 and packed 12-bit codes)
+ into calibrated floating point values, straight into a Waveform's time
+ domain.
+
+	PS::AdcCalibration cal;
+	cal.gain = 0.5e-3;		// volts per code
+	cal.offset = -1e-3;
+
+	PS::IngestAdcPacked12(wfm, frame.data(), wfm.size(), cal);
+
+ Each value is gain * code + offset, computed in the element type of the
+ output. Unpacking, sign extension, conversion and calibration are one
+ pass over the samples, and the loops are written for the compiler to
+ vectorize. With GCC on x86-64 Linux each kernel is built for AVX-512,
+ AVX2 and baseline SSE2 and picked at load time (see SimdDispatch.hpp).
+ */
+
+#ifndef ADCINGEST_HPP
+#define ADCINGEST_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <ParallelFor.hpp>
+#include <SimdDispatch.hpp>
+#include <Waveform.hpp>
+
+/*
+	Packed 12-bit layout:
+
+		Two samples in three bytes, little-endian. Byte 0 holds bits 0-7 of
+		the first sample and the low nibble of byte 1 its bits 8-11; the high
+		nibble of byte 1 holds bits 0-3 of the second sample and byte 2 its
+		bits 4-11. Samples are two's complement. With an odd number of
+		samples the last one takes a byte and a half, and the high nibble of
+		the final byte is ignored.
+ */
+
+
+namespace PS {
+
+	//!	The linear calibration applied to every code: value = gain * code + offset
+	struct AdcCalibration {
+		double	gain = 1.;
+		double	offset = 0.;
+	};
+
+
+	//!	The number of bytes holding count packed 12-bit samples
+	inline std::size_t
+	Packed12Bytes (const std::size_t count)
+	{ return (3 * count + 1) / 2; }
+
+
+namespace detail {
+
+	//!	Frames shorter than this per thread are not split
+	const std::size_t AdcSamplesPerThread = std::size_t(1) << 16;
+
+
+	template <typename Code, typename T>
+	WAVEFORM_SIMD_INLINE void
+	AdcConvertBody (const Code* __restrict codes, const std::size_t count, T* __restrict out, const T gain, const T offset)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = T(codes[i]) * gain + offset;
+	}
+
+
+	//!	Sign-extends the low 12 bits
+	WAVEFORM_SIMD_INLINE std::int32_t
+	SignExtend12 (const std::uint32_t bits)
+	{ return std::int32_t(bits << 20) >> 20; }
+
+
+	template <typename T>
+	WAVEFORM_SIMD_INLINE void
+	AdcUnpack12Body (const std::uint8_t* __restrict packed, const std::size_t count, T* __restrict out, const T gain, const T offset)
+	{
+		const std::size_t pairs = count / 2;
+
+		for (std::size_t p = 0; p < pairs; ++p) {
+			const std::uint32_t b0 = packed[3 * p];
+			const std::uint32_t b1 = packed[3 * p + 1];
+			const std::uint32_t b2 = packed[3 * p + 2];
+
+			out[2 * p]     = T(SignExtend12(b0 | b1 << 8)) * gain + offset;
+			out[2 * p + 1] = T(SignExtend12(b1 >> 4 | b2 << 4)) * gain + offset;
+		}
+
+		if (count & 1) {
+			const std::uint32_t b0 = packed[3 * pairs];
+			const std::uint32_t b1 = packed[3 * pairs + 1];
+			out[count - 1] = T(SignExtend12(b0 | b1 << 8)) * gain + offset;
+		}
+	}
+
+
+	inline WAVEFORM_SIMD_KERNEL void
+	AdcConvert (const std::int8_t* codes, const std::size_t count, double* out, const double gain, const double offset)
+	{ AdcConvertBody(codes, count, out, gain, offset); }
+
+	inline WAVEFORM_SIMD_KERNEL void
+	AdcConvert (const std::int8_t* codes, const std::size_t count, float* out, const float gain, const float offset)
+	{ AdcConvertBody(codes, count, out, gain, offset); }
+
+	inline WAVEFORM_SIMD_KERNEL void
+	AdcConvert (const std::int16_t* codes, const std::size_t count, double* out, const double gain, const double offset)
+	{ AdcConvertBody(codes, count, out, gain, offset); }
+
+	inline WAVEFORM_SIMD_KERNEL void
+	AdcConvert (const std::int16_t* codes, const std::size_t count, float* out, const float gain, const float offset)
+	{ AdcConvertBody(codes, count, out, gain, offset); }
+
+	inline WAVEFORM_SIMD_KERNEL void
+	AdcUnpack12 (const std::uint8_t* packed, const std::size_t count, double* out, const double gain, const double offset)
+	{ AdcUnpack12Body(packed, count, out, gain, offset); }
+
+	inline WAVEFORM_SIMD_KERNEL void
+	AdcUnpack12 (const std::uint8_t* packed, const std::size_t count, float* out, const float gain, const float offset)
+	{ AdcUnpack12Body(packed, count, out, gain, offset); }
+
+
+	//!	The number of pieces to split count samples into for up to maxThreads threads
+	inline std::size_t
+	AdcPieces (const std::size_t count, unsigned maxThreads)
+	{
+		const std::size_t most = count / AdcSamplesPerThread;
+
+		//	DefaultThreadCount() takes a few microseconds, as long as a short frame
+		if (most <= 1)
+			return 1;
+
+		if (maxThreads == 0)
+			maxThreads = DefaultThreadCount();
+
+		return std::min<std::size_t>(maxThreads, most);
+	}
+
+
+	//!	The time domain of wfm, to be overwritten with count values
+	template <typename WaveformT>
+	inline auto
+	AdcTimeData (WaveformT& wfm, const std::size_t count)
+	{
+		typedef typename std::decay<decltype(*wfm.PeekTimeSeries().data())>::type	T;
+		static_assert(std::is_same<T, double>::value || std::is_same<T, float>::value
+				, "AdcIngest: the time domain must hold double or float");
+
+		if (count != wfm.size())
+			throw std::length_error("AdcIngest: " + std::to_string(count) + " samples for a Waveform of size "
+									+ std::to_string(wfm.size()));
+
+		return wfm.OverwriteTimeSeries().data();
+	}
+
+}	//	namespace detail
+
+
+	//!	Writes gain * codes[i] + offset to out[i] for count int8 or int16 codes
+	/*!
+	 *	T is double or float. Frames of at least 2^16 samples per thread are
+	 *	split into contiguous pieces across up to maxThreads threads (0: one
+	 *	per core).
+	 */
+	template <typename Code, typename T>
+	inline typename std::enable_if<std::is_same<Code, std::int8_t>::value || std::is_same<Code, std::int16_t>::value>::type
+	IngestAdc (const Code* codes, const std::size_t count, T* out
+			, const AdcCalibration& cal = AdcCalibration(), const unsigned maxThreads = 1)
+	{
+		const std::size_t pieces = detail::AdcPieces(count, maxThreads);
+
+		ParallelFor(pieces, pieces, [&](std::size_t piece) {
+			const std::size_t first = count * piece / pieces;
+			const std::size_t last = count * (piece + 1) / pieces;
+			detail::AdcConvert(codes + first, last - first, out + first, T(cal.gain), T(cal.offset));
+		});
+	}
+
+
+	//!	Writes gain * code + offset to out[i] for count packed 12-bit codes
+	/*!
+	 *	packed holds Packed12Bytes(count) bytes in the layout described at
+	 *	the top of this file. Large frames are split as for IngestAdc(), at
+	 *	even samples so that every piece starts on a whole byte.
+	 */
+	template <typename T>
+	inline void
+	IngestAdcPacked12 (const std::uint8_t* packed, const std::size_t count, T* out
+			, const AdcCalibration& cal = AdcCalibration(), const unsigned maxThreads = 1)
+	{
+		const std::size_t pieces = detail::AdcPieces(count, maxThreads);
+
+		ParallelFor(pieces, pieces, [&](std::size_t piece) {
+			const std::size_t first = count / 2 * piece / pieces * 2;
+			const std::size_t last = piece + 1 < pieces ? count / 2 * (piece + 1) / pieces * 2 : count;
+			detail::AdcUnpack12(packed + first / 2 * 3, last - first, out + first, T(cal.gain), T(cal.offset));
+		});
+	}
+
+
+	//!	Overwrites the time domain of wfm from count int8 or int16 codes
+	/*!
+	 *	count must be wfm.size(), or std::length_error is thrown. The time
+	 *	domain is marked valid and the freq domain stale, without a
+	 *	transform, as for OverwriteTimeSeries().
+	 */
+	template <typename Code, typename ...Args>
+	inline void
+	IngestAdc (Waveform<Args...>& wfm, const Code* codes, const std::size_t count
+			, const AdcCalibration& cal = AdcCalibration(), const unsigned maxThreads = 1)
+	{ IngestAdc(codes, count, detail::AdcTimeData(wfm, count), cal, maxThreads); }
+
+
+	//!	Overwrites the time domain of wfm from count packed 12-bit codes
+	template <typename ...Args>
+	inline void
+	IngestAdcPacked12 (Waveform<Args...>& wfm, const std::uint8_t* packed, const std::size_t count
+			, const AdcCalibration& cal = AdcCalibration(), const unsigned maxThreads = 1)
+	{ IngestAdcPacked12(packed, count, detail::AdcTimeData(wfm, count), cal, maxThreads); }
+
+}	//	namespace PS
+
+#endif
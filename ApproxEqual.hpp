@@ -0,0 +1,336 @@
+/*
+ ApproxEqual.hpp
+ Comparison of Waveforms within a tolerance, for results which have been
+ through transforms and so are only equal up to rounding.
+
+	PS::ApproxTolerance tol;
+	tol.relative = 1e-12;
+	tol.absolute = 1e-15;
+
+	PS::ApproxReport report;
+	if (!PS::ApproxEqual(result, expected, tol, &report))
+		std::cerr << "off by " << report.maxDeviation << " at " << report.index << "\n";
+
+ Like operator==, ApproxEqual() compares a domain which is valid in both
+ Waveforms when there is one, so it usually runs no transform at all.
+ */
+
+#ifndef APPROXEQUAL_HPP
+#define APPROXEQUAL_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include <Waveform.hpp>
+
+
+namespace PS {
+
+	//!	How close two values must be for ApproxEqual()
+	/*!
+	 *	Two values are close if they are equal, or if
+	 *
+	 *		|a - b| <= max(absolute, relative * max(|a|, |b|))
+	 *
+	 *	or, with ulps nonzero, if at most ulps representable values lie
+	 *	between them. Complex values are compared part by part. NaNs are
+	 *	never close to anything.
+	 *
+	 *	The absolute tolerance applies in the domain which is compared,
+	 *	and the freq domain of an unnormalized transform is scaled by the
+	 *	length; ApproxReport::timeDomain tells which one it was.
+	 */
+	struct ApproxTolerance {
+		double			relative = 1e-12;
+		double			absolute = 0.;
+		std::uint64_t	ulps = 0;
+	};
+
+
+	//!	What ApproxEqual() found, if asked for it
+	struct ApproxReport {
+		//!	True if the time domains were compared, false for the freq domains
+		bool			timeDomain = true;
+
+		//!	The largest |a - b| of any real value or part of a complex value
+		double			maxDeviation = 0.;
+
+		//!	The element with the largest deviation
+		std::size_t		index = 0;
+
+		//!	The number of elements with a value or part which was not close
+		std::size_t		mismatches = 0;
+	};
+
+
+namespace detail {
+
+	//!	The bits of a float or double as an integer which orders the values, with -0 == +0
+	template <typename T>
+	inline std::int64_t
+	OrderedBits (const T x)
+	{
+		typedef typename std::conditional<sizeof(T) == 8, std::int64_t, std::int32_t>::type	Bits;
+
+		Bits i;
+		std::memcpy(&i, &x, sizeof(T));
+		return i < 0 ? std::int64_t(std::numeric_limits<Bits>::min()) - i : std::int64_t(i);
+	}
+
+
+	//!	Whether x and y are close under tol; with Ulps false, tol.ulps is not looked at
+	template <bool Ulps, typename T>
+	inline bool
+	ApproxClose (const T x, const T y, const T relative, const T absolute, const std::uint64_t ulps)
+	{
+		const T bound = std::max(absolute, relative * std::max(std::abs(x), std::abs(y)));
+		bool close = (x == y) | (std::abs(x - y) <= bound);
+
+		if (Ulps) {
+			const std::int64_t a = OrderedBits(x);
+			const std::int64_t b = OrderedBits(y);
+			const std::uint64_t distance = a > b ? std::uint64_t(a) - std::uint64_t(b) : std::uint64_t(b) - std::uint64_t(a);
+			close |= (distance <= ulps) & (x == x) & (y == y);
+		}
+
+		return close;
+	}
+
+
+	/*
+		The scalars are compared in blocks: within a block, every comparison
+		is made and the mismatches are counted without branches, which the
+		compiler vectorizes, and the loop stops after the first block
+		holding a mismatch. The ulps test, on the integer bits, does not
+		vectorize, so it is only run over blocks which fail the others.
+		With a report the whole array is read, for the largest deviation.
+	 */
+
+	const std::size_t ApproxBlock = 256;
+
+
+	template <bool Ulps, typename T>
+	inline bool
+	ApproxEqualScalars (const T* x, const T* y, const std::size_t n, const ApproxTolerance& tol)
+	{
+		const T relative = T(tol.relative);
+		const T absolute = T(tol.absolute);
+
+		std::size_t first = 0;
+
+		//	Whole blocks have a constant trip count, which -O2 also vectorizes
+		for (; first + ApproxBlock <= n; first += ApproxBlock) {
+			const T* xb = x + first;
+			const T* yb = y + first;
+			T far = 0;
+
+			for (std::size_t i = 0; i < ApproxBlock; ++i)
+				far += ApproxClose<false>(xb[i], yb[i], relative, absolute, tol.ulps) ? T(0) : T(1);
+
+			if (far && !Ulps)
+				return false;
+
+			if (far)
+				for (std::size_t i = 0; i < ApproxBlock; ++i)
+					if (!ApproxClose<true>(xb[i], yb[i], relative, absolute, tol.ulps))
+						return false;
+		}
+
+		for (std::size_t i = first; i < n; ++i)
+			if (!ApproxClose<Ulps>(x[i], y[i], relative, absolute, tol.ulps))
+				return false;
+
+		return true;
+	}
+
+
+	//!	Compares n scalars, count of them to an element, filling in report
+	template <typename T>
+	inline bool
+	ApproxEqualScalars (const T* x, const T* y, const std::size_t n, const std::size_t count
+			, const ApproxTolerance& tol, ApproxReport& report)
+	{
+		const T relative = T(tol.relative);
+		const T absolute = T(tol.absolute);
+
+		std::size_t lastMismatch = std::size_t(-1);
+
+		for (std::size_t i = 0; i < n; ++i) {
+			const double deviation = std::abs(double(x[i]) - double(y[i]));
+
+			//	A NaN is the largest deviation, and the first one is kept
+			if (deviation > report.maxDeviation || (deviation != deviation && report.maxDeviation == report.maxDeviation)) {
+				report.maxDeviation = deviation;
+				report.index = i / count;
+			}
+
+			const bool close = tol.ulps
+					? ApproxClose<true>(x[i], y[i], relative, absolute, tol.ulps)
+					: ApproxClose<false>(x[i], y[i], relative, absolute, tol.ulps);
+
+			if (!close && i / count != lastMismatch) {
+				++report.mismatches;
+				lastMismatch = i / count;
+			}
+		}
+
+		return report.mismatches == 0;
+	}
+
+
+	//!	Compares two contiguous containers of the same element type
+	template <typename Container1, typename Container2>
+	inline bool
+	ApproxEqualContainers (const Container1& a, const Container2& b, const ApproxTolerance& tol, ApproxReport* report, std::true_type)
+	{
+		typedef ScalarOf<typename Container1::value_type>	Scalar;
+		typedef typename Scalar::type						T;
+
+		const T* x = reinterpret_cast<const T*>(a.data());
+		const T* y = reinterpret_cast<const T*>(b.data());
+		const std::size_t n = a.size() * Scalar::count;
+
+		if (report)
+			return ApproxEqualScalars(x, y, n, Scalar::count, tol, *report);
+
+		return tol.ulps ? ApproxEqualScalars<true>(x, y, n, tol) : ApproxEqualScalars<false>(x, y, n, tol);
+	}
+
+
+	//!	The same element by element, for other containers (such as PS::SplitComplexVector)
+	template <typename Container1, typename Container2>
+	inline bool
+	ApproxEqualContainers (const Container1& a, const Container2& b, const ApproxTolerance& tol, ApproxReport* report, std::false_type)
+	{
+		typedef typename Container1::value_type		V;
+		typedef ScalarOf<V>							Scalar;
+		typedef typename Scalar::type				T;
+
+		ApproxReport local;
+		ApproxReport& r = report ? *report : local;
+
+		auto j = b.begin();
+		for (auto i = a.begin(); i != a.end(); ++i, ++j) {
+			const V x (*i);
+			const V y (*j);
+
+			const std::size_t before = r.mismatches;
+			ApproxReport element;
+			ApproxEqualScalars(reinterpret_cast<const T*>(&x), reinterpret_cast<const T*>(&y), Scalar::count, Scalar::count, tol, element);
+
+			if (element.maxDeviation > r.maxDeviation
+					|| (element.maxDeviation != element.maxDeviation && r.maxDeviation == r.maxDeviation)) {
+				r.maxDeviation = element.maxDeviation;
+				r.index = std::size_t(i - a.begin());
+			}
+
+			r.mismatches = before + element.mismatches;
+
+			if (r.mismatches && !report)
+				return false;
+		}
+
+		return r.mismatches == 0;
+	}
+
+
+	//!	Compares two domains, which are never equal if their lengths differ
+	/*!
+	 *	Two Waveforms of the same length can still have freq domains of
+	 *	different lengths, when their transforms lay the spectrum out
+	 *	differently.
+	 */
+	template <typename Container1, typename Container2>
+	inline bool
+	ApproxEqualContainers (const Container1& a, const Container2& b, const ApproxTolerance& tol, ApproxReport* report)
+	{
+		if (a.size() != b.size()) {
+			if (report)
+				report->mismatches = std::max<std::size_t>(a.size(), b.size());
+			return false;
+		}
+
+		return ApproxEqualContainers(a, b, tol, report, ScalarKernels<Container1, Container2>());
+	}
+
+}	//	namespace detail
+
+
+	//!	True if every value of lhs is close to rhs's, as ApproxTolerance describes
+	/*!
+	 *	Waveforms of different lengths are never equal. Otherwise the
+	 *	domain compared is chosen as for operator==, a domain valid in both
+	 *	(the time domain if both are), with no transform. When the valid
+	 *	domains are opposite, the Waveform holding the time domain is
+	 *	transformed forward and the spectra compared, since the normalized
+	 *	inverse transforms take an extra pass to scale; a Waveform in the
+	 *	Neither state is taken as its time domain as stored, so against a
+	 *	freq-only Waveform that one is transformed back instead. The
+	 *	transformed Waveform keeps both domains, as for any Const read.
+	 *
+	 *	Without a report the comparison stops at the first block of values
+	 *	holding a mismatch; with one, every value is compared, and the
+	 *	largest deviation and number of mismatching elements are stored.
+	 */
+	template <typename ...Args1, typename ...Args2>
+	inline bool
+	ApproxEqual (const Waveform<Args1...>& lhs, const Waveform<Args2...>& rhs
+			, const ApproxTolerance& tol = ApproxTolerance(), ApproxReport* report = nullptr)
+	{
+		typedef Waveform<Args1...>	LhsType;
+		typedef Waveform<Args2...>	RhsType;
+
+		if (report)
+			*report = ApproxReport();
+
+		if (lhs.size() != rhs.size()) {
+			if (report)
+				report->mismatches = std::max(lhs.size(), rhs.size());
+			return false;
+		}
+
+		const bool lhsNeither = lhs.GetValidDomain() == LhsType::DomainState::Neither;
+		const bool rhsNeither = rhs.GetValidDomain() == RhsType::DomainState::Neither;
+		const bool lhsTime = lhs.IsTimeValid() || lhsNeither;
+		const bool rhsTime = rhs.IsTimeValid() || rhsNeither;
+
+		bool compareTime = lhsTime && rhsTime;
+
+		if (!compareTime && !(lhs.IsFreqValid() && rhs.IsFreqValid()))
+			compareTime = lhsNeither || rhsNeither;
+
+		if (report)
+			report->timeDomain = compareTime;
+
+		if (compareTime) {
+			const auto& a = lhs.GetConstTimeSeries();
+			const auto& b = rhs.GetConstTimeSeries();
+			return detail::ApproxEqualContainers(a, b, tol, report);
+		}
+
+		const auto& a = lhs.GetConstFreqSpectrum();
+		const auto& b = rhs.GetConstFreqSpectrum();
+		return detail::ApproxEqualContainers(a, b, tol, report);
+	}
+
+
+	//!	ApproxEqual() with the given relative and absolute tolerances
+	template <typename ...Args1, typename ...Args2>
+	inline bool
+	ApproxEqual (const Waveform<Args1...>& lhs, const Waveform<Args2...>& rhs, const double relative, const double absolute = 0.)
+	{
+		ApproxTolerance tol;
+		tol.relative = relative;
+		tol.absolute = absolute;
+		return ApproxEqual(lhs, rhs, tol);
+	}
+
+}	//	namespace PS
+
+#endif
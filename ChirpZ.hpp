@@ -0,0 +1,325 @@
+/*
+ ChirpZ.hpp
+ The chirp-Z transform: the DTFT of N samples at M arbitrary, evenly
+ spaced frequencies,
+
+	X[m] = sum_n x[n] exp(-2 pi i (f0 + m df) n),		m = 0 ... M-1
+
+ with f0 and df in cycles per sample (multiply by the sample rate for Hz).
+ With f0 = k0/N and df = 1/N it gives bins k0 ... k0+M-1 of the DFT (in
+ FFTW's unnormalized convention); with a small df it "zooms" into a
+ narrow band at a resolution which would otherwise need a very long
+ zero-padded FFT.
+
+ Bluestein's algorithm writes nm = (n^2 + m^2 - (m - n)^2) / 2, which turns
+ the sum into a convolution with the chirp exp(i pi df k^2):
+
+	X[m] = post[m] sum_n (x[n] pre[n]) chirp[m - n]
+
+ The convolution is done with two FFTs of a length L >= N + M - 1 (the
+ FFT of the chirp is computed once), so a transform costs
+ O((N + M) log(N + M)) whatever the resolution.
+ */
+
+#ifndef CHIRPZ_HPP
+#define CHIRPZ_HPP 1
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <fftw3.h>
+
+#include <FftwPlanCache.hpp>
+#include <FreeFunctionSupport.hpp>
+
+
+namespace PS {
+
+namespace detail {
+
+	//!	The smallest length >= n with no prime factors but 2, 3 and 5 (fast for FFTW)
+	inline std::size_t
+	NextFastLength (const std::size_t n)
+	{
+		for (std::size_t length = n > 1 ? n : 1; ; ++length) {
+			std::size_t rest = length;
+			for (std::size_t p : { 2, 3, 5 })
+				while (rest % p == 0)
+					rest /= p;
+			if (rest == 1)
+				return length;
+		}
+	}
+
+
+	//!	exp(i sign pi step k^2), with the phase reduced exactly enough for large k
+	inline std::complex<double>
+	Chirp (const long double step, const std::size_t k, const double sign)
+	{
+		const long double pi = 3.141592653589793238462643383279502884L;
+		const long double kk = (long double)(k) * (long double)(k);
+
+		//	The phase only matters modulo 2 pi, so only step k^2 modulo 2
+		const long double cycles = std::fmod(step * kk, 2.L);
+		return std::polar(1., double(sign * pi * cycles));
+	}
+
+
+	//!	The tables of one chirp-Z configuration
+	struct ChirpZTables {
+		std::size_t								fftLength;
+
+		//!	x[n] is multiplied by pre[n] (n < N) before the convolution
+		std::vector< std::complex<double> >		pre;
+
+		//!	The convolution output m is multiplied by post[m] (m < M)
+		std::vector< std::complex<double> >		post;
+
+		//!	FFT of the chirp over fftLength, divided by fftLength
+		std::vector< std::complex<double> >		chirpSpectrum;
+	};
+
+
+	//!	The most configurations ChirpZTableCache keeps
+	const std::size_t ChirpZCacheCapacity = 32;
+
+
+	//!	Process-wide cache of ChirpZTables by (N, M, f0, df), least recently used first out
+	/*!
+	 *	A tracker which moves its band every record makes a new
+	 *	configuration each time, so the cache keeps only the
+	 *	ChirpZCacheCapacity most recently constructed ones. Tables which
+	 *	are evicted stay alive for as long as a ChirpZ holds them.
+	 */
+	class ChirpZTableCache {
+	  private:
+
+		typedef std::tuple<std::size_t, std::size_t, double, double>	Key;
+
+		struct Entry {
+			std::shared_ptr<const ChirpZTables>	tables;
+			std::list<Key>::iterator			use;
+		};
+
+		std::mutex				mutex_;
+		std::map<Key, Entry>	tables_;
+
+		//!	The keys of tables_, most recently used first
+		std::list<Key>			uses_;
+
+
+		static std::shared_ptr<const ChirpZTables>
+		Make (const std::size_t n, const std::size_t m, const double f0, const double df)
+		{
+			const long double pi = 3.141592653589793238462643383279502884L;
+
+			auto tables = std::make_shared<ChirpZTables>();
+			tables->fftLength = NextFastLength(n + m - 1);
+
+			const std::size_t length = tables->fftLength;
+
+			tables->pre.resize(n);
+			for (std::size_t k = 0; k < n; ++k) {
+				const long double shift = std::fmod((long double)(f0) * (long double)(k), 1.L);
+				tables->pre[k] = std::polar(1., double(-2.L * pi * shift)) * Chirp(df, k, -1.);
+			}
+
+			tables->post.resize(m);
+			for (std::size_t k = 0; k < m; ++k)
+				tables->post[k] = Chirp(df, k, -1.);
+
+			//	chirp[k] for k in (-N, M), wrapped around the FFT length
+			std::vector< std::complex<double> >& spectrum = tables->chirpSpectrum;
+			spectrum.assign(length, 0.);
+
+			for (std::size_t k = 0; k < m; ++k)
+				spectrum[k] = Chirp(df, k, 1.);
+			for (std::size_t k = 1; k < n; ++k)
+				spectrum[length - k] = Chirp(df, k, 1.);
+
+			::Waveform::Transform::FftwPlanCache::ExecuteC2C(length, FFTW_FORWARD, spectrum.data(), spectrum.data());
+
+			const double scale = 1. / double(length);
+			for (auto& value : spectrum)
+				value *= scale;
+
+			return tables;
+		}
+
+	  public:
+
+		static ChirpZTableCache&
+		Get (void)
+		{
+			static ChirpZTableCache cache;
+			return cache;
+		}
+
+
+		std::shared_ptr<const ChirpZTables>
+		Find (const std::size_t n, const std::size_t m, const double f0, const double df)
+		{
+			const Key key (n, m, f0, df);
+
+			std::lock_guard<std::mutex> lock (mutex_);
+
+			auto found = tables_.find(key);
+			if (found != tables_.end()) {
+				uses_.splice(uses_.begin(), uses_, found->second.use);
+				return found->second.tables;
+			}
+
+			if (tables_.size() == ChirpZCacheCapacity) {
+				tables_.erase(uses_.back());
+				uses_.pop_back();
+			}
+
+			uses_.push_front(key);
+			return tables_.emplace(key, Entry { Make(n, m, f0, df), uses_.begin() }).first->second.tables;
+		}
+
+
+		void
+		Clear (void)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+			tables_.clear();
+			uses_.clear();
+		}
+
+
+		std::size_t
+		Size (void)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+			return tables_.size();
+		}
+	};
+
+
+	struct ChirpZScratchTag {};
+
+}	//	namespace detail
+
+
+	//!	ChirpZ: the chirp-Z transform of N samples at M frequencies f0 + m df
+	/*!
+	 *	The tables (the pre- and post-multiplying chirps and the FFT of the
+	 *	convolving chirp) are made once per configuration and shared by
+	 *	every ChirpZ with the same N, M, f0 and df, and the two FFTs of
+	 *	each transform use plans from FftwPlanCache. A ChirpZ is cheap to
+	 *	copy, and Transform() may be called from several threads at once.
+	 *
+	 *		//	1001 frequencies from 0.12 to 0.13 cycles per sample
+	 *		PS::ChirpZ zoom = PS::ChirpZ::Band(wfm.size(), 0.12, 0.13, 1001);
+	 *		std::vector< std::complex<double> > spectrum;
+	 *		zoom.Transform(wfm.GetConstTimeSeries(), spectrum);
+	 */
+	class ChirpZ {
+	  private:
+
+		std::size_t								inputLength_;
+		std::size_t								outputLength_;
+		double									start_;
+		double									step_;
+		std::shared_ptr<const detail::ChirpZTables>	tables_;
+
+	  public:
+
+		//!	Transform of n samples to m outputs at frequencies f0 + k df (cycles per sample)
+		ChirpZ (const std::size_t n, const std::size_t m, const double f0, const double df)
+			: inputLength_(n)
+			, outputLength_(m)
+			, start_(f0)
+			, step_(df)
+		{
+			if (n == 0 || m == 0)
+				throw std::invalid_argument("ChirpZ: the input and output lengths must be non-zero");
+
+			tables_ = detail::ChirpZTableCache::Get().Find(n, m, f0, df);
+		}
+
+
+		//!	m frequencies spread evenly from fLow to fHigh inclusive (cycles per sample)
+		static ChirpZ
+		Band (const std::size_t n, const double fLow, const double fHigh, const std::size_t m)
+		{
+			return ChirpZ(n, m, fLow, m > 1 ? (fHigh - fLow) / double(m - 1) : 0.);
+		}
+
+
+		std::size_t
+		InputLength (void) const
+		{ return inputLength_; }
+
+		std::size_t
+		OutputLength (void) const
+		{ return outputLength_; }
+
+		//!	The length of the FFTs used, the smallest 2-3-5 smooth length >= N + M - 1
+		std::size_t
+		FftLength (void) const
+		{ return tables_->fftLength; }
+
+		//!	The frequency of output k, in cycles per sample
+		double
+		Frequency (const std::size_t k) const
+		{ return start_ + double(k) * step_; }
+
+
+		//!	Writes the M outputs for the N samples x (real or complex) to out (resized to M)
+		template <typename Container, typename ComplexContainer>
+		void
+		Transform (const Container& x, ComplexContainer& out) const
+		{
+			if (std::size_t(x.size()) != inputLength_)
+				throw std::length_error("ChirpZ: the input length does not match");
+
+			const detail::ChirpZTables& t = *tables_;
+			const std::size_t length = t.fftLength;
+
+			std::vector< std::complex<double> >& work = detail::ThreadScratch<std::complex<double>, detail::ChirpZScratchTag>(length);
+
+			for (std::size_t k = 0; k < inputLength_; ++k)
+				work[k] = t.pre[k] * std::complex<double>(x[k]);
+			for (std::size_t k = inputLength_; k < length; ++k)
+				work[k] = 0.;
+
+			using ::Waveform::Transform::FftwPlanCache;
+
+			FftwPlanCache::ExecuteC2C(length, FFTW_FORWARD, work.data(), work.data());
+
+			for (std::size_t k = 0; k < length; ++k)
+				work[k] *= t.chirpSpectrum[k];
+
+			FftwPlanCache::ExecuteC2C(length, FFTW_BACKWARD, work.data(), work.data());
+
+			out.resize(outputLength_);
+			for (std::size_t k = 0; k < outputLength_; ++k)
+				out[k] = t.post[k] * work[k];
+		}
+
+
+		//!	The number of configurations whose tables are cached, at most detail::ChirpZCacheCapacity
+		static std::size_t
+		CacheSize (void)
+		{ return detail::ChirpZTableCache::Get().Size(); }
+
+		//!	Empties the table cache; existing ChirpZs keep their tables
+		static void
+		ClearCache (void)
+		{ detail::ChirpZTableCache::Get().Clear(); }
+	};
+
+}	//	namespace PS
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ Correlation.hpp
+ Circular cross-correlation and autocorrelation of Waveforms, computed
+ from the spectra the Waveforms already hold, and the location of the
+ correlation peak to a fraction of a sample.
+
+ For real signals a and b of length N with r2c spectra A and B,
+
+	r[k] = sum_n a[(n + k) mod N] b[n]  =  IDFT( A . conj(B) )[k]
+
+ so if a is b delayed by D samples, r peaks at k = D.
+ */
+
+#ifndef CORRELATION_HPP
+#define CORRELATION_HPP 1
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <fftw3.h>
+
+#include <FftwPlanCache.hpp>
+#include <FreeFunctionSupport.hpp>
+
+
+namespace PS {
+
+	//!	The peak of a correlation
+	struct CorrelationPeak {
+		//!	The lag of the peak in samples, in [-N/2, N/2), interpolated between samples
+		double	lag;
+
+		//!	The interpolated correlation at lag
+		double	value;
+	};
+
+
+namespace detail {
+
+	struct CorrelationScratchTag {};
+
+
+	//!	r = IDFT(spectrum) into out, where spectrum (n/2+1 bins) is destroyed
+	template <typename RealContainer>
+	void
+	CorrelationInverse (const std::size_t n, std::vector< std::complex<double> >& spectrum, RealContainer& out)
+	{
+		out.resize(n);
+		::Waveform::Transform::FftwPlanCache::ExecuteC2R(n, spectrum.data(), &(*out.begin()));
+	}
+
+}	//	namespace detail
+
+
+	//!	Writes the circular cross-correlation of a and b (N values) into out
+	/*!
+	 *	The spectra are read with GetConstFreqSpectrum(), so a spectrum
+	 *	which is already valid is used as it is, and one which is not is
+	 *	computed once and stays cached in its Waveform. A . conj(B) (with
+	 *	the 1/N of the inverse folded in) is formed in one pass over the
+	 *	bins, written out part by part so that it vectorizes, and one c2r
+	 *	(from FftwPlanCache) produces the result.
+	 *
+	 *	a and b must have the same length and hold r2c spectra (see
+	 *	FreeFunctionSupport.hpp).
+	 */
+	template <typename WaveformT, typename RealContainer>
+	void
+	CrossCorrelate (const WaveformT& a, const WaveformT& b, RealContainer& out)
+	{
+		//	The spectra are read as interleaved doubles
+		static_assert(std::is_same<typename WaveformT::FreqT, std::complex<double> >::value
+				, "CrossCorrelate: the freq domain must hold std::complex<double>");
+
+		detail::RequireR2CSpectrum(a, "Correlation");
+		detail::RequireR2CSpectrum(b, "Correlation");
+
+		if (a.size() != b.size())
+			throw std::invalid_argument("CrossCorrelate: the Waveforms must have the same length");
+
+		const std::size_t n = a.size();
+		const std::size_t bins = n / 2 + 1;
+		const double scale = 1. / double(n);
+
+		const double* x = reinterpret_cast<const double*>(&(*a.GetConstFreqSpectrum().begin()));
+		const double* y = reinterpret_cast<const double*>(&(*b.GetConstFreqSpectrum().begin()));
+
+		std::vector< std::complex<double> >& product = detail::ThreadScratch<std::complex<double>, detail::CorrelationScratchTag>(bins);
+		double* p = reinterpret_cast<double*>(product.data());
+
+		for (std::size_t k = 0; k < bins; ++k) {
+			const double xr = x[2 * k];
+			const double xi = x[2 * k + 1];
+			const double yr = y[2 * k];
+			const double yi = y[2 * k + 1];
+
+			p[2 * k] = (xr * yr + xi * yi) * scale;
+			p[2 * k + 1] = (xi * yr - xr * yi) * scale;
+		}
+
+		detail::CorrelationInverse(n, product, out);
+	}
+
+
+	//!	Writes the circular autocorrelation of a (N values) into out
+	/*!
+	 *	As CrossCorrelate(a, a, out), but the product is the power
+	 *	spectrum |A|^2, so only one spectrum is read.
+	 */
+	template <typename WaveformT, typename RealContainer>
+	void
+	AutoCorrelate (const WaveformT& a, RealContainer& out)
+	{
+		static_assert(std::is_same<typename WaveformT::FreqT, std::complex<double> >::value
+				, "AutoCorrelate: the freq domain must hold std::complex<double>");
+
+		detail::RequireR2CSpectrum(a, "Correlation");
+
+		const std::size_t n = a.size();
+		const std::size_t bins = n / 2 + 1;
+		const double scale = 1. / double(n);
+
+		const double* x = reinterpret_cast<const double*>(&(*a.GetConstFreqSpectrum().begin()));
+
+		std::vector< std::complex<double> >& power = detail::ThreadScratch<std::complex<double>, detail::CorrelationScratchTag>(bins);
+		double* p = reinterpret_cast<double*>(power.data());
+
+		for (std::size_t k = 0; k < bins; ++k) {
+			const double xr = x[2 * k];
+			const double xi = x[2 * k + 1];
+
+			p[2 * k] = (xr * xr + xi * xi) * scale;
+			p[2 * k + 1] = 0.;
+		}
+
+		detail::CorrelationInverse(n, power, out);
+	}
+
+
+	//!	The largest value of a circular correlation r, located by parabolic interpolation
+	/*!
+	 *	The parabola goes through the largest sample and its two (circular)
+	 *	neighbours. Indices of N/2 and above are negative lags.
+	 */
+	template <typename RealContainer>
+	CorrelationPeak
+	FindCorrelationPeak (const RealContainer& r)
+	{
+		const std::size_t n = r.size();
+
+		if (n < 3)
+			throw std::invalid_argument("FindCorrelationPeak: needs at least 3 values");
+
+		std::size_t peak = 0;
+		for (std::size_t i = 1; i < n; ++i)
+			if (r[i] > r[peak])
+				peak = i;
+
+		const double y0 = r[(peak + n - 1) % n];
+		const double y1 = r[peak];
+		const double y2 = r[(peak + 1) % n];
+
+		const double curvature = y0 - 2. * y1 + y2;
+		const double delta = curvature != 0. ? 0.5 * (y0 - y2) / curvature : 0.;
+
+		const double index = peak < (n + 1) / 2 ? double(peak) : double(peak) - double(n);
+
+		return CorrelationPeak { index + delta, y1 - 0.25 * (y0 - y2) * delta };
+	}
+
+
+	//!	The lag and value of the cross-correlation peak of a and b, without returning the correlation
+	/*!
+	 *	The correlation goes into a reused per-thread array; otherwise as
+	 *	CrossCorrelate(a, b, out) followed by FindCorrelationPeak(out).
+	 */
+	template <typename WaveformT>
+	CorrelationPeak
+	CrossCorrelationPeak (const WaveformT& a, const WaveformT& b)
+	{
+		std::vector<double>& r = detail::ThreadScratch<double, detail::CorrelationScratchTag>(a.size());
+		CrossCorrelate(a, b, r);
+		return FindCorrelationPeak(r);
+	}
+
+}	//	namespace PS
+
+#endif
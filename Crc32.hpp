@@ -0,0 +1,91 @@
+/*
+ Crc32.hpp
+ CRC-32 (IEEE 802.3, as used by zip and png) checksums for the Waveform file formats.
+ */
+
+#ifndef CRC32_HPP
+#define CRC32_HPP 1
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace PS {
+
+namespace detail {
+
+	//!	Lookup tables for the slicing-by-8 CRC-32 algorithm
+	/*!
+	 *	Table 0 is the classic byte-at-a-time table for the reflected
+	 *	polynomial 0xEDB88320; tables 1-7 advance the remainder by one
+	 *	additional zero byte each, so eight input bytes can be folded into
+	 *	the remainder with eight independent lookups per iteration.
+	 */
+	struct Crc32Tables {
+		std::uint32_t table[8][256];
+
+		Crc32Tables (void)
+		{
+			for (std::uint32_t i = 0; i < 256; ++i) {
+				std::uint32_t crc = i;
+				for (int bit = 0; bit < 8; ++bit)
+					crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+				table[0][i] = crc;
+			}
+
+			for (std::uint32_t i = 0; i < 256; ++i)
+				for (int t = 1; t < 8; ++t)
+					table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFFu];
+		}
+
+		static const Crc32Tables&
+		Get (void)
+		{
+			static const Crc32Tables tables;
+			return tables;
+		}
+	};
+
+}	//	namespace detail
+
+
+	//!	Continues a CRC-32 over another block of bytes
+	/*!
+	 *	Start with crc = 0 and feed the blocks in order; the value returned
+	 *	after the last block is the checksum of the concatenated data.
+	 */
+	inline std::uint32_t
+	Crc32Update (std::uint32_t crc, const void* data, std::size_t length)
+	{
+		const std::uint32_t (&t)[8][256] = detail::Crc32Tables::Get().table;
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+
+		crc = ~crc;
+
+		for (; length >= 8; length -= 8, p += 8) {
+			const std::uint32_t lo = crc ^ ( std::uint32_t(p[0])
+										   | std::uint32_t(p[1]) << 8
+										   | std::uint32_t(p[2]) << 16
+										   | std::uint32_t(p[3]) << 24 );
+
+			crc = t[7][lo & 0xFFu] ^ t[6][(lo >> 8) & 0xFFu]
+				^ t[5][(lo >> 16) & 0xFFu] ^ t[4][lo >> 24]
+				^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+		}
+
+		for (; length; --length, ++p)
+			crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFFu];
+
+		return ~crc;
+	}
+
+
+	//!	Returns the CRC-32 of a single block of bytes
+	inline std::uint32_t
+	Crc32 (const void* data, std::size_t length)
+	{ return Crc32Update(0, data, length); }
+
+}	//	namespace PS
+
+#endif
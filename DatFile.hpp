@@ -0,0 +1,329 @@
+/*
+ DatFile.hpp
+ Fast parsing of whitespace-separated ".dat" text files (as found in test_data/)
+ directly into containers or Waveform domains.
+ */
+
+#ifndef DATFILE_HPP
+#define DATFILE_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <complex>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <MappedFile.hpp>
+#include <ParallelFor.hpp>
+
+/*
+	Accepted format:
+
+		Values are separated by any amount of whitespace. Real values are
+		anything std::from_chars accepts in its general format, optionally
+		preceded by '+'. Complex values use the same forms as operator>> for
+		std::complex: "re", "(re)" or "(re,im)", with optional whitespace
+		inside the parentheses.
+
+		Large files are split at line breaks and parsed by several threads,
+		so a parenthesized complex value must not span lines.
+ */
+
+
+namespace PS {
+
+namespace detail {
+
+	inline bool
+	IsDatSpace (char c)
+	{ return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+
+
+	inline const char*
+	SkipDatSpace (const char* p, const char* last)
+	{
+		while (p != last && IsDatSpace(*p))
+			++p;
+		return p;
+	}
+
+
+	inline void
+	ThrowDatError (const char* what, const char* where, const char* fileBegin)
+	{
+		throw std::runtime_error(std::string("DatFile: ") + what + " at byte "
+								 + std::to_string(where - fileBegin));
+	}
+
+
+	template <typename T>
+	const char*
+	ParseDatReal (const char* p, const char* last, T& value, const char* fileBegin)
+	{
+		if (p != last && *p == '+')
+			++p;
+
+		const std::from_chars_result result = std::from_chars(p, last, value);
+
+		if (result.ec != std::errc())
+			ThrowDatError("malformed number", p, fileBegin);
+
+		return result.ptr;
+	}
+
+
+	//!	Counts and parses whitespace-separated real values
+	template <typename T>
+	struct DatValueParser {
+		static_assert(std::is_arithmetic<T>::value, "DatFile: unsupported value type");
+
+		//!	Counts the tokens in [first, last), which must start and end between tokens
+		static std::size_t
+		Count (const char* first, const char* last)
+		{
+			//	Branch-free count of space-to-token transitions
+			std::size_t count = 0;
+			bool previousIsSpace = true;
+
+			for (const char* p = first; p != last; ++p) {
+				const bool isSpace = IsDatSpace(*p);
+				count += previousIsSpace & !isSpace;
+				previousIsSpace = isSpace;
+			}
+
+			return count;
+		}
+
+		static const char*
+		Parse (const char* p, const char* last, T& value, const char* fileBegin)
+		{ return ParseDatReal(p, last, value, fileBegin); }
+	};
+
+
+	//!	Counts and parses "re", "(re)" and "(re,im)" complex values
+	template <typename T>
+	struct DatValueParser< std::complex<T> > {
+
+		static std::size_t
+		Count (const char* first, const char* last)
+		{
+			std::size_t count = 0;
+			const char* p = SkipDatSpace(first, last);
+
+			while (p != last) {
+				if (*p == '(') {
+					const void* close = std::memchr(p, ')', last - p);
+					p = close ? static_cast<const char*>(close) + 1 : last;
+				}
+				else {
+					while (p != last && !IsDatSpace(*p))
+						++p;
+				}
+
+				++count;
+				p = SkipDatSpace(p, last);
+			}
+
+			return count;
+		}
+
+		static const char*
+		Parse (const char* p, const char* last, std::complex<T>& value, const char* fileBegin)
+		{
+			T re = 0;
+			T im = 0;
+
+			if (*p != '(') {
+				p = ParseDatReal(p, last, re, fileBegin);
+				value = std::complex<T>(re, im);
+				return p;
+			}
+
+			p = ParseDatReal(SkipDatSpace(p + 1, last), last, re, fileBegin);
+			p = SkipDatSpace(p, last);
+
+			if (p != last && *p == ',') {
+				p = ParseDatReal(SkipDatSpace(p + 1, last), last, im, fileBegin);
+				p = SkipDatSpace(p, last);
+			}
+
+			if (p == last || *p != ')')
+				ThrowDatError("expected ')'", p, fileBegin);
+
+			value = std::complex<T>(re, im);
+			return p + 1;
+		}
+	};
+
+}	//	namespace detail
+
+
+	//!	DatFile: a memory-mapped ".dat" file of values of type T
+	/*!
+	 *	Construction maps the file and counts its values, splitting the work
+	 *	across threads for large files; Read() then parses every value
+	 *	straight into caller-provided storage (again in parallel), so a
+	 *	Waveform domain can be filled without an intermediate vector:
+	 *
+	 *		PS::DatFile<double> dat ("squareFn1024_real.dat");
+	 *		WaveformType wfm (dat.size());
+	 *		PS::ReadTimeSeries(dat, wfm);
+	 *
+	 *	Parse errors throw std::runtime_error naming the byte offset.
+	 */
+	template <typename T>
+	class DatFile {
+	  public:
+
+		typedef T value_type;
+
+	  private:
+
+		typedef detail::DatValueParser<T> Parser;
+
+		//!	Files smaller than this are not split
+		static const std::size_t minChunkBytes = std::size_t(1) << 20;
+
+		MappedFile					file_;
+		unsigned					maxThreads_;
+
+		//!	chunkBegin_[i], chunkBegin_[i+1] delimit chunk i
+		std::vector<const char*>	chunkBegin_;
+
+		//!	Index of the first value of each chunk; the last entry is the total
+		std::vector<std::size_t>	chunkOffset_;
+
+	  public:
+
+		//!	Maps and scans a file, using up to maxThreads threads (0: one per core)
+		explicit
+		DatFile (const std::string& fileName, unsigned maxThreads = 0)
+			: file_(fileName)
+			, maxThreads_(maxThreads ? maxThreads : DefaultThreadCount())
+		{
+			const char* first = file_.data();
+			const char* last = first + file_.size();
+
+			const std::size_t chunks = std::max<std::size_t>(1,
+					std::min<std::size_t>(maxThreads_, file_.size() / minChunkBytes));
+
+			//	Chunk boundaries are moved forward to just after a line break
+			chunkBegin_.push_back(first);
+
+			for (std::size_t i = 1; i < chunks; ++i) {
+				const char* nominal = std::max(chunkBegin_.back(), first + file_.size() * i / chunks);
+				const void* newline = std::memchr(nominal, '\n', last - nominal);
+
+				if (!newline)
+					break;
+
+				chunkBegin_.push_back(static_cast<const char*>(newline) + 1);
+			}
+
+			chunkBegin_.push_back(last);
+
+			std::vector<std::size_t> counts (chunkBegin_.size() - 1);
+
+			ParallelFor(counts.size(), maxThreads_, [&](std::size_t i)
+			{
+				counts[i] = Parser::Count(chunkBegin_[i], chunkBegin_[i + 1]);
+			});
+
+			chunkOffset_.resize(counts.size() + 1, 0);
+
+			for (std::size_t i = 0; i < counts.size(); ++i)
+				chunkOffset_[i + 1] = chunkOffset_[i] + counts[i];
+		}
+
+
+		//!	Returns the number of values in the file
+		std::size_t
+		size (void) const
+		{ return chunkOffset_.back(); }
+
+
+		//!	Parses every value into out[0] ... out[size() - 1]
+		void
+		Read (T* out) const
+		{
+			const char* fileBegin = file_.data();
+
+			ParallelFor(chunkOffset_.size() - 1, maxThreads_, [&](std::size_t i)
+			{
+				const char* p = chunkBegin_[i];
+				const char* last = chunkBegin_[i + 1];
+				T* o = out + chunkOffset_[i];
+
+				while ((p = detail::SkipDatSpace(p, last)) != last) {
+					p = Parser::Parse(p, last, *o++, fileBegin);
+
+					if (p != last && !detail::IsDatSpace(*p))
+						detail::ThrowDatError("unexpected character", p, fileBegin);
+				}
+			});
+		}
+
+
+		//!	Parses every value into a contiguous container which already has size() elements
+		template <typename Container>
+		void
+		Read (Container& c) const
+		{
+			if (c.size() != size())
+				throw std::length_error("DatFile: the container length does not match the file");
+
+			if (!c.empty())
+				Read(&(*c.begin()));
+		}
+
+
+		//!	Returns the values in a new vector
+		std::vector<T>
+		ReadVector (void) const
+		{
+			std::vector<T> result (size());
+			Read(result);
+			return result;
+		}
+	};
+
+
+	//!	Returns the values of a ".dat" file as a vector
+	template <typename T>
+	std::vector<T>
+	ParseDatFile (const std::string& fileName)
+	{ return DatFile<T>(fileName).ReadVector(); }
+
+
+	//!	Fills the time domain of a Waveform from a ".dat" file and marks it valid
+	template <typename WaveformT>
+	void
+	ReadTimeSeries (const DatFile<typename WaveformT::TimeT>& dat, WaveformT& wfm)
+	{
+		if (wfm.PeekTimeSeries().size() != dat.size())
+			throw std::length_error("DatFile: the file length does not match the time domain");
+
+		dat.Read(wfm.OverwriteTimeSeries());
+	}
+
+
+	//!	Fills the freq domain of a Waveform from a ".dat" file and marks it valid
+	template <typename WaveformT>
+	void
+	ReadFreqSpectrum (const DatFile<typename WaveformT::FreqT>& dat, WaveformT& wfm)
+	{
+		if (wfm.PeekFreqSpectrum().size() != dat.size())
+			throw std::length_error("DatFile: the file length does not match the freq domain");
+
+		dat.Read(wfm.OverwriteFreqSpectrum());
+	}
+
+}	//	namespace PS
+
+#endif
@@ -0,0 +1,553 @@
+/*
+ Dwt.hpp
+ The discrete wavelet transform: a TransformT for Waveform (Dwt), the
+ in-place multi-level kernels it runs (DwtForward(), DwtInverse()), and a
+ container for the coefficients (WaveletCoefficients).
+
+ The signal is extended periodically, so N samples give exactly N
+ coefficients and every wavelet is perfectly invertible. After L levels
+ the coefficients are in the usual "Mallat" order, in place:
+
+	a_L | d_L | d_(L-1) | ... | d_2 | d_1
+
+ where d_j (the detail at level j) is N/2^j long and starts at N/2^j, and
+ a_L (the approximation left after the last level) is the first N/2^L.
+
+ Each level splits its input into the even and odd samples (one pass
+ through a reused per-thread scratch array) and then runs the wavelet's
+ kernel over the two halves. The kernels are unit-stride loops over two
+ separate arrays, which compilers vectorize at -O3 (or -O2
+ -ftree-vectorize); the few elements which wrap around are done apart.
+ The cost is O(N) for any number of levels.
+ */
+
+#ifndef DWT_HPP
+#define DWT_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/range.hpp>
+
+#include <TransformTypes.hpp>
+#include <Span.hpp>
+#include <FreeFunctionSupport.hpp>
+
+
+namespace Waveform {
+
+namespace Transform {
+
+namespace Wavelet {
+
+/*
+	A wavelet is a class with two static member function templates,
+
+		template <typename T> static void Forward (T* s, T* d, std::size_t h);
+		template <typename T> static void Inverse (T* s, T* d, std::size_t h);
+
+	Forward() is handed the h even samples in s and the h odd samples in d,
+	and replaces them with the approximation and detail coefficients of
+	one level; Inverse() undoes it. Both treat the halves as periodic.
+	min_length is the shortest input (2h) the kernel accepts.
+ */
+
+
+//!	Haar wavelet (orthonormal, 2 taps)
+struct Haar {
+	static constexpr std::size_t min_length = 2;
+
+	template <typename T>
+	static void
+	Forward (T* s, T* d, const std::size_t h)
+	{
+		const T r2 = std::sqrt(T(2.));
+
+		for (std::size_t i = 0; i < h; ++i) {
+			const T diff = d[i] - s[i];
+			s[i] = (s[i] + T(.5) * diff) * r2;
+			d[i] = diff / r2;
+		}
+	}
+
+	template <typename T>
+	static void
+	Inverse (T* s, T* d, const std::size_t h)
+	{
+		const T r2 = std::sqrt(T(2.));
+
+		for (std::size_t i = 0; i < h; ++i) {
+			const T diff = d[i] * r2;
+			const T even = s[i] / r2 - T(.5) * diff;
+			s[i] = even;
+			d[i] = even + diff;
+		}
+	}
+};
+
+
+//!	Daubechies wavelet with 2 vanishing moments (orthonormal, 4 taps), as three lifting steps
+struct Daubechies4 {
+	static constexpr std::size_t min_length = 4;
+
+	template <typename T>
+	static void
+	Forward (T* s, T* d, const std::size_t h)
+	{
+		const T r3 = std::sqrt(T(3.));
+		const T c1 = r3 / 4;
+		const T c2 = (r3 - 2) / 4;
+		const T ks = (r3 - 1) / std::sqrt(T(2.));
+		const T kd = (r3 + 1) / std::sqrt(T(2.));
+
+		for (std::size_t i = 0; i < h; ++i)
+			s[i] += r3 * d[i];
+
+		d[0] -= c1 * s[0] + c2 * s[h - 1];
+		for (std::size_t i = 1; i < h; ++i)
+			d[i] -= c1 * s[i] + c2 * s[i - 1];
+
+		for (std::size_t i = 0; i + 1 < h; ++i)
+			s[i] -= d[i + 1];
+		s[h - 1] -= d[0];
+
+		for (std::size_t i = 0; i < h; ++i) {
+			s[i] *= ks;
+			d[i] *= kd;
+		}
+	}
+
+	template <typename T>
+	static void
+	Inverse (T* s, T* d, const std::size_t h)
+	{
+		const T r3 = std::sqrt(T(3.));
+		const T c1 = r3 / 4;
+		const T c2 = (r3 - 2) / 4;
+		const T ks = (r3 - 1) / std::sqrt(T(2.));
+		const T kd = (r3 + 1) / std::sqrt(T(2.));
+
+		for (std::size_t i = 0; i < h; ++i) {
+			s[i] /= ks;
+			d[i] /= kd;
+		}
+
+		for (std::size_t i = 0; i + 1 < h; ++i)
+			s[i] += d[i + 1];
+		s[h - 1] += d[0];
+
+		d[0] += c1 * s[0] + c2 * s[h - 1];
+		for (std::size_t i = 1; i < h; ++i)
+			d[i] += c1 * s[i] + c2 * s[i - 1];
+
+		for (std::size_t i = 0; i < h; ++i)
+			s[i] -= r3 * d[i];
+	}
+};
+
+
+//!	Daubechies wavelet with 4 vanishing moments (orthonormal, 8 taps)
+/*!
+ *	Its lifting factorization is long and badly conditioned, so this
+ *	one is a 4-tap polyphase filter over the two halves instead. It still
+ *	works in place: the forward loop runs upwards and only reads ahead of
+ *	what it writes, the inverse loop runs downwards and only reads behind,
+ *	and the 3 values which wrap around are saved first.
+ */
+struct Daubechies8 {
+	static constexpr std::size_t min_length = 8;
+
+	//!	Low-pass analysis filter
+	template <typename T>
+	static const T*
+	Taps (void)
+	{
+		static const T h[8] = { T( 0.23037781330885523), T( 0.7148465705525415)
+							  , T( 0.6308807679295904), T(-0.02798376941698385)
+							  , T(-0.18703481171888114), T( 0.030841381835986965)
+							  , T( 0.032883011666982945), T(-0.010597401784997278) };
+		return h;
+	}
+
+	template <typename T>
+	static void
+	Forward (T* s, T* d, const std::size_t h)
+	{
+		const T* lo = Taps<T>();
+		T hi[8];
+		for (std::size_t k = 0; k < 8; ++k)
+			hi[k] = (k % 2 ? -1 : 1) * lo[7 - k];
+
+		//	even[i + j] and odd[i + j] for i + j past the end
+		T e[6];
+		T o[6];
+		for (std::size_t j = 0; j < 3; ++j) {
+			e[3 + j] = s[j];
+			o[3 + j] = d[j];
+		}
+
+		std::size_t i = 0;
+		for (; i + 3 < h; ++i) {
+			const T a = lo[0] * s[i] + lo[1] * d[i] + lo[2] * s[i + 1] + lo[3] * d[i + 1]
+					  + lo[4] * s[i + 2] + lo[5] * d[i + 2] + lo[6] * s[i + 3] + lo[7] * d[i + 3];
+			const T b = hi[0] * s[i] + hi[1] * d[i] + hi[2] * s[i + 1] + hi[3] * d[i + 1]
+					  + hi[4] * s[i + 2] + hi[5] * d[i + 2] + hi[6] * s[i + 3] + hi[7] * d[i + 3];
+			s[i] = a;
+			d[i] = b;
+		}
+
+		//	The last 3 outputs read past the end, into the saved start
+		for (std::size_t j = 0; j < 3; ++j) {
+			e[j] = s[i + j];
+			o[j] = d[i + j];
+		}
+		for (std::size_t j = 0; j < 3; ++j, ++i) {
+			const T* ej = e + j;
+			const T* oj = o + j;
+			s[i] = lo[0] * ej[0] + lo[1] * oj[0] + lo[2] * ej[1] + lo[3] * oj[1]
+				 + lo[4] * ej[2] + lo[5] * oj[2] + lo[6] * ej[3] + lo[7] * oj[3];
+			d[i] = hi[0] * ej[0] + hi[1] * oj[0] + hi[2] * ej[1] + hi[3] * oj[1]
+				 + hi[4] * ej[2] + hi[5] * oj[2] + hi[6] * ej[3] + hi[7] * oj[3];
+		}
+	}
+
+	template <typename T>
+	static void
+	Inverse (T* s, T* d, const std::size_t h)
+	{
+		const T* lo = Taps<T>();
+		T hi[8];
+		for (std::size_t k = 0; k < 8; ++k)
+			hi[k] = (k % 2 ? -1 : 1) * lo[7 - k];
+
+		//	s[i - j] and d[i - j] for i - j before the start
+		T a[6];
+		T b[6];
+		for (std::size_t j = 0; j < 3; ++j) {
+			a[j] = s[h - 3 + j];
+			b[j] = d[h - 3 + j];
+		}
+
+		std::size_t i = h;
+		for (; i-- > 3; ) {
+			const T even = lo[0] * s[i] + hi[0] * d[i] + lo[2] * s[i - 1] + hi[2] * d[i - 1]
+						 + lo[4] * s[i - 2] + hi[4] * d[i - 2] + lo[6] * s[i - 3] + hi[6] * d[i - 3];
+			const T odd = lo[1] * s[i] + hi[1] * d[i] + lo[3] * s[i - 1] + hi[3] * d[i - 1]
+						+ lo[5] * s[i - 2] + hi[5] * d[i - 2] + lo[7] * s[i - 3] + hi[7] * d[i - 3];
+			s[i] = even;
+			d[i] = odd;
+		}
+
+		//	The first 3 outputs read before the start, from the saved end
+		for (std::size_t j = 0; j < 3; ++j) {
+			a[3 + j] = s[j];
+			b[3 + j] = d[j];
+		}
+		for (std::size_t j = 3; j-- > 0; ) {
+			const T* aj = a + 3 + j;
+			const T* bj = b + 3 + j;
+			s[j] = lo[0] * aj[0] + hi[0] * bj[0] + lo[2] * aj[-1] + hi[2] * bj[-1]
+				 + lo[4] * aj[-2] + hi[4] * bj[-2] + lo[6] * aj[-3] + hi[6] * bj[-3];
+			d[j] = lo[1] * aj[0] + hi[1] * bj[0] + lo[3] * aj[-1] + hi[3] * bj[-1]
+				 + lo[5] * aj[-2] + hi[5] * bj[-2] + lo[7] * aj[-3] + hi[7] * bj[-3];
+		}
+	}
+};
+
+
+//!	Cohen-Daubechies-Feauveau 9/7 biorthogonal wavelet (JPEG 2000), as four lifting steps
+/*!
+ *	Scaled so that a constant signal gives approximation coefficients of
+ *	sqrt(2) times the constant, as for the orthonormal wavelets.
+ */
+struct Cdf97 {
+	static constexpr std::size_t min_length = 4;
+
+	template <typename T>
+	static void
+	Predict (T* d, const T* s, const std::size_t h, const T c)
+	{
+		for (std::size_t i = 0; i + 1 < h; ++i)
+			d[i] += c * (s[i] + s[i + 1]);
+		d[h - 1] += c * (s[h - 1] + s[0]);
+	}
+
+	template <typename T>
+	static void
+	Update (T* s, const T* d, const std::size_t h, const T c)
+	{
+		s[0] += c * (d[h - 1] + d[0]);
+		for (std::size_t i = 1; i < h; ++i)
+			s[i] += c * (d[i - 1] + d[i]);
+	}
+
+	template <typename T>
+	static void
+	Forward (T* s, T* d, const std::size_t h)
+	{
+		const T k = T(1.149604398860241);
+
+		Predict(d, s, h, T(-1.586134342059924));
+		Update(s, d, h, T(-0.052980118572961));
+		Predict(d, s, h, T(0.882911075530934));
+		Update(s, d, h, T(0.443506852043971));
+
+		for (std::size_t i = 0; i < h; ++i) {
+			s[i] *= k;
+			d[i] /= k;
+		}
+	}
+
+	template <typename T>
+	static void
+	Inverse (T* s, T* d, const std::size_t h)
+	{
+		const T k = T(1.149604398860241);
+
+		for (std::size_t i = 0; i < h; ++i) {
+			s[i] /= k;
+			d[i] *= k;
+		}
+
+		Update(s, d, h, T(-0.443506852043971));
+		Predict(d, s, h, T(-0.882911075530934));
+		Update(s, d, h, T(0.052980118572961));
+		Predict(d, s, h, T(1.586134342059924));
+	}
+};
+
+}	//	namespace Wavelet
+
+}	//	namespace Transform
+}	//	namespace Waveform
+
+
+
+namespace PS {
+
+namespace detail {
+
+	struct DwtScratchTag {};
+
+}	//	namespace detail
+
+
+	//!	The most levels a signal of n samples allows with WaveletT
+	/*!
+	 *	Each level halves the length, which must stay even and no shorter
+	 *	than WaveletT::min_length.
+	 */
+	template <typename WaveletT>
+	std::size_t
+	DwtMaxLevels (std::size_t n)
+	{
+		std::size_t levels = 0;
+
+		while (n % 2 == 0 && n >= WaveletT::min_length) {
+			n /= 2;
+			++levels;
+		}
+
+		return levels;
+	}
+
+
+	//!	Replaces data[0, n) with its DWT over levels levels, in the layout described above
+	template <typename WaveletT, typename T>
+	void
+	DwtForward (T* data, const std::size_t n, const std::size_t levels)
+	{
+		if (levels > DwtMaxLevels<WaveletT>(n))
+			throw std::length_error("Dwt: the length does not allow that many levels");
+
+		T* odd = detail::ThreadScratch<T, detail::DwtScratchTag>(n / 2).data();
+
+		for (std::size_t m = n, level = 0; level < levels; m /= 2, ++level) {
+			const std::size_t h = m / 2;
+
+			for (std::size_t i = 0; i < h; ++i) {
+				odd[i] = data[2 * i + 1];
+				data[i] = data[2 * i];
+			}
+			std::copy(odd, odd + h, data + h);
+
+			WaveletT::Forward(data, data + h, h);
+		}
+	}
+
+
+	//!	Undoes DwtForward() with the same n and levels, in place
+	template <typename WaveletT, typename T>
+	void
+	DwtInverse (T* data, const std::size_t n, const std::size_t levels)
+	{
+		if (levels > DwtMaxLevels<WaveletT>(n))
+			throw std::length_error("Dwt: the length does not allow that many levels");
+
+		T* odd = detail::ThreadScratch<T, detail::DwtScratchTag>(n / 2).data();
+
+		for (std::size_t level = levels; level > 0; --level) {
+			const std::size_t h = n >> level;
+
+			WaveletT::Inverse(data, data + h, h);
+
+			std::copy(data + h, data + 2 * h, odd);
+			for (std::size_t i = h; i-- > 0; ) {
+				data[2 * i] = data[i];
+				data[2 * i + 1] = odd[i];
+			}
+		}
+	}
+
+
+
+	//!	WaveletCoefficients: the N coefficients of a DWT, in the layout described above
+	/*!
+	 *	It is a std::vector<T> with accessors for the bands. It is a
+	 *	distinct type so that a Waveform using it can tell its time and
+	 *	freq domain constructors apart.
+	 */
+	template <typename T, typename Allocator = std::allocator<T> >
+	class WaveletCoefficients : public std::vector<T, Allocator> {
+	  private:
+
+		typedef std::vector<T, Allocator>	Base;
+
+	  public:
+
+		using Base::Base;
+
+		WaveletCoefficients (void) = default;
+
+
+		//!	The detail coefficients of level (1 is the finest), N/2^level values
+		Span<T>
+		detail (const std::size_t level)
+		{ return Span<T>(this->data() + (this->size() >> level), this->size() >> level); }
+
+		Span<const T>
+		detail (const std::size_t level) const
+		{ return Span<const T>(this->data() + (this->size() >> level), this->size() >> level); }
+
+
+		//!	The approximation coefficients left after levels levels, N/2^levels values
+		Span<T>
+		approximation (const std::size_t levels)
+		{ return Span<T>(this->data(), this->size() >> levels); }
+
+		Span<const T>
+		approximation (const std::size_t levels) const
+		{ return Span<const T>(this->data(), this->size() >> levels); }
+	};
+
+}	//	namespace PS
+
+
+
+namespace Waveform {
+
+namespace Transform {
+
+//!	Multi-level discrete wavelet transform
+/*!
+ *	The freq domain of a Waveform using this transform holds the N
+ *	wavelet coefficients of its N samples:
+ *
+ *		typedef PS::Waveform< std::vector<double>, PS::WaveletCoefficients<double>
+ *							, Waveform::Transform::Dwt<Waveform::Transform::Wavelet::Daubechies4, 5> > DwtWaveform;
+ *
+ *	WaveletT is one of the classes in Waveform::Transform::Wavelet, and
+ *	Levels the number of levels; 0 means as many as the length allows
+ *	(see PS::DwtMaxLevels()). The length must be a multiple of 2^Levels.
+ *
+ *	The forward transform copies the samples into the coefficient array
+ *	and runs PS::DwtForward() over it in place; the inverse does the
+ *	same the other way round. The orthonormal wavelets preserve the
+ *	energy of the signal.
+ */
+template <typename WaveletT, std::size_t Levels = 1>
+class Dwt {
+  public:
+	typedef InverseTypes::Inverse inverse_type;
+
+	static std::size_t
+	freq_length (std::size_t timeLength)
+	{ return timeLength; }
+
+	static std::size_t
+	time_length (std::size_t freqLength)
+	{ return freqLength; }
+
+  private:
+
+	double*			time_;
+	double*			coeffs_;
+	std::size_t		length_;
+	std::size_t		levels_;
+
+
+	static std::size_t
+	LevelsFor (const std::size_t length)
+	{
+		const std::size_t most = PS::DwtMaxLevels<WaveletT>(length);
+
+		//	A Waveform made from a length only has nothing to transform yet
+		if (length == 0)
+			return Levels;
+
+		if (Levels > most)
+			throw std::length_error("Dwt: the length does not allow that many levels");
+
+		return Levels ? Levels : most;
+	}
+
+  public:
+
+	//!	Iterator bounds constructor
+	template <typename Iterator1, typename Iterator2>
+	Dwt (Iterator1 first1, Iterator1 last1, Iterator2 first2)
+		: time_(&(*first1))
+		, coeffs_(&(*first2))
+		, length_(std::distance(first1, last1))
+		, levels_(LevelsFor(length_))
+	{ }
+
+
+	//!	Boost::range constructor (Random Access Range)
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	Dwt (RandomAccessRange1& range1, RandomAccessRange2& range2)
+		: Dwt(boost::begin(range1), boost::end(range1), boost::begin(range2))
+	{ }
+
+
+	//!	The number of levels the transform runs
+	std::size_t
+	levels (void) const
+	{ return levels_; }
+
+
+	void
+	exec_transform (void)
+	{
+		std::copy(time_, time_ + length_, coeffs_);
+		PS::DwtForward<WaveletT>(coeffs_, length_, levels_);
+	}
+
+	void
+	exec_inverse_transform (void)
+	{
+		std::copy(coeffs_, coeffs_ + length_, time_);
+		PS::DwtInverse<WaveletT>(time_, length_, levels_);
+	}
+};
+
+
+}	//	namespace Transform
+}	//	namespace Waveform
+
+#endif
@@ -0,0 +1,220 @@
+/*
+ FftwPlanCache.hpp
+ Process-wide cache of FFTW plans keyed by transform kind and length, for
+ the free functions (Envelope(), CrossCorrelate(), Resample(), ...) which
+ transform arrays that are not owned by a transform object, and for
+ transform objects which share plans rather than make their own.
+
+ Plans are run through FFTW's new-array execute functions
+ (http://www.fftw.org/doc/New_002darray-Execute-Functions.html), so one
+ plan serves every array of its length. Those functions require the
+ arrays to have the same alignment and in-place-ness as the ones the plan
+ was made for, so both are part of the key: arrays which fftw_malloc
+ would have returned get a plan with full SIMD, and anything else (such as
+ a std::vector of doubles) a plan made with FFTW_UNALIGNED.
+ */
+
+#ifndef FFTWPLANCACHE_HPP
+#define FFTWPLANCACHE_HPP 1
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+#include <fftw3.h>
+
+
+namespace Waveform {
+
+namespace Transform {
+
+class FftwPlanCache {
+  public:
+
+	enum class Kind {R2C, C2R, C2R_Preserve, C2C_Forward, C2C_Backward};
+
+  private:
+
+	typedef std::tuple<Kind, std::size_t, bool, bool>	Key;
+
+	std::mutex					mutex_;
+	std::map<Key, fftw_plan>	plans_;
+
+
+	FftwPlanCache (void) = default;
+
+	~FftwPlanCache (void)
+	{
+		for (auto& kv : plans_)
+			fftw_destroy_plan(kv.second);
+	}
+
+
+	static FftwPlanCache&
+	Get (void)
+	{
+		static FftwPlanCache cache;
+		return cache;
+	}
+
+
+	static bool
+	Aligned (const void* first, const void* second)
+	{
+		return fftw_alignment_of(reinterpret_cast<double*>(const_cast<void*>(first))) == 0
+			&& fftw_alignment_of(reinterpret_cast<double*>(const_cast<void*>(second))) == 0;
+	}
+
+
+	//!	Plans on scratch arrays; FFTW_ESTIMATE never reads or writes them
+	static fftw_plan
+	MakePlan (const Kind kind, const std::size_t n, const bool inPlace, const bool aligned)
+	{
+		const std::size_t complexCount = kind == Kind::C2C_Forward || kind == Kind::C2C_Backward ? n : n / 2 + 1;
+		const unsigned flags = FFTW_ESTIMATE | (aligned ? 0u : FFTW_UNALIGNED);
+
+		//	Large enough for either side, including the padding of an in-place r2c
+		fftw_complex* a = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * (complexCount + 1)));
+		fftw_complex* b = inPlace ? a : static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * (complexCount + 1)));
+
+		fftw_plan plan = nullptr;
+
+		switch (kind) {
+		case Kind::R2C:
+			plan = fftw_plan_dft_r2c_1d(int(n), reinterpret_cast<double*>(a), b, flags);
+			break;
+		case Kind::C2R:
+			plan = fftw_plan_dft_c2r_1d(int(n), a, reinterpret_cast<double*>(b), flags);
+			break;
+		case Kind::C2R_Preserve:
+			plan = fftw_plan_dft_c2r_1d(int(n), a, reinterpret_cast<double*>(b), flags | FFTW_PRESERVE_INPUT);
+			break;
+		case Kind::C2C_Forward:
+			plan = fftw_plan_dft_1d(int(n), a, b, FFTW_FORWARD, flags);
+			break;
+		case Kind::C2C_Backward:
+			plan = fftw_plan_dft_1d(int(n), a, b, FFTW_BACKWARD, flags);
+			break;
+		}
+
+		if (b != a)
+			fftw_free(b);
+		fftw_free(a);
+
+		if (!plan)
+			throw std::runtime_error("FftwPlanCache: FFTW could not make a plan");
+
+		return plan;
+	}
+
+
+	fftw_plan
+	Find (const Kind kind, const std::size_t n, const void* in, const void* out)
+	{
+		const bool inPlace = in == out;
+		const Key key (kind, n, inPlace, Aligned(in, out));
+
+		//	The FFTW planner is not thread-safe, so planning happens under the lock too
+		std::lock_guard<std::mutex> lock (mutex_);
+
+		auto found = plans_.find(key);
+		if (found == plans_.end())
+			found = plans_.emplace(key, MakePlan(kind, n, inPlace, std::get<3>(key))).first;
+
+		return found->second;
+	}
+
+  public:
+
+	//!	The plan of the given kind for arrays of length n aligned as in and out are
+	/*!
+	 *	For transform objects which resolve their plans once, when they are
+	 *	constructed, and run them without the lock afterwards (FFTW's
+	 *	execute functions are thread-safe). The plan belongs to the cache
+	 *	and stays valid until Clear().
+	 */
+	static fftw_plan
+	Lookup (const Kind kind, const std::size_t n, const void* in, const void* out)
+	{ return Get().Find(kind, n, in, out); }
+
+
+	//!	Unnormalized forward r2c: n reals to n/2+1 complex values
+	static void
+	ExecuteR2C (const std::size_t n, double* in, std::complex<double>* out)
+	{
+		fftw_execute_dft_r2c(Get().Find(Kind::R2C, n, in, out), in, reinterpret_cast<fftw_complex*>(out));
+	}
+
+
+	//!	Unnormalized inverse c2r: n/2+1 complex values to n reals; destroys in
+	static void
+	ExecuteC2R (const std::size_t n, std::complex<double>* in, double* out)
+	{
+		fftw_execute_dft_c2r(Get().Find(Kind::C2R, n, in, out), reinterpret_cast<fftw_complex*>(in), out);
+	}
+
+
+	//!	Unnormalized inverse c2r which leaves in unchanged; in and out must not overlap
+	/*!
+	 *	FFTW can only preserve the input of one-dimensional c2r
+	 *	transforms, and may pick a slower algorithm to do so.
+	 */
+	static void
+	ExecuteC2RPreserving (const std::size_t n, const std::complex<double>* in, double* out)
+	{
+		fftw_complex* input = reinterpret_cast<fftw_complex*>(const_cast<std::complex<double>*>(in));
+
+		fftw_execute_dft_c2r(Get().Find(Kind::C2R_Preserve, n, in, out), input, out);
+	}
+
+
+	//!	Unnormalized complex DFT of n values, with sign FFTW_FORWARD or FFTW_BACKWARD
+	static void
+	ExecuteC2C (const std::size_t n, const int sign, std::complex<double>* in, std::complex<double>* out)
+	{
+		const Kind kind = sign == FFTW_FORWARD ? Kind::C2C_Forward : Kind::C2C_Backward;
+
+		fftw_execute_dft(Get().Find(kind, n, in, out)
+						, reinterpret_cast<fftw_complex*>(in), reinterpret_cast<fftw_complex*>(out));
+	}
+
+
+	//!	Destroys every cached plan
+	/*!
+	 *	Call this before fftw_cleanup(): the cache is static, and destroying
+	 *	its plans after fftw_cleanup(), as its destructor would at exit, is
+	 *	undefined. No plan may be running, and no transform object holding
+	 *	one from Lookup() (Fftw3_Dft_1d_Cached_Normalized) may be used
+	 *	afterwards. Later calls plan again.
+	 */
+	static void
+	Clear (void)
+	{
+		FftwPlanCache& cache = Get();
+		std::lock_guard<std::mutex> lock (cache.mutex_);
+
+		for (auto& kv : cache.plans_)
+			fftw_destroy_plan(kv.second);
+		cache.plans_.clear();
+	}
+
+
+	//!	Number of plans in the cache
+	static std::size_t
+	Size (void)
+	{
+		FftwPlanCache& cache = Get();
+		std::lock_guard<std::mutex> lock (cache.mutex_);
+		return cache.plans_.size();
+	}
+};
+
+
+}	//	namespace Transform
+}	//	namespace Waveform
+
+#endif
@@ -3,9 +3,12 @@
 #pragma once
 
 #include <complex>
+#include <cstddef>
+#include <utility>
 #include <fftw3.h>
 #include <boost/range.hpp>
 
+#include <FftwPlanCache.hpp>
 #include <TransformTypes.hpp>
 
 //#define NORMALIZE_INVERSE 1
@@ -20,13 +23,14 @@
 	 [ ] Supporting multi-threading
 	 [ ] SIMD alignment (fftw_malloc and fftw_alignment_of)
 	 [ ] Making transforms have string names (fftw_sprint_plan)
-	 [ ] Split arrays of real and imaginary components
+	 [x] Split arrays of real and imaginary components (Fftw3_Dft_1d_Split_Normalized)
 
-	 [ ] Offloading alignment and such to an allocator can make it
+	 [x] Offloading alignment and such to an allocator can make it
 	 		so that a plan could operate on a difference set of data
 			each time through the advanced interface, meaning that
 			the input and output arrays could be moved / modified
 			with a bit more effort put into the design of these classes.
+			(Fftw3_Dft_1d_Cached_Normalized, with PS::EventArena)
 
  */
 
@@ -49,6 +53,9 @@
 
 		[ Forward Plan Name ]		[ Inverse Plan Name ]	[ Input Domain ]	[ Output Domain ]
 		fftw_plan_dft_r2c_1d		fftw_plan_dft_c2r_1d	Real 1D array		Complex 1D array
+		fftw_plan_guru_split_dft_r2c	..._split_dft_c2r	Real 1D array		Split complex 1D array
+		fftw_plan_r2r_1d (R2HC)		fftw_plan_r2r_1d (HC2R)	Real 1D array	Halfcomplex 1D array
+		fftw_plan_dft_r2c_1d		fftw_plan_dft_c2r_1d	Real 1D array		Complex 1D array (in place)
 
 
 	Eventually supported "Plans":
@@ -156,6 +163,8 @@ namespace Transform {
 class Fftw3_Dft_1d {
   public:
   	typedef InverseTypes::ScaledInverse inverse_type;
+
+	static const bool spectral_product_is_convolution = true;
 	
   private:
 
@@ -240,11 +249,38 @@ class Fftw3_Dft_1d {
 	}
 
 
-	Fftw3_Dft_1d (const Fftw3_Dft_1d& to_copy)
-		: forwardPlan(to_copy.forwardPlan)
-		, inversePlan(to_copy.inversePlan)
+	//!	Not copyable: the plans are bound to the arrays they were made for
+	Fftw3_Dft_1d (const Fftw3_Dft_1d& to_copy) = delete;
+
+	Fftw3_Dft_1d&
+	operator= (const Fftw3_Dft_1d& rhs) = delete;
+
+
+	//!	Move constructor, taking over the plans of to_move
+	Fftw3_Dft_1d (Fftw3_Dft_1d&& to_move)
+		: forwardPlan(to_move.forwardPlan)
+		, inversePlan(to_move.inversePlan)
+	{
+		to_move.forwardPlan = nullptr;
+		to_move.inversePlan = nullptr;
+	}
+
+
+	//!	Move assignment, implemented by swapping plans
+	Fftw3_Dft_1d&
+	operator= (Fftw3_Dft_1d&& rhs)
 	{
+		swap(*this, rhs);
+		return *this;
+	}
+
 
+	friend void
+	swap (Fftw3_Dft_1d& first, Fftw3_Dft_1d& second)
+	{
+		using std::swap;
+		swap(first.forwardPlan, second.forwardPlan);
+		swap(first.inversePlan, second.inversePlan);
 	}
 
 	/*!
@@ -270,8 +306,10 @@ class Fftw3_Dft_1d {
 
 	~Fftw3_Dft_1d (void)
 	{
-		fftw_destroy_plan(forwardPlan);
-		fftw_destroy_plan(inversePlan);
+		if (forwardPlan)
+			fftw_destroy_plan(forwardPlan);
+		if (inversePlan)
+			fftw_destroy_plan(inversePlan);
 	}
 
 	void
@@ -292,16 +330,16 @@ class Fftw3_Dft_1d_Normalized {
   public:
 	typedef InverseTypes::Inverse inverse_type;
 
+	static const bool spectral_product_is_convolution = true;
+
   private:
 
 //	fftw_plan forwardPlan;
 //	fftw_plan inversePlan;
 
-	//std::complex<double>*	first_;
-	fftw_complex*	first_;
+	//!	The time domain array, which the inverse transform rescales
+	double*			first_;
 	std::size_t		length_;
-	fftw_complex*	last_;
-	//std::complex<double>*	last_;
 
 
 	fftw_plan 				forwardPlan;
@@ -349,18 +387,15 @@ class Fftw3_Dft_1d_Normalized {
 	//!	Iterator bounds constructor
 	template <typename Iterator1, typename Iterator2>
 	Fftw3_Dft_1d_Normalized (Iterator1 first1, Iterator1 last1, Iterator2 first2)
-		: first_(first2)
+		: first_(&(*first1))
 		, length_(std::distance(first1, last1))
-		, last_(first_ + length_ / 2 + 1)
 		, forwardPlan( fftw_plan_dft_r2c_1d ( length_
-											, &(*first1)
 											, first_
-											//, reinterpret_cast<fftw_complex*>(&(*first2))
+											, reinterpret_cast<fftw_complex*>(&(*first2))
 											, FFTW_ESTIMATE) )
 		, inversePlan( fftw_plan_dft_c2r_1d ( length_
+											, reinterpret_cast<fftw_complex*>(&(*first2))
 											, first_
-											//, reinterpret_cast<fftw_complex*>(&(*first2))
-											, &(*first1)
 											, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT) )
 
 	{ }
@@ -373,10 +408,506 @@ class Fftw3_Dft_1d_Normalized {
 	{ }
 
 
+	//!	Not copyable: the plans are bound to the arrays they were made for
+	Fftw3_Dft_1d_Normalized (const Fftw3_Dft_1d_Normalized& to_copy) = delete;
+
+	Fftw3_Dft_1d_Normalized&
+	operator= (const Fftw3_Dft_1d_Normalized& rhs) = delete;
+
+
+	//!	Move constructor, taking over the plans of to_move
+	Fftw3_Dft_1d_Normalized (Fftw3_Dft_1d_Normalized&& to_move)
+		: first_(to_move.first_)
+		, length_(to_move.length_)
+		, forwardPlan(to_move.forwardPlan)
+		, inversePlan(to_move.inversePlan)
+	{
+		to_move.forwardPlan = nullptr;
+		to_move.inversePlan = nullptr;
+	}
+
+
+	//!	Move assignment, implemented by swapping plans
+	Fftw3_Dft_1d_Normalized&
+	operator= (Fftw3_Dft_1d_Normalized&& rhs)
+	{
+		swap(*this, rhs);
+		return *this;
+	}
+
+
+	friend void
+	swap (Fftw3_Dft_1d_Normalized& first, Fftw3_Dft_1d_Normalized& second)
+	{
+		using std::swap;
+		swap(first.first_, second.first_);
+		swap(first.length_, second.length_);
+		swap(first.forwardPlan, second.forwardPlan);
+		swap(first.inversePlan, second.inversePlan);
+	}
+
+
 	~Fftw3_Dft_1d_Normalized (void)
 	{
-		fftw_destroy_plan(forwardPlan);
-		fftw_destroy_plan(inversePlan);
+		if (forwardPlan)
+			fftw_destroy_plan(forwardPlan);
+		if (inversePlan)
+			fftw_destroy_plan(inversePlan);
+	}
+
+	void
+	exec_transform (void)
+	{
+		fftw_execute(forwardPlan);
+	}
+
+	void
+	exec_inverse_transform (void)
+	{
+		fftw_execute(inversePlan);
+
+		//	fftw_plan_dft_c2r_1d leaves the output scaled by the length
+		const double scale = 1. / double(length_);
+
+		for (std::size_t i = 0; i < length_; ++i)
+			first_[i] *= scale;
+	}
+};
+
+
+//!	Fftw3_Dft_1d_Normalized with plans shared through FftwPlanCache
+/*!
+ *	Rather than planning for its own arrays, this transform runs the
+ *	process-wide plans of FftwPlanCache on them (FFTW's new-array execute
+ *	functions). Constructing one looks its two plans up in the cache,
+ *	planning only the first time a length is seen, and the transforms run
+ *	them without taking the cache's lock. That suits short-lived
+ *	Waveforms, especially ones whose arrays come from an arena
+ *	(PS::EventArena), where planning would otherwise be the largest cost
+ *	left.
+ *
+ *	The cache keys plans on alignment, so arrays aligned as fftw_malloc
+ *	aligns them get plans with full SIMD. The inverse runs a c2r plan made
+ *	with FFTW_PRESERVE_INPUT.
+ */
+class Fftw3_Dft_1d_Cached_Normalized {
+  public:
+	typedef InverseTypes::Inverse inverse_type;
+
+	static const bool spectral_product_is_convolution = true;
+
+  private:
+
+	double*					time_;
+	std::complex<double>*	freq_;
+	std::size_t				length_;
+	fftw_plan				forward_;
+	fftw_plan				inverse_;
+
+  public:
+
+	//!	Iterator bounds constructor
+	template <typename Iterator1, typename Iterator2>
+	Fftw3_Dft_1d_Cached_Normalized (Iterator1 first1, Iterator1 last1, Iterator2 first2)
+		: time_(&(*first1))
+		, freq_(&(*first2))
+		, length_(std::distance(first1, last1))
+		, forward_(length_ ? FftwPlanCache::Lookup(FftwPlanCache::Kind::R2C, length_, time_, freq_) : nullptr)
+		, inverse_(length_ ? FftwPlanCache::Lookup(FftwPlanCache::Kind::C2R_Preserve, length_, freq_, time_) : nullptr)
+	{ }
+
+
+	//!	Boost::range constructor (Random Access Range)
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	Fftw3_Dft_1d_Cached_Normalized (RandomAccessRange1& range1, RandomAccessRange2& range2)
+		: Fftw3_Dft_1d_Cached_Normalized(boost::begin(range1), boost::end(range1), boost::begin(range2))
+	{ }
+
+
+	//!	Not copyable: the pointers are to the arrays of one Waveform
+	Fftw3_Dft_1d_Cached_Normalized (const Fftw3_Dft_1d_Cached_Normalized& to_copy) = delete;
+
+	Fftw3_Dft_1d_Cached_Normalized&
+	operator= (const Fftw3_Dft_1d_Cached_Normalized& rhs) = delete;
+
+
+	Fftw3_Dft_1d_Cached_Normalized (Fftw3_Dft_1d_Cached_Normalized&& to_move) = default;
+
+
+	Fftw3_Dft_1d_Cached_Normalized&
+	operator= (Fftw3_Dft_1d_Cached_Normalized&& rhs)
+	{
+		swap(*this, rhs);
+		return *this;
+	}
+
+
+	friend void
+	swap (Fftw3_Dft_1d_Cached_Normalized& first, Fftw3_Dft_1d_Cached_Normalized& second)
+	{
+		using std::swap;
+		swap(first.time_, second.time_);
+		swap(first.freq_, second.freq_);
+		swap(first.length_, second.length_);
+		swap(first.forward_, second.forward_);
+		swap(first.inverse_, second.inverse_);
+	}
+
+
+	void
+	exec_transform (void)
+	{
+		fftw_execute_dft_r2c(forward_, time_, reinterpret_cast<fftw_complex*>(freq_));
+	}
+
+	void
+	exec_inverse_transform (void)
+	{
+		fftw_execute_dft_c2r(inverse_, reinterpret_cast<fftw_complex*>(freq_), time_);
+
+		const double scale = 1. / double(length_);
+
+		for (std::size_t i = 0; i < length_; ++i)
+			time_[i] *= scale;
+	}
+};
+
+
+//!	Normalized r2c/c2r transform between a real array and a split complex array
+/*!
+ *	The freq domain is stored as separate arrays of real and imaginary
+ *	parts, such as PS::SplitComplexVector<double> (any container with
+ *	real_data() and imag_data() will do). The plans are made through the
+ *	guru split-array interface and run with fftw_execute_split_dft_r2c()
+ *	and fftw_execute_split_dft_c2r(), so the spectrum is never
+ *	interleaved or copied.
+ *
+ *	As with Fftw3_Dft_1d_Normalized, the inverse is rescaled so that the
+ *	pair is a true inverse.
+ */
+class Fftw3_Dft_1d_Split_Normalized {
+  public:
+	typedef InverseTypes::Inverse inverse_type;
+
+	static const bool spectral_product_is_convolution = true;
+
+  private:
+
+	double*			time_;
+	double*			re_;
+	double*			im_;
+	std::size_t		length_;
+
+	fftw_plan 		forwardPlan;
+	fftw_plan 		inversePlan;
+
+	static fftw_iodim
+	dim_ (std::size_t length)
+	{
+		fftw_iodim dim;
+		dim.n = int(length);
+		dim.is = 1;
+		dim.os = 1;
+		return dim;
+	}
+
+  public:
+
+	//!	Boost::range constructor; range2 must provide real_data() and imag_data()
+	template <typename RandomAccessRange1, typename SplitRange>
+	Fftw3_Dft_1d_Split_Normalized (RandomAccessRange1& range1, SplitRange& range2)
+		: time_(&(*boost::begin(range1)))
+		, re_(range2.real_data())
+		, im_(range2.imag_data())
+		, length_(boost::size(range1))
+		, forwardPlan(nullptr)
+		, inversePlan(nullptr)
+	{
+		const fftw_iodim dim = dim_(length_);
+
+		forwardPlan = fftw_plan_guru_split_dft_r2c(1, &dim, 0, nullptr, time_, re_, im_, FFTW_ESTIMATE);
+		inversePlan = fftw_plan_guru_split_dft_c2r(1, &dim, 0, nullptr, re_, im_, time_
+												 , FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
+	}
+
+
+	//!	Not copyable: the plans are bound to the arrays they were made for
+	Fftw3_Dft_1d_Split_Normalized (const Fftw3_Dft_1d_Split_Normalized& to_copy) = delete;
+
+	Fftw3_Dft_1d_Split_Normalized&
+	operator= (const Fftw3_Dft_1d_Split_Normalized& rhs) = delete;
+
+
+	//!	Move constructor, taking over the plans of to_move
+	Fftw3_Dft_1d_Split_Normalized (Fftw3_Dft_1d_Split_Normalized&& to_move)
+		: time_(to_move.time_)
+		, re_(to_move.re_)
+		, im_(to_move.im_)
+		, length_(to_move.length_)
+		, forwardPlan(to_move.forwardPlan)
+		, inversePlan(to_move.inversePlan)
+	{
+		to_move.forwardPlan = nullptr;
+		to_move.inversePlan = nullptr;
+	}
+
+
+	//!	Move assignment, implemented by swapping plans
+	Fftw3_Dft_1d_Split_Normalized&
+	operator= (Fftw3_Dft_1d_Split_Normalized&& rhs)
+	{
+		swap(*this, rhs);
+		return *this;
+	}
+
+
+	friend void
+	swap (Fftw3_Dft_1d_Split_Normalized& first, Fftw3_Dft_1d_Split_Normalized& second)
+	{
+		using std::swap;
+		swap(first.time_, second.time_);
+		swap(first.re_, second.re_);
+		swap(first.im_, second.im_);
+		swap(first.length_, second.length_);
+		swap(first.forwardPlan, second.forwardPlan);
+		swap(first.inversePlan, second.inversePlan);
+	}
+
+
+	~Fftw3_Dft_1d_Split_Normalized (void)
+	{
+		if (forwardPlan)
+			fftw_destroy_plan(forwardPlan);
+		if (inversePlan)
+			fftw_destroy_plan(inversePlan);
+	}
+
+	void
+	exec_transform (void)
+	{
+		fftw_execute_split_dft_r2c(forwardPlan, time_, re_, im_);
+	}
+
+	void
+	exec_inverse_transform (void)
+	{
+		fftw_execute_split_dft_c2r(inversePlan, re_, im_, time_);
+
+		const double scale = 1. / double(length_);
+
+		for (std::size_t i = 0; i < length_; ++i)
+			time_[i] *= scale;
+	}
+};
+
+
+//!	Normalized real-to-halfcomplex transform (FFTW_R2HC / FFTW_HC2R)
+/*!
+ *	The spectrum of N samples is N reals in halfcomplex order, as stored
+ *	by PS::HalfComplexVector<double>, instead of the N/2+1 complex values
+ *	of r2c: half the memory of the freq domain, and FFTW's r2r codelets
+ *	are often faster than r2c for the same length.
+ *
+ *	The inverse is rescaled by 1/N, as for Fftw3_Dft_1d_Normalized.
+ */
+class Fftw3_R2HC_1d_Normalized {
+  public:
+	typedef InverseTypes::Inverse inverse_type;
+
+	//!	The freq domain has as many (real) elements as the time domain
+	static std::size_t
+	freq_length (std::size_t timeLength)
+	{ return timeLength; }
+
+	static std::size_t
+	time_length (std::size_t freqLength)
+	{ return freqLength; }
+
+  private:
+
+	double*			first_;
+	std::size_t		length_;
+
+	fftw_plan 		forwardPlan;
+	fftw_plan 		inversePlan;
+
+  public:
+
+	//!	Iterator bounds constructor
+	template <typename Iterator1, typename Iterator2>
+	Fftw3_R2HC_1d_Normalized (Iterator1 first1, Iterator1 last1, Iterator2 first2)
+		: first_(&(*first1))
+		, length_(std::distance(first1, last1))
+		, forwardPlan( fftw_plan_r2r_1d ( length_
+										, first_
+										, &(*first2)
+										, FFTW_R2HC
+										, FFTW_ESTIMATE) )
+		, inversePlan( fftw_plan_r2r_1d ( length_
+										, &(*first2)
+										, first_
+										, FFTW_HC2R
+										, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT) )
+	{ }
+
+
+	//!	Boost::range constructor (Random Access Range)
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	Fftw3_R2HC_1d_Normalized (RandomAccessRange1& range1, RandomAccessRange2& range2)
+		: Fftw3_R2HC_1d_Normalized(boost::begin(range1), boost::end(range1), boost::begin(range2))
+	{ }
+
+
+	//!	Not copyable: the plans are bound to the arrays they were made for
+	Fftw3_R2HC_1d_Normalized (const Fftw3_R2HC_1d_Normalized& to_copy) = delete;
+
+	Fftw3_R2HC_1d_Normalized&
+	operator= (const Fftw3_R2HC_1d_Normalized& rhs) = delete;
+
+
+	//!	Move constructor, taking over the plans of to_move
+	Fftw3_R2HC_1d_Normalized (Fftw3_R2HC_1d_Normalized&& to_move)
+		: first_(to_move.first_)
+		, length_(to_move.length_)
+		, forwardPlan(to_move.forwardPlan)
+		, inversePlan(to_move.inversePlan)
+	{
+		to_move.forwardPlan = nullptr;
+		to_move.inversePlan = nullptr;
+	}
+
+
+	//!	Move assignment, implemented by swapping plans
+	Fftw3_R2HC_1d_Normalized&
+	operator= (Fftw3_R2HC_1d_Normalized&& rhs)
+	{
+		swap(*this, rhs);
+		return *this;
+	}
+
+
+	friend void
+	swap (Fftw3_R2HC_1d_Normalized& first, Fftw3_R2HC_1d_Normalized& second)
+	{
+		using std::swap;
+		swap(first.first_, second.first_);
+		swap(first.length_, second.length_);
+		swap(first.forwardPlan, second.forwardPlan);
+		swap(first.inversePlan, second.inversePlan);
+	}
+
+
+	~Fftw3_R2HC_1d_Normalized (void)
+	{
+		if (forwardPlan)
+			fftw_destroy_plan(forwardPlan);
+		if (inversePlan)
+			fftw_destroy_plan(inversePlan);
+	}
+
+	void
+	exec_transform (void)
+	{
+		fftw_execute(forwardPlan);
+	}
+
+	void
+	exec_inverse_transform (void)
+	{
+		fftw_execute(inversePlan);
+
+		const double scale = 1. / double(length_);
+
+		for (std::size_t i = 0; i < length_; ++i)
+			first_[i] *= scale;
+	}
+};
+
+
+//!	Normalized in-place r2c/c2r transform over a single buffer
+/*!
+ *	range1 (N reals) and range2 (N/2+1 complex values) must be two views
+ *	of the same storage, as set up by PS::InPlaceWaveform: the time domain
+ *	is the first N doubles of the 2*(N/2+1) in the buffer. FFTW plans the
+ *	transforms in place, so each one overwrites the domain it reads.
+ *
+ *	The inverse is rescaled by 1/N, as for Fftw3_Dft_1d_Normalized.
+ */
+class Fftw3_Dft_1d_InPlace_Normalized {
+  public:
+	typedef InverseTypes::Inverse inverse_type;
+
+  private:
+
+	double*			first_;
+	std::size_t		length_;
+
+	fftw_plan 		forwardPlan;
+	fftw_plan 		inversePlan;
+
+  public:
+
+	//!	Boost::range constructor; both ranges must start at the same address
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	Fftw3_Dft_1d_InPlace_Normalized (RandomAccessRange1& range1, RandomAccessRange2& range2)
+		: first_(&(*boost::begin(range1)))
+		, length_(boost::size(range1))
+		, forwardPlan( fftw_plan_dft_r2c_1d ( length_
+											, first_
+											, reinterpret_cast<fftw_complex*>(&(*boost::begin(range2)))
+											, FFTW_ESTIMATE) )
+		, inversePlan( fftw_plan_dft_c2r_1d ( length_
+											, reinterpret_cast<fftw_complex*>(&(*boost::begin(range2)))
+											, first_
+											, FFTW_ESTIMATE) )
+	{ }
+
+
+	//!	Not copyable: the plans are bound to the buffer they were made for
+	Fftw3_Dft_1d_InPlace_Normalized (const Fftw3_Dft_1d_InPlace_Normalized& to_copy) = delete;
+
+	Fftw3_Dft_1d_InPlace_Normalized&
+	operator= (const Fftw3_Dft_1d_InPlace_Normalized& rhs) = delete;
+
+
+	//!	Move constructor, taking over the plans of to_move
+	Fftw3_Dft_1d_InPlace_Normalized (Fftw3_Dft_1d_InPlace_Normalized&& to_move)
+		: first_(to_move.first_)
+		, length_(to_move.length_)
+		, forwardPlan(to_move.forwardPlan)
+		, inversePlan(to_move.inversePlan)
+	{
+		to_move.forwardPlan = nullptr;
+		to_move.inversePlan = nullptr;
+	}
+
+
+	//!	Move assignment, implemented by swapping plans
+	Fftw3_Dft_1d_InPlace_Normalized&
+	operator= (Fftw3_Dft_1d_InPlace_Normalized&& rhs)
+	{
+		swap(*this, rhs);
+		return *this;
+	}
+
+
+	friend void
+	swap (Fftw3_Dft_1d_InPlace_Normalized& first, Fftw3_Dft_1d_InPlace_Normalized& second)
+	{
+		using std::swap;
+		swap(first.first_, second.first_);
+		swap(first.length_, second.length_);
+		swap(first.forwardPlan, second.forwardPlan);
+		swap(first.inversePlan, second.inversePlan);
+	}
+
+
+	~Fftw3_Dft_1d_InPlace_Normalized (void)
+	{
+		if (forwardPlan)
+			fftw_destroy_plan(forwardPlan);
+		if (inversePlan)
+			fftw_destroy_plan(inversePlan);
 	}
 
 	void
@@ -390,15 +921,10 @@ class Fftw3_Dft_1d_Normalized {
 	{
 		fftw_execute(inversePlan);
 
-		/*
-		std::for_each(first_, last_, [=](std::complex<double>& x)
-		{x /= length_;});
-		*/
+		const double scale = 1. / double(length_);
 
-		for (auto iter (first_); iter != last_; ++iter) {
-			(*iter)[0] /= double(length_);
-			(*iter)[1] /= double(length_);
-		}
+		for (std::size_t i = 0; i < length_; ++i)
+			first_[i] *= scale;
 	}
 };
 
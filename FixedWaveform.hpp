@@ -0,0 +1,586 @@
+/*
+ FixedWaveform.hpp
+ A Waveform whose length is a template parameter, for the many tiny
+ waveforms (N of a few dozen to a few hundred) where a heap allocation
+ per domain and a run-time plan cost more than the FFT itself.
+
+ PS::FixedWaveform<N> keeps both domains in std::array members, so it
+ never allocates, is trivially copyable and can live on the stack or in
+ a std::vector of thousands. Its transform,
+ Waveform::Transform::Fixed_Dft_1d_Normalized<N>, has no state at all:
+ the factorization of N is chosen at compile time, every loop has a
+ constant trip count, and the twiddle factors are constexpr tables (the
+ sines and cosines are computed by the compiler, so there is no
+ initialization at run time either). Transforms of up to
+ Fixed::InlineLength complex values are inlined and unrolled whole, and
+ the butterflies of radix 2 and 4 need no multiplications. With GCC on
+ x86-64 Linux, Forward() and Inverse() are built for AVX-512, AVX2 and
+ baseline SSE2 and picked at load time, as NativeFft's kernels are (see
+ SimdDispatch.hpp).
+
+ The conventions are those of Fftw3_Dft_1d_Normalized: the spectrum is
+ the N/2+1 bins of the unnormalized r2c DFT, and the inverse is scaled
+ by 1/N.
+ */
+
+#ifndef FIXEDWAVEFORM_HPP
+#define FIXEDWAVEFORM_HPP 1
+#pragma once
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+
+#include <SimdDispatch.hpp>
+#include <TransformTypes.hpp>
+
+
+namespace Waveform {
+namespace Transform {
+namespace Fixed {
+
+	//!	cos(x) and sin(x) for |x| <= pi/4 by their Taylor series, at compile time
+	constexpr void
+	SinCos (const long double x, long double& c, long double& s)
+	{
+		const long double xx = x * x;
+		long double term = 1.L;
+
+		c = 0.L;
+		s = 0.L;
+
+		//	term is x^(2j) / (2j)!; 14 terms are far past double precision for |x| <= pi/4
+		for (int j = 0; j < 14; ++j) {
+			c += term;
+			s += term * x / (2 * j + 1);
+			term *= -xx / ((2 * j + 1) * (2 * j + 2));
+		}
+	}
+
+
+	//!	exp(-2 pi i k / n) as { real, imaginary }, at compile time
+	/*!
+	 *	The angle is reduced exactly, in integers, to within pi/4 of a
+	 *	multiple of pi/2 before the series is summed.
+	 */
+	constexpr std::array<double, 2>
+	Root (const std::size_t k, const std::size_t n)
+	{
+		const long double pi = 3.141592653589793238462643383279502884L;
+
+		const std::size_t r = k % n;
+
+		//	The nearest quarter turn q, and the rest of the angle, 2 pi (4r - qn) / 4n
+		const std::size_t q = (8 * r + n) / (2 * n);
+		const long double rest = 2.L * pi * ((long double)(4 * r) - (long double)(q * n)) / (4.L * (long double)(n));
+
+		long double c = 0.L;
+		long double s = 0.L;
+		SinCos(rest, c, s);
+
+		long double cosine = c;
+		long double sine = s;
+		switch (q % 4) {
+			case 1:	cosine = -s;	sine = c;	break;
+			case 2:	cosine = -c;	sine = -s;	break;
+			case 3:	cosine = s;		sine = -c;	break;
+			default:	break;
+		}
+
+		return {{ double(cosine), double(-sine) }};
+	}
+
+
+	//!	The radix of the first stage of a transform of n: 4 if it divides n, else the smallest prime factor
+	constexpr std::size_t
+	Radix (const std::size_t n)
+	{
+		if (n % 4 == 0)
+			return 4;
+
+		for (std::size_t p = 2; p * p <= n; ++p)
+			if (n % p == 0)
+				return p;
+
+		return n;
+	}
+
+
+	//!	The table of exp(-2 pi i k / N), k < N, interleaved, computed at compile time
+	template <std::size_t N>
+	struct Roots {
+		static constexpr std::array<double, 2 * N>
+		Make (void)
+		{
+			std::array<double, 2 * N> roots {};
+
+			for (std::size_t k = 0; k < N; ++k) {
+				const std::array<double, 2> root = Root(k, N);
+				roots[2 * k] = root[0];
+				roots[2 * k + 1] = root[1];
+			}
+
+			return roots;
+		}
+
+		static constexpr std::array<double, 2 * N> value = Make();
+	};
+
+
+	//!	Complex transforms up to this length are inlined whole into their caller
+	/*!
+	 *	Inlining every level of a long transform would copy each
+	 *	sub-transform once per call site, which for N = 256 is a couple of
+	 *	hundred loops per target and slow to compile for little gain.
+	 */
+	const std::size_t InlineLength = 16;
+
+
+	//!	y[k] = sum_j x[j S] exp(-2 pi i j k / N); x and y interleaved complex, y contiguous
+	/*!
+	 *	Decimation in time: the Radix(N) sequences x[p S + j Radix(N) S]
+	 *	are transformed into consecutive blocks of y, which are then
+	 *	combined in place, one output column k at a time. x and y must not
+	 *	overlap.
+	 *
+	 *	Multiplying by a constant 1 or i cannot be folded away under IEEE
+	 *	rules (0 * x is not 0 for every x), so the butterflies of radix 2
+	 *	and 4 are written out and the twiddles of k = 0 are skipped.
+	 */
+	template <std::size_t N, std::size_t S>
+	struct ComplexDft {
+		//!	Inlined up to InlineLength; longer transforms are functions of their own
+		static WAVEFORM_SIMD_INLINE void
+		Run (const double* x, double* y)
+		{
+			if (N <= InlineLength)
+				Body(x, y);
+			else
+				OutOfLine(x, y);
+		}
+
+
+		static WAVEFORM_SIMD_KERNEL void
+		OutOfLine (const double* x, double* y)
+		{ Body(x, y); }
+
+
+		static WAVEFORM_SIMD_INLINE void
+		Body (const double* x, double* y)
+		{
+			constexpr std::size_t P = Radix(N);
+			constexpr std::size_t M = N / P;
+
+			WAVEFORM_SIMD_UNROLL
+			for (std::size_t p = 0; p < P; ++p)
+				ComplexDft<M, S * P>::Run(x + 2 * S * p, y + 2 * M * p);
+
+			//	k = 0 needs no twiddles; the other columns make a loop without branches
+			Butterfly<false>(y, 0);
+
+			WAVEFORM_SIMD_IVDEP
+			for (std::size_t k = 1; k < M; ++k)
+				Butterfly<true>(y, k);
+		}
+
+
+		//!	Column k of the combining pass, in place
+		template <bool Twiddled>
+		static WAVEFORM_SIMD_INLINE void
+		Butterfly (double* y, const std::size_t k)
+		{
+			constexpr std::size_t P = Radix(N);
+			constexpr std::size_t M = N / P;
+			constexpr const std::array<double, 2 * N>& w = Roots<N>::value;
+
+			double tr[P];
+			double ti[P];
+
+			//	The twiddles w^(pk) of the sub-transforms
+			WAVEFORM_SIMD_UNROLL
+			for (std::size_t p = 0; p < P; ++p) {
+				const double ar = y[2 * (p * M + k)];
+				const double ai = y[2 * (p * M + k) + 1];
+
+				if (p == 0 || !Twiddled) {
+					tr[p] = ar;
+					ti[p] = ai;
+				}
+				else {
+					const double wr = w[2 * p * k];
+					const double wi = w[2 * p * k + 1];
+					tr[p] = ar * wr - ai * wi;
+					ti[p] = ar * wi + ai * wr;
+				}
+			}
+
+			double* out = y + 2 * k;
+
+			if (P == 2) {
+				out[0] = tr[0] + tr[1];
+				out[1] = ti[0] + ti[1];
+				out[2 * M] = tr[0] - tr[1];
+				out[2 * M + 1] = ti[0] - ti[1];
+			}
+			else if (P == 4) {
+				const double ar = tr[0] + tr[2];
+				const double ai = ti[0] + ti[2];
+				const double br = tr[0] - tr[2];
+				const double bi = ti[0] - ti[2];
+				const double cr = tr[1] + tr[3];
+				const double ci = ti[1] + ti[3];
+				const double dr = tr[1] - tr[3];
+				const double di = ti[1] - ti[3];
+
+				//	The roots of 4 are 1, -i, -1, i
+				out[0] = ar + cr;
+				out[1] = ai + ci;
+				out[2 * M] = br + di;
+				out[2 * M + 1] = bi - dr;
+				out[4 * M] = ar - cr;
+				out[4 * M + 1] = ai - ci;
+				out[6 * M] = br - di;
+				out[6 * M + 1] = bi + dr;
+			}
+			else {
+				//	A DFT of the odd prime P, whose roots are w^(M pq)
+				WAVEFORM_SIMD_UNROLL
+				for (std::size_t q = 0; q < P; ++q) {
+					double sr = tr[0];
+					double si = ti[0];
+
+					WAVEFORM_SIMD_UNROLL
+					for (std::size_t p = 1; p < P; ++p) {
+						if (q == 0) {
+							sr += tr[p];
+							si += ti[p];
+						}
+						else {
+							const std::size_t j = (M * p * q) % N;
+							sr += tr[p] * w[2 * j] - ti[p] * w[2 * j + 1];
+							si += tr[p] * w[2 * j + 1] + ti[p] * w[2 * j];
+						}
+					}
+
+					out[2 * q * M] = sr;
+					out[2 * q * M + 1] = si;
+				}
+			}
+		}
+	};
+
+
+	template <std::size_t S>
+	struct ComplexDft<1, S> {
+		static WAVEFORM_SIMD_INLINE void
+		Run (const double* x, double* y)
+		{
+			y[0] = x[0];
+			y[1] = x[1];
+		}
+	};
+
+}	//	namespace Fixed
+
+
+	//!	Normalized r2c/c2r DFT of a compile-time length N, without plans or allocations
+	/*!
+	 *	N must be even. The N samples are transformed as N/2 complex
+	 *	values (even samples as real parts, odd as imaginary) and the
+	 *	spectra of the two halves are separated in one pass, as FFTW's
+	 *	r2c does. The conventions match Fftw3_Dft_1d_Normalized.
+	 *
+	 *	All members are static; FixedWaveform calls Forward() and
+	 *	Inverse() directly.
+	 */
+	template <std::size_t N>
+	class Fixed_Dft_1d_Normalized {
+	  public:
+
+		static_assert(N >= 2 && N % 2 == 0, "Fixed_Dft_1d_Normalized: N must be even");
+
+		typedef InverseTypes::Inverse	inverse_type;
+
+		typedef std::array<double, N>						TimeArray;
+		typedef std::array<std::complex<double>, N / 2 + 1>	FreqArray;
+
+
+		//!	freq = the N/2+1 bins of the DFT of time
+		static WAVEFORM_SIMD_KERNEL void
+		Forward (const TimeArray& time, FreqArray& freq)
+		{
+			constexpr std::size_t H = N / 2;
+			constexpr const std::array<double, N * 2>& w = Fixed::Roots<N>::value;
+
+			//	z[j] = x[2j] + i x[2j+1], which is the time array itself
+			std::array<double, N> z;
+			Fixed::ComplexDft<H, 1>::Run(time.data(), z.data());
+
+			double* X = reinterpret_cast<double*>(freq.data());
+
+			X[0] = z[0] + z[1];
+			X[1] = 0.;
+			X[2 * H] = z[0] - z[1];
+			X[2 * H + 1] = 0.;
+
+			//	X[k] = E[k] + w^k O[k], with E = (Z[k] + conj Z[H-k]) / 2 and O = (Z[k] - conj Z[H-k]) / 2i
+			for (std::size_t k = 1; k < H; ++k) {
+				const double ar = z[2 * k];
+				const double ai = z[2 * k + 1];
+				const double br = z[2 * (H - k)];
+				const double bi = -z[2 * (H - k) + 1];
+
+				const double er = 0.5 * (ar + br);
+				const double ei = 0.5 * (ai + bi);
+				const double or_ = 0.5 * (ai - bi);
+				const double oi = -0.5 * (ar - br);
+
+				const double wr = w[2 * k];
+				const double wi = w[2 * k + 1];
+
+				X[2 * k] = er + wr * or_ - wi * oi;
+				X[2 * k + 1] = ei + wr * oi + wi * or_;
+			}
+		}
+
+
+		//!	time = the inverse of the N/2+1 bins freq, scaled by 1/N
+		static WAVEFORM_SIMD_KERNEL void
+		Inverse (const FreqArray& freq, TimeArray& time)
+		{
+			constexpr std::size_t H = N / 2;
+			constexpr const std::array<double, N * 2>& w = Fixed::Roots<N>::value;
+			constexpr double scale = 1. / double(N);
+
+			const double* X = reinterpret_cast<const double*>(freq.data());
+
+			//	conj(Z[k]) / H, with Z[k] = E[k] + i O[k] rebuilt from X[k] and X[H-k]
+			std::array<double, N> z;
+
+			for (std::size_t k = 0; k < H; ++k) {
+				const double ar = X[2 * k];
+				const double ai = X[2 * k + 1];
+				const double br = X[2 * (H - k)];
+				const double bi = -X[2 * (H - k) + 1];
+
+				const double er = ar + br;
+				const double ei = ai + bi;
+
+				//	(X[k] - conj X[H-k]) w^-k
+				const double dr = ar - br;
+				const double di = ai - bi;
+				const double wr = w[2 * k];
+				const double wi = -w[2 * k + 1];
+				const double or_ = dr * wr - di * wi;
+				const double oi = dr * wi + di * wr;
+
+				z[2 * k] = scale * (er - oi);
+				z[2 * k + 1] = -scale * (ei + or_);
+			}
+
+			//	The inverse of H is conj(DFT(conj Z)); the last conjugate leaves the odd samples negated
+			Fixed::ComplexDft<H, 1>::Run(z.data(), time.data());
+
+			for (std::size_t j = 1; j < N; j += 2)
+				time[j] = -time[j];
+		}
+	};
+
+}	//	namespace Transform
+}	//	namespace Waveform
+
+
+namespace PS {
+
+	//!	FixedWaveform: a Waveform of compile-time length N with inline storage
+	/*!
+	 *	The interface follows Waveform: the domains are validated lazily,
+	 *	the Get* accessors hand out a domain for writing (making the
+	 *	other stale), and the GetConst* accessors fill in a stale domain
+	 *	and leave both valid. The domains are std::array's, so
+	 *
+	 *		PS::FixedWaveform<64> wfm (samples);		// std::array<double, 64>
+	 *		const auto& spectrum = wfm.GetConstFreqSpectrum();	// 33 bins
+	 *
+	 *	makes no allocation, and FixedWaveform is trivially copyable.
+	 *	A default-constructed FixedWaveform is in the Neither state, and
+	 *	reading either domain before one is written throws
+	 *	std::logic_error rather than returning the zeroed arrays.
+	 *
+	 *	TransformT must provide static Forward(const TimeArray&,
+	 *	FreqArray&) and Inverse(const FreqArray&, TimeArray&), as
+	 *	Waveform::Transform::Fixed_Dft_1d_Normalized<N> does.
+	 *
+	 *	TransformStats, TransitionTrace, Edit() and Save/Load only cover
+	 *	PS::Waveform.
+	 */
+	template <std::size_t N, typename TransformT = ::Waveform::Transform::Fixed_Dft_1d_Normalized<N> >
+	class FixedWaveform {
+	  public:
+
+		typedef double					TimeT;
+		typedef std::complex<double>	FreqT;
+
+		typedef std::array<TimeT, N>			TimeContainer;
+		typedef std::array<FreqT, N / 2 + 1>	FreqContainer;
+
+		typedef TransformT	transform_type;
+
+		//!	A domain, as for Waveform
+		enum class Domain {Time, Freq, Either};
+
+		//!	Which domain array(s) currently hold valid data, as for Waveform
+		enum class DomainState {Neither, Time, Freq, Both};
+
+	  private:
+
+		mutable DomainState		state_;
+
+		mutable TimeContainer	timeSeries_;
+
+		mutable FreqContainer	freqSpectrum_;
+
+
+		//!	Fills in a stale domain from the valid one; the state becomes Both
+		void
+		Refresh (const Domain toRead) const
+		{
+			if (state_ == DomainState::Neither)
+				throw std::logic_error("FixedWaveform: a domain was read before either was written");
+
+			if (toRead != Domain::Freq && state_ == DomainState::Freq) {
+				TransformT::Inverse(freqSpectrum_, timeSeries_);
+				state_ = DomainState::Both;
+			}
+			else if (toRead != Domain::Time && state_ == DomainState::Time) {
+				TransformT::Forward(timeSeries_, freqSpectrum_);
+				state_ = DomainState::Both;
+			}
+		}
+
+	  public:
+
+		//!	A FixedWaveform which holds no data yet (Neither)
+		FixedWaveform (void)
+			: state_(DomainState::Neither)
+			, timeSeries_()
+			, freqSpectrum_()
+		{ }
+
+
+		//!	Time domain copy constructor
+		explicit
+		FixedWaveform (const TimeContainer& toCopy)
+			: state_(DomainState::Time)
+			, timeSeries_(toCopy)
+			, freqSpectrum_()
+		{ }
+
+
+		//!	Frequency domain copy constructor
+		explicit
+		FixedWaveform (const FreqContainer& toCopy)
+			: state_(DomainState::Freq)
+			, timeSeries_()
+			, freqSpectrum_(toCopy)
+		{ }
+
+
+		//!	Returns the length of the time domain
+		static constexpr std::size_t
+		size (void)
+		{ return N; }
+
+
+		//!	Returns the domain(s) which currently hold valid data
+		DomainState
+		GetValidDomain (void) const
+		{ return state_; }
+
+
+		bool
+		IsTimeValid (void) const
+		{ return state_ == DomainState::Time || state_ == DomainState::Both; }
+
+
+		bool
+		IsFreqValid (void) const
+		{ return state_ == DomainState::Freq || state_ == DomainState::Both; }
+
+
+		//!	Marks domain(s) as valid without performing any transform
+		void
+		AssumeValidDomain (const DomainState toAssume)
+		{ state_ = toAssume; }
+
+
+		//!	Brings the requested domain up to date; Time or Freq make the other one stale, even from Neither
+		/*!
+		 *	From Neither, Time or Freq hand out a domain to be written and
+		 *	Either does nothing; only reads throw.
+		 */
+		void
+		ValidateDomain (const Domain toValidate)
+		{
+			if (state_ != DomainState::Neither)
+				Refresh(toValidate);
+
+			if (toValidate == Domain::Time)
+				state_ = DomainState::Time;
+			else if (toValidate == Domain::Freq)
+				state_ = DomainState::Freq;
+		}
+
+
+		//!	Returns mutable reference to the time domain; the freq domain becomes stale
+		TimeContainer&
+		GetTimeSeries (void)
+		{ ValidateDomain(Domain::Time); return timeSeries_; }
+
+
+		//!	Returns mutable reference to the freq domain; the time domain becomes stale
+		FreqContainer&
+		GetFreqSpectrum (void)
+		{ ValidateDomain(Domain::Freq); return freqSpectrum_; }
+
+
+		//!	Returns constant reference to the time domain, transforming if it is stale; throws from Neither
+		const TimeContainer&
+		GetConstTimeSeries (void) const
+		{ Refresh(Domain::Time); return timeSeries_; }
+
+
+		//!	Returns constant reference to the freq domain, transforming if it is stale; throws from Neither
+		const FreqContainer&
+		GetConstFreqSpectrum (void) const
+		{ Refresh(Domain::Freq); return freqSpectrum_; }
+
+
+		//!	Returns constant reference to the time domain as stored, without validation
+		const TimeContainer&
+		PeekTimeSeries (void) const
+		{ return timeSeries_; }
+
+
+		//!	Returns constant reference to the freq domain as stored, without validation
+		const FreqContainer&
+		PeekFreqSpectrum (void) const
+		{ return freqSpectrum_; }
+
+
+		//!	Returns mutable reference to the time domain, skipping the transform
+		TimeContainer&
+		OverwriteTimeSeries (void)
+		{ state_ = DomainState::Time; return timeSeries_; }
+
+
+		//!	Returns mutable reference to the freq domain, skipping the transform
+		FreqContainer&
+		OverwriteFreqSpectrum (void)
+		{ state_ = DomainState::Freq; return freqSpectrum_; }
+	};
+
+}	//	namespace PS
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ FreeFunctionSupport.hpp
+ Helpers shared by the free functions which work on a Waveform's domains,
+ such as Envelope() and AnalyticSignal().
+
+ Those which read a Waveform's spectrum bin by bin need it to be an r2c
+ spectrum: N/2+1 bins of std::complex<double> in the Waveform's
+ normalized convention, as Fftw3_Dft_1d_Normalized makes.
+ RequireR2CSpectrum() checks the bin count, so that any other freq
+ domain throws rather than being read past its end.
+ */
+
+#ifndef FREEFUNCTIONSUPPORT_HPP
+#define FREEFUNCTIONSUPPORT_HPP 1
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace PS {
+
+namespace detail {
+
+	//!	Throws std::invalid_argument, naming who, unless wfm's freq domain has N/2+1 bins
+	template <typename WaveformT>
+	void
+	RequireR2CSpectrum (const WaveformT& wfm, const char* who)
+	{
+		if (wfm.PeekFreqSpectrum().size() != wfm.size() / 2 + 1)
+			throw std::invalid_argument(std::string(who) + ": the Waveform's freq domain must be an r2c spectrum of N/2+1 bins");
+	}
+
+
+	//!	A per-thread array of size values, so that repeated calls do not allocate
+	/*!
+	 *	There is one array per thread for each T and Tag. Tag is an empty
+	 *	struct naming the user, so that two functions whose arrays are in
+	 *	use at the same time (one calling the other) never share one. The
+	 *	array keeps its capacity between calls, and its contents are
+	 *	unspecified.
+	 */
+	template <typename T, typename Tag>
+	std::vector<T>&
+	ThreadScratch (const std::size_t size)
+	{
+		thread_local std::vector<T> scratch;
+		scratch.resize(size);
+		return scratch;
+	}
+
+}	//	namespace detail
+
+}	//	namespace PS
+
+#endif
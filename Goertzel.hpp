@@ -0,0 +1,164 @@
+/*
+ Goertzel.hpp
+ A few bins of a Waveform's spectrum without computing all N/2+1 of them.
+
+ The Goertzel recurrence for bin k (w = 2 pi k / N),
+
+	s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2],		X[k] = s[N] - exp(-i w) s[N-1]
+
+ (with x[N] = 0) costs one multiply and two adds per sample and bin, so
+ for a handful of bins it is cheaper than a full FFT, and it needs no
+ memory beyond two values per bin. Bins are run in groups of
+ GoertzelLanes, interleaved in one pass over the samples, so that the
+ recurrences of a group fill a SIMD register and the samples are read
+ once per group rather than once per bin.
+ */
+
+#ifndef GOERTZEL_HPP
+#define GOERTZEL_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+
+#include <FreeFunctionSupport.hpp>
+
+
+namespace PS {
+
+	//!	How GetBins() computes bins which are not already available
+	enum class BinMethod {
+		Auto,		//!< Whichever GoertzelIsCheaper() picks
+		Goertzel,	//!< Always the Goertzel recurrence over the time domain
+		Fft			//!< Always the full spectrum, which then stays cached in the Waveform
+	};
+
+
+	//!	Bins run together in one pass over the samples
+	const std::size_t GoertzelLanes = 4;
+
+
+	//!	The cost model of BinMethod::Auto: true if Goertzel beats an r2c FFT of n samples
+	/*!
+	 *	Goertzel costs about 3 flops per sample and bin. An r2c FFT costs
+	 *	about 2.5 n log2(n) flops (FFTW's own estimate), but it writes
+	 *	and reads an array of n/2+1 complex values while Goertzel reads
+	 *	the samples once per group of bins, which is counted as a factor
+	 *	of 2 in Goertzel's favour. Past about 5/3 log2(n) bins the FFT
+	 *	wins (33 bins at n = 2^20).
+	 */
+	inline bool
+	GoertzelIsCheaper (const std::size_t n, const std::size_t bins)
+	{
+		if (n < 2)
+			return true;
+
+		const double goertzel = 3. * double(n) * double(bins);
+		const double fft = 2.5 * double(n) * std::log2(double(n)) * 2.;
+
+		return goertzel < fft;
+	}
+
+
+namespace detail {
+
+	//!	out[j] = bin indices[first + j] of x[0, n), for count <= GoertzelLanes bins
+	template <typename IndexContainer, typename ComplexContainer>
+	void
+	GoertzelGroup (const double* x, const std::size_t n
+				, const IndexContainer& indices, const std::size_t first, const std::size_t count
+				, ComplexContainer& out)
+	{
+		const double pi = std::acos(-1.);
+		const std::size_t L = GoertzelLanes;
+
+		double coeff[L] = {};
+		double s1[L] = {};
+		double s2[L] = {};
+
+		for (std::size_t j = 0; j < count; ++j)
+			coeff[j] = 2. * std::cos(2. * pi * double(indices[first + j]) / double(n));
+
+		//	Unused lanes run on zero coefficients and are discarded
+		for (std::size_t i = 0; i < n; ++i) {
+			const double xi = x[i];
+
+			for (std::size_t j = 0; j < L; ++j) {
+				const double s0 = xi + coeff[j] * s1[j] - s2[j];
+				s2[j] = s1[j];
+				s1[j] = s0;
+			}
+		}
+
+		for (std::size_t j = 0; j < count; ++j) {
+			const double w = 2. * pi * double(indices[first + j]) / double(n);
+
+			//	One more step with x[n] = 0
+			const double sN = coeff[j] * s1[j] - s2[j];
+
+			out[first + j] = std::complex<double>(sN - std::cos(w) * s1[j], std::sin(w) * s1[j]);
+		}
+	}
+
+}	//	namespace detail
+
+
+	//!	Writes bin indices[j] of x[0, n)'s DFT (unnormalized, as FFTW's r2c) to out[j]
+	template <typename IndexContainer, typename ComplexContainer>
+	void
+	Goertzel (const double* x, const std::size_t n, const IndexContainer& indices, ComplexContainer& out)
+	{
+		out.resize(indices.size());
+
+		for (std::size_t first = 0; first < indices.size(); first += GoertzelLanes) {
+			const std::size_t count = std::min(GoertzelLanes, indices.size() - first);
+			detail::GoertzelGroup(x, n, indices, first, count, out);
+		}
+	}
+
+
+	//!	Writes bins indices[j] of wfm's spectrum to out[j] (resized to indices.size())
+	/*!
+	 *	If the spectrum is valid, the bins are read from it. Otherwise
+	 *	they are computed from the time domain, either by Goertzel or by
+	 *	the full transform (whose spectrum then stays cached in wfm), as
+	 *	method says; BinMethod::Auto asks GoertzelIsCheaper().
+	 *
+	 *	wfm must hold an r2c spectrum (see FreeFunctionSupport.hpp), and
+	 *	every index must be at most N/2.
+	 */
+	template <typename WaveformT, typename IndexContainer, typename ComplexContainer>
+	void
+	GetBins (const WaveformT& wfm, const IndexContainer& indices, ComplexContainer& out
+			, const BinMethod method = BinMethod::Auto)
+	{
+		detail::RequireR2CSpectrum(wfm, "GetBins");
+
+		const std::size_t n = wfm.size();
+
+		for (std::size_t j = 0; j < indices.size(); ++j)
+			if (std::size_t(indices[j]) > n / 2)
+				throw std::out_of_range("GetBins: bin index past N/2");
+
+		const bool useGoertzel = !wfm.IsFreqValid()
+							  && (method == BinMethod::Goertzel
+								  || (method == BinMethod::Auto && GoertzelIsCheaper(n, indices.size())));
+
+		if (useGoertzel) {
+			Goertzel(&(*wfm.GetConstTimeSeries().begin()), n, indices, out);
+			return;
+		}
+
+		const auto& spectrum = wfm.GetConstFreqSpectrum();
+
+		out.resize(indices.size());
+		for (std::size_t j = 0; j < indices.size(); ++j)
+			out[j] = spectrum[indices[j]];
+	}
+
+}	//	namespace PS
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ HalfComplex.hpp
+ A real spectrum container in FFTW's "halfcomplex" order, for use as the
+ FreqContainer of a Waveform with Fftw3_R2HC_1d_Normalized.
+
+ The spectrum of N real samples is stored as N reals instead of N/2+1
+ complex values:
+
+	r0, r1, r2, ..., r(N/2), i((N+1)/2 - 1), ..., i2, i1
+
+ where rk and ik are the real and imaginary parts of bin k. The imaginary
+ parts of bin 0 and (for even N) bin N/2 are always zero and not stored.
+ See http://www.fftw.org/doc/The-Halfcomplex_002dformat-DFT.html
+ */
+
+#ifndef HALFCOMPLEX_HPP
+#define HALFCOMPLEX_HPP 1
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+
+namespace PS {
+
+	//!	HalfComplexVector: N reals holding the N/2+1 bins of a real signal's spectrum
+	/*!
+	 *	It is a std::vector<T> (so the raw layout is available through the
+	 *	usual interface) with accessors which understand the layout. It is
+	 *	a distinct type so that a Waveform using it can tell its time and
+	 *	freq domain constructors apart.
+	 */
+	template <typename T, typename Allocator = std::allocator<T> >
+	class HalfComplexVector : public std::vector<T, Allocator> {
+	  private:
+
+		typedef std::vector<T, Allocator>	Base;
+
+	  public:
+
+		using Base::Base;
+
+		HalfComplexVector (void) = default;
+
+
+		//!	The number of frequency bins, N/2+1
+		std::size_t
+		bins (void) const
+		{ return this->size() / 2 + 1; }
+
+
+		//!	True if bin k has a stored imaginary part
+		bool
+		has_imag (const std::size_t k) const
+		{ return k != 0 && 2 * k != this->size(); }
+
+
+		//!	Real part of bin k, for k < bins()
+		T
+		real (const std::size_t k) const
+		{ return (*this)[k]; }
+
+
+		//!	Imaginary part of bin k, for k < bins(); zero for DC and Nyquist
+		T
+		imag (const std::size_t k) const
+		{ return has_imag(k) ? (*this)[this->size() - k] : T(); }
+
+
+		//!	Bin k as a complex value
+		std::complex<T>
+		bin (const std::size_t k) const
+		{ return std::complex<T>(real(k), imag(k)); }
+
+
+		//!	Sets bin k
+		/*!
+		 *	The imaginary part of DC and Nyquist cannot be stored (it is
+		 *	always zero for the spectrum of a real signal) and is ignored.
+		 */
+		void
+		set_bin (const std::size_t k, const std::complex<T>& value)
+		{
+			(*this)[k] = value.real();
+
+			if (has_imag(k))
+				(*this)[this->size() - k] = value.imag();
+		}
+
+
+		//!	Copies the bins into a container of N/2+1 complex values (r2c layout)
+		template <typename ComplexContainer>
+		void
+		to_complex (ComplexContainer& out) const
+		{
+			out.resize(bins());
+
+			for (std::size_t k = 0; k < bins(); ++k)
+				out[k] = bin(k);
+		}
+	};
+
+
+
+	//
+	//	Filters over the half-complex layout
+	//
+	//	Bin k has its real part at index k and its imaginary part at N-k,
+	//	so each operation is one forward loop over the real parts and one
+	//	over the imaginary parts, with no complex arithmetic where the
+	//	filter is real.
+	//
+
+	//!	Bin k *= gain[k] for a real gain per bin (gain.size() == x.bins())
+	template <typename T, typename A, typename RealContainer>
+	void
+	ApplyGain (HalfComplexVector<T, A>& x, const RealContainer& gain)
+	{
+		if (gain.size() != x.bins())
+			throw std::length_error("HalfComplexVector: ApplyGain() needs one gain per bin");
+
+		const std::size_t n = x.size();
+		T* v = x.data();
+		const T* g = &(*gain.begin());
+
+		for (std::size_t k = 0; k <= n / 2; ++k)
+			v[k] *= g[k];
+
+		for (std::size_t k = 1; 2 * k < n; ++k)
+			v[n - k] *= g[k];
+	}
+
+
+	//!	Bin k *= h[k] for a complex response per bin (h.size() == x.bins())
+	template <typename T, typename A, typename ComplexContainer>
+	void
+	Multiply (HalfComplexVector<T, A>& x, const ComplexContainer& h)
+	{
+		if (h.size() != x.bins())
+			throw std::length_error("HalfComplexVector: Multiply() needs one value per bin");
+
+		const std::size_t n = x.size();
+		T* v = x.data();
+
+		//	DC and Nyquist are real, so only the real part of h applies
+		v[0] *= std::real(h[0]);
+		if (n % 2 == 0)
+			v[n / 2] *= std::real(h[n / 2]);
+
+		for (std::size_t k = 1; 2 * k < n; ++k) {
+			const T re = v[k];
+			const T im = v[n - k];
+			const T hr = std::real(h[k]);
+			const T hi = std::imag(h[k]);
+
+			v[k] = re * hr - im * hi;
+			v[n - k] = re * hi + im * hr;
+		}
+	}
+
+
+	//!	out[k] = |bin k|; out is resized to x.bins()
+	template <typename T, typename A, typename RealContainer>
+	void
+	Magnitude (const HalfComplexVector<T, A>& x, RealContainer& out)
+	{
+		out.resize(x.bins());
+
+		const std::size_t n = x.size();
+		const T* v = x.data();
+
+		for (std::size_t k = 0; k < x.bins(); ++k)
+			out[k] = std::abs(v[k]);
+
+		for (std::size_t k = 1; 2 * k < n; ++k)
+			out[k] = std::sqrt(v[k] * v[k] + v[n - k] * v[n - k]);
+	}
+
+}	//	namespace PS
+
+#endif
@@ -0,0 +1,275 @@
+/*
+ Hilbert.hpp
+ The analytic signal and envelope of a real signal: a TransformT for
+ Waveform (Fftw3_Analytic_1d), and free functions which work from the
+ spectrum a Waveform already holds (AnalyticSignal(), Envelope()).
+
+ For a real signal x of even length N with r2c spectrum X, the analytic
+ signal is z = x + i H(x), with spectrum
+
+	Z[0] = X[0],  Z[k] = 2 X[k] for 0 < k < N/2,  Z[N/2] = X[N/2],  Z[k] = 0 above,
+
+ and the envelope is |z| = sqrt(x^2 + H(x)^2).
+ */
+
+#ifndef HILBERT_HPP
+#define HILBERT_HPP 1
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fftw3.h>
+#include <boost/range.hpp>
+
+#include <TransformTypes.hpp>
+#include <FftwPlanCache.hpp>
+#include <FreeFunctionSupport.hpp>
+
+
+namespace Waveform {
+
+namespace Transform {
+
+//!	Transform between a real signal and its analytic signal
+/*!
+ *	The "freq" domain of a Waveform using this transform holds the N
+ *	complex samples of the analytic signal rather than a spectrum:
+ *
+ *		typedef PS::Waveform< std::vector<double>, std::vector< std::complex<double> >
+ *							, Waveform::Transform::Fftw3_Analytic_1d > AnalyticWaveform;
+ *
+ *	The forward transform is one r2c straight into the output array, one
+ *	pass which masks and scales the bins in place, and one in-place
+ *	inverse c2c; no other buffer is used. The inverse takes the real part,
+ *	which recovers the signal exactly.
+ */
+class Fftw3_Analytic_1d {
+  public:
+	typedef InverseTypes::Inverse inverse_type;
+
+	//!	The analytic signal has as many samples as the real one
+	static std::size_t
+	freq_length (std::size_t timeLength)
+	{ return timeLength; }
+
+	static std::size_t
+	time_length (std::size_t freqLength)
+	{ return freqLength; }
+
+  private:
+
+	double*					time_;
+	std::complex<double>*	analytic_;
+	std::size_t				length_;
+
+	fftw_plan 				forwardPlan;
+	fftw_plan 				inversePlan;
+
+  public:
+
+	//!	Iterator bounds constructor
+	template <typename Iterator1, typename Iterator2>
+	Fftw3_Analytic_1d (Iterator1 first1, Iterator1 last1, Iterator2 first2)
+		: time_(&(*first1))
+		, analytic_(&(*first2))
+		, length_(std::distance(first1, last1))
+		, forwardPlan( fftw_plan_dft_r2c_1d ( length_
+											, time_
+											, reinterpret_cast<fftw_complex*>(analytic_)
+											, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT) )
+		, inversePlan( fftw_plan_dft_1d ( length_
+										, reinterpret_cast<fftw_complex*>(analytic_)
+										, reinterpret_cast<fftw_complex*>(analytic_)
+										, FFTW_BACKWARD
+										, FFTW_ESTIMATE) )
+	{ }
+
+
+	//!	Boost::range constructor (Random Access Range)
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	Fftw3_Analytic_1d (RandomAccessRange1& range1, RandomAccessRange2& range2)
+		: Fftw3_Analytic_1d(boost::begin(range1), boost::end(range1), boost::begin(range2))
+	{ }
+
+
+	//!	Not copyable: the plans are bound to the arrays they were made for
+	Fftw3_Analytic_1d (const Fftw3_Analytic_1d& to_copy) = delete;
+
+	Fftw3_Analytic_1d&
+	operator= (const Fftw3_Analytic_1d& rhs) = delete;
+
+
+	//!	Move constructor, taking over the plans of to_move
+	Fftw3_Analytic_1d (Fftw3_Analytic_1d&& to_move)
+		: time_(to_move.time_)
+		, analytic_(to_move.analytic_)
+		, length_(to_move.length_)
+		, forwardPlan(to_move.forwardPlan)
+		, inversePlan(to_move.inversePlan)
+	{
+		to_move.forwardPlan = nullptr;
+		to_move.inversePlan = nullptr;
+	}
+
+
+	//!	Move assignment, implemented by swapping plans
+	Fftw3_Analytic_1d&
+	operator= (Fftw3_Analytic_1d&& rhs)
+	{
+		swap(*this, rhs);
+		return *this;
+	}
+
+
+	friend void
+	swap (Fftw3_Analytic_1d& first, Fftw3_Analytic_1d& second)
+	{
+		using std::swap;
+		swap(first.time_, second.time_);
+		swap(first.analytic_, second.analytic_);
+		swap(first.length_, second.length_);
+		swap(first.forwardPlan, second.forwardPlan);
+		swap(first.inversePlan, second.inversePlan);
+	}
+
+
+	~Fftw3_Analytic_1d (void)
+	{
+		if (forwardPlan)
+			fftw_destroy_plan(forwardPlan);
+		if (inversePlan)
+			fftw_destroy_plan(inversePlan);
+	}
+
+	void
+	exec_transform (void)
+	{
+		fftw_execute(forwardPlan);
+
+		//	Mask the negative frequencies and fold in the 1/N of the inverse
+		const double scale = 1. / double(length_);
+		const std::size_t half = length_ / 2;
+
+		analytic_[0] *= scale;
+		for (std::size_t k = 1; k < half; ++k)
+			analytic_[k] *= 2. * scale;
+		analytic_[half] *= scale;
+		for (std::size_t k = half + 1; k < length_; ++k)
+			analytic_[k] = 0.;
+
+		fftw_execute(inversePlan);
+	}
+
+	void
+	exec_inverse_transform (void)
+	{
+		for (std::size_t i = 0; i < length_; ++i)
+			time_[i] = analytic_[i].real();
+	}
+};
+
+
+}	//	namespace Transform
+}	//	namespace Waveform
+
+
+
+namespace PS {
+
+namespace detail {
+
+	struct HilbertScratchTag {};
+
+}	//	namespace detail
+
+
+	//!	Writes the N samples of the analytic signal of wfm into out
+	/*!
+	 *	The spectrum is read with GetConstFreqSpectrum(), so a spectrum
+	 *	which is already valid is used as it is (otherwise it is computed
+	 *	once and stays cached in wfm). The bins are masked and scaled while
+	 *	being copied into out, and one in-place inverse FFT (from
+	 *	FftwPlanCache) produces the result.
+	 *
+	 *	wfm must hold an r2c spectrum (see FreeFunctionSupport.hpp).
+	 */
+	template <typename WaveformT, typename ComplexContainer>
+	void
+	AnalyticSignal (const WaveformT& wfm, ComplexContainer& out)
+	{
+		detail::RequireR2CSpectrum(wfm, "Hilbert");
+
+		const std::size_t n = wfm.size();
+		const std::size_t half = n / 2;
+		const auto& spectrum = wfm.GetConstFreqSpectrum();
+
+		out.resize(n);
+		std::complex<double>* z = &(*out.begin());
+
+		//	The 1/N of the inverse is folded into the mask
+		const double scale = 1. / double(n);
+
+		z[0] = scale * spectrum[0];
+		for (std::size_t k = 1; k < half; ++k)
+			z[k] = (2. * scale) * spectrum[k];
+		z[half] = scale * spectrum[half];
+		for (std::size_t k = half + 1; k < n; ++k)
+			z[k] = 0.;
+
+		::Waveform::Transform::FftwPlanCache::ExecuteC2C(n, FFTW_BACKWARD, z, z);
+	}
+
+
+	//!	Writes the envelope |x + i H(x)| of wfm's time series into out (N reals)
+	/*!
+	 *	Both domains of wfm are read through the Const accessors, so at
+	 *	most one transform of wfm is run (none if both are valid), and its
+	 *	result stays cached.
+	 *
+	 *	The Hilbert transform H(x) is real, so it is computed with a c2r
+	 *	of N/2+1 bins straight into out: the bins are multiplied by -i
+	 *	(and the DC and Nyquist bins dropped) while being copied into a
+	 *	reused per-thread scratch array, which the c2r consumes. A final
+	 *	pass replaces out[i] with hypot(x[i], out[i]). No complex array of
+	 *	N values is ever made.
+	 *
+	 *	The same requirements on wfm as for AnalyticSignal() apply.
+	 */
+	template <typename WaveformT, typename RealContainer>
+	void
+	Envelope (const WaveformT& wfm, RealContainer& out)
+	{
+		detail::RequireR2CSpectrum(wfm, "Hilbert");
+
+		const std::size_t n = wfm.size();
+		const std::size_t half = n / 2;
+		const auto& spectrum = wfm.GetConstFreqSpectrum();
+		const auto& x = wfm.GetConstTimeSeries();
+
+		std::vector< std::complex<double> >& scratch = detail::ThreadScratch<std::complex<double>, detail::HilbertScratchTag>(half + 1);
+
+		scratch[0] = 0.;
+		for (std::size_t k = 1; k < half; ++k)
+			scratch[k] = std::complex<double>(spectrum[k].imag(), -spectrum[k].real());
+		scratch[half] = 0.;
+
+		out.resize(n);
+		double* h = &(*out.begin());
+
+		::Waveform::Transform::FftwPlanCache::ExecuteC2R(n, scratch.data(), h);
+
+		const double scale = 1. / double(n);
+		for (std::size_t i = 0; i < n; ++i) {
+			const double hi = h[i] * scale;
+			h[i] = std::sqrt(x[i] * x[i] + hi * hi);
+		}
+	}
+
+}	//	namespace PS
+
+#endif
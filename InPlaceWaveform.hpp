@@ -0,0 +1,218 @@
+/*
+ InPlaceWaveform.hpp
+ A Waveform variant whose time and freq domains share a single buffer,
+ for records so large that holding both domains at once is too costly.
+ */
+
+#ifndef INPLACEWAVEFORM_HPP
+#define INPLACEWAVEFORM_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <TransformTypes.hpp>
+#include <Span.hpp>
+
+
+namespace PS {
+
+	//!	InPlaceWaveform: one buffer, interpreted as either domain
+	/*!
+	 *	The buffer holds N/2+1 complex values, which is 2*(N/2+1) doubles:
+	 *	the freq domain is the whole buffer, and the time domain is its
+	 *	first N doubles (the layout FFTW uses for in-place r2c transforms).
+	 *	Compared with a Waveform of vectors this halves the memory, and an
+	 *	in-place transform touches half as many cache lines.
+	 *
+	 *	Because the two domains overwrite each other, only one is ever
+	 *	valid. Accessing the other runs the transform in place and the
+	 *	previously valid domain is gone: there are no "Const" accessors
+	 *	which keep both, and alternating between the domains costs a
+	 *	transform every time.
+	 *
+	 *	TransformT is constructed with a Span<double> over the time domain
+	 *	and a Span<std::complex<double>> over the freq domain, which start
+	 *	at the same address; Waveform::Transform::Fftw3_Dft_1d_InPlace_Normalized
+	 *	plans for exactly this. It must be a true inverse pair, as for
+	 *	Waveform.
+	 *
+	 *	TransformStats and TransitionTrace only cover PS::Waveform.
+	 */
+	template <typename TransformT>
+	class InPlaceWaveform {
+	  public:
+
+		typedef double					TimeT;
+		typedef std::complex<double>	FreqT;
+
+		//!	A domain, as passed to ValidateDomain()
+		enum class Domain {Time, Freq};
+
+		//!	The domain whose data the buffer currently holds
+		/*!
+		 *	Neither is the state of an InPlaceWaveform made from a length
+		 *	only: either domain may be written without a transform.
+		 */
+		enum class DomainState {Neither, Time, Freq};
+
+	  private:
+
+		std::size_t			length_;
+
+		DomainState			state_;
+
+		//!	The shared storage; std::complex<double> is layout-compatible with double[2]
+		std::vector<FreqT>	buffer_;
+
+		//!	The two interpretations of buffer_; moving buffer_ does not move its storage
+		Span<TimeT>			timeView_;
+		Span<FreqT>			freqView_;
+
+		TransformT			transform_;
+
+
+		static std::size_t
+		CheckedLength (const std::size_t length)
+		{
+			if (length % 2)
+				throw std::length_error("InPlaceWaveform: The array length was not a multiple of 2!");
+			return length;
+		}
+
+
+	  public:
+
+		InPlaceWaveform (void) = delete;
+
+
+		//!	Fill constructor; the Waveform holds no data yet (Neither)
+		explicit
+		InPlaceWaveform (const std::size_t count)
+			: length_(CheckedLength(count))
+			, state_(DomainState::Neither)
+			, buffer_(count / 2 + 1)
+			, timeView_(reinterpret_cast<TimeT*>(buffer_.data()), length_)
+			, freqView_(buffer_.data(), buffer_.size())
+			, transform_(timeView_, freqView_)
+		{ }
+
+
+		//!	Time domain copy constructor
+		explicit
+		InPlaceWaveform (const std::vector<TimeT>& toCopy)
+			: InPlaceWaveform(toCopy.size())
+		{
+			std::copy(toCopy.begin(), toCopy.end(), timeView_.begin());
+			state_ = DomainState::Time;
+		}
+
+
+		//!	Frequency domain copy constructor
+		explicit
+		InPlaceWaveform (const std::vector<FreqT>& toCopy)
+			: InPlaceWaveform((toCopy.size() - 1) * 2)
+		{
+			std::copy(toCopy.begin(), toCopy.end(), buffer_.begin());
+			state_ = DomainState::Freq;
+		}
+
+
+		//!	Copy constructor; plans anew over the copied buffer
+		InPlaceWaveform (const InPlaceWaveform& toCopy)
+			: length_(toCopy.length_)
+			, state_(toCopy.state_)
+			, buffer_(toCopy.buffer_)
+			, timeView_(reinterpret_cast<TimeT*>(buffer_.data()), length_)
+			, freqView_(buffer_.data(), buffer_.size())
+			, transform_(timeView_, freqView_)
+		{ }
+
+
+		//!	Move constructor; the moved buffer keeps its address, so the plans stay valid
+		InPlaceWaveform (InPlaceWaveform&& rhs)
+			: length_(rhs.length_)
+			, state_(rhs.state_)
+			, buffer_(std::move(rhs.buffer_))
+			, timeView_(rhs.timeView_)
+			, freqView_(rhs.freqView_)
+			, transform_(std::move(rhs.transform_))
+		{ }
+
+
+		//!	Copy-and-swap assignment, as for Waveform
+		InPlaceWaveform&
+		operator= (InPlaceWaveform rhs)
+		{
+			swap(*this, rhs);
+			return *this;
+		}
+
+
+		friend void
+		swap (InPlaceWaveform& first, InPlaceWaveform& second)
+		{
+			using std::swap;
+			swap(first.length_, second.length_);
+			swap(first.state_, second.state_);
+			swap(first.buffer_, second.buffer_);
+			swap(first.timeView_, second.timeView_);
+			swap(first.freqView_, second.freqView_);
+			swap(first.transform_, second.transform_);
+		}
+
+
+		//!	Returns the length of the time domain
+		std::size_t
+		size (void) const
+		{ return length_; }
+
+
+		//!	Returns the domain whose data the buffer holds
+		DomainState
+		GetValidDomain (void) const
+		{ return state_; }
+
+
+		//!	Size in bytes of the shared buffer
+		std::size_t
+		BufferBytes (void) const
+		{ return buffer_.size() * sizeof(FreqT); }
+
+
+		//!	Transforms in place if needed, so that the buffer holds the requested domain
+		/*!
+		 *	From Neither no transform is run. Afterwards only toValidate is
+		 *	valid.
+		 */
+		void
+		ValidateDomain (const Domain toValidate)
+		{
+			if (toValidate == Domain::Time && state_ == DomainState::Freq)
+				transform_.exec_inverse_transform();
+			else if (toValidate == Domain::Freq && state_ == DomainState::Time)
+				transform_.exec_transform();
+
+			state_ = toValidate == Domain::Time ? DomainState::Time : DomainState::Freq;
+		}
+
+
+		//!	The time domain (N reals), transforming in place if the freq domain is valid
+		Span<TimeT>
+		GetTimeSeries (void)
+		{ ValidateDomain(Domain::Time); return timeView_; }
+
+
+		//!	The freq domain (N/2+1 bins), transforming in place if the time domain is valid
+		Span<FreqT>
+		GetFreqSpectrum (void)
+		{ ValidateDomain(Domain::Freq); return freqView_; }
+	};
+
+}	//	namespace PS
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ MappedFile.hpp
+ Read-only memory mapping of a whole file (POSIX mmap).
+ */
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP 1
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace PS {
+
+	//!	MappedFile: maps a file read-only into memory for the lifetime of the object
+	/*!
+	 *	The pages are only read from disk when touched, so mapping a large
+	 *	file is cheap and the parsers can work directly on the file's bytes
+	 *	without staging them through a stream buffer.
+	 *
+	 *	An empty file is represented by data() == nullptr and size() == 0.
+	 */
+	class MappedFile {
+	  private:
+
+		const char*		data_;
+		std::size_t		size_;
+
+	  public:
+
+		//!	Maps the named file; throws std::runtime_error if it cannot be opened
+		explicit
+		MappedFile (const std::string& fileName)
+			: data_(nullptr)
+			, size_(0)
+		{
+			const int fd = ::open(fileName.c_str(), O_RDONLY);
+
+			if (fd < 0)
+				throw std::runtime_error("MappedFile: could not open " + fileName);
+
+			struct stat info;
+
+			if (::fstat(fd, &info) != 0) {
+				::close(fd);
+				throw std::runtime_error("MappedFile: could not stat " + fileName);
+			}
+
+			size_ = static_cast<std::size_t>(info.st_size);
+
+			if (size_) {
+				void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+				if (mapped == MAP_FAILED) {
+					::close(fd);
+					throw std::runtime_error("MappedFile: could not map " + fileName);
+				}
+
+				::madvise(mapped, size_, MADV_SEQUENTIAL);
+				data_ = static_cast<const char*>(mapped);
+			}
+
+			//	The mapping stays valid after the descriptor is closed
+			::close(fd);
+		}
+
+		MappedFile (const MappedFile&) = delete;
+
+		MappedFile& operator= (const MappedFile&) = delete;
+
+		MappedFile (MappedFile&& rhs)
+			: data_(rhs.data_)
+			, size_(rhs.size_)
+		{
+			rhs.data_ = nullptr;
+			rhs.size_ = 0;
+		}
+
+		MappedFile&
+		operator= (MappedFile&& rhs)
+		{
+			std::swap(data_, rhs.data_);
+			std::swap(size_, rhs.size_);
+			return *this;
+		}
+
+		~MappedFile (void)
+		{
+			if (data_)
+				::munmap(const_cast<char*>(data_), size_);
+		}
+
+
+		//!	Returns a pointer to the first byte of the file
+		const char*
+		data (void) const
+		{ return data_; }
+
+
+		//!	Returns the length of the file in bytes
+		std::size_t
+		size (void) const
+		{ return size_; }
+	};
+
+}	//	namespace PS
+
+#endif
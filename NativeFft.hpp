@@ -0,0 +1,960 @@
+/*
+ NativeFft.hpp
+ A self-contained FFT, for builds which cannot link FFTW: the TransformT
+ Native_Dft_1d_Normalized is a drop-in replacement for
+ Fftw3_Dft_1d_Normalized (same domains, same conventions) which uses
+ nothing but the standard library.
+
+ The engine is a mixed-radix Stockham FFT (radix 4, 2, 3 and a generic
+ odd radix for any other prime factor). Each stage reads one array and
+ writes the other, so no bit reversal pass is needed, and the innermost
+ loop of every stage after the first runs with unit stride over
+ interleaved complex values, which the compiler vectorizes. Long
+ transforms are cache-blocked with the four-step algorithm (see Plan), so
+ that the data crosses memory twice rather than once per stage.
+
+ A real transform of even length N runs as a complex transform of N/2
+ (the even and odd samples as real and imaginary parts) followed by one
+ pass which separates the two spectra; odd lengths run as a complex
+ transform of N. All twiddle factors are computed once per length and
+ shared through a process-wide cache.
+
+ With GCC on x86-64 Linux each kernel is compiled for AVX-512, AVX2 with
+ FMA and baseline SSE2, and the loader picks the one the CPU supports
+ (see SimdDispatch.hpp, which also covers WAVEFORM_NO_DISPATCH and the
+ optimization level the kernels expect).
+
+ Lengths with a large prime factor p cost O(N p) rather than
+ O(N log N).
+ */
+
+#ifndef NATIVEFFT_HPP
+#define NATIVEFFT_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <boost/range.hpp>
+
+#include <SimdDispatch.hpp>
+#include <TransformTypes.hpp>
+
+
+namespace Waveform {
+
+namespace Transform {
+
+namespace NativeFft {
+
+	/*
+		One stage of radix P takes sub-transforms of length n = P m, s of
+		them interleaved: input value r of butterfly (p, q) is
+		x[q + s (p + r m)], and output t goes to y[q + s (P p + t)] after
+		multiplying by w^(p t), w = exp(-2 pi i / n). The twiddles of a
+		stage are held as twr[(t-1) m + p] and twi[(t-1) m + p] for
+		t = 1 ... P-1.
+
+		The first stage reads the caller's interleaved complex array
+		(re, im, re, im, ...) and the last writes one, but the stages in
+		between work on split arrays (all the real parts, then all the
+		imaginary parts), so that every butterfly is plain arithmetic on
+		whole SIMD registers with no shuffling. The template parameters I
+		and O are the distance between successive real parts of the input
+		and the output: 2 for interleaved, 1 for split. Complex products
+		are written out by hand, as std::complex multiplication checks for
+		infinities and NaNs, which keeps loops from vectorizing.
+
+		The first stage has s = 1 and runs its loop over p instead, which
+		is the one with unit stride there.
+	 */
+
+	template <std::size_t I, std::size_t O>
+	WAVEFORM_SIMD_INLINE void
+	Butterfly2 (const double* __restrict xr, const double* __restrict xi, const std::size_t a, const std::size_t da
+				, double* __restrict yr, double* __restrict yi, const std::size_t b, const std::size_t db
+				, const double wr, const double wi)
+	{
+		const double ar = xr[I * a], ai = xi[I * a];
+		const double br = xr[I * (a + da)], bi = xi[I * (a + da)];
+
+		yr[O * b] = ar + br;
+		yi[O * b] = ai + bi;
+
+		const double dr = ar - br, di = ai - bi;
+		yr[O * (b + db)] = dr * wr - di * wi;
+		yi[O * (b + db)] = dr * wi + di * wr;
+	}
+
+
+	template <std::size_t I, std::size_t O>
+	WAVEFORM_SIMD_INLINE void
+	Butterfly3 (const double* __restrict xr, const double* __restrict xi, const std::size_t a, const std::size_t da
+				, double* __restrict yr, double* __restrict yi, const std::size_t b, const std::size_t db
+				, const double w1r, const double w1i, const double w2r, const double w2i)
+	{
+		//	sin(2 pi / 3)
+		const double c = 0.86602540378443864676;
+
+		const double ar = xr[I * a], ai = xi[I * a];
+		const double br = xr[I * (a + da)], bi = xi[I * (a + da)];
+		const double cr = xr[I * (a + 2 * da)], ci = xi[I * (a + 2 * da)];
+
+		const double sr = br + cr, si = bi + ci;
+		const double dr = br - cr, di = bi - ci;
+
+		yr[O * b] = ar + sr;
+		yi[O * b] = ai + si;
+
+		//	a + w3 b + w3^2 c, and its mirror, with w3 = -1/2 - i sin(2 pi / 3)
+		const double tr = ar - 0.5 * sr, ti = ai - 0.5 * si;
+		const double b1r = tr + c * di, b1i = ti - c * dr;
+		const double b2r = tr - c * di, b2i = ti + c * dr;
+
+		yr[O * (b + db)] = b1r * w1r - b1i * w1i;
+		yi[O * (b + db)] = b1r * w1i + b1i * w1r;
+		yr[O * (b + 2 * db)] = b2r * w2r - b2i * w2i;
+		yi[O * (b + 2 * db)] = b2r * w2i + b2i * w2r;
+	}
+
+
+	template <std::size_t I, std::size_t O>
+	WAVEFORM_SIMD_INLINE void
+	Butterfly4 (const double* __restrict xr, const double* __restrict xi, const std::size_t a, const std::size_t da
+				, double* __restrict yr, double* __restrict yi, const std::size_t b, const std::size_t db
+				, const double w1r, const double w1i, const double w2r, const double w2i
+				, const double w3r, const double w3i)
+	{
+		const double ar = xr[I * a], ai = xi[I * a];
+		const double br = xr[I * (a + da)], bi = xi[I * (a + da)];
+		const double cr = xr[I * (a + 2 * da)], ci = xi[I * (a + 2 * da)];
+		const double dr = xr[I * (a + 3 * da)], di = xi[I * (a + 3 * da)];
+
+		const double u0r = ar + cr, u0i = ai + ci;
+		const double u1r = ar - cr, u1i = ai - ci;
+		const double u2r = br + dr, u2i = bi + di;
+		const double u3r = br - dr, u3i = bi - di;
+
+		yr[O * b] = u0r + u2r;
+		yi[O * b] = u0i + u2i;
+
+		//	b1 = u1 - i u3, b2 = u0 - u2, b3 = u1 + i u3
+		const double b1r = u1r + u3i, b1i = u1i - u3r;
+		const double b2r = u0r - u2r, b2i = u0i - u2i;
+		const double b3r = u1r - u3i, b3i = u1i + u3r;
+
+		yr[O * (b + db)] = b1r * w1r - b1i * w1i;
+		yi[O * (b + db)] = b1r * w1i + b1i * w1r;
+		yr[O * (b + 2 * db)] = b2r * w2r - b2i * w2i;
+		yi[O * (b + 2 * db)] = b2r * w2i + b2i * w2r;
+		yr[O * (b + 3 * db)] = b3r * w3r - b3i * w3i;
+		yi[O * (b + 3 * db)] = b3r * w3i + b3i * w3r;
+	}
+
+
+	template <std::size_t I, std::size_t O>
+	WAVEFORM_SIMD_INLINE void
+	Radix2Stage (const double* __restrict xr, const double* __restrict xi, double* __restrict yr, double* __restrict yi
+				, const std::size_t m, const std::size_t s, const double* __restrict twr, const double* __restrict twi)
+	{
+		if (s == 1) {
+			WAVEFORM_SIMD_IVDEP
+			for (std::size_t p = 0; p < m; ++p)
+				Butterfly2<I, O>(xr, xi, p, m, yr, yi, 2 * p, 1, twr[p], twi[p]);
+			return;
+		}
+
+		for (std::size_t p = 0; p < m; ++p) {
+			const double wr = twr[p], wi = twi[p];
+
+			WAVEFORM_SIMD_IVDEP
+			for (std::size_t q = 0; q < s; ++q)
+				Butterfly2<I, O>(xr, xi, q + s * p, s * m, yr, yi, q + 2 * s * p, s, wr, wi);
+		}
+	}
+
+
+	template <std::size_t I, std::size_t O>
+	WAVEFORM_SIMD_INLINE void
+	Radix3Stage (const double* __restrict xr, const double* __restrict xi, double* __restrict yr, double* __restrict yi
+				, const std::size_t m, const std::size_t s, const double* __restrict twr, const double* __restrict twi)
+	{
+		if (s == 1) {
+			WAVEFORM_SIMD_IVDEP
+			for (std::size_t p = 0; p < m; ++p)
+				Butterfly3<I, O>(xr, xi, p, m, yr, yi, 3 * p, 1, twr[p], twi[p], twr[m + p], twi[m + p]);
+			return;
+		}
+
+		for (std::size_t p = 0; p < m; ++p) {
+			const double w1r = twr[p], w1i = twi[p];
+			const double w2r = twr[m + p], w2i = twi[m + p];
+
+			WAVEFORM_SIMD_IVDEP
+			for (std::size_t q = 0; q < s; ++q)
+				Butterfly3<I, O>(xr, xi, q + s * p, s * m, yr, yi, q + 3 * s * p, s, w1r, w1i, w2r, w2i);
+		}
+	}
+
+
+	template <std::size_t I, std::size_t O>
+	WAVEFORM_SIMD_INLINE void
+	Radix4Stage (const double* __restrict xr, const double* __restrict xi, double* __restrict yr, double* __restrict yi
+				, const std::size_t m, const std::size_t s, const double* __restrict twr, const double* __restrict twi)
+	{
+		if (s == 1) {
+			WAVEFORM_SIMD_IVDEP
+			for (std::size_t p = 0; p < m; ++p)
+				Butterfly4<I, O>(xr, xi, p, m, yr, yi, 4 * p, 1
+								, twr[p], twi[p], twr[m + p], twi[m + p], twr[2 * m + p], twi[2 * m + p]);
+			return;
+		}
+
+		for (std::size_t p = 0; p < m; ++p) {
+			const double w1r = twr[p], w1i = twi[p];
+			const double w2r = twr[m + p], w2i = twi[m + p];
+			const double w3r = twr[2 * m + p], w3i = twi[2 * m + p];
+
+			WAVEFORM_SIMD_IVDEP
+			for (std::size_t q = 0; q < s; ++q)
+				Butterfly4<I, O>(xr, xi, q + s * p, s * m, yr, yi, q + 4 * s * p, s
+								, w1r, w1i, w2r, w2i, w3r, w3i);
+		}
+	}
+
+
+	//	The compiled kernels, one per radix, for each combination of interleaved and split arrays
+
+	inline WAVEFORM_SIMD_KERNEL void
+	Radix2 (const double* xr, const double* xi, const std::size_t in
+			, double* yr, double* yi, const std::size_t out
+			, const std::size_t m, const std::size_t s, const double* twr, const double* twi)
+	{
+		if (in == 2)
+			out == 2 ? Radix2Stage<2, 2>(xr, xi, yr, yi, m, s, twr, twi) : Radix2Stage<2, 1>(xr, xi, yr, yi, m, s, twr, twi);
+		else
+			out == 2 ? Radix2Stage<1, 2>(xr, xi, yr, yi, m, s, twr, twi) : Radix2Stage<1, 1>(xr, xi, yr, yi, m, s, twr, twi);
+	}
+
+
+	inline WAVEFORM_SIMD_KERNEL void
+	Radix3 (const double* xr, const double* xi, const std::size_t in
+			, double* yr, double* yi, const std::size_t out
+			, const std::size_t m, const std::size_t s, const double* twr, const double* twi)
+	{
+		if (in == 2)
+			out == 2 ? Radix3Stage<2, 2>(xr, xi, yr, yi, m, s, twr, twi) : Radix3Stage<2, 1>(xr, xi, yr, yi, m, s, twr, twi);
+		else
+			out == 2 ? Radix3Stage<1, 2>(xr, xi, yr, yi, m, s, twr, twi) : Radix3Stage<1, 1>(xr, xi, yr, yi, m, s, twr, twi);
+	}
+
+
+	inline WAVEFORM_SIMD_KERNEL void
+	Radix4 (const double* xr, const double* xi, const std::size_t in
+			, double* yr, double* yi, const std::size_t out
+			, const std::size_t m, const std::size_t s, const double* twr, const double* twi)
+	{
+		if (in == 2)
+			out == 2 ? Radix4Stage<2, 2>(xr, xi, yr, yi, m, s, twr, twi) : Radix4Stage<2, 1>(xr, xi, yr, yi, m, s, twr, twi);
+		else
+			out == 2 ? Radix4Stage<1, 2>(xr, xi, yr, yi, m, s, twr, twi) : Radix4Stage<1, 1>(xr, xi, yr, yi, m, s, twr, twi);
+	}
+
+
+	//!	A stage of any radix P, directly: roots holds exp(-2 pi i k / P) for k < P, a holds 2 P doubles of scratch
+	inline void
+	RadixGeneric (const double* xr, const double* xi, const std::size_t in
+				, double* yr, double* yi, const std::size_t out
+				, const std::size_t radix, const std::size_t m, const std::size_t s
+				, const double* twr, const double* twi
+				, const double* rootr, const double* rooti, double* a)
+	{
+		for (std::size_t p = 0; p < m; ++p)
+			for (std::size_t q = 0; q < s; ++q) {
+				for (std::size_t r = 0; r < radix; ++r) {
+					a[2 * r] = xr[in * (q + s * (p + r * m))];
+					a[2 * r + 1] = xi[in * (q + s * (p + r * m))];
+				}
+
+				for (std::size_t t = 0; t < radix; ++t) {
+					double br = 0.;
+					double bi = 0.;
+					std::size_t k = 0;
+
+					for (std::size_t r = 0; r < radix; ++r) {
+						br += a[2 * r] * rootr[k] - a[2 * r + 1] * rooti[k];
+						bi += a[2 * r] * rooti[k] + a[2 * r + 1] * rootr[k];
+
+						k += t;
+						if (k >= radix)
+							k -= radix;
+					}
+
+					const std::size_t j = out * (q + s * (radix * p + t));
+
+					if (t == 0) {
+						yr[j] = br;
+						yi[j] = bi;
+					} else {
+						const double wr = twr[(t - 1) * m + p], wi = twi[(t - 1) * m + p];
+						yr[j] = br * wr - bi * wi;
+						yi[j] = br * wi + bi * wr;
+					}
+				}
+			}
+	}
+
+
+	//!	Copies a block of width columns, starting at src, of a matrix with rows of stride values into dst (rows x width)
+	inline WAVEFORM_SIMD_KERNEL void
+	GatherColumns (const double* __restrict src, double* __restrict dst
+				, const std::size_t rows, const std::size_t stride, const std::size_t width)
+	{
+		for (std::size_t r = 0; r < rows; ++r)
+			for (std::size_t i = 0; i < 2 * width; ++i)
+				dst[2 * r * width + i] = src[2 * r * stride + i];
+	}
+
+
+	//!	The reverse of GatherColumns, multiplying by the matching block of tw (of the same stride) if given
+	inline WAVEFORM_SIMD_KERNEL void
+	ScatterColumns (const double* __restrict src, double* __restrict dst
+				, const std::size_t rows, const std::size_t stride, const std::size_t width
+				, const double* __restrict tw)
+	{
+		for (std::size_t r = 0; r < rows; ++r) {
+			const double* x = src + 2 * r * width;
+			double* y = dst + 2 * r * stride;
+
+			if (!tw) {
+				for (std::size_t i = 0; i < 2 * width; ++i)
+					y[i] = x[i];
+				continue;
+			}
+
+			const double* w = tw + 2 * r * stride;
+			for (std::size_t i = 0; i < 2 * width; i += 2) {
+				y[i] = x[i] * w[i] - x[i + 1] * w[i + 1];
+				y[i + 1] = x[i] * w[i + 1] + x[i + 1] * w[i];
+			}
+		}
+	}
+
+
+	//!	dst[j width + b] = src[b stride + j]: width rows of length values, interleaved
+	inline WAVEFORM_SIMD_KERNEL void
+	GatherRows (const double* __restrict src, double* __restrict dst
+				, const std::size_t length, const std::size_t stride, const std::size_t width)
+	{
+		for (std::size_t j = 0; j < length; ++j)
+			for (std::size_t b = 0; b < width; ++b) {
+				dst[2 * (j * width + b)] = src[2 * (b * stride + j)];
+				dst[2 * (j * width + b) + 1] = src[2 * (b * stride + j) + 1];
+			}
+	}
+
+
+	//!	exp(-2 pi i k / n), with k reduced modulo n first
+	inline std::complex<double>
+	Root (const std::size_t k, const std::size_t n)
+	{
+		const double pi = 3.14159265358979323846;
+		return std::polar(1., -2. * pi * double(k % n) / double(n));
+	}
+
+
+	//!	Per-thread scratch of at least count doubles
+	/*!
+	 *	Slots 0 and 3 are the real transforms' work arrays, 1 and 4 the
+	 *	four-step batches and 2 the generic radix's, so that none is
+	 *	resized while another is in use.
+	 */
+	inline double*
+	Scratch (const std::size_t count, const int which)
+	{
+		thread_local std::vector<double> scratch[5];
+		if (scratch[which].size() < count)
+			scratch[which].resize(count);
+		return scratch[which].data();
+	}
+
+
+	//!	Complex transforms longer than this many values use the four-step algorithm
+	/*!
+	 *	The Stockham passes stream the whole array once per stage, which
+	 *	is cheap while it stays in the last level cache; 2^22 values
+	 *	(64 MiB with the work array) is past that on most machines. The
+	 *	threshold is a parameter of Plan, so the crossover on another
+	 *	machine can be found by timing both.
+	 */
+	const std::size_t FourStepLength = std::size_t(1) << 22;
+
+
+	//!	A forward complex transform of one length (unnormalized, exp(-2 pi i j k / n))
+	/*!
+	 *	Short lengths run the Stockham stages over the whole array. Long
+	 *	ones use the four-step algorithm: with the input seen as a matrix
+	 *	of rows_ x columns_, x[j1 + columns_ j2], the columns are
+	 *	transformed and multiplied by twiddles, then the rows, and the
+	 *	result comes out transposed, X[k2 + rows_ k1]. Both passes copy a
+	 *	few columns or rows at a time into a batch small enough for the
+	 *	cache and transform them together as interleaved arrays, so the
+	 *	whole array is only read and written twice, and every stage runs
+	 *	its inner loop over the batch with unit stride.
+	 */
+	class Plan {
+	  private:
+
+		struct Stage {
+			std::size_t		radix;
+			std::size_t		m;
+			std::size_t		s;
+
+			//!	Offsets of the stage's twiddles and (for the generic radix) roots
+			std::size_t		twiddles;
+			std::size_t		roots;
+		};
+
+		std::size_t				length_;
+		std::vector<Stage>		stages_;
+
+		//!	Real and imaginary parts of every stage's twiddles and (for the generic radix) roots
+		std::vector<double>		twiddleReal_;
+		std::vector<double>		twiddleImag_;
+		std::vector<double>		rootReal_;
+		std::vector<double>		rootImag_;
+
+		//!	The four-step split, length_ = rows_ columns_, when rowPlan_ is set
+		std::size_t				rows_;
+		std::size_t				columns_;
+		std::size_t				batch_;
+		std::unique_ptr<Plan>	rowPlan_;
+		std::unique_ptr<Plan>	columnPlan_;
+
+		//!	exp(-2 pi i j1 k2 / length_) at [j1 + columns_ k2]
+		std::vector<double>		blockTwiddles_;
+
+
+		static std::vector<std::size_t>
+		Factor (std::size_t n)
+		{
+			std::vector<std::size_t> factors;
+
+			while (n % 4 == 0) {
+				factors.push_back(4);
+				n /= 4;
+			}
+			if (n % 2 == 0) {
+				factors.push_back(2);
+				n /= 2;
+			}
+			for (std::size_t p = 3; p * p <= n; p += 2)
+				while (n % p == 0) {
+					factors.push_back(p);
+					n /= p;
+				}
+			if (n > 1)
+				factors.push_back(n);
+
+			return factors;
+		}
+
+
+		void
+		MakeStages (void)
+		{
+			const std::vector<std::size_t> factors = Factor(length_);
+
+			std::size_t n = length_;
+			std::size_t s = 1;
+
+			for (const std::size_t radix : factors) {
+				const std::size_t m = n / radix;
+
+				Stage stage = { radix, m, s, twiddleReal_.size(), rootReal_.size() };
+
+				for (std::size_t t = 1; t < radix; ++t)
+					for (std::size_t p = 0; p < m; ++p) {
+						const std::complex<double> w = Root(p * t, n);
+						twiddleReal_.push_back(w.real());
+						twiddleImag_.push_back(w.imag());
+					}
+
+				if (radix > 4)
+					for (std::size_t k = 0; k < radix; ++k) {
+						const std::complex<double> w = Root(k, radix);
+						rootReal_.push_back(w.real());
+						rootImag_.push_back(w.imag());
+					}
+
+				stages_.push_back(stage);
+
+				n = m;
+				s *= radix;
+			}
+		}
+
+
+		//!	Splits the length for the four-step algorithm, or returns false if it has no useful split
+		bool
+		MakeFourStep (void)
+		{
+			std::size_t columns = 1;
+			for (const std::size_t factor : Factor(length_)) {
+				if (columns * columns >= length_)
+					break;
+				columns *= factor;
+			}
+
+			const std::size_t rows = length_ / columns;
+			if (rows < 16 || columns < 16)
+				return false;
+
+			rows_ = rows;
+			columns_ = columns;
+
+			//	About 128 kB per batch array
+			batch_ = std::max<std::size_t>(4, std::min<std::size_t>(16, 8192 / std::max(rows_, columns_)));
+
+			rowPlan_.reset(new Plan(columns_, 0));
+			columnPlan_.reset(new Plan(rows_, 0));
+
+			blockTwiddles_.resize(2 * length_);
+			for (std::size_t k = 0; k < rows_; ++k)
+				for (std::size_t j = 0; j < columns_; ++j) {
+					const std::complex<double> w = Root(j * k, length_);
+					blockTwiddles_[2 * (j + columns_ * k)] = w.real();
+					blockTwiddles_[2 * (j + columns_ * k) + 1] = w.imag();
+				}
+
+			return true;
+		}
+
+
+		//!	Runs one stage from x to y, each of count complex values, interleaved if its flag is set
+		void
+		RunStage (const Stage& stage, const double* x, const bool xInterleaved, double* y, const bool yInterleaved
+				, const std::size_t count, const std::size_t batch) const
+		{
+			const double* xi = xInterleaved ? x + 1 : x + count;
+			double* yi = yInterleaved ? y + 1 : y + count;
+			const std::size_t in = xInterleaved ? 2 : 1;
+			const std::size_t out = yInterleaved ? 2 : 1;
+
+			const double* twr = twiddleReal_.data() + stage.twiddles;
+			const double* twi = twiddleImag_.data() + stage.twiddles;
+			const std::size_t s = stage.s * batch;
+
+			switch (stage.radix) {
+				case 2:
+					Radix2(x, xi, in, y, yi, out, stage.m, s, twr, twi);
+					break;
+				case 3:
+					Radix3(x, xi, in, y, yi, out, stage.m, s, twr, twi);
+					break;
+				case 4:
+					Radix4(x, xi, in, y, yi, out, stage.m, s, twr, twi);
+					break;
+				default:
+					RadixGeneric(x, xi, in, y, yi, out, stage.radix, stage.m, s, twr, twi
+								, rootReal_.data() + stage.roots, rootImag_.data() + stage.roots
+								, Scratch(2 * stage.radix, 2));
+			}
+		}
+
+
+		void
+		ExecuteFourStep (const double* src, double* dst, double* work) const
+		{
+			const std::size_t size = 2 * batch_ * std::max(rows_, columns_);
+			double* a = Scratch(size, 1);
+			double* b = Scratch(size, 4);
+
+			//	Columns, into work with the twiddles
+			for (std::size_t first = 0; first < columns_; first += batch_) {
+				const std::size_t width = std::min(batch_, columns_ - first);
+
+				double* in = columnPlan_->Staging(a, b);
+				GatherColumns(src + 2 * first, in, rows_, columns_, width);
+				columnPlan_->Execute(in, a, b, width);
+				ScatterColumns(a, work + 2 * first, rows_, columns_, width, blockTwiddles_.data() + 2 * first);
+			}
+
+			//	Rows, each batch written out as columns of dst
+			for (std::size_t first = 0; first < rows_; first += batch_) {
+				const std::size_t width = std::min(batch_, rows_ - first);
+
+				double* in = rowPlan_->Staging(a, b);
+				GatherRows(work + 2 * first * columns_, in, columns_, columns_, width);
+				rowPlan_->Execute(in, a, b, width);
+				ScatterColumns(a, dst + 2 * first, columns_, rows_, width, nullptr);
+			}
+		}
+
+	  public:
+
+		//!	Plans a transform of n complex values, cache-blocked if n is longer than fourStepLength
+		/*!
+		 *	fourStepLength == 0 never blocks. The rows and columns of a
+		 *	four-step plan are planned that way, as they share one set of
+		 *	batch arrays.
+		 */
+		explicit
+		Plan (const std::size_t n, const std::size_t fourStepLength = FourStepLength)
+			: length_(n)
+			, rows_(0)
+			, columns_(0)
+			, batch_(1)
+		{
+			if (fourStepLength == 0 || length_ <= fourStepLength || !MakeFourStep())
+				MakeStages();
+		}
+
+
+		std::size_t
+		size (void) const
+		{ return length_; }
+
+
+		//!	Where to put the input of Execute(src, dst, work) when it cannot be left where it is
+		/*!
+		 *	Execute() first writes to whichever of dst and work this does
+		 *	not return, so src must not be that array.
+		 */
+		double*
+		Staging (double* dst, double* work) const
+		{
+			if (rowPlan_)
+				return dst;
+			return stages_.size() % 2 ? work : dst;
+		}
+
+
+		//!	dst = the transform of src, n complex values each; work is n complex values of scratch
+		/*!
+		 *	src is only read, and may be Staging(dst, work). For a plan which
+		 *	is not blocked, batch transforms may be run at once on
+		 *	arrays of batch interleaved inputs, x[b + batch j].
+		 */
+		void
+		Execute (const double* src, double* dst, double* work, const std::size_t batch = 1) const
+		{
+			if (rowPlan_) {
+				ExecuteFourStep(src, dst, work);
+				return;
+			}
+
+			if (stages_.empty()) {
+				if (src != dst)
+					std::copy(src, src + 2 * length_ * batch, dst);
+				return;
+			}
+
+			//	The stages alternate between dst and work, ending in dst; only src and dst are interleaved
+			const std::size_t last = stages_.size() - 1;
+			const double* x = src;
+
+			for (std::size_t i = 0; i <= last; ++i) {
+				double* y = (last - i) % 2 ? work : dst;
+				RunStage(stages_[i], x, i == 0, y, i == last, length_ * batch, batch);
+				x = y;
+			}
+		}
+	};
+
+
+	//!	A normalized r2c / c2r pair of one length, in FFTW's r2c layout
+	class RealPlan {
+	  private:
+
+		std::size_t				length_;
+		Plan					complex_;
+
+		//!	exp(-2 pi i k / length_) for k <= length_/4, for even lengths
+		std::vector<double>		twiddles_;
+
+	  public:
+
+		explicit
+		RealPlan (const std::size_t n)
+			: length_(n)
+			, complex_(n % 2 ? n : n / 2)
+		{
+			if (length_ % 2 == 0)
+				for (std::size_t k = 0; k <= length_ / 4; ++k) {
+					const std::complex<double> w = Root(k, length_);
+					twiddles_.push_back(w.real());
+					twiddles_.push_back(w.imag());
+				}
+		}
+
+
+		std::size_t
+		size (void) const
+		{ return length_; }
+
+
+		//!	X[0, n/2] = the spectrum of x[0, n), unnormalized
+		void
+		Forward (const double* x, std::complex<double>* spectrum) const
+		{
+			double* X = reinterpret_cast<double*>(spectrum);
+			const std::size_t h = length_ / 2;
+
+			if (length_ % 2) {
+				double* out = Scratch(2 * length_, 0);
+				double* work = Scratch(2 * length_, 3);
+				double* in = complex_.Staging(out, work);
+
+				for (std::size_t i = 0; i < length_; ++i) {
+					in[2 * i] = x[i];
+					in[2 * i + 1] = 0.;
+				}
+
+				complex_.Execute(in, out, work);
+				std::copy(out, out + 2 * (h + 1), X);
+				return;
+			}
+
+			//	The even and odd samples, as the real and imaginary parts of h values
+			complex_.Execute(x, X, Scratch(2 * h, 0));
+
+			//	Separate the two spectra: X[k] = E[k] + w^k O[k] and X[h-k] = conj(E[k] - w^k O[k])
+			const double z0r = X[0], z0i = X[1];
+
+			for (std::size_t k = 1; 2 * k <= h; ++k) {
+				const std::size_t j = h - k;
+
+				const double ar = X[2 * k], ai = X[2 * k + 1];
+				const double br = X[2 * j], bi = -X[2 * j + 1];
+
+				const double er = 0.5 * (ar + br), ei = 0.5 * (ai + bi);
+
+				//	O = -i (a - b) / 2
+				const double or_ = 0.5 * (ai - bi), oi = -0.5 * (ar - br);
+
+				//	w^k for k <= h/2, from the table of k <= n/4
+				const double wr = twiddles_[2 * k], wi = twiddles_[2 * k + 1];
+				const double tr = wr * or_ - wi * oi, ti = wr * oi + wi * or_;
+
+				X[2 * k] = er + tr;
+				X[2 * k + 1] = ei + ti;
+				X[2 * j] = er - tr;
+				X[2 * j + 1] = -(ei - ti);
+			}
+
+			X[0] = z0r + z0i;
+			X[1] = 0.;
+			X[2 * h] = z0r - z0i;
+			X[2 * h + 1] = 0.;
+		}
+
+
+		//!	x[0, n) = the inverse of X[0, n/2], divided by n; X is not changed
+		void
+		Inverse (const std::complex<double>* spectrum, double* x) const
+		{
+			const double* X = reinterpret_cast<const double*>(spectrum);
+			const std::size_t h = length_ / 2;
+			const double scale = 1. / double(length_);
+
+			//	The inverse is run as a forward transform of the conjugate
+			if (length_ % 2) {
+				double* out = Scratch(2 * length_, 0);
+				double* work = Scratch(2 * length_, 3);
+				double* in = complex_.Staging(out, work);
+
+				for (std::size_t k = 0; k <= h; ++k) {
+					in[2 * k] = X[2 * k] * scale;
+					in[2 * k + 1] = -X[2 * k + 1] * scale;
+				}
+				for (std::size_t k = h + 1; k < length_; ++k) {
+					in[2 * k] = X[2 * (length_ - k)] * scale;
+					in[2 * k + 1] = X[2 * (length_ - k) + 1] * scale;
+				}
+
+				complex_.Execute(in, out, work);
+
+				for (std::size_t i = 0; i < length_; ++i)
+					x[i] = out[2 * i];
+				return;
+			}
+
+			double* work = Scratch(2 * h, 0);
+			double* in = complex_.Staging(x, work);
+
+			//	Z[k] = E[k] + i O[k], E = (X[k] + conj X[h-k]) / 2, O = conj(w^k) (X[k] - conj X[h-k]) / 2
+			for (std::size_t k = 0; k < h; ++k) {
+				const std::size_t j = h - k;
+
+				const double ar = X[2 * k], ai = X[2 * k + 1];
+				const double br = X[2 * j], bi = -X[2 * j + 1];
+
+				const double er = ar + br, ei = ai + bi;
+				const double dr = ar - br, di = ai - bi;
+
+				//	conj(w^k), from the table of k <= n/4 using w^(h-k) = -conj(w^k)
+				double wr, wi;
+				if (k <= length_ / 4) {
+					wr = twiddles_[2 * k];
+					wi = -twiddles_[2 * k + 1];
+				} else {
+					wr = -twiddles_[2 * j];
+					wi = -twiddles_[2 * j + 1];
+				}
+
+				const double orr = wr * dr - wi * di, oi = wr * di + wi * dr;
+
+				//	conj(E + i O) / h, with the 1/2s
+				in[2 * k] = (er - oi) * scale;
+				in[2 * k + 1] = -(ei + orr) * scale;
+			}
+
+			complex_.Execute(in, x, work);
+
+			//	The transform of conj(Z) is conj(x_even + i x_odd)
+			for (std::size_t i = 1; i < length_; i += 2)
+				x[i] = -x[i];
+		}
+	};
+
+
+	//!	Process-wide cache of RealPlans by length
+	class PlanCache {
+	  private:
+
+		std::mutex												mutex_;
+		std::map< std::size_t, std::shared_ptr<const RealPlan> >	plans_;
+
+
+		static PlanCache&
+		Get (void)
+		{
+			static PlanCache cache;
+			return cache;
+		}
+
+	  public:
+
+		static std::shared_ptr<const RealPlan>
+		Find (const std::size_t n)
+		{
+			PlanCache& cache = Get();
+			std::lock_guard<std::mutex> lock (cache.mutex_);
+
+			auto found = cache.plans_.find(n);
+			if (found == cache.plans_.end())
+				found = cache.plans_.emplace(n, std::make_shared<const RealPlan>(n)).first;
+
+			return found->second;
+		}
+
+
+		static std::size_t
+		Size (void)
+		{
+			PlanCache& cache = Get();
+			std::lock_guard<std::mutex> lock (cache.mutex_);
+			return cache.plans_.size();
+		}
+	};
+
+}	//	namespace NativeFft
+
+
+//!	Normalized r2c/c2r transform which needs no FFTW
+/*!
+ *	The same transform as Fftw3_Dft_1d_Normalized: N real samples to
+ *	N/2+1 complex bins, unscaled forward and scaled by 1/N on the
+ *	inverse, which leaves the spectrum unchanged. Swapping one for the
+ *	other in a Waveform typedef changes nothing else:
+ *
+ *		typedef PS::Waveform< std::vector<double>, std::vector< std::complex<double> >
+ *							, Waveform::Transform::Native_Dft_1d_Normalized > NativeWaveform;
+ *
+ *	The plan of each length is made once (only twiddle tables, no
+ *	measuring) and shared by every transform of that length.
+ */
+class Native_Dft_1d_Normalized {
+  public:
+	typedef InverseTypes::Inverse inverse_type;
+
+	static const bool spectral_product_is_convolution = true;
+
+  private:
+
+	double*					time_;
+	std::complex<double>*	freq_;
+	std::shared_ptr<const NativeFft::RealPlan>	plan_;
+
+  public:
+
+	//!	Iterator bounds constructor
+	template <typename Iterator1, typename Iterator2>
+	Native_Dft_1d_Normalized (Iterator1 first1, Iterator1 last1, Iterator2 first2)
+		: time_(&(*first1))
+		, freq_(&(*first2))
+		, plan_(NativeFft::PlanCache::Find(std::distance(first1, last1)))
+	{ }
+
+
+	//!	Boost::range constructor (Random Access Range)
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	Native_Dft_1d_Normalized (RandomAccessRange1& range1, RandomAccessRange2& range2)
+		: Native_Dft_1d_Normalized(boost::begin(range1), boost::end(range1), boost::begin(range2))
+	{ }
+
+
+	//!	Not copyable: the transform is bound to the arrays it was made for
+	Native_Dft_1d_Normalized (const Native_Dft_1d_Normalized& to_copy) = delete;
+
+	Native_Dft_1d_Normalized&
+	operator= (const Native_Dft_1d_Normalized& rhs) = delete;
+
+
+	//!	Move constructor
+	Native_Dft_1d_Normalized (Native_Dft_1d_Normalized&& to_move) = default;
+
+	//!	Move assignment, implemented by swapping
+	Native_Dft_1d_Normalized&
+	operator= (Native_Dft_1d_Normalized&& rhs)
+	{
+		swap(*this, rhs);
+		return *this;
+	}
+
+
+	friend void
+	swap (Native_Dft_1d_Normalized& first, Native_Dft_1d_Normalized& second)
+	{
+		using std::swap;
+		swap(first.time_, second.time_);
+		swap(first.freq_, second.freq_);
+		swap(first.plan_, second.plan_);
+	}
+
+
+	void
+	exec_transform (void)
+	{
+		plan_->Forward(time_, freq_);
+	}
+
+	void
+	exec_inverse_transform (void)
+	{
+		plan_->Inverse(freq_, time_);
+	}
+};
+
+}	//	namespace Transform
+}	//	namespace Waveform
+
+#endif
@@ -0,0 +1,641 @@
+/*
+ NpyFile.hpp
+ NumPy ".npy" and stored (uncompressed) ".npz" files for exchanging Waveform domains with Python.
+ */
+
+#ifndef NPYFILE_HPP
+#define NPYFILE_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <Crc32.hpp>
+#include <MappedFile.hpp>
+
+/*
+	The .npy format (version 1.0) is described at
+	https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+
+		"\x93NUMPY", major version 1, minor version 0,
+		little-endian uint16 length of the header text,
+		header text: a Python dict literal such as
+			{'descr': '<f8', 'fortran_order': False, 'shape': (1024,), }
+		padded with spaces and a final '\n' so that the data starts on a
+		64-byte boundary,
+		the raw array data in C order.
+
+	A .npz file is a zip archive of .npy files. Only stored (method 0)
+	entries are written or read, which is what numpy.savez produces; the
+	zip64 extensions are not supported, so each entry must be under 4 GiB.
+
+	Only little-endian hosts are supported, so that views can point
+	straight into the mapped file.
+ */
+
+
+namespace PS {
+
+namespace detail {
+
+	//!	NumPy dtype strings for the supported element types
+	template <typename T> struct NpyDescr;
+
+	template <> struct NpyDescr<float>					{ static const char* Get (void) { return "<f4"; } };
+	template <> struct NpyDescr<double>					{ static const char* Get (void) { return "<f8"; } };
+	template <> struct NpyDescr< std::complex<float> >	{ static const char* Get (void) { return "<c8"; } };
+	template <> struct NpyDescr< std::complex<double> >	{ static const char* Get (void) { return "<c16"; } };
+	template <> struct NpyDescr<std::int8_t>			{ static const char* Get (void) { return "|i1"; } };
+	template <> struct NpyDescr<std::uint8_t>			{ static const char* Get (void) { return "|u1"; } };
+	template <> struct NpyDescr<std::int16_t>			{ static const char* Get (void) { return "<i2"; } };
+	template <> struct NpyDescr<std::uint16_t>			{ static const char* Get (void) { return "<u2"; } };
+	template <> struct NpyDescr<std::int32_t>			{ static const char* Get (void) { return "<i4"; } };
+	template <> struct NpyDescr<std::uint32_t>			{ static const char* Get (void) { return "<u4"; } };
+	template <> struct NpyDescr<std::int64_t>			{ static const char* Get (void) { return "<i8"; } };
+	template <> struct NpyDescr<std::uint64_t>			{ static const char* Get (void) { return "<u8"; } };
+
+
+	inline void
+	RequireLittleEndianHost (void)
+	{
+		const std::uint16_t probe = 1;
+		unsigned char firstByte;
+		std::memcpy(&firstByte, &probe, 1);
+
+		if (firstByte != 1)
+			throw std::runtime_error("NpyFile: big-endian hosts are not supported");
+	}
+
+
+	//!	Returns the complete .npy header (magic through padding) for a 1-D array
+	template <typename T>
+	std::string
+	MakeNpyHeader (std::size_t count)
+	{
+		std::string dict = std::string("{'descr': '") + NpyDescr<T>::Get()
+						 + "', 'fortran_order': False, 'shape': ("
+						 + std::to_string(count) + ",), }";
+
+		//	Pad with spaces so that magic + length + dict + '\n' is a multiple of 64
+		const std::size_t unpadded = 10 + dict.size() + 1;
+		dict.append((64 - unpadded % 64) % 64, ' ');
+		dict.push_back('\n');
+
+		std::string header ("\x93NUMPY\x01\x00", 8);
+		header.push_back(static_cast<char>(dict.size() & 0xFF));
+		header.push_back(static_cast<char>(dict.size() >> 8));
+		return header + dict;
+	}
+
+
+	//!	Returns the value following 'key': in a .npy header dict
+	inline std::string
+	NpyHeaderValue (const std::string& dict, const std::string& key)
+	{
+		const std::size_t keyPos = dict.find("'" + key + "'");
+
+		if (keyPos == std::string::npos)
+			throw std::runtime_error("NpyFile: header has no '" + key + "' entry");
+
+		const std::size_t colon = dict.find(':', keyPos);
+		if (colon == std::string::npos)
+			throw std::runtime_error("NpyFile: malformed header");
+
+		const std::size_t first = dict.find_first_not_of(' ', colon + 1);
+		if (first == std::string::npos)
+			throw std::runtime_error("NpyFile: malformed header");
+
+		//	Values are a quoted string, a tuple, or a bare word
+		std::size_t last;
+		if (dict[first] == '\'')
+			last = dict.find('\'', first + 1);
+		else if (dict[first] == '(')
+			last = dict.find(')', first);
+		else
+			last = dict.find_first_of(",}", first);
+
+		if (last == std::string::npos)
+			throw std::runtime_error("NpyFile: malformed header");
+
+		//	The closing quote or parenthesis is part of the value
+		if (dict[first] == '\'' || dict[first] == '(')
+			++last;
+
+		return dict.substr(first, last - first);
+	}
+
+
+	//!	Parses a .npy header in [data, data + size); returns the offset of the array data
+	inline std::size_t
+	ParseNpyHeader (const char* data, std::size_t size, std::string& descr, std::vector<std::size_t>& shape)
+	{
+		if (size < 10 || std::memcmp(data, "\x93NUMPY", 6) != 0)
+			throw std::runtime_error("NpyFile: not a .npy file");
+
+		const unsigned char major = static_cast<unsigned char>(data[6]);
+		std::size_t dictOffset;
+		std::size_t dictLength;
+
+		if (major == 1) {
+			dictOffset = 10;
+			dictLength = static_cast<unsigned char>(data[8]) | std::size_t(static_cast<unsigned char>(data[9])) << 8;
+		}
+		else if (major == 2 || major == 3) {
+			if (size < 12)
+				throw std::runtime_error("NpyFile: truncated header");
+
+			dictOffset = 12;
+			dictLength = 0;
+			for (int i = 3; i >= 0; --i)
+				dictLength = (dictLength << 8) | static_cast<unsigned char>(data[8 + i]);
+		}
+		else
+			throw std::runtime_error("NpyFile: unsupported format version");
+
+		if (dictOffset + dictLength > size)
+			throw std::runtime_error("NpyFile: truncated header");
+
+		const std::string dict (data + dictOffset, dictLength);
+
+		descr = NpyHeaderValue(dict, "descr");
+		if (descr.size() < 2 || descr.front() != '\'')
+			throw std::runtime_error("NpyFile: malformed header");
+		descr = descr.substr(1, descr.size() - 2);
+
+		if (NpyHeaderValue(dict, "fortran_order") != "False")
+			throw std::runtime_error("NpyFile: Fortran-ordered arrays are not supported");
+
+		const std::string shapeText = NpyHeaderValue(dict, "shape");
+		shape.clear();
+
+		for (std::size_t p = 1; p < shapeText.size(); ) {
+			p = shapeText.find_first_of("0123456789", p);
+			if (p == std::string::npos)
+				break;
+
+			std::size_t used = 0;
+			unsigned long long extent;
+
+			try {
+				extent = std::stoull(shapeText.substr(p), &used);
+			}
+			catch (const std::out_of_range&) {
+				throw std::runtime_error("NpyFile: malformed header");
+			}
+
+			if (extent > std::numeric_limits<std::size_t>::max())
+				throw std::runtime_error("NpyFile: malformed header");
+
+			shape.push_back(std::size_t(extent));
+			p += used;
+		}
+
+		return dictOffset + dictLength;
+	}
+
+
+	template <typename UInt>
+	void
+	AppendLittleEndian (std::string& out, UInt value)
+	{
+		for (std::size_t i = 0; i < sizeof(UInt); ++i)
+			out.push_back(static_cast<char>(value >> (8 * i)));
+	}
+
+	template <typename UInt>
+	UInt
+	ReadLittleEndian (const char* src)
+	{
+		UInt value = 0;
+		for (std::size_t i = 0; i < sizeof(UInt); ++i)
+			value |= UInt(static_cast<unsigned char>(src[i])) << (8 * i);
+		return value;
+	}
+
+}	//	namespace detail
+
+
+	//!	NpyView: read-only view of a 1-D .npy array (or a .npz member) of type T
+	/*!
+	 *	For a .npy file the view points straight into the memory-mapped
+	 *	file, so opening it does not copy or even read the data. Members of
+	 *	a .npz archive are only copied if the zip layout leaves them
+	 *	misaligned for T.
+	 *
+	 *	The element type must match the stored dtype exactly; arrays of
+	 *	more than one dimension are viewed as their flattened C-order data,
+	 *	with the dimensions available from shape().
+	 */
+	template <typename T>
+	class NpyView {
+	  private:
+
+		std::shared_ptr<const MappedFile>	file_;
+		std::vector<T>						copy_;
+		const T*							data_;
+		std::size_t							size_;
+		std::vector<std::size_t>			shape_;
+
+	  public:
+
+		typedef T			value_type;
+		typedef const T*	const_iterator;
+		typedef const T*	iterator;
+
+		//!	Maps a .npy file
+		explicit
+		NpyView (const std::string& fileName)
+			: NpyView(std::make_shared<const MappedFile>(fileName), 0, std::string::npos)
+		{ }
+
+		//!	Views the .npy image stored at [offset, offset + length) of a mapped file
+		NpyView (std::shared_ptr<const MappedFile> file, std::size_t offset, std::size_t length)
+			: file_(file)
+			, data_(nullptr)
+			, size_(0)
+		{
+			detail::RequireLittleEndianHost();
+
+			length = std::min(length, file_->size() - std::min(offset, file_->size()));
+			const char* image = file_->data() + offset;
+
+			std::string descr;
+			const std::size_t dataOffset = detail::ParseNpyHeader(image, length, descr, shape_);
+
+			if (descr != detail::NpyDescr<T>::Get())
+				throw std::runtime_error("NpyFile: stored dtype '" + descr + "' does not match the requested type");
+
+			//	Checked so that a huge shape cannot wrap around to a size which passes the length test
+			size_ = 1;
+			for (std::size_t extent : shape_) {
+				if (extent != 0 && size_ > std::numeric_limits<std::size_t>::max() / extent)
+					throw std::runtime_error("NpyFile: malformed header");
+				size_ *= extent;
+			}
+
+			if (dataOffset > length || size_ > (length - dataOffset) / sizeof(T))
+				throw std::runtime_error("NpyFile: the array data is truncated");
+
+			const char* first = image + dataOffset;
+
+			if (reinterpret_cast<std::uintptr_t>(first) % alignof(T) == 0) {
+				data_ = reinterpret_cast<const T*>(first);
+			}
+			else {
+				copy_.resize(size_);
+				std::memcpy(copy_.data(), first, size_ * sizeof(T));
+				data_ = copy_.data();
+			}
+		}
+
+		NpyView (const NpyView&) = delete;
+
+		NpyView& operator= (const NpyView&) = delete;
+
+		NpyView (NpyView&& rhs)
+			: file_(std::move(rhs.file_))
+			, copy_(std::move(rhs.copy_))
+			, data_(copy_.empty() ? rhs.data_ : copy_.data())
+			, size_(rhs.size_)
+			, shape_(std::move(rhs.shape_))
+		{ }
+
+		const T*	data (void) const	{ return data_; }
+		std::size_t	size (void) const	{ return size_; }
+		bool		empty (void) const	{ return size_ == 0; }
+		const T*	begin (void) const	{ return data_; }
+		const T*	end (void) const	{ return data_ + size_; }
+
+		const T&
+		operator[] (std::size_t i) const
+		{ return data_[i]; }
+
+		//!	Returns the array dimensions as stored
+		const std::vector<std::size_t>&
+		shape (void) const
+		{ return shape_; }
+	};
+
+
+	//!	NpzFile: a memory-mapped .npz archive of stored .npy members
+	class NpzFile {
+	  private:
+
+		struct Entry {
+			std::size_t offset;
+			std::size_t length;
+		};
+
+		std::shared_ptr<const MappedFile>	file_;
+		std::map<std::string, Entry>		entries_;
+
+	  public:
+
+		explicit
+		NpzFile (const std::string& fileName)
+			: file_(std::make_shared<const MappedFile>(fileName))
+		{
+			const char* data = file_->data();
+			const std::size_t size = file_->size();
+
+			//	The end of central directory record is at most 64 KiB + 22 bytes from the end
+			std::size_t eocd = std::string::npos;
+
+			if (size >= 22) {
+				const std::size_t lowest = size > 65535 + 22 ? size - 65535 - 22 : 0;
+
+				for (std::size_t p = size - 22 + 1; p-- > lowest; ) {
+					if (detail::ReadLittleEndian<std::uint32_t>(data + p) == 0x06054b50u) {
+						eocd = p;
+						break;
+					}
+				}
+			}
+
+			if (eocd == std::string::npos)
+				throw std::runtime_error("NpyFile: " + fileName + " is not a zip archive");
+
+			const std::size_t count = detail::ReadLittleEndian<std::uint16_t>(data + eocd + 10);
+			std::size_t p = detail::ReadLittleEndian<std::uint32_t>(data + eocd + 16);
+
+			for (std::size_t i = 0; i < count; ++i) {
+				if (p + 46 > size || detail::ReadLittleEndian<std::uint32_t>(data + p) != 0x02014b50u)
+					throw std::runtime_error("NpyFile: corrupt zip central directory");
+
+				const std::uint16_t method = detail::ReadLittleEndian<std::uint16_t>(data + p + 10);
+				const std::uint32_t storedSize = detail::ReadLittleEndian<std::uint32_t>(data + p + 20);
+				const std::uint16_t nameLength = detail::ReadLittleEndian<std::uint16_t>(data + p + 28);
+				const std::uint16_t extraLength = detail::ReadLittleEndian<std::uint16_t>(data + p + 30);
+				const std::uint16_t commentLength = detail::ReadLittleEndian<std::uint16_t>(data + p + 32);
+				const std::uint32_t localOffset = detail::ReadLittleEndian<std::uint32_t>(data + p + 42);
+
+				if (p + 46 + nameLength + extraLength + commentLength > size)
+					throw std::runtime_error("NpyFile: corrupt zip central directory");
+
+				std::string name (data + p + 46, nameLength);
+				p += 46 + nameLength + extraLength + commentLength;
+
+				if (method != 0)
+					throw std::runtime_error("NpyFile: compressed .npz member " + name + " is not supported");
+
+				if (localOffset + 30 > size)
+					throw std::runtime_error("NpyFile: corrupt zip local header");
+
+				const std::size_t dataOffset = localOffset + 30
+						+ detail::ReadLittleEndian<std::uint16_t>(data + localOffset + 26)
+						+ detail::ReadLittleEndian<std::uint16_t>(data + localOffset + 28);
+
+				//	numpy.savez names members "<key>.npy"; look them up by key
+				if (name.size() > 4 && name.compare(name.size() - 4, 4, ".npy") == 0)
+					name.erase(name.size() - 4);
+
+				entries_[name] = Entry{dataOffset, storedSize};
+			}
+		}
+
+
+		//!	Returns the keys of the stored arrays (without the ".npy" suffix)
+		std::vector<std::string>
+		Names (void) const
+		{
+			std::vector<std::string> names;
+			for (auto& entry : entries_)
+				names.push_back(entry.first);
+			return names;
+		}
+
+
+		//!	Returns a view of the array stored under key
+		template <typename T>
+		NpyView<T>
+		Get (const std::string& key) const
+		{
+			auto found = entries_.find(key);
+
+			if (found == entries_.end())
+				throw std::runtime_error("NpyFile: no array named " + key);
+
+			return NpyView<T>(file_, found->second.offset, found->second.length);
+		}
+	};
+
+
+	//!	Writes a 1-D array to a stream in .npy format
+	template <typename T>
+	void
+	SaveNpy (std::ostream& os, const T* data, std::size_t count)
+	{
+		detail::RequireLittleEndianHost();
+
+		const std::string header = detail::MakeNpyHeader<T>(count);
+		os.write(header.data(), header.size());
+		os.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+
+		if (!os)
+			throw std::runtime_error("NpyFile: write failed");
+	}
+
+
+	//!	Writes the contents of a contiguous container to a .npy file
+	template <typename Container>
+	void
+	SaveNpy (const std::string& fileName, const Container& c)
+	{
+		std::ofstream ofs (fileName.c_str(), std::ios::binary);
+
+		if (!ofs)
+			throw std::runtime_error("NpyFile: could not open " + fileName);
+
+		SaveNpy(ofs, c.empty() ? nullptr : &(*c.begin()), c.size());
+	}
+
+
+	//!	NpzWriter: writes .npy members into a stored (uncompressed) zip archive
+	class NpzWriter {
+	  private:
+
+		std::ofstream	ofs_;
+		std::string		centralDirectory_;
+		std::size_t		entries_;
+		std::size_t		offset_;
+		bool			closed_;
+
+	  public:
+
+		explicit
+		NpzWriter (const std::string& fileName)
+			: ofs_(fileName.c_str(), std::ios::binary)
+			, entries_(0)
+			, offset_(0)
+			, closed_(false)
+		{
+			detail::RequireLittleEndianHost();
+
+			if (!ofs_)
+				throw std::runtime_error("NpyFile: could not open " + fileName);
+		}
+
+		~NpzWriter (void)
+		{
+			try {
+				Close();
+			}
+			catch (...) {
+			}
+		}
+
+
+		//!	Adds a 1-D array as member "<key>.npy"
+		template <typename T>
+		void
+		Add (const std::string& key, const T* data, std::size_t count)
+		{
+			const std::string name = key + ".npy";
+			const std::string header = detail::MakeNpyHeader<T>(count);
+			const std::size_t dataBytes = count * sizeof(T);
+			const std::size_t memberBytes = header.size() + dataBytes;
+
+			if (memberBytes > 0xFFFFFFFFu || offset_ > 0xFFFFFFFFu)
+				throw std::length_error("NpyFile: .npz members larger than 4 GiB need zip64, which is not supported");
+
+			const std::uint32_t crc = Crc32Update(Crc32(header.data(), header.size()), data, dataBytes);
+
+			//	Local file header and its central directory twin share most fields
+			std::string common;
+			detail::AppendLittleEndian<std::uint16_t>(common, 20);		//	version needed
+			detail::AppendLittleEndian<std::uint16_t>(common, 0);		//	flags
+			detail::AppendLittleEndian<std::uint16_t>(common, 0);		//	method: stored
+			detail::AppendLittleEndian<std::uint16_t>(common, 0);		//	time
+			detail::AppendLittleEndian<std::uint16_t>(common, 0x21);	//	date: 1980-01-01
+			detail::AppendLittleEndian<std::uint32_t>(common, crc);
+			detail::AppendLittleEndian<std::uint32_t>(common, memberBytes);
+			detail::AppendLittleEndian<std::uint32_t>(common, memberBytes);
+			detail::AppendLittleEndian<std::uint16_t>(common, name.size());
+			detail::AppendLittleEndian<std::uint16_t>(common, 0);		//	extra length
+
+			std::string local;
+			detail::AppendLittleEndian<std::uint32_t>(local, 0x04034b50u);
+			local += common + name;
+
+			detail::AppendLittleEndian<std::uint32_t>(centralDirectory_, 0x02014b50u);
+			detail::AppendLittleEndian<std::uint16_t>(centralDirectory_, 20);	//	version made by
+			centralDirectory_ += common;
+			detail::AppendLittleEndian<std::uint16_t>(centralDirectory_, 0);	//	comment length
+			detail::AppendLittleEndian<std::uint16_t>(centralDirectory_, 0);	//	disk number
+			detail::AppendLittleEndian<std::uint16_t>(centralDirectory_, 0);	//	internal attributes
+			detail::AppendLittleEndian<std::uint32_t>(centralDirectory_, 0);	//	external attributes
+			detail::AppendLittleEndian<std::uint32_t>(centralDirectory_, offset_);
+			centralDirectory_ += name;
+
+			ofs_.write(local.data(), local.size());
+			ofs_.write(header.data(), header.size());
+			ofs_.write(reinterpret_cast<const char*>(data), dataBytes);
+
+			if (!ofs_)
+				throw std::runtime_error("NpyFile: write failed");
+
+			offset_ += local.size() + memberBytes;
+			++entries_;
+		}
+
+
+		//!	Adds the contents of a contiguous container as member "<key>.npy"
+		template <typename Container>
+		void
+		Add (const std::string& key, const Container& c)
+		{ Add(key, c.empty() ? nullptr : &(*c.begin()), c.size()); }
+
+
+		//!	Writes the central directory; called by the destructor if needed
+		void
+		Close (void)
+		{
+			if (closed_)
+				return;
+
+			closed_ = true;
+
+			std::string end;
+			detail::AppendLittleEndian<std::uint32_t>(end, 0x06054b50u);
+			detail::AppendLittleEndian<std::uint16_t>(end, 0);
+			detail::AppendLittleEndian<std::uint16_t>(end, 0);
+			detail::AppendLittleEndian<std::uint16_t>(end, entries_);
+			detail::AppendLittleEndian<std::uint16_t>(end, entries_);
+			detail::AppendLittleEndian<std::uint32_t>(end, centralDirectory_.size());
+			detail::AppendLittleEndian<std::uint32_t>(end, offset_);
+			detail::AppendLittleEndian<std::uint16_t>(end, 0);
+
+			ofs_.write(centralDirectory_.data(), centralDirectory_.size());
+			ofs_.write(end.data(), end.size());
+			ofs_.close();
+
+			if (!ofs_)
+				throw std::runtime_error("NpyFile: write failed");
+		}
+	};
+
+
+	//!	Writes the time domain of a Waveform (transforming if needed) as a .npy file
+	template <typename WaveformT>
+	void
+	SaveNpyTimeSeries (const std::string& fileName, WaveformT& wfm)
+	{ SaveNpy(fileName, wfm.GetConstTimeSeries()); }
+
+
+	//!	Writes the freq domain of a Waveform (transforming if needed) as a .npy file
+	template <typename WaveformT>
+	void
+	SaveNpyFreqSpectrum (const std::string& fileName, WaveformT& wfm)
+	{ SaveNpy(fileName, wfm.GetConstFreqSpectrum()); }
+
+
+	//!	Writes both domains of a Waveform as members "time" and "freq" of a .npz archive
+	template <typename WaveformT>
+	void
+	SaveNpz (const std::string& fileName, WaveformT& wfm)
+	{
+		NpzWriter npz (fileName);
+		npz.Add("time", wfm.GetConstTimeSeries());
+		npz.Add("freq", wfm.GetConstFreqSpectrum());
+		npz.Close();
+	}
+
+
+	//!	Copies a .npy array into the time domain of a Waveform and marks it valid
+	template <typename WaveformT>
+	void
+	ReadTimeSeries (const NpyView<typename WaveformT::TimeT>& npy, WaveformT& wfm)
+	{
+		if (wfm.PeekTimeSeries().size() != npy.size())
+			throw std::length_error("NpyFile: the array length does not match the time domain");
+
+		std::copy(npy.begin(), npy.end(), wfm.OverwriteTimeSeries().begin());
+	}
+
+
+	//!	Copies a .npy array into the freq domain of a Waveform and marks it valid
+	template <typename WaveformT>
+	void
+	ReadFreqSpectrum (const NpyView<typename WaveformT::FreqT>& npy, WaveformT& wfm)
+	{
+		if (wfm.PeekFreqSpectrum().size() != npy.size())
+			throw std::length_error("NpyFile: the array length does not match the freq domain");
+
+		std::copy(npy.begin(), npy.end(), wfm.OverwriteFreqSpectrum().begin());
+	}
+
+}	//	namespace PS
+
+#endif
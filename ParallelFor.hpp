@@ -0,0 +1,86 @@
+/*
+ ParallelFor.hpp
+ Minimal fork-join helper used to split large records across threads.
+ */
+
+#ifndef PARALLELFOR_HPP
+#define PARALLELFOR_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+
+namespace PS {
+
+	//!	Returns the number of hardware threads, or 1 if it cannot be determined
+	inline unsigned
+	DefaultThreadCount (void)
+	{
+		const unsigned hw = std::thread::hardware_concurrency();
+		return hw ? hw : 1;
+	}
+
+
+	//!	Calls f(task) for every task in [0, tasks) using up to maxThreads threads
+	/*!
+	 *	Tasks are handed out in contiguous blocks, one block per thread, and
+	 *	the calling thread works on the first block itself. The call returns
+	 *	once every task has finished; if any task threw, the exception from
+	 *	the lowest-numbered block is rethrown.
+	 *
+	 *	Passing maxThreads == 0 uses DefaultThreadCount().
+	 */
+	template <typename Function>
+	void
+	ParallelFor (std::size_t tasks, unsigned maxThreads, Function f)
+	{
+		if (maxThreads == 0)
+			maxThreads = DefaultThreadCount();
+
+		const std::size_t threads = std::min<std::size_t>(maxThreads, tasks);
+
+		if (threads <= 1) {
+			for (std::size_t task = 0; task < tasks; ++task)
+				f(task);
+			return;
+		}
+
+		std::vector<std::exception_ptr> errors (threads);
+
+		auto runBlock = [&](std::size_t block)
+		{
+			const std::size_t first = tasks * block / threads;
+			const std::size_t last = tasks * (block + 1) / threads;
+
+			try {
+				for (std::size_t task = first; task < last; ++task)
+					f(task);
+			}
+			catch (...) {
+				errors[block] = std::current_exception();
+			}
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(threads - 1);
+
+		for (std::size_t block = 1; block < threads; ++block)
+			workers.emplace_back(runBlock, block);
+
+		runBlock(0);
+
+		for (auto& worker : workers)
+			worker.join();
+
+		for (auto& error : errors)
+			if (error)
+				std::rethrow_exception(error);
+	}
+
+}	//	namespace PS
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ Resample.hpp
+ Spectral resampling of a Waveform to a new length: the spectrum is
+ zero-padded (upsampling) or truncated (downsampling) and rescaled, which
+ is exact for a periodic, band-limited signal.
+
+ The Nyquist bin is treated as in scipy.signal.resample. When upsampling
+ from N samples, the old Nyquist bin X[N/2] stands for a component split
+ evenly between +N/2 and -N/2, so half of it is kept. When downsampling to
+ M samples, the components at +M/2 and -M/2 fold onto the new Nyquist bin,
+ which becomes 2 Re(X[M/2]).
+ */
+
+#ifndef RESAMPLE_HPP
+#define RESAMPLE_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <fftw3.h>
+
+#include <FftwPlanCache.hpp>
+#include <FftwTransform.hpp>
+#include <FreeFunctionSupport.hpp>
+#include <Waveform.hpp>
+
+
+namespace PS {
+
+namespace detail {
+
+	struct ResampleScratchTag {};
+
+}	//	namespace detail
+
+
+	//!	The type Resample() returns for a WaveformT unless told otherwise
+	/*!
+	 *	A Waveform of doubles and std::complex<double> bins comes back with
+	 *	Fftw3_Dft_1d_Cached_Normalized as its transform, which has the same
+	 *	conventions as Fftw3_Dft_1d_Normalized but takes its plans from
+	 *	FftwPlanCache, so that making the result plans nothing. Any other
+	 *	type comes back as it is.
+	 */
+	template <typename WaveformT>
+	struct ResampledWaveform {
+		typedef WaveformT	type;
+	};
+
+	template <typename TimeContainer, typename FreqContainer, typename TransformT>
+	struct ResampledWaveform< Waveform<TimeContainer, FreqContainer, TransformT> > {
+		typedef typename std::conditional<std::is_same<typename TimeContainer::value_type, double>::value
+										  && std::is_same<typename FreqContainer::value_type, std::complex<double> >::value
+				, Waveform<TimeContainer, FreqContainer, ::Waveform::Transform::Fftw3_Dft_1d_Cached_Normalized>
+				, Waveform<TimeContainer, FreqContainer, TransformT>
+				>::type	type;
+	};
+
+
+	//!	A new Waveform of newLength samples with the same band-limited content as wfm
+	/*!
+	 *	The spectrum is read with GetConstFreqSpectrum(), so a spectrum
+	 *	which is already valid is used as it is (otherwise it is computed
+	 *	once and stays cached in wfm). The new spectrum is written straight
+	 *	into the result, scaled by newLength/N so that it matches the
+	 *	result's own forward transform, and the new samples are made from
+	 *	it by one c2r with a plan from FftwPlanCache. The result is returned
+	 *	with both domains valid, so reading either costs no transform.
+	 *
+	 *	The result is a ResampledWaveform<WaveformT>::type, whose transform
+	 *	also takes its plans from FftwPlanCache, so resampling a record
+	 *	whose spectrum is valid costs one FFT of the new length and makes
+	 *	no plans once the length has been seen. Resample<ResultT>() returns
+	 *	a ResultT instead, such as WaveformT itself, at the cost of
+	 *	whatever constructing one costs (Fftw3_Dft_1d_Normalized plans
+	 *	for every Waveform it is made for).
+	 *
+	 *	wfm and the result must hold r2c spectra (see
+	 *	FreeFunctionSupport.hpp), and newLength must be even and non-zero.
+	 */
+	template <typename ResultT = void, typename WaveformT>
+	typename std::conditional<std::is_void<ResultT>::value, typename ResampledWaveform<WaveformT>::type, ResultT>::type
+	Resample (const WaveformT& wfm, const std::size_t newLength)
+	{
+		typedef typename std::conditional<std::is_void<ResultT>::value
+				, typename ResampledWaveform<WaveformT>::type, ResultT>::type	Result;
+		typedef typename Result::DomainState	DomainState;
+		typedef typename Result::Domain			Domain;
+
+		detail::RequireR2CSpectrum(wfm, "Resample");
+
+		const std::size_t n = wfm.size();
+
+		if (newLength == 0 || newLength % 2)
+			throw std::length_error("Resample: the new length must be a non-zero multiple of 2");
+
+		const auto& spectrum = wfm.GetConstFreqSpectrum();
+
+		const std::size_t newBins = newLength / 2 + 1;
+		const std::size_t kept = std::min(n, newLength) / 2;
+		const double gain = double(newLength) / double(n);
+
+		Result resampled (newLength);
+		detail::RequireR2CSpectrum(resampled, "Resample");
+
+		//	From Neither, the edit runs no transform
+		{
+			auto e = resampled.Edit(Domain::Freq);
+			auto y = e.Freq();
+
+			for (std::size_t k = 0; k < kept; ++k)
+				y[k] = gain * spectrum[k];
+
+			if (newLength > n)
+				y[kept] = (0.5 * gain) * spectrum[kept];
+			else if (newLength < n)
+				y[kept] = 2. * gain * spectrum[kept].real();
+			else
+				y[kept] = gain * spectrum[kept];
+
+			for (std::size_t k = kept + 1; k < newBins; ++k)
+				y[k] = 0.;
+		}
+
+		//	The c2r destroys its input, so it runs on a scaled copy of the new bins
+		std::vector< std::complex<double> >& bins = detail::ThreadScratch<std::complex<double>, detail::ResampleScratchTag>(newBins);
+		const auto& y = resampled.PeekFreqSpectrum();
+		const double scale = 1. / double(newLength);
+
+		for (std::size_t k = 0; k < newBins; ++k)
+			bins[k] = scale * y[k];
+
+		auto& samples = resampled.OverwriteTimeSeries();
+		::Waveform::Transform::FftwPlanCache::ExecuteC2R(newLength, bins.data(), &(*samples.begin()));
+
+		resampled.AssumeValidDomain(DomainState::Both);
+
+		return resampled;
+	}
+
+}	//	namespace PS
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ SimdDispatch.hpp
+ Attributes for the vectorized kernels of NativeFft.hpp, FixedWaveform.hpp
+ and AdcIngest.hpp.
+
+ The kernels are plain loops written for the compiler to vectorize, with
+ no intrinsics. With GCC 11 or later on x86-64 Linux, a function marked
+ WAVEFORM_SIMD_KERNEL is compiled three times, for AVX-512
+ (x86-64-v4), AVX2 with FMA (x86-64-v3) and baseline SSE2, and the
+ loader picks the one the CPU supports (target_clones). Define
+ WAVEFORM_NO_DISPATCH to build only for the target of the compile, for
+ instance under ThreadSanitizer, whose run time is not yet set up when
+ the loader resolves the clones.
+
+ The kernels expect -O2 or higher. GCC's -O2 only vectorizes loops
+ which its very cheap cost model accepts, which excludes most loops
+ with run-time trip counts; build with -O3, or add
+ -fvect-cost-model=dynamic to -O2 (as the makefile does), to vectorize
+ all of them.
+ */
+
+#ifndef SIMDDISPATCH_HPP
+#define SIMDDISPATCH_HPP 1
+#pragma once
+
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11 \
+	&& defined(__x86_64__) && defined(__linux__) && !defined(WAVEFORM_NO_DISPATCH)
+#define WAVEFORM_SIMD_KERNEL __attribute__((target_clones("arch=x86-64-v4", "arch=x86-64-v3", "default")))
+#else
+#define WAVEFORM_SIMD_KERNEL
+#endif
+
+//	WAVEFORM_SIMD_INLINE pulls a helper into each clone of its kernel, so the helper is built for that
+//	target too. WAVEFORM_SIMD_IVDEP marks a loop as free of dependences between iterations, for loops
+//	whose stores go to one array at run-time distances. WAVEFORM_SIMD_UNROLL unrolls a short loop with a
+//	constant trip count, so that constant operands fold into the arithmetic
+#if defined(__GNUC__) && !defined(__clang__)
+#define WAVEFORM_SIMD_INLINE inline __attribute__((always_inline))
+#define WAVEFORM_SIMD_IVDEP _Pragma("GCC ivdep")
+#define WAVEFORM_SIMD_UNROLL _Pragma("GCC unroll 16")
+#elif defined(__clang__)
+#define WAVEFORM_SIMD_INLINE inline __attribute__((always_inline))
+#define WAVEFORM_SIMD_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#define WAVEFORM_SIMD_UNROLL _Pragma("unroll")
+#else
+#define WAVEFORM_SIMD_INLINE inline
+#define WAVEFORM_SIMD_IVDEP
+#define WAVEFORM_SIMD_UNROLL
+#endif
+
+#endif
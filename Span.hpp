@@ -0,0 +1,79 @@
+/*
+ Span.hpp
+ A minimal contiguous view (pointer and length), standing in for C++20's
+ std::span until the library moves past C++17.
+ */
+
+#ifndef SPAN_HPP
+#define SPAN_HPP 1
+#pragma once
+
+#include <cstddef>
+
+
+namespace PS {
+
+	//!	Span: unchecked access to size() contiguous elements starting at data()
+	template <typename T>
+	class Span {
+	  public:
+
+		typedef T				value_type;
+		typedef T*				iterator;
+		typedef const T*		const_iterator;
+		typedef std::size_t		size_type;
+
+	  private:
+
+		T*				data_;
+		std::size_t		size_;
+
+	  public:
+
+		Span (void)
+			: data_(nullptr)
+			, size_(0)
+		{ }
+
+		Span (T* data, std::size_t size)
+			: data_(data)
+			, size_(size)
+		{ }
+
+		//!	Views every element of a contiguous container
+		template <typename Container>
+		explicit
+		Span (Container& c)
+			: data_(c.empty() ? nullptr : &(*c.begin()))
+			, size_(c.size())
+		{ }
+
+
+		T*
+		data (void) const
+		{ return data_; }
+
+		std::size_t
+		size (void) const
+		{ return size_; }
+
+		bool
+		empty (void) const
+		{ return size_ == 0; }
+
+		T&
+		operator[] (std::size_t i) const
+		{ return data_[i]; }
+
+		T*
+		begin (void) const
+		{ return data_; }
+
+		T*
+		end (void) const
+		{ return data_ + size_; }
+	};
+
+}	//	namespace PS
+
+#endif
@@ -0,0 +1,439 @@
+/*
+ SplitComplex.hpp
+ A complex container which stores the real and imaginary parts in two
+ separate arrays ("split" or structure-of-arrays layout), for use as the
+ FreqContainer of a Waveform.
+
+ Element-wise spectral operations (magnitude, filtering, phase rotation)
+ on interleaved std::complex arrays need shuffles to separate the parts
+ before they can be vectorized; on split arrays they are plain loops over
+ contiguous doubles. FFTW reads and writes this layout directly through
+ its split-array interface (see Fftw3_Dft_1d_Split_Normalized in
+ FftwTransform.hpp), so no conversion is ever needed.
+ */
+
+#ifndef SPLITCOMPLEX_HPP
+#define SPLITCOMPLEX_HPP 1
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <Span.hpp>
+
+
+namespace PS {
+
+	//!	Proxy for one element of a SplitComplexVector
+	/*!
+	 *	Reads convert to std::complex<T>; assignments write both parts.
+	 */
+	template <typename T>
+	class SplitComplexReference {
+	  private:
+
+		T*	re_;
+		T*	im_;
+
+	  public:
+
+		SplitComplexReference (T& re, T& im)
+			: re_(&re)
+			, im_(&im)
+		{ }
+
+		operator std::complex<T> (void) const
+		{ return std::complex<T>(*re_, *im_); }
+
+		//!	Assigns the value of another element, not the proxy itself
+		SplitComplexReference&
+		operator= (const SplitComplexReference& rhs)
+		{ return *this = std::complex<T>(rhs); }
+
+		SplitComplexReference&
+		operator= (const std::complex<T>& rhs)
+		{ *re_ = rhs.real(); *im_ = rhs.imag(); return *this; }
+
+		SplitComplexReference&
+		operator*= (const std::complex<T>& rhs)
+		{ return *this = std::complex<T>(*this) * rhs; }
+
+		SplitComplexReference&
+		operator+= (const std::complex<T>& rhs)
+		{ *re_ += rhs.real(); *im_ += rhs.imag(); return *this; }
+
+		T
+		real (void) const
+		{ return *re_; }
+
+		T
+		imag (void) const
+		{ return *im_; }
+
+		friend bool
+		operator== (const SplitComplexReference& lhs, const SplitComplexReference& rhs)
+		{ return std::complex<T>(lhs) == std::complex<T>(rhs); }
+
+		friend bool
+		operator== (const SplitComplexReference& lhs, const std::complex<T>& rhs)
+		{ return std::complex<T>(lhs) == rhs; }
+
+		friend bool
+		operator== (const std::complex<T>& lhs, const SplitComplexReference& rhs)
+		{ return lhs == std::complex<T>(rhs); }
+	};
+
+
+namespace detail {
+
+	//!	Random access iterator over a pair of part arrays
+	/*!
+	 *	Reference is SplitComplexReference<T> for the mutable iterator, and
+	 *	std::complex<T> (a value) for the const one.
+	 */
+	template <typename T, typename PartPointer, typename Reference>
+	class SplitComplexIterator
+		: public boost::iterator_facade< SplitComplexIterator<T, PartPointer, Reference>
+									   , std::complex<T>
+									   , boost::random_access_traversal_tag
+									   , Reference
+									   >
+	{
+	  private:
+
+		friend class boost::iterator_core_access;
+
+		template <typename, typename, typename>
+		friend class SplitComplexIterator;
+
+		PartPointer	re_;
+		PartPointer	im_;
+
+		Reference
+		dereference (void) const
+		{ return Reference(*re_, *im_); }
+
+		template <typename OtherPointer, typename OtherReference>
+		bool
+		equal (const SplitComplexIterator<T, OtherPointer, OtherReference>& rhs) const
+		{ return re_ == rhs.re_; }
+
+		void
+		increment (void)
+		{ ++re_; ++im_; }
+
+		void
+		decrement (void)
+		{ --re_; --im_; }
+
+		void
+		advance (std::ptrdiff_t n)
+		{ re_ += n; im_ += n; }
+
+		template <typename OtherPointer, typename OtherReference>
+		std::ptrdiff_t
+		distance_to (const SplitComplexIterator<T, OtherPointer, OtherReference>& rhs) const
+		{ return rhs.re_ - re_; }
+
+	  public:
+
+		SplitComplexIterator (void)
+			: re_(nullptr)
+			, im_(nullptr)
+		{ }
+
+		SplitComplexIterator (PartPointer re, PartPointer im)
+			: re_(re)
+			, im_(im)
+		{ }
+
+		//!	Mutable to const conversion
+		template <typename OtherPointer, typename OtherReference>
+		SplitComplexIterator (const SplitComplexIterator<T, OtherPointer, OtherReference>& rhs)
+			: re_(rhs.re_)
+			, im_(rhs.im_)
+		{ }
+	};
+
+}	//	namespace detail
+
+
+	//!	SplitComplexVector: a vector of std::complex<T> stored as two arrays of T
+	/*!
+	 *	The interface follows std::vector where the split layout allows it.
+	 *	Elements are accessed through a proxy (SplitComplexReference), so
+	 *	there is no data() of std::complex<T>; use real_data() and
+	 *	imag_data(), or real() and imag(), for direct access to the parts.
+	 *
+	 *	Because it has no contiguous array of std::complex<T>,
+	 *	Waveform::Edit(Domain::Freq) is not available for this container;
+	 *	edit the parts through GetFreqSpectrum().real() and imag() instead.
+	 */
+	template <typename T, typename Allocator = std::allocator<T> >
+	class SplitComplexVector {
+	  public:
+
+		typedef std::complex<T>		value_type;
+		typedef Allocator			allocator_type;
+		typedef std::size_t			size_type;
+		typedef std::ptrdiff_t		difference_type;
+
+		typedef SplitComplexReference<T>		reference;
+		typedef std::complex<T>					const_reference;
+
+		typedef detail::SplitComplexIterator<T, T*, reference>					iterator;
+		typedef detail::SplitComplexIterator<T, const T*, const_reference>		const_iterator;
+
+	  private:
+
+		typedef std::vector<T, Allocator>	PartContainer;
+
+		PartContainer	re_;
+		PartContainer	im_;
+
+	  public:
+
+		SplitComplexVector (void) = default;
+
+		explicit
+		SplitComplexVector (size_type count, const Allocator& alloc = Allocator())
+			: re_(count, T(), alloc)
+			, im_(count, T(), alloc)
+		{ }
+
+		SplitComplexVector (size_type count, const value_type& value, const Allocator& alloc = Allocator())
+			: re_(count, value.real(), alloc)
+			, im_(count, value.imag(), alloc)
+		{ }
+
+		//!	Copies a range of std::complex<T> (or anything convertible to it)
+		template <typename InputIterator
+				, typename = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+		SplitComplexVector (InputIterator first, InputIterator last, const Allocator& alloc = Allocator())
+			: re_(alloc)
+			, im_(alloc)
+		{
+			for (; first != last; ++first) {
+				const value_type value (*first);
+				re_.push_back(value.real());
+				im_.push_back(value.imag());
+			}
+		}
+
+
+		size_type
+		size (void) const
+		{ return re_.size(); }
+
+		bool
+		empty (void) const
+		{ return re_.empty(); }
+
+		void
+		resize (size_type count)
+		{ re_.resize(count); im_.resize(count); }
+
+		allocator_type
+		get_allocator (void) const
+		{ return re_.get_allocator(); }
+
+
+		reference
+		operator[] (size_type i)
+		{ return reference(re_[i], im_[i]); }
+
+		const_reference
+		operator[] (size_type i) const
+		{ return const_reference(re_[i], im_[i]); }
+
+		reference
+		at (size_type i)
+		{
+			if (i >= size())
+				throw std::out_of_range("SplitComplexVector: index out of range");
+			return (*this)[i];
+		}
+
+		const_reference
+		at (size_type i) const
+		{
+			if (i >= size())
+				throw std::out_of_range("SplitComplexVector: index out of range");
+			return (*this)[i];
+		}
+
+
+		iterator
+		begin (void)
+		{ return iterator(re_.data(), im_.data()); }
+
+		iterator
+		end (void)
+		{ return iterator(re_.data() + size(), im_.data() + size()); }
+
+		const_iterator
+		begin (void) const
+		{ return const_iterator(re_.data(), im_.data()); }
+
+		const_iterator
+		end (void) const
+		{ return const_iterator(re_.data() + size(), im_.data() + size()); }
+
+		const_iterator
+		cbegin (void) const
+		{ return begin(); }
+
+		const_iterator
+		cend (void) const
+		{ return end(); }
+
+
+		//!	The array of real parts
+		T*
+		real_data (void)
+		{ return re_.data(); }
+
+		const T*
+		real_data (void) const
+		{ return re_.data(); }
+
+		//!	The array of imaginary parts
+		T*
+		imag_data (void)
+		{ return im_.data(); }
+
+		const T*
+		imag_data (void) const
+		{ return im_.data(); }
+
+		Span<T>
+		real (void)
+		{ return Span<T>(re_.data(), re_.size()); }
+
+		Span<const T>
+		real (void) const
+		{ return Span<const T>(re_.data(), re_.size()); }
+
+		Span<T>
+		imag (void)
+		{ return Span<T>(im_.data(), im_.size()); }
+
+		Span<const T>
+		imag (void) const
+		{ return Span<const T>(im_.data(), im_.size()); }
+
+
+		friend void
+		swap (SplitComplexVector& first, SplitComplexVector& second)
+		{
+			using std::swap;
+			swap(first.re_, second.re_);
+			swap(first.im_, second.im_);
+		}
+
+		friend bool
+		operator== (const SplitComplexVector& lhs, const SplitComplexVector& rhs)
+		{ return lhs.re_ == rhs.re_ && lhs.im_ == rhs.im_; }
+
+		friend bool
+		operator!= (const SplitComplexVector& lhs, const SplitComplexVector& rhs)
+		{ return !(lhs == rhs); }
+	};
+
+
+
+	//
+	//	Element-wise spectral operations
+	//
+	//	Each is a single loop over contiguous arrays of T with no shuffles,
+	//	which compilers vectorize at -O3 (or -O2 -ftree-vectorize). The arrays of different
+	//	containers never overlap, so the runtime alias checks always pass.
+	//
+
+	//!	x[k] *= h[k], e.g. applying a complex filter response
+	template <typename T, typename A1, typename A2>
+	void
+	Multiply (SplitComplexVector<T, A1>& x, const SplitComplexVector<T, A2>& h)
+	{
+		if (x.size() != h.size())
+			throw std::length_error("SplitComplexVector: Multiply() needs equal lengths");
+
+		T* xr = x.real_data();
+		T* xi = x.imag_data();
+		const T* hr = h.real_data();
+		const T* hi = h.imag_data();
+
+		for (std::size_t k = 0; k < x.size(); ++k) {
+			const T r = xr[k] * hr[k] - xi[k] * hi[k];
+			const T i = xr[k] * hi[k] + xi[k] * hr[k];
+			xr[k] = r;
+			xi[k] = i;
+		}
+	}
+
+
+	//!	x[k] *= gain[k] for a real gain per bin (a zero-phase filter)
+	template <typename T, typename A, typename RealContainer>
+	void
+	ApplyGain (SplitComplexVector<T, A>& x, const RealContainer& gain)
+	{
+		if (x.size() != gain.size())
+			throw std::length_error("SplitComplexVector: ApplyGain() needs equal lengths");
+
+		T* xr = x.real_data();
+		T* xi = x.imag_data();
+		const T* g = &(*gain.begin());
+
+		for (std::size_t k = 0; k < x.size(); ++k) {
+			xr[k] *= g[k];
+			xi[k] *= g[k];
+		}
+	}
+
+
+	//!	x[k] *= exp(i * phase), rotating every bin by the same angle
+	template <typename T, typename A>
+	void
+	Rotate (SplitComplexVector<T, A>& x, const T phase)
+	{
+		const T c = std::cos(phase);
+		const T s = std::sin(phase);
+
+		T* xr = x.real_data();
+		T* xi = x.imag_data();
+
+		for (std::size_t k = 0; k < x.size(); ++k) {
+			const T r = xr[k] * c - xi[k] * s;
+			const T i = xr[k] * s + xi[k] * c;
+			xr[k] = r;
+			xi[k] = i;
+		}
+	}
+
+
+	//!	out[k] = |x[k]|; out is resized to x.size()
+	template <typename T, typename A, typename RealContainer>
+	void
+	Magnitude (const SplitComplexVector<T, A>& x, RealContainer& out)
+	{
+		out.resize(x.size());
+
+		const T* xr = x.real_data();
+		const T* xi = x.imag_data();
+		T* o = &(*out.begin());
+
+		for (std::size_t k = 0; k < x.size(); ++k)
+			o[k] = std::sqrt(xr[k] * xr[k] + xi[k] * xi[k]);
+	}
+
+}	//	namespace PS
+
+#endif
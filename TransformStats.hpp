@@ -0,0 +1,389 @@
+/*
+ TransformStats.hpp
+ Optional counters for the transforms which Waveform runs: forward and
+ inverse executions, bytes touched, planning (transform construction) and
+ wall time, per transform type and per length.
+
+ Waveform only records anything when WAVEFORM_TRANSFORM_STATS is defined
+ before Waveform.hpp is included; otherwise none of this is compiled in.
+ */
+
+#ifndef TRANSFORMSTATS_HPP
+#define TRANSFORMSTATS_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+/*
+	Design:
+
+		Every thread records into its own fixed-size table of counters, which
+		only that thread ever writes, so recording takes no lock and needs no
+		atomic read-modify-write; the counters are std::atomic only so that a
+		snapshot taken from another thread reads them safely.
+
+		A table is registered (under a mutex) the first time its thread
+		records something, and folded into a set of retired totals when the
+		thread exits, so counts outlive the threads which made them.
+		TransformStatsSnapshot() sums the retired totals and every live table.
+
+		The counters only ever increase; subtract two snapshots to measure an
+		interval.
+ */
+
+
+namespace PS {
+
+	//!	Aggregated counters for one transform type at one length
+	struct TransformStatsEntry {
+		//!	Name of the TransformT class
+		std::string		transform;
+
+		//!	Length of the time domain
+		/*!
+		 *	Counts which did not fit in a thread's table are reported with
+		 *	transform "(overflow)" and length 0.
+		 */
+		std::size_t		length;
+
+		std::uint64_t	forward;
+		std::uint64_t	inverse;
+
+		//!	Number of transform objects constructed (for FFTW, each makes its plans)
+		std::uint64_t	plans;
+
+		//!	Bytes of both domain arrays, counted once per execution
+		std::uint64_t	bytes;
+
+		//!	Wall time spent executing transforms
+		double			seconds;
+
+		//!	Wall time spent constructing transform objects
+		double			planSeconds;
+	};
+
+
+namespace detail {
+
+	enum TransformStatsCounter {
+		StatsForward, StatsInverse, StatsPlans, StatsBytes, StatsNanoseconds, StatsPlanNanoseconds
+	  , StatsCounterCount
+	};
+
+
+	struct TransformStatsTotals {
+		std::uint64_t	counter[StatsCounterCount] = {};
+	};
+
+
+	//!	One (transform type, length) entry of a per-thread table
+	struct TransformStatsSlot {
+		//!	0 while unused; written once by the owning thread
+		std::atomic<std::uint64_t>	key {0};
+		std::atomic<std::uint64_t>	counter[StatsCounterCount] = {};
+
+		//!	Single-writer increment; cheaper than fetch_add
+		void
+		Add (TransformStatsCounter which, std::uint64_t value)
+		{
+			std::atomic<std::uint64_t>& c = counter[which];
+			c.store(c.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+	};
+
+
+	//!	Open-addressing table of slots owned by one thread
+	struct TransformStatsTable {
+		static const std::size_t capacity = 256;
+
+		//!	The extra last slot collects keys which found no free slot
+		TransformStatsSlot	slots[capacity + 1];
+
+		TransformStatsSlot&
+		Find (std::uint64_t key)
+		{
+			std::size_t i = (key * 0x9E3779B97F4A7C15ull) >> 56;
+
+			for (std::size_t probe = 0; probe < capacity; ++probe, i = (i + 1) % capacity) {
+				const std::uint64_t k = slots[i].key.load(std::memory_order_relaxed);
+
+				if (k == key)
+					return slots[i];
+
+				if (k == 0) {
+					slots[i].key.store(key, std::memory_order_release);
+					return slots[i];
+				}
+			}
+
+			return slots[capacity];
+		}
+	};
+
+
+	inline std::uint64_t
+	TransformStatsKey (std::uint16_t typeIndex, std::size_t length)
+	{ return (std::uint64_t(typeIndex) << 48) | (std::uint64_t(length) & 0xFFFFFFFFFFFFull); }
+
+
+	//!	Process-wide list of live tables, retired totals and transform names
+	class TransformStatsRegistry {
+	  private:
+
+		std::mutex									mutex_;
+		std::vector<TransformStatsTable*>			live_;
+		std::map<std::uint64_t, TransformStatsTotals>	retired_;
+		std::vector<std::string>					names_;
+
+		static void
+		Accumulate (TransformStatsTotals& totals, const TransformStatsSlot& slot)
+		{
+			for (int c = 0; c < StatsCounterCount; ++c)
+				totals.counter[c] += slot.counter[c].load(std::memory_order_relaxed);
+		}
+
+		//!	Adds every used slot of a table to totals, keyed as in the table
+		static void
+		Accumulate (std::map<std::uint64_t, TransformStatsTotals>& totals, const TransformStatsTable& table)
+		{
+			for (std::size_t i = 0; i < TransformStatsTable::capacity; ++i) {
+				const std::uint64_t key = table.slots[i].key.load(std::memory_order_acquire);
+
+				if (key)
+					Accumulate(totals[key], table.slots[i]);
+			}
+
+			//	Counts which found no free slot are reported as "(overflow)", length 0
+			Accumulate(totals[TransformStatsKey(0, 0)], table.slots[TransformStatsTable::capacity]);
+		}
+
+	  public:
+
+		static TransformStatsRegistry&
+		Get (void)
+		{
+			static TransformStatsRegistry registry;
+			return registry;
+		}
+
+
+		//!	Returns a small index for a transform name; index 0 is reserved for overflow
+		std::uint16_t
+		RegisterType (const std::string& name)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+
+			if (names_.empty())
+				names_.push_back("(overflow)");
+
+			names_.push_back(name);
+			return static_cast<std::uint16_t>(names_.size() - 1);
+		}
+
+
+		void
+		Register (TransformStatsTable* table)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+			live_.push_back(table);
+		}
+
+
+		void
+		Retire (TransformStatsTable* table)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+			Accumulate(retired_, *table);
+			live_.erase(std::find(live_.begin(), live_.end(), table));
+		}
+
+
+		std::vector<TransformStatsEntry>
+		Snapshot (void)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+
+			std::map<std::uint64_t, TransformStatsTotals> totals (retired_);
+
+			for (const TransformStatsTable* table : live_)
+				Accumulate(totals, *table);
+
+			std::vector<TransformStatsEntry> result;
+
+			for (const auto& kv : totals) {
+				const std::uint64_t* c = kv.second.counter;
+
+				if (!(c[StatsForward] | c[StatsInverse] | c[StatsPlans]))
+					continue;
+
+				const std::size_t type = kv.first >> 48;
+
+				TransformStatsEntry entry;
+				entry.transform = type < names_.size() ? names_[type] : std::string();
+				entry.length = kv.first & 0xFFFFFFFFFFFFull;
+				entry.forward = c[StatsForward];
+				entry.inverse = c[StatsInverse];
+				entry.plans = c[StatsPlans];
+				entry.bytes = c[StatsBytes];
+				entry.seconds = c[StatsNanoseconds] * 1e-9;
+				entry.planSeconds = c[StatsPlanNanoseconds] * 1e-9;
+				result.push_back(entry);
+			}
+
+			std::sort(result.begin(), result.end(), [](const TransformStatsEntry& a, const TransformStatsEntry& b)
+			{ return std::make_pair(a.transform, a.length) < std::make_pair(b.transform, b.length); });
+
+			return result;
+		}
+	};
+
+
+	//!	Owns the calling thread's table and retires it when the thread exits
+	class TransformStatsThread {
+	  private:
+
+		std::unique_ptr<TransformStatsTable>	table_;
+
+	  public:
+
+		TransformStatsThread (void)
+			: table_(new TransformStatsTable)
+		{ TransformStatsRegistry::Get().Register(table_.get()); }
+
+		~TransformStatsThread (void)
+		{ TransformStatsRegistry::Get().Retire(table_.get()); }
+
+		static TransformStatsTable&
+		Table (void)
+		{
+			//	The registry is constructed first, so it is destroyed after every thread's table
+			TransformStatsRegistry::Get();
+			thread_local TransformStatsThread thread;
+			return *thread.table_;
+		}
+	};
+
+
+	inline std::string
+	DemangledName (const char* name)
+	{
+#ifdef __GNUG__
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+
+		if (status == 0 && demangled) {
+			std::string result (demangled);
+			std::free(demangled);
+			return result;
+		}
+#endif
+		return name;
+	}
+
+
+	template <typename TransformT>
+	std::uint16_t
+	TransformStatsTypeIndex (void)
+	{
+		static const std::uint16_t index =
+				TransformStatsRegistry::Get().RegisterType(DemangledName(typeid(TransformT).name()));
+		return index;
+	}
+
+
+	inline std::uint64_t
+	StatsNanosecondsSince (std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start).count();
+	}
+
+}	//	namespace detail
+
+
+	//!	Records one execution of a TransformT of the given length
+	template <typename TransformT>
+	inline void
+	RecordTransform (bool forward, std::size_t length, std::uint64_t bytes, std::uint64_t nanoseconds)
+	{
+		detail::TransformStatsSlot& slot = detail::TransformStatsThread::Table().Find(
+				detail::TransformStatsKey(detail::TransformStatsTypeIndex<TransformT>(), length));
+
+		slot.Add(forward ? detail::StatsForward : detail::StatsInverse, 1);
+		slot.Add(detail::StatsBytes, bytes);
+		slot.Add(detail::StatsNanoseconds, nanoseconds);
+	}
+
+
+	//!	Records the construction of a TransformT of the given length
+	template <typename TransformT>
+	inline void
+	RecordTransformPlan (std::size_t length, std::uint64_t nanoseconds)
+	{
+		detail::TransformStatsSlot& slot = detail::TransformStatsThread::Table().Find(
+				detail::TransformStatsKey(detail::TransformStatsTypeIndex<TransformT>(), length));
+
+		slot.Add(detail::StatsPlans, 1);
+		slot.Add(detail::StatsPlanNanoseconds, nanoseconds);
+	}
+
+
+	//!	Returns the counters summed over every thread, sorted by transform and length
+	inline std::vector<TransformStatsEntry>
+	TransformStatsSnapshot (void)
+	{ return detail::TransformStatsRegistry::Get().Snapshot(); }
+
+
+	//!	Writes a snapshot in the Prometheus text exposition format
+	inline void
+	WriteTransformStats (std::ostream& os, const std::vector<TransformStatsEntry>& stats = TransformStatsSnapshot())
+	{
+		auto header = [&](const char* name, const char* help)
+		{ os << "# HELP " << name << " " << help << "\n# TYPE " << name << " counter\n"; };
+
+		auto labels = [](const TransformStatsEntry& e)
+		{ return "{transform=\"" + e.transform + "\",length=\"" + std::to_string(e.length) + "\""; };
+
+		header("waveform_transforms_total", "Transforms executed by Waveform");
+		for (const TransformStatsEntry& e : stats) {
+			os << "waveform_transforms_total" << labels(e) << ",direction=\"forward\"} " << e.forward << "\n";
+			os << "waveform_transforms_total" << labels(e) << ",direction=\"inverse\"} " << e.inverse << "\n";
+		}
+
+		header("waveform_transform_bytes_total", "Bytes of both domains touched by transforms");
+		for (const TransformStatsEntry& e : stats)
+			os << "waveform_transform_bytes_total" << labels(e) << "} " << e.bytes << "\n";
+
+		header("waveform_transform_seconds_total", "Wall time spent in transforms");
+		for (const TransformStatsEntry& e : stats)
+			os << "waveform_transform_seconds_total" << labels(e) << "} " << e.seconds << "\n";
+
+		header("waveform_transform_plans_total", "Transform objects (plans) constructed");
+		for (const TransformStatsEntry& e : stats)
+			os << "waveform_transform_plans_total" << labels(e) << "} " << e.plans << "\n";
+
+		header("waveform_transform_plan_seconds_total", "Wall time spent constructing transforms");
+		for (const TransformStatsEntry& e : stats)
+			os << "waveform_transform_plan_seconds_total" << labels(e) << "} " << e.planSeconds << "\n";
+	}
+
+}	//	namespace PS
+
+#endif
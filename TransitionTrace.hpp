@@ -0,0 +1,356 @@
+/*
+ TransitionTrace.hpp
+ Debug tracing of the transforms run by Waveform::ValidateDomain(), with
+ the call site of the accessor which triggered each one, to find code which
+ alternates between the time and freq domains and pays for a full
+ transform on every access.
+
+ Tracing is only compiled in when WAVEFORM_TRACE_TRANSITIONS is defined
+ before Waveform.hpp is included. Otherwise PS::CallSite is an empty type
+ and the accessors' extra default argument costs nothing.
+ */
+
+#ifndef TRANSITIONTRACE_HPP
+#define TRANSITIONTRACE_HPP 1
+#pragma once
+
+#ifdef WAVEFORM_TRACE_TRANSITIONS
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#endif
+
+
+namespace PS {
+
+#ifdef WAVEFORM_TRACE_TRANSITIONS
+
+	//!	Where a Waveform accessor was called from
+	/*!
+	 *	Used as a default argument, Current() picks up the location of the
+	 *	caller of the function taking it (in the same way as C++20's
+	 *	std::source_location::current()).
+	 */
+	struct CallSite {
+		const char*	file;
+		unsigned	line;
+		const char*	function;
+
+#if defined(__GNUC__) || defined(__clang__)
+		static CallSite
+		Current (const char* file = __builtin_FILE(), unsigned line = __builtin_LINE(), const char* function = __builtin_FUNCTION())
+		{ return CallSite { file, line, function }; }
+#else
+		static CallSite
+		Current (void)
+		{ return CallSite { "unknown", 0, "unknown" }; }
+#endif
+	};
+
+#else
+
+	//!	Placeholder for the call site when tracing is compiled out
+	struct CallSite {
+		static constexpr CallSite
+		Current (void)
+		{ return CallSite(); }
+	};
+
+#endif
+
+
+#ifdef WAVEFORM_TRACE_TRANSITIONS
+
+	enum class TransformDirection {Forward, Inverse};
+
+
+	//!	One transform run by ValidateDomain()
+	struct TransitionEvent {
+		//!	Identifies the Waveform; unique for the lifetime of the process
+		std::uint64_t		waveform;
+		TransformDirection	direction;
+		std::size_t			length;
+		CallSite			site;
+	};
+
+
+	//!	Transforms triggered from one call site
+	struct TransitionSiteCount {
+		std::string		file;
+		unsigned		line;
+		std::string		function;
+		std::uint64_t	forward;
+		std::uint64_t	inverse;
+
+		std::uint64_t
+		transforms (void) const
+		{ return forward + inverse; }
+	};
+
+
+	//!	A live Waveform which transformed more often than the report threshold
+	struct WaveformTransitionRecord {
+		std::uint64_t	waveform;
+		std::size_t		length;
+
+		//!	Transforms since the Waveform was created or last changed length
+		std::uint64_t	transforms;
+
+		//!	Where those transforms were triggered from, most frequent first
+		std::vector<TransitionSiteCount>	sites;
+	};
+
+
+	struct TransitionTraceReport {
+		//!	Live Waveforms with more transforms than the threshold, most transforms first
+		std::vector<WaveformTransitionRecord>	waveforms;
+
+		//!	Every call site which triggered a transform, most transforms first, including destroyed Waveforms' transforms
+		std::vector<TransitionSiteCount>		sites;
+	};
+
+
+namespace detail {
+
+	typedef std::tuple<std::string, unsigned, std::string>	TraceSiteKey;
+
+	struct TraceSiteCounts {
+		std::uint64_t	forward = 0;
+		std::uint64_t	inverse = 0;
+	};
+
+
+	inline std::vector<TransitionSiteCount>
+	SortedSites (const std::map<TraceSiteKey, TraceSiteCounts>& sites)
+	{
+		std::vector<TransitionSiteCount> result;
+
+		for (const auto& kv : sites)
+			result.push_back(TransitionSiteCount { std::get<0>(kv.first), std::get<1>(kv.first), std::get<2>(kv.first)
+												 , kv.second.forward, kv.second.inverse });
+
+		std::stable_sort(result.begin(), result.end(), [](const TransitionSiteCount& a, const TransitionSiteCount& b)
+		{ return a.transforms() > b.transforms(); });
+
+		return result;
+	}
+
+
+	//!	Process-wide trace state; a single mutex is fine for a debugging aid
+	class TransitionTracer {
+	  public:
+
+		//!	Number of recent events kept by Events()
+		static const std::size_t eventCapacity = 4096;
+
+	  private:
+
+		struct WaveformState {
+			std::size_t								length = 0;
+			std::uint64_t							transforms = 0;
+			std::map<TraceSiteKey, TraceSiteCounts>	sites;
+		};
+
+		std::mutex									mutex_;
+		std::map<std::uint64_t, WaveformState>		waveforms_;
+		std::map<TraceSiteKey, TraceSiteCounts>		sites_;
+		std::deque<TransitionEvent>					events_;
+
+	  public:
+
+		static TransitionTracer&
+		Get (void)
+		{
+			static TransitionTracer tracer;
+			return tracer;
+		}
+
+
+		static std::uint64_t
+		NextWaveformId (void)
+		{
+			static std::atomic<std::uint64_t> next {1};
+			return next.fetch_add(1, std::memory_order_relaxed);
+		}
+
+
+		void
+		Record (const TransitionEvent& event)
+		{
+			const TraceSiteKey key (event.site.file, event.site.line, event.site.function);
+			const bool forward = event.direction == TransformDirection::Forward;
+
+			std::lock_guard<std::mutex> lock (mutex_);
+
+			WaveformState& state = waveforms_[event.waveform];
+
+			if (state.length != event.length) {
+				state = WaveformState();
+				state.length = event.length;
+			}
+
+			++state.transforms;
+			++(forward ? state.sites[key].forward : state.sites[key].inverse);
+			++(forward ? sites_[key].forward : sites_[key].inverse);
+
+			events_.push_back(event);
+			if (events_.size() > eventCapacity)
+				events_.pop_front();
+		}
+
+
+		TransitionTraceReport
+		Report (std::uint64_t threshold)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+
+			TransitionTraceReport report;
+
+			for (const auto& kv : waveforms_) {
+				if (kv.second.transforms > threshold)
+					report.waveforms.push_back(WaveformTransitionRecord { kv.first, kv.second.length
+																		, kv.second.transforms, SortedSites(kv.second.sites) });
+			}
+
+			std::stable_sort(report.waveforms.begin(), report.waveforms.end()
+							, [](const WaveformTransitionRecord& a, const WaveformTransitionRecord& b)
+			{ return a.transforms > b.transforms; });
+
+			report.sites = SortedSites(sites_);
+			return report;
+		}
+
+
+		//!	Drops a destroyed Waveform's entry; its transforms stay in the per-site histogram
+		void
+		Forget (const std::uint64_t waveform)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+			waveforms_.erase(waveform);
+		}
+
+
+		std::vector<TransitionEvent>
+		Events (void)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+			return std::vector<TransitionEvent>(events_.begin(), events_.end());
+		}
+
+
+		void
+		Reset (void)
+		{
+			std::lock_guard<std::mutex> lock (mutex_);
+			waveforms_.clear();
+			sites_.clear();
+			events_.clear();
+		}
+	};
+
+
+	//!	Gives each Waveform an id for the trace; copies and moves get a new one
+	/*!
+	 *	The tracer's entry for the id is dropped with the TraceId, so the
+	 *	table of Waveforms only holds live ones however long the run.
+	 */
+	class TraceId {
+	  private:
+
+		std::uint64_t	id_;
+
+	  public:
+
+		//	Get() makes sure the tracer is constructed first, so that it outlives a static Waveform
+		TraceId (void)
+			: id_((TransitionTracer::Get(), TransitionTracer::NextWaveformId()))
+		{ }
+
+		TraceId (const TraceId&)
+			: TraceId()
+		{ }
+
+		~TraceId (void)
+		{ TransitionTracer::Get().Forget(id_); }
+
+		TraceId&
+		operator= (const TraceId&)
+		{ return *this; }
+
+		std::uint64_t
+		get (void) const
+		{ return id_; }
+	};
+
+}	//	namespace detail
+
+
+	//!	Records a transform run by a Waveform; called from Waveform::ValidateDomain()
+	inline void
+	RecordTransition (std::uint64_t waveform, TransformDirection direction, std::size_t length, const CallSite& site)
+	{ detail::TransitionTracer::Get().Record(TransitionEvent { waveform, direction, length, site }); }
+
+
+	//!	Returns the Waveforms with more than threshold transforms, and the per-site histogram
+	/*!
+	 *	A Waveform's count restarts whenever it transforms at a different
+	 *	length, so the report singles out repeated transforms of unchanged
+	 *	data shapes, which usually come from alternating GetTimeSeries() and
+	 *	GetFreqSpectrum() in a loop. Only live Waveforms are listed; the
+	 *	transforms of destroyed ones are still counted per call site.
+	 */
+	inline TransitionTraceReport
+	GetTransitionTraceReport (std::uint64_t threshold)
+	{ return detail::TransitionTracer::Get().Report(threshold); }
+
+
+	//!	Returns the most recent transforms, oldest first
+	inline std::vector<TransitionEvent>
+	TransitionTraceEvents (void)
+	{ return detail::TransitionTracer::Get().Events(); }
+
+
+	//!	Forgets everything recorded so far
+	inline void
+	ResetTransitionTrace (void)
+	{ detail::TransitionTracer::Get().Reset(); }
+
+
+	//!	Writes GetTransitionTraceReport(threshold) in a readable form
+	inline void
+	WriteTransitionTraceReport (std::ostream& os, std::uint64_t threshold)
+	{
+		const TransitionTraceReport report = GetTransitionTraceReport(threshold);
+
+		os << "Waveforms with more than " << threshold << " transforms at an unchanged length: "
+		   << report.waveforms.size() << "\n";
+
+		for (const WaveformTransitionRecord& w : report.waveforms) {
+			os << "  waveform #" << w.waveform << ", length " << w.length << ": " << w.transforms << " transforms\n";
+
+			for (const TransitionSiteCount& s : w.sites)
+				os << "    " << s.transforms() << "\t" << s.file << ":" << s.line << " (" << s.function << ")\n";
+		}
+
+		os << "Transforms per call site:\n";
+
+		for (const TransitionSiteCount& s : report.sites)
+			os << "  " << s.forward << " forward, " << s.inverse << " inverse\t"
+			   << s.file << ":" << s.line << " (" << s.function << ")\n";
+	}
+
+#endif
+
+}	//	namespace PS
+
+#endif
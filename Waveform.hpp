@@ -15,9 +15,14 @@
 #include <functional>
 #include <iterator>
 #include <numeric>
+#include <utility>
+#include <cstddef>
+#include <memory>
 //#include <fstream>
 #include <string>
+#include <stdexcept>
 #include <cmath>
+#include <complex>
 //#include <iomanip>
 //#include <sstream>
 
@@ -33,6 +38,18 @@
 #include <boost/assert.hpp>
 
 
+// Waveform header files
+
+#include <TransformTypes.hpp>
+#include <TransitionTrace.hpp>
+#include <Span.hpp>
+
+#ifdef WAVEFORM_TRANSFORM_STATS
+#include <chrono>
+#include <TransformStats.hpp>
+#endif
+
+
 #define WAVEFORM_USE_CBEGIN_CEND 1
 
 /*!
@@ -111,6 +128,203 @@ namespace PS {
 
 		}
 	};
+
+
+namespace detail {
+
+	//!	The lengths of the two domain arrays, as laid out by a transform
+	/*!
+	 *	By default the freq domain holds the N/2+1 bins of a real-to-complex
+	 *	transform of N samples. A transform with a different layout (such
+	 *	as the N reals of a half-complex spectrum) declares it with static
+	 *	member functions freq_length(timeLength) and time_length(freqLength).
+	 */
+	template <typename TransformT, typename = void>
+	struct DomainLengths {
+		static std::size_t
+		freq_length (const std::size_t timeLength)
+		{ return timeLength / 2 + 1; }
+
+		static std::size_t
+		time_length (const std::size_t freqLength)
+		{ return (freqLength - 1) * 2; }
+	};
+
+	template <typename TransformT>
+	struct DomainLengths<TransformT, decltype(void(TransformT::freq_length(std::size_t())))> {
+		static std::size_t
+		freq_length (const std::size_t timeLength)
+		{ return TransformT::freq_length(timeLength); }
+
+		static std::size_t
+		time_length (const std::size_t freqLength)
+		{ return TransformT::time_length(freqLength); }
+	};
+
+
+	//!	The inverse_type of a transform, or InverseTypes::Other if it declares none
+	template <typename TransformT, typename = void>
+	struct InverseTypeOf {
+		typedef InverseTypes::Other	type;
+	};
+
+	template <typename TransformT>
+	struct InverseTypeOf<TransformT, decltype(void(typename TransformT::inverse_type()))> {
+		typedef typename TransformT::inverse_type	type;
+	};
+
+
+	//!	TransformT::spectral_product_is_convolution, or false if it declares none
+	/*!
+	 *	A transform declares it true when multiplying two of its freq
+	 *	domains bin by bin convolves the time domains (the r2c DFTs), which
+	 *	Waveform::operator*= relies on.
+	 */
+	template <typename TransformT, typename = void>
+	struct SpectralProductIsConvolution : std::false_type { };
+
+	template <typename TransformT>
+	struct SpectralProductIsConvolution<TransformT, decltype(void(TransformT::spectral_product_is_convolution))>
+		: std::integral_constant<bool, TransformT::spectral_product_is_convolution> { };
+
+
+	//!	The scalar type of an element (T for T and for std::complex<T>) and how many make one
+	template <typename T>
+	struct ScalarOf {
+		typedef T	type;
+		static const std::size_t count = 1;
+	};
+
+	template <typename T>
+	struct ScalarOf< std::complex<T> > {
+		typedef T	type;
+		static const std::size_t count = 2;
+	};
+
+
+	//!	True for a container with data(), whose elements are contiguous
+	template <typename Container, typename = void>
+	struct HasData : std::false_type {};
+
+	template <typename Container>
+	struct HasData<Container, decltype(void(std::declval<const Container&>().data()))> : std::true_type {};
+
+
+	//!	True if the element-wise kernels may run over the two containers as plain arrays of scalars
+	template <typename Container1, typename Container2>
+	using ScalarKernels = std::integral_constant<bool
+			, HasData<Container1>::value && HasData<Container2>::value
+			&& std::is_same<typename Container1::value_type, typename Container2::value_type>::value>;
+
+
+	/*
+		The element-wise kernels behind Waveform's compound assignments.
+
+		With std::true_type both containers are contiguous arrays of the same
+		element type, and std::complex<T> is viewed as two T (as the standard
+		allows), so each kernel is one loop over scalars, which the compiler
+		vectorizes. The complex product is written out rather than left to
+		std::complex's operator*, whose checks for infinities keep it from
+		vectorizing. With std::false_type (as for PS::SplitComplexVector) the
+		same is done element by element through operator[].
+	 */
+
+	//!	lhs[i] += factor * rhs[i]
+	template <typename Container1, typename Container2>
+	inline void
+	AddInPlace (Container1& lhs, const Container2& rhs, const double factor, std::true_type)
+	{
+		typedef ScalarOf<typename Container1::value_type>	Scalar;
+		typedef typename Scalar::type						T;
+
+		T* l = reinterpret_cast<T*>(lhs.data());
+		const T* r = reinterpret_cast<const T*>(rhs.data());
+		const std::size_t n = lhs.size() * Scalar::count;
+		const T f = T(factor);
+
+		for (std::size_t i = 0; i < n; ++i)
+			l[i] += f * r[i];
+	}
+
+	template <typename Container1, typename Container2>
+	inline void
+	AddInPlace (Container1& lhs, const Container2& rhs, const double factor, std::false_type)
+	{
+		typedef typename Container1::value_type		V;
+		const typename ScalarOf<V>::type f (factor);
+
+		for (std::size_t i = 0; i < lhs.size(); ++i)
+			lhs[i] = V(lhs[i]) + f * V(rhs[i]);
+	}
+
+
+	//!	c[i] *= factor
+	template <typename Container>
+	inline void
+	ScaleInPlace (Container& c, const double factor, std::true_type)
+	{
+		typedef ScalarOf<typename Container::value_type>	Scalar;
+		typedef typename Scalar::type						T;
+
+		T* p = reinterpret_cast<T*>(c.data());
+		const std::size_t n = c.size() * Scalar::count;
+		const T f = T(factor);
+
+		for (std::size_t i = 0; i < n; ++i)
+			p[i] *= f;
+	}
+
+	template <typename Container>
+	inline void
+	ScaleInPlace (Container& c, const double factor, std::false_type)
+	{
+		typedef typename Container::value_type		V;
+		const typename ScalarOf<V>::type f (factor);
+
+		for (std::size_t i = 0; i < c.size(); ++i)
+			c[i] = V(c[i]) * f;
+	}
+
+
+	//!	lhs[k] *= rhs[k] for complex elements
+	template <typename Container1, typename Container2>
+	inline void
+	MultiplyInPlace (Container1& lhs, const Container2& rhs, std::true_type)
+	{
+		typedef typename ScalarOf<typename Container1::value_type>::type	T;
+
+		T* l = reinterpret_cast<T*>(lhs.data());
+		const T* r = reinterpret_cast<const T*>(rhs.data());
+
+		for (std::size_t k = 0; k < lhs.size(); ++k) {
+			const T re = l[2*k] * r[2*k] - l[2*k+1] * r[2*k+1];
+			const T im = l[2*k] * r[2*k+1] + l[2*k+1] * r[2*k];
+			l[2*k] = re;
+			l[2*k+1] = im;
+		}
+	}
+
+	template <typename Container1, typename Container2>
+	inline void
+	MultiplyInPlace (Container1& lhs, const Container2& rhs, std::false_type)
+	{
+		typedef typename Container1::value_type		V;
+
+		for (std::size_t k = 0; k < lhs.size(); ++k) {
+			const V a (lhs[k]);
+			const V b (rhs[k]);
+			lhs[k] = V(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+		}
+	}
+
+}	//	namespace detail
+
+
+	//!	When Waveform::Edit() recomputes the domain which was not edited
+	enum class EditPolicy {
+		Lazy,	//!< On the next access which needs it, as for any other write
+		Eager	//!< Straight away, when the edit is committed
+	};
 	
 	
 	
@@ -185,20 +399,42 @@ namespace PS {
 		//enum DomainSpecifier {TimeDomain, FreqDomain, EitherDomain};
 		enum class Domain {Time, Freq, Either};
 
+		//!	Which domain array(s) currently hold valid data
+		/*!
+		 *	Neither is the state of a Waveform made by the fill constructor:
+		 *	no data has been given yet, so either domain may be written
+		 *	without a transform, and reading one does not transform either.
+		 */
+		enum class DomainState {Neither, Time, Freq, Both};
+
 	  private:
 
 		//!	Indicates the valid domain array(s)
-		//DomainSpecifier				validDomain_;
-		Domain			validDomain_;
+		/*!
+		 *	The state and both arrays are mutable because the Const
+		 *	accessors fill in a stale domain on demand; this is caching,
+		 *	and does not change the signal the Waveform describes.
+		 */
+		mutable DomainState		state_;
 
 		//!	Container object for the time series array
-		TimeContainer	timeSeries_;
+		mutable TimeContainer	timeSeries_;
 
 		//!	Container object for the frequency spectrum array
-		FreqContainer	freqSpectrum_;
+		mutable FreqContainer	freqSpectrum_;
+
+#ifdef WAVEFORM_TRANSFORM_STATS
+		//!	When construction of transform_ began, for RecordTransformPlan()
+		std::chrono::steady_clock::time_point	planStart_ = std::chrono::steady_clock::now();
+#endif
 
 		//!	Transform class object which wraps the forward and inverse transform functions
-		TransformT		transform_;
+		mutable TransformT		transform_;
+
+#ifdef WAVEFORM_TRACE_TRANSITIONS
+		//!	Identifies this Waveform in the transition trace
+		detail::TraceId	traceId_;
+#endif
  
 		//!	Default constructor
 		/*! 
@@ -216,33 +452,122 @@ namespace PS {
 			: validDomain_(EitherDomain)
 		{ }
 		*/
+
+
+		//!	Records the construction of transform_ (WAVEFORM_TRANSFORM_STATS only)
+		void
+		RecordPlan (void)
+		{
+#ifdef WAVEFORM_TRANSFORM_STATS
+			RecordTransformPlan<TransformT>(timeSeries_.size(), detail::StatsNanosecondsSince(planStart_));
+#endif
+		}
+
+
+		//!	Runs the forward transform, recording it for TransformStats and TransitionTrace if enabled
+		void
+		ExecTransform (const CallSite& site) const
+		{
+#ifdef WAVEFORM_TRANSFORM_STATS
+			const auto start = std::chrono::steady_clock::now();
+			transform_.exec_transform();
+			RecordTransform<TransformT>(true, timeSeries_.size(), DomainBytes(), detail::StatsNanosecondsSince(start));
+#else
+			transform_.exec_transform();
+#endif
+
+#ifdef WAVEFORM_TRACE_TRANSITIONS
+			RecordTransition(traceId_.get(), TransformDirection::Forward, timeSeries_.size(), site);
+#else
+			(void)site;
+#endif
+		}
+
+
+		//!	Runs the inverse transform, recording it for TransformStats and TransitionTrace if enabled
+		void
+		ExecInverseTransform (const CallSite& site) const
+		{
+#ifdef WAVEFORM_TRANSFORM_STATS
+			const auto start = std::chrono::steady_clock::now();
+			transform_.exec_inverse_transform();
+			RecordTransform<TransformT>(false, timeSeries_.size(), DomainBytes(), detail::StatsNanosecondsSince(start));
+#else
+			transform_.exec_inverse_transform();
+#endif
+
+#ifdef WAVEFORM_TRACE_TRANSITIONS
+			RecordTransition(traceId_.get(), TransformDirection::Inverse, timeSeries_.size(), site);
+#else
+			(void)site;
+#endif
+		}
+
+
+		//!	Size in bytes of both domain arrays
+		std::size_t
+		DomainBytes (void) const
+		{ return timeSeries_.size() * sizeof(TimeT) + freqSpectrum_.size() * sizeof(FreqT); }
+
+
+		//!	The state in which only the given domain (Time or Freq) is valid
+		static DomainState
+		StateOf (const Domain domain)
+		{ return domain == Domain::Time ? DomainState::Time : DomainState::Freq; }
+
+
+		//!	Brings one domain up to date for reading, leaving the other valid
+		/*!
+		 *	From Neither there is nothing to compute, so no transform is run
+		 *	and the state is left as it is.
+		 */
+		void
+		ValidateForRead (const Domain toRead, const CallSite& site) const
+		{
+			if (toRead == Domain::Time && state_ == DomainState::Freq) {
+				ExecInverseTransform(site);
+				state_ = DomainState::Both;
+			}
+			else if (toRead == Domain::Freq && state_ == DomainState::Time) {
+				ExecTransform(site);
+				state_ = DomainState::Both;
+			}
+		}
 		
 	  public:
 		
 		//! Fill constructor
 		Waveform(const std::size_t count)
 			//: validDomain_(EitherDomain)
-			: validDomain_(Domain::Either)
+			: state_(DomainState::Neither)
 			, timeSeries_(count)
-			, freqSpectrum_(count)
+			, freqSpectrum_(detail::DomainLengths<TransformT>::freq_length(count))
 			, transform_(timeSeries_, freqSpectrum_)
 		{ 
 			if (timeSeries_.size()%2)
 				throw std::length_error("Waveform: The array length was not a multiple of 2!");
+
+			RecordPlan();
 		}
 
 
 		//! Copy constructor
+		/*!
+		 *	The transform is constructed anew over the copied containers;
+		 *	copying toCopy.transform_ would leave it operating on the
+		 *	arrays of toCopy.
+		 */
 		explicit
 		Waveform(const Waveform& toCopy)
-			: validDomain_(toCopy.validDomain_)
+			: state_(toCopy.state_)
 			, timeSeries_(toCopy.timeSeries_)
 			, freqSpectrum_(toCopy.freqSpectrum_)
-			//, transform_(timeSeries_, freqSpectrum_)
-			, transform_ (toCopy.transform_)
+			, transform_(timeSeries_, freqSpectrum_)
 		{
 			if (timeSeries_.size()%2)
 				throw std::length_error("Waveform: The array length was not a multiple of 2!");
+
+			RecordPlan();
 		}
 		
 		
@@ -251,27 +576,93 @@ namespace PS {
 		//! Time domain copy constructor
 		explicit Waveform(const TimeContainer& toCopy)
 			//: validDomain_(TimeDomain)
-			: validDomain_(Domain::Time)
+			: state_(DomainState::Time)
 			, timeSeries_(toCopy)
-			, freqSpectrum_(timeSeries_.size()/2 + 1)
+			, freqSpectrum_(detail::DomainLengths<TransformT>::freq_length(timeSeries_.size()))
 			, transform_(timeSeries_, freqSpectrum_)
 		{
 			if (timeSeries_.size()%2)
 				throw std::length_error("Waveform: The array length was not a multiple of 2!");
+
+			RecordPlan();
 		}
 		
 		//! Frequency domain copy constructor
 		explicit Waveform(const FreqContainer& toCopy)
 			//: validDomain_(FreqDomain)
-			: validDomain_(Domain::Freq)
-			, timeSeries_((toCopy.size() - 1) * 2)
+			: state_(DomainState::Freq)
+			, timeSeries_(detail::DomainLengths<TransformT>::time_length(toCopy.size()))
 			, freqSpectrum_(toCopy)
 			, transform_(timeSeries_, freqSpectrum_)
 		{
 			if (timeSeries_.size()%2)
 				throw std::length_error("Waveform: The array length was not a multiple of 2!");
+
+			RecordPlan();
 		}
 		
+
+		//!	Fill constructor allocating both domains with alloc
+		/*!
+		 *	This and the other allocator-extended constructors place the
+		 *	domains with the given allocator, such as a
+		 *	std::pmr::polymorphic_allocator over an arena (see
+		 *	WaveformArena.hpp); the freq domain's allocator is made from
+		 *	alloc, as allocators of different types are made from each other.
+		 *	The constructors without one use default-constructed allocators.
+		 */
+		Waveform(const std::size_t count, const TimeAllocT& alloc)
+			: state_(DomainState::Neither)
+			, timeSeries_(count, alloc)
+			, freqSpectrum_(detail::DomainLengths<TransformT>::freq_length(count), FreqAllocT(alloc))
+			, transform_(timeSeries_, freqSpectrum_)
+		{
+			if (timeSeries_.size()%2)
+				throw std::length_error("Waveform: The array length was not a multiple of 2!");
+
+			RecordPlan();
+		}
+
+
+		//!	Copy constructor allocating both domains with alloc
+		Waveform(const Waveform& toCopy, const TimeAllocT& alloc)
+			: state_(toCopy.state_)
+			, timeSeries_(toCopy.timeSeries_, alloc)
+			, freqSpectrum_(toCopy.freqSpectrum_, FreqAllocT(alloc))
+			, transform_(timeSeries_, freqSpectrum_)
+		{
+			RecordPlan();
+		}
+
+
+		//!	Time domain copy constructor allocating both domains with alloc
+		Waveform(const TimeContainer& toCopy, const TimeAllocT& alloc)
+			: state_(DomainState::Time)
+			, timeSeries_(toCopy, alloc)
+			, freqSpectrum_(detail::DomainLengths<TransformT>::freq_length(timeSeries_.size()), FreqAllocT(alloc))
+			, transform_(timeSeries_, freqSpectrum_)
+		{
+			if (timeSeries_.size()%2)
+				throw std::length_error("Waveform: The array length was not a multiple of 2!");
+
+			RecordPlan();
+		}
+
+
+		//!	Frequency domain copy constructor allocating both domains with alloc
+		Waveform(const FreqContainer& toCopy, const FreqAllocT& alloc)
+			: state_(DomainState::Freq)
+			, timeSeries_(detail::DomainLengths<TransformT>::time_length(toCopy.size()), TimeAllocT(alloc))
+			, freqSpectrum_(toCopy, alloc)
+			, transform_(timeSeries_, freqSpectrum_)
+		{
+			if (timeSeries_.size()%2)
+				throw std::length_error("Waveform: The array length was not a multiple of 2!");
+
+			RecordPlan();
+		}
+
+
 		//!	Default destructor
 		~Waveform (void) {}
 		
@@ -284,47 +675,47 @@ namespace PS {
 		 *	design 100% in line with the STL idioms)>
 		 */
 		std::size_t
-		GetSize	(void) //const
-		{ return GetConstTimeSeries().size(); }
+		GetSize	(void) const
+		{ return timeSeries_.size(); }
 	
 
 		//!	Returns the size of the time domain container
+		/*!
+		 *	The length never depends on which domain is valid, so this
+		 *	does not transform.
+		 */
 		std::size_t
-		size (void) //const
-		{ return GetConstTimeSeries().size(); }
+		size (void) const
+		{ return timeSeries_.size(); }
 		
 
 		//!	Returns constant reference to the time domain container
 		/*!
-		 *	Pass "EitherDomain" because domain will not be modified.
+		 *	Only the time domain is brought up to date: if it is stale,
+		 *	the inverse transform runs once and both domains are valid
+		 *	afterwards. A valid freq domain is never invalidated.
 		 *
-		 *	Unfortunately the const keyword cannot be used here,
-		 *	because ValidateDomain(...) could modify the class.
-		 *	
-		 *	If enough thought went into it, there could be a way
-		 *	to separate these cases and use overloading between the
-		 *	non-const and const member methods.
+		 *	This is a const member (the state is mutable), so it must not
+		 *	be called on the same Waveform from several threads at once
+		 *	while a domain is stale.
 		 */
 		const TimeContainer&
-		GetConstTimeSeries (void)
+		GetConstTimeSeries (const CallSite& site = CallSite::Current()) const
 		//{ ValidateDomain(EitherDomain); return timeSeries_; }
-		{ ValidateDomain(Domain::Either); return timeSeries_; }
+		{ ValidateForRead(Domain::Time, site); return timeSeries_; }
 		
 
 		//!	Returns constant reference to the frequency domain container
 		/*!
-		 *	Pass "EitherDomain" because domain will not be modified.
-		 *	Unfortunately the const keyword cannot be used here,
-		 *	because ValidateDomain(...) could modify the class.
-		 *	
-		 *	If enough thought went into it, there could be a way
-		 *	to separate these cases and use overloading between the
-		 *	non-const and const member methods.
+		 *	Only the freq domain is brought up to date: if it is stale,
+		 *	the forward transform runs once and both domains are valid
+		 *	afterwards. The same threading caveat as GetConstTimeSeries()
+		 *	applies.
 		 */
 		const FreqContainer&
-		GetConstFreqSpectrum (void)
+		GetConstFreqSpectrum (const CallSite& site = CallSite::Current()) const
 		//{ ValidateDomain(EitherDomain); return freqSpectrum_; }
-		{ ValidateDomain(Domain::Either); return freqSpectrum_; }
+		{ ValidateForRead(Domain::Freq, site); return freqSpectrum_; }
 		
 
 		//!	Returns mutable reference to the time domain container
@@ -334,9 +725,9 @@ namespace PS {
 		 *	scenes, given the valid frequency domain; returns when complete.
 		 */
 		TimeContainer&
-		GetTimeSeries (void)
+		GetTimeSeries (const CallSite& site = CallSite::Current())
 		//{ ValidateDomain(TimeDomain); return timeSeries_; }
-		{ ValidateDomain(Domain::Time); return timeSeries_; }
+		{ ValidateDomain(Domain::Time, site); return timeSeries_; }
 		
 
 		//!	Returns mutable reference to the frequency domain container
@@ -346,9 +737,209 @@ namespace PS {
 		 *	scenes, given the valid time domain; returns when complete.
 		 */
 		FreqContainer&
-		GetFreqSpectrum (void)
+		GetFreqSpectrum (const CallSite& site = CallSite::Current())
 		//{ ValidateDomain(FreqDomain); return freqSpectrum_; }
-		{ ValidateDomain(Domain::Freq); return freqSpectrum_; }
+		{ ValidateDomain(Domain::Freq, site); return freqSpectrum_; }
+		
+
+
+		//!	Scoped, unchecked write access to one domain; see Waveform::Edit()
+		class EditScope {
+		  private:
+
+			friend class Waveform;
+
+			Waveform*		waveform_;
+			Domain			domain_;
+			EditPolicy		policy_;
+			CallSite		site_;
+
+			EditScope (Waveform& wfm, const Domain domain, const EditPolicy policy, const CallSite& site)
+				: waveform_(&wfm)
+				, domain_(domain)
+				, policy_(policy)
+				, site_(site)
+			{ }
+
+		  public:
+
+			EditScope (const EditScope&) = delete;
+
+			EditScope&
+			operator= (const EditScope&) = delete;
+
+			EditScope (EditScope&& rhs)
+				: waveform_(rhs.waveform_)
+				, domain_(rhs.domain_)
+				, policy_(rhs.policy_)
+				, site_(rhs.site_)
+			{ rhs.waveform_ = nullptr; }
+
+			//!	Commits the edit if Commit() was not called
+			~EditScope (void)
+			{ Commit(); }
+
+
+			//!	The time domain array; only for an edit of Domain::Time
+			Span<TimeT>
+			Time (void) const
+			{
+				BOOST_ASSERT(waveform_ && domain_ == Domain::Time);
+				return Span<TimeT>(waveform_->timeSeries_);
+			}
+
+
+			//!	The freq domain array; only for an edit of Domain::Freq
+			Span<FreqT>
+			Freq (void) const
+			{
+				BOOST_ASSERT(waveform_ && domain_ == Domain::Freq);
+				return Span<FreqT>(waveform_->freqSpectrum_);
+			}
+
+
+			//!	Marks the other domain stale (and recomputes it if the policy is Eager)
+			/*!
+			 *	Only the first call has any effect; the spans must not be
+			 *	used afterwards.
+			 */
+			void
+			Commit (void)
+			{
+				if (!waveform_)
+					return;
+
+				Waveform& wfm = *waveform_;
+				waveform_ = nullptr;
+
+				wfm.state_ = StateOf(domain_);
+
+				if (policy_ == EditPolicy::Eager)
+					wfm.ValidateDomain(Domain::Either, site_);
+			}
+		};
+
+
+		//!	Opens an edit of one domain, committed when the returned scope ends
+		/*!
+		 *	The edited domain is brought up to date first (transforming if
+		 *	it is stale), after which the scope hands out raw spans over it:
+		 *
+		 *		{
+		 *			auto e = wfm.Edit(WaveformType::Domain::Freq);
+		 *			auto spectrum = e.Freq();
+		 *			for (std::size_t i = 0; i < spectrum.size(); ++i)
+		 *				spectrum[i] *= filter[i];
+		 *		}
+		 *
+		 *	No transforms happen while the scope is open, however many
+		 *	writes are made. When it ends (or Commit() is called) the other
+		 *	domain is marked stale once, and with EditPolicy::Eager it is
+		 *	recomputed immediately instead of on the next access.
+		 *
+		 *	The Waveform must not be used through its other members while
+		 *	the edit is open, and the spans are invalidated by any change of
+		 *	length.
+		 */
+		EditScope
+		Edit (const Domain toEdit, const EditPolicy policy = EditPolicy::Lazy, const CallSite& site = CallSite::Current())
+		{
+			if (toEdit == Domain::Either)
+				throw std::invalid_argument("Waveform: Edit() takes Domain::Time or Domain::Freq");
+
+			//	Keep the other domain valid until the edit is committed
+			ValidateForRead(toEdit, site);
+
+			return EditScope(*this, toEdit, policy, site);
+		}
+
+
+		//!	Returns the domain(s) which currently hold valid data
+		DomainState
+		GetValidDomain (void) const
+		{ return state_; }
+
+
+		//!	Returns the allocator of the time domain container
+		TimeAllocT
+		GetTimeAllocator (void) const
+		{ return timeSeries_.get_allocator(); }
+
+
+		//!	Returns the allocator of the freq domain container
+		FreqAllocT
+		GetFreqAllocator (void) const
+		{ return freqSpectrum_.get_allocator(); }
+
+
+		//!	True if the time domain can be read without a transform
+		/*!
+		 *	A Waveform in the Neither state reports neither domain valid.
+		 */
+		bool
+		IsTimeValid (void) const
+		{ return state_ == DomainState::Time || state_ == DomainState::Both; }
+
+
+		//!	True if the freq domain can be read without a transform
+		bool
+		IsFreqValid (void) const
+		{ return state_ == DomainState::Freq || state_ == DomainState::Both; }
+
+
+		//!	Marks domain(s) as valid without performing any transform
+		/*!
+		 *	This is meant for code which restores a Waveform from storage,
+		 *	where the contents of the domain(s) were written directly (for
+		 *	instance through OverwriteTimeSeries()) and are already known
+		 *	to be consistent. Passing DomainState::Both asserts that both
+		 *	domain arrays describe the same signal.
+		 */
+		void
+		AssumeValidDomain (const DomainState toAssume)
+		{ state_ = toAssume; }
+
+
+		//!	Returns constant reference to the time domain container as stored
+		/*!
+		 *	No validation is performed, so the contents are only meaningful
+		 *	if GetValidDomain() reports the time domain as valid.
+		 */
+		const TimeContainer&
+		PeekTimeSeries (void) const
+		{ return timeSeries_; }
+
+
+		//!	Returns constant reference to the freq domain container as stored
+		/*!
+		 *	No validation is performed, so the contents are only meaningful
+		 *	if GetValidDomain() reports the freq domain as valid.
+		 */
+		const FreqContainer&
+		PeekFreqSpectrum (void) const
+		{ return freqSpectrum_; }
+
+
+		//!	Returns mutable reference to the time domain container, skipping the transform
+		/*!
+		 *	The caller promises to overwrite every element, so the previous
+		 *	contents of either domain are irrelevant: the time domain is
+		 *	marked valid and the freq domain stale without transforming.
+		 */
+		TimeContainer&
+		OverwriteTimeSeries (void)
+		{ state_ = DomainState::Time; return timeSeries_; }
+
+
+		//!	Returns mutable reference to the freq domain container, skipping the transform
+		/*!
+		 *	The caller promises to overwrite every element, so the previous
+		 *	contents of either domain are irrelevant: the freq domain is
+		 *	marked valid and the time domain stale without transforming.
+		 */
+		FreqContainer&
+		OverwriteFreqSpectrum (void)
+		{ state_ = DomainState::Freq; return freqSpectrum_; }
 		
 		
 
@@ -392,62 +983,38 @@ namespace PS {
 		 *	based on which domain(s) are valid as well as the domain which was
 		 *	requested by the programmer.
 		 *
-		 *	As a reminder, DomainSpecifier is an enumeration which can be set
-		 *	to one of 3 unique values: TimeDomain, FreqDomain, EitherDomain.
+		 *	The member state_ records which domain array(s) are up to date:
 		 *
-		 *	The variable validDomain_ maintains the current state of the system.
-		 *	Each of the values of validDomain_ and their meaning are described
-		 *	below:
+		 *		Neither		the Waveform was made by the fill constructor and
+		 *					holds no data yet. Either array may be written
+		 *					without a transform, and nothing is computed
+		 *					when one is read.
 		 *
-		 *		TimeDomain		the time domain array timeSeries_ is valid,
-		 *						while the contents of freqSpectrum_ should be
-		 *						assumed to be out of date / invalid.
+		 *		Time		timeSeries_ is valid, freqSpectrum_ is stale.
 		 *
-		 *		FreqDomain		the freq domain array freqSpectrum_ is valid,
-		 *						while the contents of timeSeries_ should be
-		 *						assumed to be out of date / invalid.
+		 *		Freq		freqSpectrum_ is valid, timeSeries_ is stale.
 		 *
-		 *		EitherDomain	this has to meanings, both of which ultimately
-		 *						can be treated the same way:
-		 *							1:	The last domain requested was done so
-		 *								using one of the "Const" accessor
-		 *								functions, so both of the domain arrays
-		 *								may be read and modified from this
-		 *								state.
-		 *							2:	The Waveform was just constructed and
-		 *								neither of the domain arrays contain
-		 *								"useful" (useful to the user)
-		 *								information. This means that either of
-		 *								the domain arrays may be written to
-		 *								without worrying about the validity of
-		 *								the other domain. However, this also
-		 *								means that neither of the domain arrays
-		 *								can be read to provide valid data, but
-		 *								since the user just initialized the
-		 *								object they should be aware in any
-		 *								circumstance that the arrays contain
-		 *								only garbage.
+		 *		Both		both arrays describe the same signal; this is
+		 *					the state after a transform, until one of the
+		 *					arrays is handed out for writing.
 		 *
-		 *	The function parameter toValidate can take on those same three
-		 *	values, this time with slightly different meanings:
+		 *	The parameter toValidate says what the caller is about to do:
 		 *
-		 *		TimeDomain		the time domain array was requested and
-		 *						transforms should be performed as needed in
-		 *						order to validate the domain.
+		 *		Time, Freq	the array is handed out for writing. A stale
+		 *					array is transformed into from the other one
+		 *					(never when the state is Neither or Both), and
+		 *					afterwards only the requested domain is valid.
 		 *
-		 *		FreqDomain		the freq domain array was requested and
-		 *						transforms should be performed as needed in
-		 *						order to validate the domain.
+		 *		Either		both arrays are brought up to date (at most one
+		 *					transform), leaving the state Both; from
+		 *					Neither there is nothing to compute.
 		 *
-		 *		EitherDomain	the request for one of the domain arrays was
-		 *						of the "Const" variety, so no matter which
-		 *						domain the user wanted, both domain arrays
-		 *						will be valid after the call. Using
-		 *						EitherDomain like this allows the
-		 *						implementation to be much simpler.
+		 *	Reads through the Const accessors do not come through here: they
+		 *	only ever fill in the domain which was asked for, and never mark
+		 *	the other one stale.
 		 *
 		 *	Because this is the core mechanism of the library, it's important
-		 *	to note that the use of EitherDomain like this is fundamentally
+		 *	to note that keeping both domains valid like this is fundamentally
 		 *	reliant on the transform class used for the Waveform classes'
 		 *	template parameter TransformT <em>providing two functions which
 		 *	(along with the dataset) form a group (by the definition of group
@@ -473,30 +1040,25 @@ namespace PS {
 		 *	"exec_inverse_transform()" (both are required functions of a
 		 *	compatible TransformT class) to simply call the same function for
 		 *	both.
+		 *
+		 *	site names the caller for the transition trace (see
+		 *	TransitionTrace.hpp); it is filled in automatically and is an
+		 *	empty placeholder unless WAVEFORM_TRACE_TRANSITIONS is defined.
 		 */
 		int
 		//ValidateDomain (const DomainSpecifier toValidate)
-		ValidateDomain (const Domain toValidate)
+		ValidateDomain (const Domain toValidate, const CallSite& site = CallSite::Current())
 		{
-			if (toValidate == validDomain_ || validDomain_ == Domain::Either) {
-				//	There aren't any transforms to be performed
+			if (toValidate == Domain::Either) {
+				ValidateForRead(state_ == DomainState::Time ? Domain::Freq : Domain::Time, site);
 			}
-			else if (toValidate == Domain::Time) {
-				transform_.exec_inverse_transform();
-			}
-			else if (toValidate == Domain::Freq) {
-				transform_.exec_transform();
-			}
-			else if (toValidate == Domain::Either) {
-				if (validDomain_ == Domain::Time) {
-					transform_.exec_transform();
-				} else // if (validDomain_ == FreqDomain)
-				{
-					transform_.exec_inverse_transform();
-				}
+			else {
+				ValidateForRead(toValidate, site);
+
+				//	The caller may write to the array, so the other domain goes stale
+				state_ = StateOf(toValidate);
 			}
-			
-			validDomain_ = toValidate;
+
 			return 0;
 		}
 		
@@ -530,7 +1092,10 @@ namespace PS {
 		{
 			using std::swap;
 
-			swap(first.validDomain_, second.validDomain_);
+			//	Swapping containers whose allocators differ is undefined (operator= avoids it)
+			BOOST_ASSERT(SameAllocators(first, second));
+
+			swap(first.state_, second.state_);
 
 			swap(first.timeSeries_, second.timeSeries_);
 
@@ -567,121 +1132,309 @@ namespace PS {
 		//operator= (WaveformT rhs)
 		operator= (Waveform rhs)
 		{
+			//	With allocators which can differ (std::pmr), the copy is made
+			//	with this Waveform's allocator, which stays as it is
+			if (!SameAllocators(*this, rhs)) {
+				Waveform placed (rhs, GetTimeAllocator());
+				swap(*this, placed);
+				return *this;
+			}
+
 			swap(*this, rhs);
 
 			return *this;
 		}
 
 
+		//!	True if first and second allocate both domains alike, as swapping them requires
+		static bool
+		SameAllocators (const Waveform& first, const Waveform& second)
+		{
+			typedef std::allocator_traits<TimeAllocT>	TimeTraits;
+			typedef std::allocator_traits<FreqAllocT>	FreqTraits;
+
+			return (TimeTraits::is_always_equal::value || first.GetTimeAllocator() == second.GetTimeAllocator())
+				&& (FreqTraits::is_always_equal::value || first.GetFreqAllocator() == second.GetFreqAllocator());
+		}
+
+
 		//!	Move constructor (C++11)
 		/*!
 		 *	When rhs is just an rvalue, C++11 can make use of move semantics,
-		 *	instead of copying values from memory to memory, the references
-		 *	are swapped, in the exact same way they were for the copy assignment
-		 *	operator.
+		 *	instead of copying values from memory to memory, the containers
+		 *	and the transform are moved over from rhs.
 		 *
-		 *	This particular function also uses constructor delegation, a feature
-		 *	which is not present for all compiler's implementations of C++11.
+		 *	Moving a container such as std::vector hands over its buffer, so
+		 *	the moved transform still refers to the arrays now owned by this
+		 *	Waveform and no new plans need to be made. rhs is left empty and
+		 *	may only be destroyed or assigned to.
 		 */
 		Waveform(Waveform&& rhs)
-			: Waveform()
-		{
-			swap(*this, rhs);
-		}
-
-		Waveform(const Waveform&& rhs)
-			: Waveform()
-		{
-			swap(*this, rhs);
-		}
+			: state_(rhs.state_)
+			, timeSeries_(std::move(rhs.timeSeries_))
+			, freqSpectrum_(std::move(rhs.freqSpectrum_))
+			, transform_(std::move(rhs.transform_))
+		{ }
 
 		
 //	};
 
 	
-	//!	Equality operator
+	//!	Equality operator, defined below the class
 	/*!
-	 *	This checks that the valid domains of two waveforms are equal.
-	 *	
-	 *	If the two waveforms have some valid domain which is in common,
-	 *	it will compare those common domains.
-	 *
-	 *	If two waveforms are of opposite domains, it will pick one to convert.
-	 *	No transforms are done otherwise.
+	 *	Declared here so that it may read state_; defining it here
+	 *	would define the same function template once per specialization.
 	 */
 	template <typename ...Args1, typename ...Args2>
 	friend
 	inline bool
-	operator==(const Waveform<Args1...>& lhs, const Waveform<Args2...>& rhs)
+	operator==(const Waveform<Args1...>& lhs, const Waveform<Args2...>& rhs);
+
+	template <typename ...Args1, typename ...Args2>
+	friend
+	inline bool
+	operator!=(const Waveform<Args1...>& lhs, const Waveform<Args2...>& rhs);
+
+
+
+
+	//!	Adds rhs to this Waveform
+	/*!
+	 *	What is computed depends on the transform's inverse_type, chosen at
+	 *	compile time:
+	 *
+	 *		Inverse, ScaledInverse	the transform is linear, so the sum may be
+	 *								taken in either domain. It is taken in
+	 *								every domain valid in both Waveforms (so
+	 *								two of Both stay Both), and no transform
+	 *								is run; if they have no valid domain in
+	 *								common, rhs's stale domain is filled in
+	 *								with one transform, which rhs keeps.
+	 *
+	 *		Other					the sum is taken in the time domain, which
+	 *								is brought up to date first; the freq
+	 *								domain becomes stale.
+	 *
+	 *	A Waveform in the Neither state is taken as its time domain as
+	 *	stored. Each domain is one in-place loop, vectorized for contiguous
+	 *	containers. Throws std::length_error if the lengths differ.
+	 */
+	Waveform&
+	operator+= (const Waveform& rhs)
 	{
-		//	Could probably just see what the valid domain is and compare only that.
-		//	Perhaps in a later version.
+		CheckLength(rhs);
+		AddScaled(rhs, 1., InverseTag());
+		return *this;
+	}
 
-		//	At the very least it makes sense to check the valid domain first, because
-		//	the valid domain doesn't require a transform. 
-		//	However, that would require either this function to be a friend function or
-		//	for the validDomain_ variable to be made public.
-		
-		if (lhs.validDomain_ == Domain::Either)
-		{
-			if (rhs.validDomain_ == Domain::Either)
-			{
-				return lhs.GetTimeSeries() == rhs.GetTimeSeries() && lhs.GetFreqSpectrum() == rhs.GetFreqSpectrum();
-			}
+
+	//!	Subtracts rhs from this Waveform, in the domain(s) operator+= would use
+	Waveform&
+	operator-= (const Waveform& rhs)
+	{
+		CheckLength(rhs);
+		AddScaled(rhs, -1., InverseTag());
+		return *this;
+	}
+
+
+	//!	Multiplies the signal by a real factor
+	/*!
+	 *	For a linear transform every valid domain is scaled and none is
+	 *	made stale, so no transform is ever needed; otherwise the time
+	 *	domain is scaled as for operator+=.
+	 */
+	Waveform&
+	operator*= (const double factor)
+	{
+		Scale(factor, InverseTag());
+		return *this;
+	}
+
+
+	//!	Multiplies the spectra bin by bin: convolution in the time domain
+	/*!
+	 *	Only for transforms which declare spectral_product_is_convolution,
+	 *	the DFTs with an r2c spectrum; for others, such as Fftw3_Analytic_1d
+	 *	whose second domain is not a spectrum, the product would be
+	 *	something else, and this does not compile. The freq domain of this
+	 *	Waveform is brought up to date and is the only one valid
+	 *	afterwards; rhs's is filled in if it is stale.
+	 *
+	 *	How the time domain reads afterwards depends on the inverse_type:
+	 *
+	 *		Inverse			the circular convolution of the two time series,
+	 *						y[n] = sum over m of x[m] h[(n-m) mod N]
+	 *						(Fftw3_Dft_1d_Normalized and the like)
+	 *
+	 *		ScaledInverse	N times that, as the inverse is not divided by N
+	 *						(Fftw3_Dft_1d, whose round trip also scales by N)
+	 *
+	 *	Throws std::length_error if the lengths differ.
+	 */
+	Waveform&
+	operator*= (const Waveform& rhs)
+	{
+		static_assert(detail::SpectralProductIsConvolution<TransformT>::value
+				, "Waveform: *= of two Waveforms needs a transform whose spectral product is convolution");
+
+		CheckLength(rhs);
+
+		const FreqContainer& h = rhs.GetConstFreqSpectrum(CallSite::Current());
+		ValidateDomain(Domain::Freq, CallSite::Current());
+
+		detail::MultiplyInPlace(freqSpectrum_, h, detail::ScalarKernels<FreqContainer, FreqContainer>());
+		return *this;
+	}
+
+  private:
+
+	typedef typename detail::InverseTypeOf<TransformT>::type	InverseTag;
+
+
+	void
+	CheckLength (const Waveform& rhs) const
+	{
+		if (rhs.size() != size())
+			throw std::length_error("Waveform: The operands have different lengths!");
+	}
+
+
+	//!	*this += factor * rhs for a linear transform
+	void
+	AddScaled (const Waveform& rhs, const double factor, InverseTypes::Inverse)
+	{
+		//	Neither is taken as the time domain as stored
+		const bool myTime = IsTimeValid() || state_ == DomainState::Neither;
+		const bool rhsTime = rhs.IsTimeValid() || rhs.state_ == DomainState::Neither;
+
+		const bool time = myTime && rhsTime;
+		const bool freq = IsFreqValid() && rhs.IsFreqValid();
+
+		if (!time && !freq) {
+			//	One is Time and the other Freq: one transform, of rhs unless
+			//	it is Neither (which has no freq domain to give)
+			if (rhs.state_ == DomainState::Neither)
+				ValidateForRead(Domain::Time, CallSite::Current());
+			else if (myTime)
+				rhs.ValidateForRead(Domain::Time, CallSite::Current());
 			else
-			if (rhs.validDomain_ == Domain::Time)
-			{
-				return (lhs.GetTimeSeries() == rhs.GetTimeSeries());
-			}
-			else	//	Else rhs.validDomain_ == Domain::Freq
-			{
-				return (lhs.GetFreqSpectrum() == rhs.GetFreqSpectrum());
-			}
-		}
-		else
-		if (lhs.validDomain_ == Domain::Time)
-		{
-			return (lhs.GetTimeSeries() == rhs.GetTimeSeries());
-		}
-		else
-		if (lhs.validDomain_ == Domain::Freq)
-		{
-			return (lhs.GetFreqSpectrum() == rhs.GetFreqSpectrum());
+				rhs.ValidateForRead(Domain::Freq, CallSite::Current());
+
+			AddScaled(rhs, factor, InverseTypes::Inverse());
+			return;
 		}
 
+		if (time)
+			detail::AddInPlace(timeSeries_, rhs.timeSeries_, factor, detail::ScalarKernels<TimeContainer, TimeContainer>());
 
-		//return lhs.GetTimeSeries() == rhs.GetTimeSeries() && lhs.GetFreqSpectrum() == rhs.GetFreqSpectrum();
+		if (freq)
+			detail::AddInPlace(freqSpectrum_, rhs.freqSpectrum_, factor, detail::ScalarKernels<FreqContainer, FreqContainer>());
+
+		state_ = time && freq ? DomainState::Both : time ? DomainState::Time : DomainState::Freq;
 	}
 
-	template <typename ...Args1, typename ...Args2>
-	friend
-	inline bool
-	operator!=(const Waveform<Args1...>& lhs, const Waveform<Args2...>& rhs)
+
+	void
+	AddScaled (const Waveform& rhs, const double factor, InverseTypes::ScaledInverse)
+	{ AddScaled(rhs, factor, InverseTypes::Inverse()); }
+
+
+	void
+	AddScaled (const Waveform& rhs, const double factor, InverseTypes::Other)
 	{
-		return !(lhs == rhs);
+		ValidateDomain(Domain::Time, CallSite::Current());
+		detail::AddInPlace(timeSeries_, rhs.GetConstTimeSeries(CallSite::Current()), factor
+				, detail::ScalarKernels<TimeContainer, TimeContainer>());
 	}
 
 
+	//!	*this *= factor for a linear transform: every valid domain, no transform
+	void
+	Scale (const double factor, InverseTypes::Inverse)
+	{
+		if (state_ == DomainState::Neither)
+			state_ = DomainState::Time;
 
+		if (IsTimeValid())
+			detail::ScaleInPlace(timeSeries_, factor, detail::ScalarKernels<TimeContainer, TimeContainer>());
 
-	/*
+		if (IsFreqValid())
+			detail::ScaleInPlace(freqSpectrum_, factor, detail::ScalarKernels<FreqContainer, FreqContainer>());
+	}
 
-	std::enable_if<std::is_same(transform_::inverse_type, InverseTypes::Inverse)::value, Waveform&>::type
-	//Waveform&
-	operator*= (TimeContainer& rhs)
+
+	void
+	Scale (const double factor, InverseTypes::ScaledInverse)
+	{ Scale(factor, InverseTypes::Inverse()); }
+
+
+	void
+	Scale (const double factor, InverseTypes::Other)
 	{
-		//if (std::is_same(transform_::inverse_type, InverseTypes::Inverse)::value)
-		
-		this->GetTimeSeries() *= rhs.GetTimeSeries();
-		return *this;
+		ValidateDomain(Domain::Time, CallSite::Current());
+		detail::ScaleInPlace(timeSeries_, factor, detail::ScalarKernels<TimeContainer, TimeContainer>());
 	}
-	*/
 
 
 
 
 	};
 
+
+	//!	Equality operator
+	/*!
+	 *	Waveforms of different lengths are unequal without any transform.
+	 *
+	 *	Otherwise a domain which is valid in both is compared (the time
+	 *	domain if both are), so no transform is done. Only when the valid
+	 *	domains are opposite is one transform run, filling in rhs's stale
+	 *	domain. A Waveform in the Neither state is compared by its time
+	 *	domain as stored (so against a freq-only lhs, lhs is transformed).
+	 *
+	 *	The elements are compared exactly, with the == of the element types.
+	 */
+	template <typename ...Args1, typename ...Args2>
+	inline bool
+	operator==(const Waveform<Args1...>& lhs, const Waveform<Args2...>& rhs)
+	{
+		typedef typename Waveform<Args1...>::DomainState LhsState;
+		typedef typename Waveform<Args2...>::DomainState RhsState;
+
+		if (lhs.size() != rhs.size())
+			return false;
+
+		const bool lhsTime = lhs.state_ != LhsState::Freq;
+		const bool rhsTime = rhs.state_ != RhsState::Freq;
+		const bool lhsFreq = lhs.state_ == LhsState::Freq || lhs.state_ == LhsState::Both;
+		const bool rhsFreq = rhs.state_ == RhsState::Freq || rhs.state_ == RhsState::Both;
+
+		//	A domain valid in both; failing that, the one valid in lhs, unless rhs
+		//	holds no data (Neither), which only has a time domain to compare
+		bool compareTime = lhsTime && rhsTime;
+
+		if (!compareTime && !(lhsFreq && rhsFreq))
+			compareTime = lhsTime || rhs.state_ == RhsState::Neither;
+
+		if (compareTime) {
+			const auto& a = lhs.GetConstTimeSeries();
+			const auto& b = rhs.GetConstTimeSeries();
+			return std::equal(a.begin(), a.end(), b.begin(), b.end());
+		}
+
+		const auto& a = lhs.GetConstFreqSpectrum();
+		const auto& b = rhs.GetConstFreqSpectrum();
+		return std::equal(a.begin(), a.end(), b.begin(), b.end());
+	}
+
+	template <typename ...Args1, typename ...Args2>
+	inline bool
+	operator!=(const Waveform<Args1...>& lhs, const Waveform<Args2...>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+
 	
 } // End of namespace PS
 
@@ -0,0 +1,197 @@
+/*
+ WaveformArena.hpp
+ Per-event arenas for short-lived Waveforms, through std::pmr.
+
+ A simulation which makes and drops thousands of Waveforms per event
+ spends much of its time in malloc and free. With std::pmr containers
+ the domains of those Waveforms can instead be carved out of one arena:
+ allocation is a pointer bump, freeing is nothing, and the whole arena is
+ released at once (and its memory reused) when the event is done:
+
+	PS::EventArena arena;
+
+	for (const Event& event : events) {
+		typedef PS::PmrWaveform<Waveform::Transform::Fftw3_Dft_1d_Cached_Normalized>	EventWaveform;
+
+		EventWaveform wfm (samples, arena.Allocator<double>());
+		...
+		arena.Reset();		//	every Waveform of the event must be gone by now
+	}
+
+ Every block the arena hands out is aligned to SimdAlignment (as
+ fftw_malloc's are), so FFTW and the compiler's vector loops see arrays
+ aligned for the widest SIMD. Fftw3_Dft_1d_Cached_Normalized runs
+ shared plans from FftwPlanCache instead of planning per Waveform, which
+ removes the other large per-Waveform cost.
+ */
+
+#ifndef WAVEFORMARENA_HPP
+#define WAVEFORMARENA_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include <Waveform.hpp>
+
+
+namespace PS {
+
+	//!	The alignment of every block from an AlignedResource, enough for AVX-512
+	const std::size_t SimdAlignment = 64;
+
+
+	//!	std::pmr containers of the two domains
+	typedef std::pmr::vector<double>					PmrRealVector;
+	typedef std::pmr::vector< std::complex<double> >	PmrComplexVector;
+
+	//!	A Waveform whose domains may be allocated from any std::pmr::memory_resource
+	/*!
+	 *	Construct it with an allocator (see Waveform's allocator-extended
+	 *	constructors); without one, its domains come from
+	 *	std::pmr::get_default_resource().
+	 */
+	template <typename TransformT>
+	using PmrWaveform = Waveform<PmrRealVector, PmrComplexVector, TransformT>;
+
+
+	//!	AlignedResource: passes allocations to an upstream resource, aligned to at least SimdAlignment
+	/*!
+	 *	Sizes are rounded up to a multiple of the alignment as well, so
+	 *	consecutive blocks from a monotonic upstream do not share a cache
+	 *	line. It also counts the bytes it has handed out.
+	 */
+	class AlignedResource : public std::pmr::memory_resource {
+	  private:
+
+		std::pmr::memory_resource*	upstream_;
+		std::size_t					bytes_;
+
+
+		static std::size_t
+		RoundUp (const std::size_t n, const std::size_t multiple)
+		{ return (n + multiple - 1) / multiple * multiple; }
+
+
+		void*
+		do_allocate (const std::size_t bytes, const std::size_t alignment) override
+		{
+			const std::size_t align = std::max(alignment, SimdAlignment);
+			const std::size_t size = RoundUp(bytes ? bytes : 1, align);
+
+			void* p = upstream_->allocate(size, align);
+			bytes_ += size;
+			return p;
+		}
+
+
+		void
+		do_deallocate (void* p, const std::size_t bytes, const std::size_t alignment) override
+		{
+			const std::size_t align = std::max(alignment, SimdAlignment);
+			upstream_->deallocate(p, RoundUp(bytes ? bytes : 1, align), align);
+		}
+
+
+		bool
+		do_is_equal (const std::pmr::memory_resource& other) const noexcept override
+		{ return this == &other; }
+
+	  public:
+
+		explicit
+		AlignedResource (std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: upstream_(upstream)
+			, bytes_(0)
+		{ }
+
+
+		std::pmr::memory_resource*
+		Upstream (void) const
+		{ return upstream_; }
+
+
+		//!	Bytes handed out (after rounding) since construction or the last ResetCount()
+		std::size_t
+		BytesAllocated (void) const
+		{ return bytes_; }
+
+
+		void
+		ResetCount (void)
+		{ bytes_ = 0; }
+	};
+
+
+	//!	EventArena: a monotonic arena of SIMD-aligned blocks, released all at once
+	/*!
+	 *	The arena starts with one buffer of initialBytes and asks the
+	 *	upstream resource (by default new/delete) for more, in growing
+	 *	blocks, once it is used up. Deallocation does nothing; Reset()
+	 *	gives everything back and the next event starts over, in the
+	 *	initial buffer, which is kept. An arena sized for a typical event
+	 *	therefore makes no system allocations at all after the first
+	 *	event.
+	 *
+	 *	Everything allocated from the arena must be destroyed before
+	 *	Reset() or the arena's destruction. An EventArena is not
+	 *	thread-safe; use one per thread.
+	 */
+	class EventArena {
+	  private:
+
+		std::vector<unsigned char>				initial_;
+		std::pmr::monotonic_buffer_resource		monotonic_;
+		AlignedResource							aligned_;
+
+	  public:
+
+		explicit
+		EventArena (const std::size_t initialBytes = std::size_t(1) << 20
+				, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+			: initial_(initialBytes + SimdAlignment)
+			, monotonic_(initial_.data(), initial_.size(), upstream)
+			, aligned_(&monotonic_)
+		{ }
+
+
+		EventArena (const EventArena&) = delete;
+
+		EventArena&
+		operator= (const EventArena&) = delete;
+
+
+		//!	The resource to allocate from
+		std::pmr::memory_resource*
+		Resource (void)
+		{ return &aligned_; }
+
+
+		//!	A polymorphic allocator over Resource(), for containers and Waveform's constructors
+		template <typename T>
+		std::pmr::polymorphic_allocator<T>
+		Allocator (void)
+		{ return std::pmr::polymorphic_allocator<T>(&aligned_); }
+
+
+		//!	Bytes handed out since construction or the last Reset()
+		std::size_t
+		BytesAllocated (void) const
+		{ return aligned_.BytesAllocated(); }
+
+
+		//!	Releases every block at once; all that was allocated from the arena must be gone
+		void
+		Reset (void)
+		{
+			monotonic_.release();
+			aligned_.ResetCount();
+		}
+	};
+
+}	//	namespace PS
+
+#endif
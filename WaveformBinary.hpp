@@ -0,0 +1,381 @@
+/*
+ WaveformBinary.hpp
+ Compact little-endian binary storage of a Waveform, including which domains are valid.
+ */
+
+#ifndef WAVEFORMBINARY_HPP
+#define WAVEFORMBINARY_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <complex>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <Crc32.hpp>
+
+/*
+	File layout (version 1), every integer and scalar stored little-endian:
+
+		[ Offset ]	[ Size ]	[ Field ]
+		0			4			magic "PSWF"
+		4			2			format version
+		6			1			valid domain flags (bit 0: time, bit 1: freq)
+		7			1			reserved, zero
+		8			3			time element: scalar kind, scalar bytes, components
+		11			3			freq element: scalar kind, scalar bytes, components
+		14			2			reserved, zero
+		16			8			time domain length (elements)
+		24			8			freq domain length (elements)
+		32			4			CRC-32 of bytes 0-31
+
+	Followed, for each valid domain in the order time then freq, by the raw
+	element data and a CRC-32 of that data.
+
+	Both lengths are always stored so that a reader can construct a Waveform
+	of the right shape even when only one of the domains was saved.
+
+	The scalar kind is 0 for signed integers, 1 for unsigned integers and 2
+	for IEEE floating point; complex elements have 2 components.
+ */
+
+
+namespace PS {
+
+	//!	Version written by Save(); Load() accepts this version only
+	const std::uint16_t WaveformBinaryVersion = 1;
+
+
+	//!	Decoded header of a Waveform binary file
+	struct WaveformBinaryHeader {
+		std::uint16_t	version;
+		bool			timeValid;
+		bool			freqValid;
+		std::uint8_t	timeScalarKind;
+		std::uint8_t	timeScalarBytes;
+		std::uint8_t	timeComponents;
+		std::uint8_t	freqScalarKind;
+		std::uint8_t	freqScalarBytes;
+		std::uint8_t	freqComponents;
+		std::uint64_t	timeLength;
+		std::uint64_t	freqLength;
+	};
+
+
+namespace detail {
+
+	const std::size_t WaveformBinaryHeaderSize = 36;
+
+
+	//!	Describes how an element type is laid out as scalars
+	template <typename T>
+	struct BinaryElementTraits {
+		static_assert(std::is_arithmetic<T>::value, "WaveformBinary: unsupported element type");
+
+		typedef T scalar_type;
+
+		static const std::uint8_t kind = std::is_floating_point<T>::value ? 2
+									   : (std::is_signed<T>::value ? 0 : 1);
+		static const std::uint8_t components = 1;
+	};
+
+	template <typename T>
+	struct BinaryElementTraits< std::complex<T> > {
+		typedef T scalar_type;
+
+		static const std::uint8_t kind = BinaryElementTraits<T>::kind;
+		static const std::uint8_t components = 2;
+	};
+
+
+	inline bool
+	HostIsLittleEndian (void)
+	{
+		const std::uint16_t probe = 1;
+		unsigned char firstByte;
+		std::memcpy(&firstByte, &probe, 1);
+		return firstByte == 1;
+	}
+
+
+	template <typename UInt>
+	void
+	PutLittleEndian (unsigned char* dst, UInt value)
+	{
+		for (std::size_t i = 0; i < sizeof(UInt); ++i)
+			dst[i] = static_cast<unsigned char>(value >> (8 * i));
+	}
+
+	template <typename UInt>
+	UInt
+	GetLittleEndian (const unsigned char* src)
+	{
+		UInt value = 0;
+		for (std::size_t i = 0; i < sizeof(UInt); ++i)
+			value |= UInt(src[i]) << (8 * i);
+		return value;
+	}
+
+
+	//!	Reverses the byte order of every scalar in a buffer
+	inline void
+	SwapScalarBytes (unsigned char* data, std::size_t bytes, std::size_t scalarBytes)
+	{
+		for (std::size_t offset = 0; offset + scalarBytes <= bytes; offset += scalarBytes)
+			for (std::size_t i = 0; i < scalarBytes / 2; ++i)
+				std::swap(data[offset + i], data[offset + scalarBytes - 1 - i]);
+	}
+
+
+	//!	Writes the contiguous contents of a container, returning their CRC-32
+	template <typename Container>
+	std::uint32_t
+	WriteBlock (std::ostream& os, const Container& c)
+	{
+		typedef typename Container::value_type T;
+		typedef typename BinaryElementTraits<T>::scalar_type ScalarT;
+
+		if (c.empty())
+			return 0;
+
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(&(*c.begin()));
+		const std::size_t bytes = c.size() * sizeof(T);
+
+		if (HostIsLittleEndian()) {
+			os.write(reinterpret_cast<const char*>(data), bytes);
+			return Crc32(data, bytes);
+		}
+
+		//	Big-endian hosts byte-swap through a bounded staging buffer
+		std::vector<unsigned char> staging (std::min<std::size_t>(bytes, 1 << 16));
+		std::uint32_t crc = 0;
+
+		for (std::size_t offset = 0; offset < bytes; offset += staging.size()) {
+			const std::size_t chunk = std::min(staging.size(), bytes - offset);
+			std::memcpy(staging.data(), data + offset, chunk);
+			SwapScalarBytes(staging.data(), chunk, sizeof(ScalarT));
+			os.write(reinterpret_cast<const char*>(staging.data()), chunk);
+			crc = Crc32Update(crc, staging.data(), chunk);
+		}
+
+		return crc;
+	}
+
+
+	//!	Reads a block into the contiguous storage of a container and verifies its CRC-32
+	template <typename Container>
+	void
+	ReadBlock (std::istream& is, Container& c, const char* domainName)
+	{
+		typedef typename Container::value_type T;
+		typedef typename BinaryElementTraits<T>::scalar_type ScalarT;
+
+		const std::size_t bytes = c.size() * sizeof(T);
+		unsigned char* data = c.empty() ? nullptr : reinterpret_cast<unsigned char*>(&(*c.begin()));
+
+		if (bytes)
+			is.read(reinterpret_cast<char*>(data), bytes);
+
+		unsigned char crcBytes[4];
+		is.read(reinterpret_cast<char*>(crcBytes), 4);
+
+		if (!is)
+			throw std::runtime_error(std::string("WaveformBinary: unexpected end of file in the ") + domainName + " domain");
+
+		if (Crc32(data, bytes) != GetLittleEndian<std::uint32_t>(crcBytes))
+			throw std::runtime_error(std::string("WaveformBinary: checksum mismatch in the ") + domainName + " domain");
+
+		if (!HostIsLittleEndian())
+			SwapScalarBytes(data, bytes, sizeof(ScalarT));
+	}
+
+
+	template <typename T>
+	void
+	CheckElementLayout (std::uint8_t kind, std::uint8_t scalarBytes, std::uint8_t components, const char* domainName)
+	{
+		typedef BinaryElementTraits<T> Traits;
+
+		if (kind != Traits::kind
+			|| scalarBytes != sizeof(typename Traits::scalar_type)
+			|| components != Traits::components)
+			throw std::runtime_error(std::string("WaveformBinary: the stored ") + domainName
+									 + " domain element type does not match the Waveform");
+	}
+
+}	//	namespace detail
+
+
+	//!	Reads and validates the header of a Waveform binary file
+	/*!
+	 *	Leaves the stream positioned at the first data block, so the result
+	 *	can be used to construct a Waveform of the right length and then be
+	 *	passed to Load(std::istream&, const WaveformBinaryHeader&, WaveformT&).
+	 */
+	inline WaveformBinaryHeader
+	ReadWaveformBinaryHeader (std::istream& is)
+	{
+		unsigned char raw[detail::WaveformBinaryHeaderSize];
+		is.read(reinterpret_cast<char*>(raw), sizeof(raw));
+
+		if (!is)
+			throw std::runtime_error("WaveformBinary: unexpected end of file in the header");
+
+		if (std::memcmp(raw, "PSWF", 4) != 0)
+			throw std::runtime_error("WaveformBinary: not a Waveform binary file");
+
+		if (Crc32(raw, 32) != detail::GetLittleEndian<std::uint32_t>(raw + 32))
+			throw std::runtime_error("WaveformBinary: checksum mismatch in the header");
+
+		WaveformBinaryHeader header;
+		header.version = detail::GetLittleEndian<std::uint16_t>(raw + 4);
+
+		if (header.version != WaveformBinaryVersion)
+			throw std::runtime_error("WaveformBinary: unsupported format version");
+
+		header.timeValid		= raw[6] & 1u;
+		header.freqValid		= raw[6] & 2u;
+		header.timeScalarKind	= raw[8];
+		header.timeScalarBytes	= raw[9];
+		header.timeComponents	= raw[10];
+		header.freqScalarKind	= raw[11];
+		header.freqScalarBytes	= raw[12];
+		header.freqComponents	= raw[13];
+		header.timeLength		= detail::GetLittleEndian<std::uint64_t>(raw + 16);
+		header.freqLength		= detail::GetLittleEndian<std::uint64_t>(raw + 24);
+
+		if (!header.timeValid && !header.freqValid)
+			throw std::runtime_error("WaveformBinary: the file contains no valid domain");
+
+		return header;
+	}
+
+
+	//!	Writes a Waveform, including every domain which is currently valid
+	/*!
+	 *	No transform is performed: a Waveform whose spectrum is up to date
+	 *	is stored with both domains, so that loading it does not need to
+	 *	recompute either one.
+	 */
+	template <typename WaveformT>
+	void
+	Save (std::ostream& os, const WaveformT& wfm)
+	{
+		typedef detail::BinaryElementTraits<typename WaveformT::TimeT> TimeTraits;
+		typedef detail::BinaryElementTraits<typename WaveformT::FreqT> FreqTraits;
+
+		//	A Waveform holding no data yet (Neither) is saved as its stored time domain
+		const bool timeValid = wfm.GetValidDomain() != WaveformT::DomainState::Freq;
+		const bool freqValid = wfm.IsFreqValid();
+
+		unsigned char raw[detail::WaveformBinaryHeaderSize] = {};
+		std::memcpy(raw, "PSWF", 4);
+		detail::PutLittleEndian<std::uint16_t>(raw + 4, WaveformBinaryVersion);
+		raw[6]  = (timeValid ? 1u : 0u) | (freqValid ? 2u : 0u);
+		raw[8]  = TimeTraits::kind;
+		raw[9]  = sizeof(typename TimeTraits::scalar_type);
+		raw[10] = TimeTraits::components;
+		raw[11] = FreqTraits::kind;
+		raw[12] = sizeof(typename FreqTraits::scalar_type);
+		raw[13] = FreqTraits::components;
+		detail::PutLittleEndian<std::uint64_t>(raw + 16, wfm.PeekTimeSeries().size());
+		detail::PutLittleEndian<std::uint64_t>(raw + 24, wfm.PeekFreqSpectrum().size());
+		detail::PutLittleEndian<std::uint32_t>(raw + 32, Crc32(raw, 32));
+
+		os.write(reinterpret_cast<const char*>(raw), sizeof(raw));
+
+		unsigned char crcBytes[4];
+
+		if (timeValid) {
+			detail::PutLittleEndian<std::uint32_t>(crcBytes, detail::WriteBlock(os, wfm.PeekTimeSeries()));
+			os.write(reinterpret_cast<const char*>(crcBytes), 4);
+		}
+
+		if (freqValid) {
+			detail::PutLittleEndian<std::uint32_t>(crcBytes, detail::WriteBlock(os, wfm.PeekFreqSpectrum()));
+			os.write(reinterpret_cast<const char*>(crcBytes), 4);
+		}
+
+		if (!os)
+			throw std::runtime_error("WaveformBinary: write failed");
+	}
+
+
+	//!	Reads the data blocks described by an already-read header into a Waveform
+	/*!
+	 *	The Waveform must already have the stored length(s); its valid
+	 *	domain is restored exactly as saved, without performing any transform.
+	 */
+	template <typename WaveformT>
+	void
+	Load (std::istream& is, const WaveformBinaryHeader& header, WaveformT& wfm)
+	{
+		typedef typename WaveformT::DomainState DomainState;
+
+		detail::CheckElementLayout<typename WaveformT::TimeT>(header.timeScalarKind, header.timeScalarBytes, header.timeComponents, "time");
+		detail::CheckElementLayout<typename WaveformT::FreqT>(header.freqScalarKind, header.freqScalarBytes, header.freqComponents, "freq");
+
+		//	The freq length only matters when the spectrum itself was stored
+		if (wfm.PeekTimeSeries().size() != header.timeLength
+			|| (header.freqValid && wfm.PeekFreqSpectrum().size() != header.freqLength))
+			throw std::length_error("WaveformBinary: the stored lengths do not match the Waveform");
+
+		if (header.timeValid)
+			detail::ReadBlock(is, wfm.OverwriteTimeSeries(), "time");
+
+		if (header.freqValid)
+			detail::ReadBlock(is, wfm.OverwriteFreqSpectrum(), "freq");
+
+		if (header.timeValid && header.freqValid)
+			wfm.AssumeValidDomain(DomainState::Both);
+	}
+
+
+	//!	Reads a Waveform written by Save()
+	template <typename WaveformT>
+	void
+	Load (std::istream& is, WaveformT& wfm)
+	{
+		const WaveformBinaryHeader header = ReadWaveformBinaryHeader(is);
+		Load(is, header, wfm);
+	}
+
+
+	//!	Writes a Waveform to a file
+	template <typename WaveformT>
+	void
+	Save (const std::string& fileName, const WaveformT& wfm)
+	{
+		std::ofstream ofs (fileName.c_str(), std::ios::binary);
+
+		if (!ofs)
+			throw std::runtime_error("WaveformBinary: could not open " + fileName);
+
+		Save(ofs, wfm);
+	}
+
+
+	//!	Reads a Waveform from a file written by Save()
+	template <typename WaveformT>
+	void
+	Load (const std::string& fileName, WaveformT& wfm)
+	{
+		std::ifstream ifs (fileName.c_str(), std::ios::binary);
+
+		if (!ifs)
+			throw std::runtime_error("WaveformBinary: could not open " + fileName);
+
+		Load(ifs, wfm);
+	}
+
+}	//	namespace PS
+
+#endif
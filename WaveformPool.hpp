@@ -0,0 +1,471 @@
+/*
+ WaveformPool.hpp
+ A pool of ready-made Waveforms of any length, recycled through per-thread
+ free lists.
+
+ Constructing a Waveform allocates both domains, touches every page of
+ them and constructs the transform (for FFTW, plans). A loop which needs
+ a Waveform of the same length over and over can take one from a pool
+ instead, and give it back when done:
+
+	PS::WaveformPool<WaveformType> pool;
+
+	for (...) {
+		PS::WaveformPool<WaveformType>::Handle wfm = pool.Acquire(1024);
+		std::copy(samples, samples + 1024, wfm->GetTimeSeries().begin());
+		...
+	}	//	the handle gives the Waveform back to the pool
+ */
+
+#ifndef WAVEFORMPOOL_HPP
+#define WAVEFORMPOOL_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Design:
+
+		Every thread which uses a pool gets its own cache in it: free lists
+		of idle Waveforms by length, which only that thread ever touches, so
+		Acquire() and Release() take no lock. A Waveform is given back to
+		the cache of the thread which releases it, whichever thread acquired
+		it.
+
+		A thread finds its cache through a thread_local list of (pool id,
+		cache) pairs; a pool id is never reused, so an entry of a destroyed
+		pool can never match. The caches are registered with their pool
+		(under its mutex) the first time a thread uses the pool, which is
+		the only time the fast path is left. When a thread exits, its cache
+		is marked orphaned, and the next thread to register adopts it with
+		its idle Waveforms, so pools used from short-lived threads do not
+		grow.
+
+		The counters follow TransformStats.hpp: each is written only by the
+		thread which owns the cache, and is atomic only so that Stats() can
+		read it from any thread.
+ */
+
+
+namespace PS {
+
+	//!	Counters of a WaveformPool, summed over every thread
+	struct WaveformPoolStats {
+		//!	Calls to Acquire()
+		std::uint64_t	acquires;
+
+		//!	Acquires served from a free list, without constructing a Waveform
+		std::uint64_t	hits;
+
+		//!	Waveforms constructed (by Acquire() misses and Reserve())
+		std::uint64_t	constructed;
+
+		//!	Waveforms given back to the pool
+		std::uint64_t	releases;
+
+		//!	Waveforms destroyed: released over the limits, trimmed, or freed with the pool
+		std::uint64_t	destroyed;
+
+		//!	Waveforms in the free lists
+		std::size_t		idle;
+
+		//!	Waveforms handed out and not yet given back
+		std::size_t		outstanding;
+
+		//!	Bytes of the domains of the idle Waveforms
+		std::size_t		idleBytes;
+
+		//!	Bytes of the domains of every Waveform of the pool, idle or handed out
+		std::size_t		liveBytes;
+	};
+
+
+namespace detail {
+
+	enum WaveformPoolCounter {
+		PoolAcquires, PoolHits, PoolConstructed, PoolReleases, PoolDestroyed
+	  , PoolConstructedBytes, PoolDestroyedBytes, PoolIdle, PoolIdleBytes
+	  , PoolCounterCount
+	};
+
+
+	//!	Ids for pools, unique for the life of the process
+	inline std::uint64_t
+	NextWaveformPoolId (void)
+	{
+		static std::atomic<std::uint64_t> next {1};
+		return next.fetch_add(1, std::memory_order_relaxed);
+	}
+
+}	//	namespace detail
+
+
+	//!	WaveformPool: hands out Waveforms of a given length, and recycles them
+	/*!
+	 *	Acquire(length) returns a Handle, a std::unique_ptr which gives the
+	 *	Waveform back to the pool when it is destroyed. A recycled Waveform
+	 *	has its transform bound already and its arrays allocated and
+	 *	touched; it is in the Neither state, as if just made by the fill
+	 *	constructor, but its arrays hold whatever they last held, so a
+	 *	domain must be written before it is read.
+	 *
+	 *	Each thread keeps at most Limits::maxIdlePerLength idle Waveforms of
+	 *	each length, and at most Limits::maxIdleBytes of idle domains; a
+	 *	Waveform released over either limit is destroyed.
+	 *
+	 *	WaveformT is any Waveform made by WaveformT(length). Every Handle
+	 *	must be destroyed before the pool is.
+	 */
+	template <typename WaveformT>
+	class WaveformPool {
+	  public:
+
+		//!	Bounds on the idle Waveforms of each thread
+		struct Limits {
+			std::size_t		maxIdlePerLength = 64;
+			std::size_t		maxIdleBytes = std::size_t(256) << 20;
+		};
+
+
+		//!	Deleter of a Handle: gives the Waveform back to its pool
+		class Releaser {
+		  private:
+
+			WaveformPool*	pool_;
+
+		  public:
+
+			Releaser (WaveformPool* pool = nullptr)
+				: pool_(pool)
+			{ }
+
+			void
+			operator() (WaveformT* wfm) const
+			{ pool_->Release(wfm); }
+		};
+
+		typedef std::unique_ptr<WaveformT, Releaser>	Handle;
+
+	  private:
+
+		//!	The idle Waveforms and counters of one thread
+		struct ThreadCache {
+			std::unordered_map< std::size_t, std::vector< std::unique_ptr<WaveformT> > >	idle;
+			std::size_t									idleCount = 0;
+			std::size_t									idleBytes = 0;
+			std::atomic<std::uint64_t>					counter[detail::PoolCounterCount] = {};
+
+			//!	Set by the owning thread when it exits; cleared by the thread which adopts the cache
+			std::atomic<bool>							orphaned {false};
+
+			//!	Single-writer increment; cheaper than fetch_add
+			void
+			Add (const detail::WaveformPoolCounter which, const std::uint64_t value)
+			{
+				std::atomic<std::uint64_t>& c = counter[which];
+				c.store(c.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+			}
+
+			void
+			Set (const detail::WaveformPoolCounter which, const std::uint64_t value)
+			{ counter[which].store(value, std::memory_order_relaxed); }
+		};
+
+
+		//!	One entry of a thread's list of the caches it uses
+		struct LocalEntry {
+			std::uint64_t				id;
+			ThreadCache*				cache;
+			std::weak_ptr<ThreadCache>	owner;
+		};
+
+
+		//!	The caches of the calling thread, in every live pool of this type
+		struct LocalCaches {
+			std::vector<LocalEntry>		entries;
+
+			~LocalCaches (void)
+			{
+				for (LocalEntry& entry : entries)
+					if (std::shared_ptr<ThreadCache> cache = entry.owner.lock())
+						cache->orphaned.store(true, std::memory_order_release);
+			}
+		};
+
+
+		const std::uint64_t								id_;
+		const Limits									limits_;
+
+		std::mutex										mutex_;
+		std::vector< std::shared_ptr<ThreadCache> >		caches_;
+
+
+		static LocalCaches&
+		Local (void)
+		{
+			thread_local LocalCaches local;
+			return local;
+		}
+
+
+		//!	The calling thread's cache, registered on the first call from each thread
+		ThreadCache&
+		Cache (void)
+		{
+			LocalCaches& local = Local();
+
+			for (const LocalEntry& entry : local.entries)
+				if (entry.id == id_)
+					return *entry.cache;
+
+			return Register(local);
+		}
+
+
+		ThreadCache&
+		Register (LocalCaches& local)
+		{
+			//	Forget the caches of pools which no longer exist
+			local.entries.erase(std::remove_if(local.entries.begin(), local.entries.end()
+					, [](const LocalEntry& entry) { return entry.owner.expired(); })
+				, local.entries.end());
+
+			std::shared_ptr<ThreadCache> cache;
+
+			{
+				std::lock_guard<std::mutex> lock (mutex_);
+
+				for (const std::shared_ptr<ThreadCache>& c : caches_) {
+					bool orphaned = true;
+					if (c->orphaned.compare_exchange_strong(orphaned, false, std::memory_order_acquire)) {
+						cache = c;
+						break;
+					}
+				}
+
+				if (!cache) {
+					cache = std::make_shared<ThreadCache>();
+					caches_.push_back(cache);
+				}
+			}
+
+			local.entries.push_back(LocalEntry{id_, cache.get(), cache});
+			return *cache;
+		}
+
+
+		//!	Bytes of both domain arrays of wfm
+		static std::size_t
+		Bytes (const WaveformT& wfm)
+		{
+			return wfm.PeekTimeSeries().size() * sizeof(typename WaveformT::TimeT)
+				+ wfm.PeekFreqSpectrum().size() * sizeof(typename WaveformT::FreqT);
+		}
+
+
+		//!	Constructs a Waveform of the given length, counted in cache
+		static std::unique_ptr<WaveformT>
+		Construct (ThreadCache& cache, const std::size_t length)
+		{
+			std::unique_ptr<WaveformT> wfm (new WaveformT(length));
+
+			cache.Add(detail::PoolConstructed, 1);
+			cache.Add(detail::PoolConstructedBytes, Bytes(*wfm));
+			return wfm;
+		}
+
+
+		//!	Puts wfm in a free list of cache if the limits allow; otherwise destroys it
+		void
+		Keep (ThreadCache& cache, std::unique_ptr<WaveformT> wfm)
+		{
+			const std::size_t bytes = Bytes(*wfm);
+			std::vector< std::unique_ptr<WaveformT> >& list = cache.idle[wfm->size()];
+
+			if (list.size() >= limits_.maxIdlePerLength || cache.idleBytes + bytes > limits_.maxIdleBytes) {
+				wfm.reset();
+				cache.Add(detail::PoolDestroyed, 1);
+				cache.Add(detail::PoolDestroyedBytes, bytes);
+				return;
+			}
+
+			wfm->AssumeValidDomain(WaveformT::DomainState::Neither);
+			list.push_back(std::move(wfm));
+
+			cache.idleCount += 1;
+			cache.idleBytes += bytes;
+			Publish(cache);
+		}
+
+
+		//!	Updates the idle counters of cache, for Stats()
+		static void
+		Publish (ThreadCache& cache)
+		{
+			cache.Set(detail::PoolIdle, cache.idleCount);
+			cache.Set(detail::PoolIdleBytes, cache.idleBytes);
+		}
+
+
+		//!	Destroys every idle Waveform of cache
+		static void
+		Clear (ThreadCache& cache)
+		{
+			for (auto& lengthAndList : cache.idle) {
+				for (std::unique_ptr<WaveformT>& wfm : lengthAndList.second) {
+					cache.Add(detail::PoolDestroyedBytes, Bytes(*wfm));
+					wfm.reset();
+				}
+
+				cache.Add(detail::PoolDestroyed, lengthAndList.second.size());
+			}
+
+			cache.idle.clear();
+			cache.idleCount = 0;
+			cache.idleBytes = 0;
+			Publish(cache);
+		}
+
+
+		void
+		Release (WaveformT* released)
+		{
+			std::unique_ptr<WaveformT> wfm (released);
+			ThreadCache& cache = Cache();
+
+			cache.Add(detail::PoolReleases, 1);
+			Keep(cache, std::move(wfm));
+		}
+
+	  public:
+
+		explicit
+		WaveformPool (const Limits& limits = Limits())
+			: id_(detail::NextWaveformPoolId())
+			, limits_(limits)
+		{ }
+
+
+		WaveformPool (const WaveformPool&) = delete;
+
+		WaveformPool&
+		operator= (const WaveformPool&) = delete;
+
+
+		//!	Frees every idle Waveform; no Handle may be left
+		~WaveformPool (void)
+		{
+			for (const std::shared_ptr<ThreadCache>& cache : caches_)
+				Clear(*cache);
+		}
+
+
+		//!	Returns a Waveform of the given length, recycled if one is idle in this thread
+		/*!
+		 *	Throws what WaveformT(length) throws (std::length_error for an
+		 *	odd length) when a Waveform has to be made.
+		 */
+		Handle
+		Acquire (const std::size_t length)
+		{
+			ThreadCache& cache = Cache();
+			cache.Add(detail::PoolAcquires, 1);
+
+			const auto found = cache.idle.find(length);
+
+			if (found != cache.idle.end() && !found->second.empty()) {
+				std::unique_ptr<WaveformT> wfm = std::move(found->second.back());
+				found->second.pop_back();
+
+				cache.idleCount -= 1;
+				cache.idleBytes -= Bytes(*wfm);
+				cache.Add(detail::PoolHits, 1);
+				Publish(cache);
+
+				return Handle(wfm.release(), Releaser(this));
+			}
+
+			return Handle(Construct(cache, length).release(), Releaser(this));
+		}
+
+
+		//!	Makes idle Waveforms of the given length in this thread's cache, up to count of them
+		/*!
+		 *	Fewer are made if the limits are reached. Returns the number of
+		 *	idle Waveforms of the length in this thread's cache afterwards.
+		 */
+		std::size_t
+		Reserve (const std::size_t length, const std::size_t count)
+		{
+			ThreadCache& cache = Cache();
+			std::vector< std::unique_ptr<WaveformT> >& list = cache.idle[length];
+
+			while (list.size() < std::min(count, limits_.maxIdlePerLength)) {
+				const std::size_t before = list.size();
+
+				Keep(cache, Construct(cache, length));
+
+				if (list.size() == before)
+					break;
+			}
+
+			return list.size();
+		}
+
+
+		//!	Destroys the idle Waveforms of this thread's cache
+		void
+		Trim (void)
+		{ Clear(Cache()); }
+
+
+		//!	The limits the pool was made with
+		const Limits&
+		GetLimits (void) const
+		{ return limits_; }
+
+
+		//!	Sums the counters of every thread which has used the pool
+		/*!
+		 *	This may be called from any thread; counts which other threads
+		 *	are updating at the time may be read before or after the update.
+		 */
+		WaveformPoolStats
+		Stats (void)
+		{
+			std::uint64_t c[detail::PoolCounterCount] = {};
+
+			{
+				std::lock_guard<std::mutex> lock (mutex_);
+
+				for (const std::shared_ptr<ThreadCache>& cache : caches_)
+					for (int i = 0; i < detail::PoolCounterCount; ++i)
+						c[i] += cache->counter[i].load(std::memory_order_relaxed);
+			}
+
+			WaveformPoolStats stats;
+			stats.acquires = c[detail::PoolAcquires];
+			stats.hits = c[detail::PoolHits];
+			stats.constructed = c[detail::PoolConstructed];
+			stats.releases = c[detail::PoolReleases];
+			stats.destroyed = c[detail::PoolDestroyed];
+			stats.idle = c[detail::PoolIdle];
+			//	Counters read while other threads update them may briefly disagree
+			stats.outstanding = std::size_t(std::max<std::int64_t>(0
+					, std::int64_t(c[detail::PoolConstructed] - c[detail::PoolDestroyed] - c[detail::PoolIdle])));
+			stats.idleBytes = c[detail::PoolIdleBytes];
+			stats.liveBytes = c[detail::PoolConstructedBytes] - c[detail::PoolDestroyedBytes];
+			return stats;
+		}
+	};
+
+}	//	namespace PS
+
+#endif
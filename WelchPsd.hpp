@@ -0,0 +1,329 @@
+/*
+ WelchPsd.hpp
+ Welch's method for the power spectral density of a long record: the
+ record is cut into overlapping segments, each is windowed and
+ transformed, and the periodograms are averaged.
+
+ Rather than one Waveform (one allocation and one plan) per segment, a
+ WelchPsd engine plans once for a batch of segments
+ (fftw_plan_many_dft_r2c) and runs that plan on per-thread buffers through
+ FFTW's new-array execute function. The window is applied while copying
+ the segments into the batch, and |X|^2 is accumulated straight from the
+ batch output.
+ */
+
+#ifndef WELCHPSD_HPP
+#define WELCHPSD_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fftw3.h>
+
+#include <ParallelFor.hpp>
+
+
+namespace PS {
+
+namespace detail {
+
+	//!	Frees an fftw_malloc'd array
+	struct FftwFree {
+		void
+		operator() (void* p) const
+		{ fftw_free(p); }
+	};
+
+	template <typename T>
+	using FftwArray = std::unique_ptr<T[], FftwFree>;
+
+	template <typename T>
+	FftwArray<T>
+	MakeFftwArray (const std::size_t count)
+	{
+		T* p = static_cast<T*>(fftw_malloc(sizeof(T) * (count ? count : 1)));
+		if (!p)
+			throw std::bad_alloc();
+		return FftwArray<T>(p);
+	}
+
+}	//	namespace detail
+
+
+	//!	WelchPsd: averaged, windowed periodograms of one segment length
+	/*!
+	 *	The estimate is one-sided: Bins() = segmentLength/2+1 values of
+	 *	power per unit frequency, with every bin other than DC and Nyquist
+	 *	doubled, scaled by 1 / (sampleRate * sum(window^2)) as in
+	 *	scipy.signal.welch(..., detrend=False, scaling='density'):
+	 *
+	 *		PS::WelchPsd welch (1024, 512);		// Hann window, 50% overlap
+	 *		std::vector<double> psd;
+	 *		welch.Estimate(wfm.GetConstTimeSeries(), psd);
+	 *
+	 *	Segments are processed in fixed blocks of BatchSize() (the last
+	 *	block may be shorter), the blocks are shared among up to maxThreads
+	 *	threads, and each block's sum is kept apart. The sums are added in
+	 *	block order at the end, so the result does not depend on the
+	 *	number of threads.
+	 *
+	 *	Estimate() may be called from several threads at once.
+	 */
+	class WelchPsd {
+	  private:
+
+		//!	Owns one plan
+		struct Plan {
+			fftw_plan plan;
+
+			explicit
+			Plan (fftw_plan p)
+				: plan(p)
+			{
+				if (!plan)
+					throw std::runtime_error("WelchPsd: FFTW could not make a plan");
+			}
+
+			Plan (const Plan&) = delete;
+
+			Plan&
+			operator= (const Plan&) = delete;
+
+			~Plan (void)
+			{ fftw_destroy_plan(plan); }
+		};
+
+
+		std::size_t				segmentLength_;
+		std::size_t				step_;
+		std::size_t				batch_;
+
+		//!	Distances between segments in the batch arrays, padded so each segment is 64-byte aligned
+		std::size_t				inStride_;
+		std::size_t				outStride_;
+		unsigned				maxThreads_;
+		double					sampleRate_;
+		std::vector<double>		window_;
+
+		//!	Plans for batch_ segments and for one, made on arrays like the per-thread ones
+		std::unique_ptr<Plan>	batchPlan_;
+		std::unique_ptr<Plan>	singlePlan_;
+
+
+		static std::size_t
+		RoundUp (const std::size_t n, const std::size_t multiple)
+		{ return (n + multiple - 1) / multiple * multiple; }
+
+
+		fftw_plan
+		MakePlan (const std::size_t howMany) const
+		{
+			auto in = detail::MakeFftwArray<double>(inStride_ * howMany);
+			auto out = detail::MakeFftwArray<fftw_complex>(outStride_ * howMany);
+			const int n = int(segmentLength_);
+
+			return fftw_plan_many_dft_r2c(1, &n, int(howMany)
+										, in.get(), nullptr, 1, int(inStride_)
+										, out.get(), nullptr, 1, int(outStride_)
+										, FFTW_ESTIMATE);
+		}
+
+
+		//!	The per-thread input and output arrays of one batch, grown as needed
+		struct Buffers {
+			std::size_t						inCapacity = 0;
+			std::size_t						outCapacity = 0;
+			detail::FftwArray<double>		in;
+			detail::FftwArray<fftw_complex>	out;
+		};
+
+		Buffers&
+		ThreadBuffers (void) const
+		{
+			thread_local Buffers buffers;
+
+			if (buffers.inCapacity < inStride_ * batch_) {
+				buffers.in = detail::MakeFftwArray<double>(inStride_ * batch_);
+				buffers.inCapacity = inStride_ * batch_;
+			}
+
+			if (buffers.outCapacity < outStride_ * batch_) {
+				buffers.out = detail::MakeFftwArray<fftw_complex>(outStride_ * batch_);
+				buffers.outCapacity = outStride_ * batch_;
+			}
+
+			return buffers;
+		}
+
+	  public:
+
+		//!	A periodic Hann window, as scipy.signal.get_window("hann", length)
+		static std::vector<double>
+		Hann (const std::size_t length)
+		{
+			const double pi = std::acos(-1.);
+			std::vector<double> window (length);
+
+			for (std::size_t i = 0; i < length; ++i)
+				window[i] = 0.5 - 0.5 * std::cos(2. * pi * double(i) / double(length));
+
+			return window;
+		}
+
+
+		//!	Sets up the engine
+		/*!
+		 *	window must have segmentLength values, and overlap must be less
+		 *	than segmentLength. batchSize segments go through each call of
+		 *	the batched plan; maxThreads == 0 uses one thread per core.
+		 */
+		WelchPsd (const std::size_t segmentLength
+				, const std::size_t overlap
+				, std::vector<double> window
+				, const double sampleRate = 1.
+				, const unsigned maxThreads = 0
+				, const std::size_t batchSize = 16)
+			: segmentLength_(segmentLength)
+			, step_(segmentLength - overlap)
+			, batch_(batchSize ? batchSize : 1)
+			, inStride_(RoundUp(segmentLength, 8))
+			, outStride_(RoundUp(segmentLength / 2 + 1, 4))
+			, maxThreads_(maxThreads ? maxThreads : DefaultThreadCount())
+			, sampleRate_(sampleRate)
+			, window_(std::move(window))
+		{
+			if (segmentLength < 2 || overlap >= segmentLength)
+				throw std::invalid_argument("WelchPsd: the overlap must be less than the segment length");
+
+			if (window_.size() != segmentLength)
+				throw std::invalid_argument("WelchPsd: the window must have one value per sample of a segment");
+
+			batchPlan_.reset(new Plan(MakePlan(batch_)));
+			singlePlan_.reset(new Plan(MakePlan(1)));
+		}
+
+
+		//!	Sets up the engine with a Hann window
+		WelchPsd (const std::size_t segmentLength
+				, const std::size_t overlap
+				, const double sampleRate = 1.
+				, const unsigned maxThreads = 0)
+			: WelchPsd(segmentLength, overlap, Hann(segmentLength), sampleRate, maxThreads)
+		{ }
+
+
+		std::size_t
+		SegmentLength (void) const
+		{ return segmentLength_; }
+
+		std::size_t
+		BatchSize (void) const
+		{ return batch_; }
+
+		//!	The number of values in an estimate
+		std::size_t
+		Bins (void) const
+		{ return segmentLength_ / 2 + 1; }
+
+		//!	The number of whole segments in a record of n samples
+		std::size_t
+		Segments (const std::size_t n) const
+		{ return n < segmentLength_ ? 0 : (n - segmentLength_) / step_ + 1; }
+
+		//!	The frequency of bin k
+		double
+		Frequency (const std::size_t k) const
+		{ return sampleRate_ * double(k) / double(segmentLength_); }
+
+
+		//!	Writes the estimate for record[0, n) to psd[0, Bins())
+		/*!
+		 *	Samples after the last whole segment are not used. Throws
+		 *	std::length_error if the record is shorter than one segment.
+		 */
+		void
+		Estimate (const double* record, const std::size_t n, double* psd) const
+		{
+			const std::size_t segments = Segments(n);
+
+			if (segments == 0)
+				throw std::length_error("WelchPsd: the record is shorter than one segment");
+
+			const std::size_t bins = Bins();
+			const std::size_t blocks = (segments + batch_ - 1) / batch_;
+
+			std::vector<double> sums (blocks * bins);
+
+			ParallelFor(blocks, maxThreads_, [&](std::size_t block)
+			{
+				Buffers& buffers = ThreadBuffers();
+
+				const std::size_t first = block * batch_;
+				const std::size_t count = std::min(batch_, segments - first);
+
+				//	Windowing fused with the copy into the batch
+				for (std::size_t s = 0; s < count; ++s) {
+					const double* x = record + (first + s) * step_;
+					double* in = buffers.in.get() + s * inStride_;
+					const double* w = window_.data();
+
+					for (std::size_t i = 0; i < segmentLength_; ++i)
+						in[i] = x[i] * w[i];
+				}
+
+				if (count == batch_)
+					fftw_execute_dft_r2c(batchPlan_->plan, buffers.in.get(), buffers.out.get());
+				else
+					for (std::size_t s = 0; s < count; ++s)
+						fftw_execute_dft_r2c(singlePlan_->plan
+											, buffers.in.get() + s * inStride_
+											, buffers.out.get() + s * outStride_);
+
+				//	|X|^2 summed over the block's segments, straight from the batch output
+				double* sum = sums.data() + block * bins;
+
+				for (std::size_t s = 0; s < count; ++s) {
+					const double* X = reinterpret_cast<const double*>(buffers.out.get() + s * outStride_);
+
+					for (std::size_t k = 0; k < bins; ++k)
+						sum[k] += X[2 * k] * X[2 * k] + X[2 * k + 1] * X[2 * k + 1];
+				}
+			});
+
+			double windowPower = 0.;
+			for (double w : window_)
+				windowPower += w * w;
+
+			const double scale = 1. / (sampleRate_ * windowPower * double(segments));
+
+			for (std::size_t k = 0; k < bins; ++k) {
+				double total = 0.;
+				for (std::size_t block = 0; block < blocks; ++block)
+					total += sums[block * bins + k];
+
+				const bool single = k == 0 || 2 * k == segmentLength_;
+				psd[k] = total * scale * (single ? 1. : 2.);
+			}
+		}
+
+
+		//!	Writes the estimate for a contiguous container of samples into psd (resized to Bins())
+		template <typename RealContainer, typename OutContainer>
+		void
+		Estimate (const RealContainer& record, OutContainer& psd) const
+		{
+			psd.resize(Bins());
+			Estimate(&(*record.begin()), record.size(), &(*psd.begin()));
+		}
+	};
+
+}	//	namespace PS
+
+#endif
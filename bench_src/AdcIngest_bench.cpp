@@ -0,0 +1,110 @@
+//
+//	Converting a frame of ADC codes into a Waveform's time domain. The rows are
+//
+//		Int16_Scalar		the loop this replaces: calibrated codes pushed onto a
+//							std::vector<double>, then copied into the Waveform
+//		Int16				IngestAdc() into an existing Waveform
+//		Packed12_Scalar		the same for packed 12-bit codes, unpacked one at a time
+//		Packed12			IngestAdcPacked12() into an existing Waveform
+//		Packed12_Threads	IngestAdcPacked12() with one thread per core (frames of
+//							fewer than 2^16 samples per thread are not split)
+//
+//		Build and run with:
+//
+//	make AdcIngest_bench
+//	./bench_bin/AdcIngest_bench --min-log2=10 --max-log2=22 --out=adc.json
+//
+//	See bench_src/BenchHarness.hpp for the options and the JSON layout.
+//
+
+#include <algorithm>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+#include <AdcIngest.hpp>
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+
+#include "BenchHarness.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+
+void
+RunAll (Bench::Harness& harness, std::size_t n)
+{
+	PS::AdcCalibration cal;
+	cal.gain = 0.5e-3;
+	cal.offset = -1e-3;
+
+	std::vector<std::int16_t> codes16 (n);
+	for (std::size_t i = 0; i < n; ++i)
+		codes16[i] = std::int16_t(i * 7919);
+
+	std::vector<std::uint8_t> packed (PS::Packed12Bytes(n));
+	for (std::size_t i = 0; i < packed.size(); ++i)
+		packed[i] = std::uint8_t(i * 131);
+
+	WaveformType wfm (n);
+
+	harness.Run("Int16_Scalar", n, [&]{
+		RealType samples;
+		for (std::size_t i = 0; i < n; ++i)
+			samples.push_back(cal.gain * codes16[i] + cal.offset);
+		std::copy(samples.begin(), samples.end(), wfm.OverwriteTimeSeries().begin());
+		Bench::DoNotOptimize(wfm.PeekTimeSeries().data());
+	});
+
+	harness.Run("Int16", n, [&]{
+		PS::IngestAdc(wfm, codes16.data(), n, cal);
+		Bench::DoNotOptimize(wfm.PeekTimeSeries().data());
+	});
+
+	harness.Run("Packed12_Scalar", n, [&]{
+		RealType samples;
+		for (std::size_t i = 0; i < n; ++i) {
+			const std::uint8_t* p = &packed[i / 2 * 3];
+			int code = i % 2 ? (p[1] >> 4 | p[2] << 4) : (p[0] | (p[1] & 0xF) << 8);
+			if (code & 0x800)
+				code -= 0x1000;
+			samples.push_back(cal.gain * code + cal.offset);
+		}
+		std::copy(samples.begin(), samples.end(), wfm.OverwriteTimeSeries().begin());
+		Bench::DoNotOptimize(wfm.PeekTimeSeries().data());
+	});
+
+	harness.Run("Packed12", n, [&]{
+		PS::IngestAdcPacked12(wfm, packed.data(), n, cal);
+		Bench::DoNotOptimize(wfm.PeekTimeSeries().data());
+	});
+
+	harness.Run("Packed12_Threads", n, [&]{
+		PS::IngestAdcPacked12(wfm, packed.data(), n, cal, 0);
+		Bench::DoNotOptimize(wfm.PeekTimeSeries().data());
+	});
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	Bench::Harness harness (argc, argv);
+
+	for (std::size_t n : harness.Sizes())
+		RunAll(harness, n);
+
+	harness.Report();
+
+	fftw_cleanup();
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+//
+//	Comparing Waveforms which match (so every value is read), in the time
+//	domain and in the freq domain. The rows are
+//
+//		Exact			operator==
+//		Approx			ApproxEqual() with relative and absolute tolerances
+//		Approx_Ulps		ApproxEqual() with an ulps tolerance as well
+//		Approx_Report	ApproxEqual() filling in an ApproxReport
+//
+//	each with the suffix _Time or _Freq.
+//
+//		Build and run with:
+//
+//	make ApproxEqual_bench
+//	./bench_bin/ApproxEqual_bench --min-log2=8 --max-log2=16 --out=approx.json
+//
+//	See bench_src/BenchHarness.hpp for the options and the JSON layout.
+//
+
+#include <cmath>
+#include <complex>
+#include <string>
+#include <vector>
+
+#include <ApproxEqual.hpp>
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+
+#include "BenchHarness.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+
+RealType
+MakeSignal (std::size_t n)
+{
+	RealType signal (n);
+
+	for (std::size_t i = 0; i < n; ++i)
+		signal[i] = std::sin(0.01 * i) + 0.25 * std::cos(0.37 * i);
+
+	return signal;
+}
+
+
+void
+RunDomain (Bench::Harness& harness, const std::string& suffix, const WaveformType& a, const WaveformType& b)
+{
+	const std::size_t n = a.size();
+
+	PS::ApproxTolerance tol;
+	tol.absolute = 1e-15;
+
+	PS::ApproxTolerance ulps (tol);
+	ulps.ulps = 4;
+
+	harness.Run("Exact" + suffix, n, [&]{
+		Bench::DoNotOptimize(a == b);
+	});
+
+	harness.Run("Approx" + suffix, n, [&]{
+		Bench::DoNotOptimize(PS::ApproxEqual(a, b, tol));
+	});
+
+	harness.Run("Approx_Ulps" + suffix, n, [&]{
+		Bench::DoNotOptimize(PS::ApproxEqual(a, b, ulps));
+	});
+
+	harness.Run("Approx_Report" + suffix, n, [&]{
+		PS::ApproxReport report;
+		Bench::DoNotOptimize(PS::ApproxEqual(a, b, tol, &report));
+		Bench::DoNotOptimize(report.maxDeviation);
+	});
+}
+
+
+void
+RunAll (Bench::Harness& harness, std::size_t n)
+{
+	const RealType signal = MakeSignal(n);
+
+	const WaveformType timeA (signal);
+	const WaveformType timeB (signal);
+	RunDomain(harness, "_Time", timeA, timeB);
+
+	const WaveformType freqA (timeA.GetConstFreqSpectrum());
+	const WaveformType freqB (timeA.GetConstFreqSpectrum());
+	RunDomain(harness, "_Freq", freqA, freqB);
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	Bench::Harness harness (argc, argv);
+
+	for (std::size_t n : harness.Sizes())
+		RunAll(harness, n);
+
+	harness.Report();
+
+	fftw_cleanup();
+
+	return 0;
+}
@@ -0,0 +1,289 @@
+/*
+ BenchHarness.hpp
+ A small self-contained micro-benchmark harness for the programs in
+ bench_src/, writing results as JSON laid out like Google Benchmark's
+ "--benchmark_format=json" so that the usual comparison tools can read it.
+ */
+
+#ifndef BENCHHARNESS_HPP
+#define BENCHHARNESS_HPP 1
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	Command line options understood by Harness:
+
+		--min-log2=K		smallest size is 2^K (default 6)
+		--max-log2=K		largest size is 2^K (default 24)
+		--min-time=S		seconds each repetition should run for (default 0.1)
+		--repetitions=R		repetitions per benchmark, the median is reported (default 3)
+		--filter=TEXT		only run benchmarks whose name contains TEXT
+		--out=FILE			write the JSON to FILE instead of stdout
+
+	Progress is printed to stderr, one line per benchmark.
+ */
+
+
+namespace Bench {
+
+	//!	Keeps the compiler from discarding a value which is otherwise unused
+	template <typename T>
+	inline void
+	DoNotOptimize (const T& value)
+	{
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+
+
+	//!	Prevents the compiler from caching memory contents across this point
+	inline void
+	ClobberMemory (void)
+	{
+		asm volatile("" : : : "memory");
+	}
+
+
+	//!	The outcome of one benchmark at one size
+	struct Result {
+		std::string		name;
+		std::size_t		size;
+		std::size_t		iterations;
+
+		//!	Median over the repetitions, in nanoseconds per iteration
+		double			realTime;
+		double			cpuTime;
+
+		//!	Fastest repetition, in nanoseconds per iteration
+		double			minRealTime;
+	};
+
+
+	class Harness {
+	  private:
+
+		unsigned					minLog2_;
+		unsigned					maxLog2_;
+		double						minTime_;
+		unsigned					repetitions_;
+		std::string					filter_;
+		std::string					outFile_;
+
+		std::string					program_;
+		std::vector<Result>			results_;
+
+
+		static double
+		CpuSeconds (void)
+		{ return double(std::clock()) / CLOCKS_PER_SEC; }
+
+
+		//!	Runs body() iterations times and returns {real, cpu} seconds
+		template <typename Body>
+		static std::pair<double, double>
+		Time (Body& body, std::size_t iterations)
+		{
+			const double cpuStart = CpuSeconds();
+			const auto start = std::chrono::steady_clock::now();
+
+			for (std::size_t i = 0; i < iterations; ++i)
+				body();
+
+			ClobberMemory();
+
+			const std::chrono::duration<double> real = std::chrono::steady_clock::now() - start;
+			return std::make_pair(real.count(), CpuSeconds() - cpuStart);
+		}
+
+
+		static std::string
+		Escape (const std::string& text)
+		{
+			std::string result;
+
+			for (char c : text) {
+				if (c == '"' || c == '\\')
+					result.push_back('\\');
+				result.push_back(c);
+			}
+
+			return result;
+		}
+
+	  public:
+
+		Harness (int argc, char** argv)
+			: minLog2_(6)
+			, maxLog2_(24)
+			, minTime_(0.1)
+			, repetitions_(3)
+			, program_(argc > 0 ? argv[0] : "")
+		{
+			for (int i = 1; i < argc; ++i) {
+				const std::string arg (argv[i]);
+				const std::size_t eq = arg.find('=');
+				const std::string key = arg.substr(0, eq);
+				const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+				if (key == "--min-log2")
+					minLog2_ = std::stoul(value);
+				else if (key == "--max-log2")
+					maxLog2_ = std::stoul(value);
+				else if (key == "--min-time")
+					minTime_ = std::stod(value);
+				else if (key == "--repetitions")
+					repetitions_ = std::max(1ul, std::stoul(value));
+				else if (key == "--filter")
+					filter_ = value;
+				else if (key == "--out")
+					outFile_ = value;
+				else
+					throw std::invalid_argument("Bench: unknown option " + arg);
+			}
+		}
+
+
+		//!	Returns the sizes 2^min-log2 ... 2^max-log2
+		std::vector<std::size_t>
+		Sizes (void) const
+		{
+			std::vector<std::size_t> sizes;
+
+			for (unsigned k = minLog2_; k <= maxLog2_; ++k)
+				sizes.push_back(std::size_t(1) << k);
+
+			return sizes;
+		}
+
+
+		//!	Returns whether a benchmark of this name will be run
+		bool
+		Enabled (const std::string& name) const
+		{ return name.find(filter_) != std::string::npos; }
+
+
+		//!	Times body(), reported as "name/size"
+		/*!
+		 *	The iteration count is grown until one run takes at least
+		 *	--min-time seconds, then that count is run --repetitions times.
+		 *	Anything which should not be timed belongs outside body().
+		 */
+		template <typename Body>
+		void
+		Run (const std::string& name, std::size_t size, Body body)
+		{
+			if (!Enabled(name))
+				return;
+
+			std::size_t iterations = 1;
+
+			for (;;) {
+				const double seconds = Time(body, iterations).first;
+
+				if (seconds >= minTime_ || iterations >= (std::size_t(1) << 30))
+					break;
+
+				//	Aim directly for the target once there is a usable measurement
+				const double factor = seconds > minTime_ / 64 ? 1.4 * minTime_ / seconds : 8.;
+				iterations = std::max(iterations + 1, std::size_t(iterations * std::min(factor, 8.)));
+			}
+
+			std::vector<double> real;
+			std::vector<double> cpu;
+
+			for (unsigned r = 0; r < repetitions_; ++r) {
+				const std::pair<double, double> seconds = Time(body, iterations);
+				real.push_back(seconds.first * 1e9 / iterations);
+				cpu.push_back(seconds.second * 1e9 / iterations);
+			}
+
+			std::sort(real.begin(), real.end());
+			std::sort(cpu.begin(), cpu.end());
+
+			const Result result = { name, size, iterations
+								  , real[real.size() / 2], cpu[cpu.size() / 2], real.front() };
+			results_.push_back(result);
+
+			std::fprintf(stderr, "%-40s %14.1f ns %12zu iterations\n"
+						, (name + "/" + std::to_string(size)).c_str(), result.realTime, iterations);
+		}
+
+
+		//!	Writes every result as JSON, to --out or stdout
+		void
+		Report (void) const
+		{
+			if (outFile_.empty()) {
+				Report(std::cout);
+				return;
+			}
+
+			std::ofstream ofs (outFile_.c_str());
+
+			if (!ofs)
+				throw std::runtime_error("Bench: could not open " + outFile_);
+
+			Report(ofs);
+		}
+
+
+		void
+		Report (std::ostream& os) const
+		{
+			char date[64];
+			const std::time_t now = std::time(nullptr);
+			std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+			os << "{\n"
+			   << "  \"context\": {\n"
+			   << "    \"date\": \"" << date << "\",\n"
+			   << "    \"executable\": \"" << Escape(program_) << "\",\n"
+			   << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+			   << "    \"compiler\": \"" << Escape(__VERSION__) << "\",\n"
+#ifdef NDEBUG
+			   << "    \"library_build_type\": \"release\"\n"
+#else
+			   << "    \"library_build_type\": \"debug\"\n"
+#endif
+			   << "  },\n"
+			   << "  \"benchmarks\": [";
+
+			for (std::size_t i = 0; i < results_.size(); ++i) {
+				const Result& r = results_[i];
+				const std::string fullName = r.name + "/" + std::to_string(r.size);
+
+				os << (i ? "," : "") << "\n"
+				   << "    {\n"
+				   << "      \"name\": \"" << Escape(fullName) << "\",\n"
+				   << "      \"run_name\": \"" << Escape(fullName) << "\",\n"
+				   << "      \"run_type\": \"aggregate\",\n"
+				   << "      \"aggregate_name\": \"median\",\n"
+				   << "      \"repetitions\": " << repetitions_ << ",\n"
+				   << "      \"iterations\": " << r.iterations << ",\n"
+				   << "      \"size\": " << r.size << ",\n"
+				   << "      \"real_time\": " << r.realTime << ",\n"
+				   << "      \"cpu_time\": " << r.cpuTime << ",\n"
+				   << "      \"min_real_time\": " << r.minRealTime << ",\n"
+				   << "      \"time_unit\": \"ns\",\n"
+				   << "      \"items_per_second\": " << r.size * 1e9 / r.realTime << "\n"
+				   << "    }";
+			}
+
+			os << "\n  ]\n}\n";
+		}
+	};
+
+}	//	namespace Bench
+
+#endif
@@ -0,0 +1,129 @@
+//
+//	Throughput of DatFile against the istream_iterator parser it replaces,
+//	on generated real and complex ".dat" files.
+//
+//		Build and run with:
+//
+//	make DatFile_bench
+//	./bench_bin/DatFile_bench [megabytes per file, default 1024]
+//
+//	The files are written to the working directory and removed afterwards.
+//
+
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <DatFile.hpp>
+
+
+namespace {
+
+//!	Writes values until the file reaches the requested size
+template <typename T>
+void
+GenerateFile (const std::string& fileName, std::size_t bytes)
+{
+	std::ofstream ofs (fileName.c_str(), std::ios::binary);
+	std::vector<char> line (128);
+	std::string block;
+	std::size_t written = 0;
+
+	for (std::size_t i = 0; written < bytes; ++i) {
+		const double re = std::sin(1e-3 * i) * 1e3;
+		const double im = std::cos(1e-3 * i) * 1e-3;
+		char* p = line.data();
+		char* end = line.data() + line.size();
+
+		if (std::is_same<T, double>::value) {
+			p = std::to_chars(p, end, re).ptr;
+		}
+		else {
+			*p++ = '(';
+			p = std::to_chars(p, end, re).ptr;
+			*p++ = ',';
+			p = std::to_chars(p, end, im).ptr;
+			*p++ = ')';
+		}
+		*p++ = '\n';
+
+		block.append(line.data(), p);
+
+		if (block.size() >= (1u << 20)) {
+			ofs << block;
+			written += block.size();
+			block.clear();
+		}
+	}
+}
+
+
+template <typename Function>
+double
+SecondsFor (Function f)
+{
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+
+template <typename T>
+void
+RunFor (const char* kind, std::size_t bytes)
+{
+	const std::string fileName = std::string("DatFile_bench_") + kind + ".dat";
+	GenerateFile<T>(fileName, bytes);
+
+	std::size_t values = 0;
+
+	const double streamSeconds = SecondsFor([&]{
+			std::ifstream ifs (fileName.c_str());
+			std::vector<T> result { std::istream_iterator<T>(ifs), std::istream_iterator<T>() };
+			values = result.size();
+		});
+
+	const double serialSeconds = SecondsFor([&]{
+			PS::DatFile<T> dat (fileName, 1);
+			std::vector<T> result (dat.size());
+			dat.Read(result);
+		});
+
+	const double parallelSeconds = SecondsFor([&]{
+			PS::DatFile<T> dat (fileName);
+			std::vector<T> result (dat.size());
+			dat.Read(result);
+		});
+
+	std::remove(fileName.c_str());
+
+	const double mb = bytes / 1e6;
+
+	std::printf("%-8s %zu values, %.0f MB\n", kind, values, mb);
+	std::printf("  istream_iterator   %8.3f s %8.1f MB/s\n", streamSeconds, mb / streamSeconds);
+	std::printf("  DatFile, 1 thread  %8.3f s %8.1f MB/s\n", serialSeconds, mb / serialSeconds);
+	std::printf("  DatFile, %2u threads%8.3f s %8.1f MB/s\n", PS::DefaultThreadCount(), parallelSeconds, mb / parallelSeconds);
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	const std::size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+
+	RunFor<double>("real", megabytes << 20);
+	RunFor< std::complex<double> >("complex", megabytes << 20);
+
+	return 0;
+}
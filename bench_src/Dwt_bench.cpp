@@ -0,0 +1,101 @@
+//
+//	The multi-level DWT for each wavelet against the FFT path, forward and
+//	inverse, for sizes 2^6 through 2^24.
+//
+//		Build and run with:
+//
+//	make Dwt_bench
+//	./bench_bin/Dwt_bench --max-log2=20 --out=dwt.json
+//
+//	See bench_src/BenchHarness.hpp for the options and the JSON layout.
+//
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <Dwt.hpp>
+#include <FftwTransform.hpp>
+
+#include "BenchHarness.hpp"
+
+
+namespace {
+
+namespace Wavelet = Waveform::Transform::Wavelet;
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::WaveletCoefficients<double>		CoeffType;
+
+
+RealType
+MakeSignal (std::size_t n)
+{
+	RealType signal (n);
+
+	for (std::size_t i = 0; i < n; ++i)
+		signal[i] = std::sin(0.01 * i) + 0.25 * std::cos(0.37 * i);
+
+	return signal;
+}
+
+
+//!	Every level the length allows, through the TransformT as a Waveform would run it
+template <typename WaveletT>
+void
+RunDwt (Bench::Harness& harness, const char* name, const RealType& signal)
+{
+	RealType time (signal);
+	CoeffType coeffs (signal.size());
+	Waveform::Transform::Dwt<WaveletT, 0> transform (time, coeffs);
+
+	harness.Run(name, signal.size(), [&]{
+		transform.exec_transform();
+		transform.exec_inverse_transform();
+		Bench::DoNotOptimize(time.data());
+	});
+}
+
+
+void
+RunAll (Bench::Harness& harness, std::size_t n)
+{
+	const RealType signal = MakeSignal(n);
+
+	RunDwt<Wavelet::Haar>(harness, "Haar", signal);
+	RunDwt<Wavelet::Daubechies4>(harness, "Daubechies4", signal);
+	RunDwt<Wavelet::Daubechies8>(harness, "Daubechies8", signal);
+	RunDwt<Wavelet::Cdf97>(harness, "Cdf97", signal);
+
+	//	The r2c/c2r pair of Waveform_bench's "ForwardInverse", for reference
+	{
+		RealType time (signal);
+		ComplexType freq (n / 2 + 1);
+		Waveform::Transform::Fftw3_Dft_1d_Normalized transform (time, freq);
+
+		harness.Run("Fft", n, [&]{
+			transform.exec_transform();
+			transform.exec_inverse_transform();
+			Bench::DoNotOptimize(time.data());
+		});
+	}
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	Bench::Harness harness (argc, argv);
+
+	for (std::size_t n : harness.Sizes())
+		RunAll(harness, n);
+
+	harness.Report();
+
+	fftw_cleanup();
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+//
+//	FixedWaveform<N> against a Waveform of vectors (Fftw3_Dft_1d_Normalized)
+//	for the small lengths it is meant for, N = 16 through 256: making one
+//	from samples and reading its spectrum (allocations and planning
+//	included), and a forward and inverse transform of an existing one.
+//	The lengths are template arguments, so --min-log2 and --max-log2 only
+//	select among them.
+//
+//		Build and run with:
+//
+//	make FixedWaveform_bench
+//	./bench_bin/FixedWaveform_bench --min-log2=4 --max-log2=8 --out=fixed.json
+//
+//	See bench_src/BenchHarness.hpp for the options and the JSON layout.
+//
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <FixedWaveform.hpp>
+#include <Waveform.hpp>
+
+#include "BenchHarness.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+
+template <std::size_t N>
+void
+RunLength (Bench::Harness& harness)
+{
+	std::array<double, N> samples;
+	for (std::size_t i = 0; i < N; ++i)
+		samples[i] = std::sin(0.01 * i) + 0.25 * std::cos(0.37 * i);
+
+	const RealType signal (samples.begin(), samples.end());
+
+	harness.Run("Fixed_ConstructForward", N, [&]{
+		PS::FixedWaveform<N> wfm (samples);
+		Bench::DoNotOptimize(wfm.GetConstFreqSpectrum().data());
+	});
+
+	harness.Run("Waveform_ConstructForward", N, [&]{
+		WaveformType wfm (signal);
+		Bench::DoNotOptimize(wfm.GetConstFreqSpectrum().data());
+	});
+
+	{
+		PS::FixedWaveform<N> wfm (samples);
+
+		harness.Run("Fixed_PingPong", N, [&]{
+			Bench::DoNotOptimize(wfm.GetFreqSpectrum().data());
+			Bench::DoNotOptimize(wfm.GetTimeSeries().data());
+		});
+	}
+
+	{
+		WaveformType wfm (signal);
+
+		harness.Run("Waveform_PingPong", N, [&]{
+			Bench::DoNotOptimize(wfm.GetFreqSpectrum().data());
+			Bench::DoNotOptimize(wfm.GetTimeSeries().data());
+		});
+	}
+}
+
+
+//!	Runs RunLength<N> if N is among the harness's sizes
+template <std::size_t N>
+void
+RunIfSelected (Bench::Harness& harness)
+{
+	for (std::size_t n : harness.Sizes())
+		if (n == N)
+			RunLength<N>(harness);
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	Bench::Harness harness (argc, argv);
+
+	RunIfSelected<16>(harness);
+	RunIfSelected<32>(harness);
+	RunIfSelected<64>(harness);
+	RunIfSelected<128>(harness);
+	RunIfSelected<256>(harness);
+
+	harness.Report();
+
+	fftw_cleanup();
+
+	return 0;
+}
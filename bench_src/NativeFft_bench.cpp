@@ -0,0 +1,118 @@
+//
+//	The self-contained FFT against FFTW: forward and inverse transforms of
+//	Native_Dft_1d_Normalized and Fftw3_Dft_1d_Normalized Waveforms of
+//	lengths 2^6 through 2^24, plus 3 * 2^k lengths (mixed radix) as
+//	"Mixed" rows. Construction (planning) is outside the timed loops. The
+//	Complex rows time the complex engine alone, once as Stockham passes
+//	and once cache-blocked (four-step), to find where
+//	NativeFft::FourStepLength should be on this machine.
+//
+//		Build and run with:
+//
+//	make NativeFft_bench
+//	./bench_bin/NativeFft_bench --min-log2=8 --max-log2=22 --out=native.json
+//
+//	See bench_src/BenchHarness.hpp for the options and the JSON layout.
+//
+
+#include <cmath>
+#include <complex>
+#include <string>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <NativeFft.hpp>
+#include <Waveform.hpp>
+
+#include "BenchHarness.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	FftwWaveform;
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Native_Dft_1d_Normalized>	NativeWaveform;
+
+
+RealType
+MakeSignal (std::size_t n)
+{
+	RealType signal (n);
+
+	for (std::size_t i = 0; i < n; ++i)
+		signal[i] = std::sin(0.01 * i) + 0.25 * std::cos(0.37 * i);
+
+	return signal;
+}
+
+
+//!	Forward and inverse transform timings of one Waveform type
+template <typename WaveformT>
+void
+RunTransforms (Bench::Harness& harness, const std::string& name, std::size_t n)
+{
+	WaveformT wfm (MakeSignal(n));
+
+	harness.Run(name + "_Forward", n, [&]{
+		wfm.AssumeValidDomain(WaveformT::DomainState::Time);
+		Bench::DoNotOptimize(wfm.GetConstFreqSpectrum().data());
+	});
+
+	harness.Run(name + "_Inverse", n, [&]{
+		wfm.AssumeValidDomain(WaveformT::DomainState::Freq);
+		Bench::DoNotOptimize(wfm.GetConstTimeSeries().data());
+	});
+}
+
+
+//!	A complex transform of n values, Stockham passes over the whole array or four-step
+void
+RunComplex (Bench::Harness& harness, const std::string& name, std::size_t n, std::size_t fourStepLength)
+{
+	const Waveform::Transform::NativeFft::Plan plan (n, fourStepLength);
+
+	const RealType src = MakeSignal(2 * n);
+	RealType dst (2 * n);
+	RealType work (2 * n);
+
+	harness.Run(name, n, [&]{
+		plan.Execute(src.data(), dst.data(), work.data());
+		Bench::DoNotOptimize(dst.data());
+	});
+}
+
+
+void
+RunAll (Bench::Harness& harness, std::size_t n)
+{
+	RunTransforms<FftwWaveform>(harness, "Fftw", n);
+	RunTransforms<NativeWaveform>(harness, "Native", n);
+
+	//	3 * 2^k, with a radix-3 stage
+	const std::size_t mixed = 3 * (n / 4);
+	RunTransforms<FftwWaveform>(harness, "Fftw_Mixed", mixed);
+	RunTransforms<NativeWaveform>(harness, "Native_Mixed", mixed);
+
+	RunComplex(harness, "Complex_Stockham", n, 0);
+	RunComplex(harness, "Complex_FourStep", n, 1);
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	Bench::Harness harness (argc, argv);
+
+	for (std::size_t n : harness.Sizes())
+		RunAll(harness, n);
+
+	harness.Report();
+
+	fftw_cleanup();
+
+	return 0;
+}
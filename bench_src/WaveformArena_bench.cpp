@@ -0,0 +1,107 @@
+//
+//	Short-lived Waveforms with and without a per-event arena: one "event"
+//	makes 64 Waveforms from samples, reads each one's spectrum and drops
+//	them all. The rows are
+//
+//		Default			std::vector and Fftw3_Dft_1d_Normalized (plans per Waveform)
+//		Default_Cached	std::vector and Fftw3_Dft_1d_Cached_Normalized (shared plans)
+//		Arena_Cached	PS::EventArena, reset after each event, and shared plans
+//
+//	so the cost of planning and the cost of malloc/free show separately.
+//
+//		Build and run with:
+//
+//	make WaveformArena_bench
+//	./bench_bin/WaveformArena_bench --min-log2=6 --max-log2=14 --out=arena.json
+//
+//	See bench_src/BenchHarness.hpp for the options and the JSON layout.
+//
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <WaveformArena.hpp>
+
+#include "BenchHarness.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>			DefaultWaveform;
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Cached_Normalized>	CachedWaveform;
+typedef PS::PmrWaveform<Waveform::Transform::Fftw3_Dft_1d_Cached_Normalized>						ArenaWaveform;
+
+const std::size_t WaveformsPerEvent = 64;
+
+
+RealType
+MakeSignal (std::size_t n)
+{
+	RealType signal (n);
+
+	for (std::size_t i = 0; i < n; ++i)
+		signal[i] = std::sin(0.01 * i) + 0.25 * std::cos(0.37 * i);
+
+	return signal;
+}
+
+
+template <typename WaveformT>
+void
+RunEvents (Bench::Harness& harness, const std::string& name, const RealType& signal)
+{
+	harness.Run(name, signal.size(), [&]{
+		for (std::size_t i = 0; i < WaveformsPerEvent; ++i) {
+			WaveformT wfm (signal);
+			Bench::DoNotOptimize(wfm.GetConstFreqSpectrum().data());
+		}
+	});
+}
+
+
+void
+RunAll (Bench::Harness& harness, std::size_t n)
+{
+	const RealType signal = MakeSignal(n);
+
+	RunEvents<DefaultWaveform>(harness, "Default", signal);
+	RunEvents<CachedWaveform>(harness, "Default_Cached", signal);
+
+	//	Room for every Waveform of an event, so only the first event reaches the heap
+	PS::EventArena arena (WaveformsPerEvent * (n + n + 2 + 2 * PS::SimdAlignment / sizeof(double)) * sizeof(double));
+	const PS::PmrRealVector samples (signal.begin(), signal.end());
+
+	harness.Run("Arena_Cached", n, [&]{
+		for (std::size_t i = 0; i < WaveformsPerEvent; ++i) {
+			ArenaWaveform wfm (samples, arena.Allocator<double>());
+			Bench::DoNotOptimize(wfm.GetConstFreqSpectrum().data());
+		}
+		arena.Reset();
+	});
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	Bench::Harness harness (argc, argv);
+
+	for (std::size_t n : harness.Sizes())
+		RunAll(harness, n);
+
+	harness.Report();
+
+	//	The cached plans must go before FFTW's own state
+	Waveform::Transform::FftwPlanCache::Clear();
+	fftw_cleanup();
+
+	return 0;
+}
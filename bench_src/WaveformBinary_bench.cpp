@@ -0,0 +1,126 @@
+//
+//	Compares the Waveform binary format against the Boost text archives
+//	used for the test data (test_data/bs_*_tDomain_.txt).
+//
+//		Build and run with:
+//
+//	make WaveformBinary_bench
+//	./bench_bin/WaveformBinary_bench
+//
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <Waveform.hpp>
+#include <WaveformBinary.hpp>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/complex.hpp>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::Waveform<RealType, ComplexType>	WaveformType;
+
+
+template <typename Function>
+double
+SecondsFor (Function f, int repetitions)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; ++i)
+		f();
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / repetitions;
+}
+
+
+void
+Report (const char* name, std::size_t length, std::size_t bytes, double seconds)
+{
+	std::printf("%-22s N=%-9zu %10.3f ms %10.1f MB/s\n"
+				, name, length, seconds * 1e3, bytes / seconds / 1e6);
+}
+
+
+void
+RunForLength (std::size_t length)
+{
+	RealType tDomain (length);
+	ComplexType fDomain (length / 2 + 1);
+
+	for (std::size_t i = 0; i < tDomain.size(); ++i)
+		tDomain[i] = std::sin(0.001 * i) / 3.;
+
+	for (std::size_t i = 0; i < fDomain.size(); ++i)
+		fDomain[i] = std::complex<double>(1. / (i + 3.), std::cos(0.002 * i) / 7.);
+
+	//	A Waveform with both domains valid, as after a transform
+	WaveformType wfm (tDomain);
+	wfm.OverwriteFreqSpectrum() = fDomain;
+	wfm.OverwriteTimeSeries() = tDomain;
+	wfm.AssumeValidDomain(WaveformType::DomainState::Both);
+
+	const int reps = length >= (1u << 20) ? 3 : 20;
+
+	//	Boost text archives, one per domain as in test_data/
+	std::string textBytes;
+	const double textSave = SecondsFor([&]{
+			std::ostringstream os;
+			boost::archive::text_oarchive oa (os);
+			oa << tDomain << fDomain;
+			textBytes = os.str();
+		}, reps);
+
+	const double textLoad = SecondsFor([&]{
+			std::istringstream is (textBytes);
+			boost::archive::text_iarchive ia (is);
+			RealType t;
+			ComplexType f;
+			ia >> t >> f;
+		}, reps);
+
+	std::string binaryBytes;
+	const double binarySave = SecondsFor([&]{
+			std::ostringstream os;
+			PS::Save(os, wfm);
+			binaryBytes = os.str();
+		}, reps);
+
+	WaveformType loaded (tDomain);
+	const double binaryLoad = SecondsFor([&]{
+			std::istringstream is (binaryBytes);
+			PS::Load(is, loaded);
+		}, reps);
+
+	Report("boost text save", length, textBytes.size(), textSave);
+	Report("boost text load", length, textBytes.size(), textLoad);
+	Report("binary save", length, binaryBytes.size(), binarySave);
+	Report("binary load", length, binaryBytes.size(), binaryLoad);
+
+	std::printf("%-22s N=%-9zu text %zu bytes, binary %zu bytes\n\n"
+				, "size", length, textBytes.size(), binaryBytes.size());
+}
+
+}	//	namespace
+
+
+int
+main (void)
+{
+	for (std::size_t length = 1u << 10; length <= (1u << 22); length <<= 4)
+		RunForLength(length);
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+//
+//	A steady-state loop which needs one Waveform at a time: write samples,
+//	read the spectrum, drop the Waveform. The rows are
+//
+//		Construct		a new Waveform every time (allocation, first touch, planning)
+//		Pool			a Waveform from a WaveformPool, given back afterwards
+//		Pool_Threads	one Waveform on each core per iteration; ParallelFor starts new
+//						threads, which adopt the free lists of the ones before
+//
+//		Build and run with:
+//
+//	make WaveformPool_bench
+//	./bench_bin/WaveformPool_bench --min-log2=6 --max-log2=14 --out=pool.json
+//
+//	See bench_src/BenchHarness.hpp for the options and the JSON layout.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <ParallelFor.hpp>
+#include <Waveform.hpp>
+#include <WaveformPool.hpp>
+
+#include "BenchHarness.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+typedef PS::WaveformPool<WaveformType>														PoolType;
+
+
+RealType
+MakeSignal (std::size_t n)
+{
+	RealType signal (n);
+
+	for (std::size_t i = 0; i < n; ++i)
+		signal[i] = std::sin(0.01 * i) + 0.25 * std::cos(0.37 * i);
+
+	return signal;
+}
+
+
+void
+UsePooled (PoolType& pool, const RealType& signal)
+{
+	PoolType::Handle wfm = pool.Acquire(signal.size());
+	std::copy(signal.begin(), signal.end(), wfm->GetTimeSeries().begin());
+	Bench::DoNotOptimize(wfm->GetConstFreqSpectrum().data());
+}
+
+
+void
+RunAll (Bench::Harness& harness, PoolType& pool, std::size_t n)
+{
+	const RealType signal = MakeSignal(n);
+
+	harness.Run("Construct", n, [&]{
+		WaveformType wfm (signal);
+		Bench::DoNotOptimize(wfm.GetConstFreqSpectrum().data());
+	});
+
+	harness.Run("Pool", n, [&]{
+		UsePooled(pool, signal);
+	});
+
+	const unsigned threads = PS::DefaultThreadCount();
+
+	harness.Run("Pool_Threads", n, [&]{
+		PS::ParallelFor(threads, threads, [&](std::size_t) {
+			UsePooled(pool, signal);
+		});
+	});
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	Bench::Harness harness (argc, argv);
+
+	{
+		PoolType pool;
+
+		for (std::size_t n : harness.Sizes())
+			RunAll(harness, pool, n);
+	}
+
+	harness.Report();
+
+	fftw_cleanup();
+
+	return 0;
+}
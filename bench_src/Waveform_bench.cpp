@@ -0,0 +1,161 @@
+//
+//	Waveform construction, transforms and domain switching, for sizes
+//	2^6 through 2^24, using Waveform::Transform::Fftw3_Dft_1d_Normalized.
+//
+//		Build and run with:
+//
+//	make bench
+//
+//	or, for a subset:
+//
+//	make Waveform_bench
+//	./bench_bin/Waveform_bench --filter=PingPong --max-log2=16 --out=results.json
+//
+//	See bench_src/BenchHarness.hpp for the options and the JSON layout.
+//
+
+#include <cmath>
+#include <complex>
+#include <utility>
+#include <vector>
+
+#include <Waveform.hpp>
+#include <FftwTransform.hpp>
+
+#include "BenchHarness.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef Waveform::Transform::Fftw3_Dft_1d_Normalized	TransformType;
+typedef PS::Waveform<RealType, ComplexType, TransformType>	WaveformType;
+
+
+RealType
+MakeSignal (std::size_t n)
+{
+	RealType signal (n);
+
+	for (std::size_t i = 0; i < n; ++i)
+		signal[i] = std::sin(0.01 * i) + 0.25 * std::cos(0.37 * i);
+
+	return signal;
+}
+
+
+//!	A low-pass response, one coefficient per frequency bin
+ComplexType
+MakeFilter (std::size_t n)
+{
+	ComplexType filter (n / 2 + 1);
+
+	for (std::size_t i = 0; i < filter.size(); ++i)
+		filter[i] = std::polar(1. / (1. + double(i) / 64.), -1e-3 * i);
+
+	return filter;
+}
+
+
+void
+RunAll (Bench::Harness& harness, std::size_t n)
+{
+	const RealType signal = MakeSignal(n);
+	const ComplexType filter = MakeFilter(n);
+
+	//	Includes allocating both domains and making the FFTW plans
+	harness.Run("Construct", n, [&]{
+		WaveformType wfm (signal);
+		Bench::DoNotOptimize(wfm.PeekTimeSeries().data());
+	});
+
+	//	The transforms alone, without the Waveform bookkeeping
+	{
+		RealType time (signal);
+		ComplexType freq (n / 2 + 1);
+		TransformType transform (time, freq);
+
+		harness.Run("ForwardInverse", n, [&]{
+			transform.exec_transform();
+			transform.exec_inverse_transform();
+			Bench::DoNotOptimize(time.data());
+		});
+	}
+
+	//	Mutable access to alternating domains: one transform per access
+	{
+		WaveformType wfm (signal);
+
+		harness.Run("PingPong", n, [&]{
+			Bench::DoNotOptimize(wfm.GetFreqSpectrum().data());
+			Bench::DoNotOptimize(wfm.GetTimeSeries().data());
+		});
+	}
+
+	//	Const access once both domains are valid: no transforms at all
+	{
+		WaveformType wfm (signal);
+		wfm.GetConstFreqSpectrum();
+
+		harness.Run("ConstAccess", n, [&]{
+			Bench::DoNotOptimize(wfm.GetConstTimeSeries().data());
+			Bench::DoNotOptimize(wfm.GetConstFreqSpectrum().data());
+		});
+	}
+
+	//	Copying both domains and re-planning for the copy
+	{
+		WaveformType wfm (signal);
+		wfm.GetConstFreqSpectrum();
+
+		harness.Run("Copy", n, [&]{
+			WaveformType copy (wfm);
+			Bench::DoNotOptimize(copy.PeekTimeSeries().data());
+		});
+	}
+
+	//	Two moves and a swap; no data or plans are copied
+	{
+		WaveformType wfm (signal);
+
+		harness.Run("Move", n, [&]{
+			WaveformType moved (std::move(wfm));
+			wfm = std::move(moved);
+			Bench::DoNotOptimize(wfm.PeekTimeSeries().data());
+		});
+	}
+
+	//	Writing the time domain, filtering in the freq domain and reading back
+	{
+		WaveformType wfm (signal);
+
+		harness.Run("Filter", n, [&]{
+			wfm.GetTimeSeries()[0] = signal[0];
+
+			ComplexType& spectrum = wfm.GetFreqSpectrum();
+			for (std::size_t i = 0; i < spectrum.size(); ++i)
+				spectrum[i] *= filter[i];
+
+			Bench::DoNotOptimize(wfm.GetConstTimeSeries().data());
+		});
+	}
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	Bench::Harness harness (argc, argv);
+
+	for (std::size_t n : harness.Sizes())
+		RunAll(harness, n);
+
+	harness.Report();
+
+	fftw_cleanup();
+
+	return 0;
+}
@@ -0,0 +1,114 @@
+//
+//	Welch PSD estimates of long records: the WelchPsd engine (on one
+//	thread and on every core) against one Waveform per segment, for
+//	record lengths 2^12 through 2^24 in segments of 1024 with 50% overlap.
+//
+//		Build and run with:
+//
+//	make WelchPsd_bench
+//	./bench_bin/WelchPsd_bench --min-log2=16 --max-log2=22 --out=welch.json
+//
+//	See bench_src/BenchHarness.hpp for the options and the JSON layout.
+//
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <WelchPsd.hpp>
+
+#include "BenchHarness.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+const std::size_t segmentLength = 1024;
+const std::size_t overlap = 512;
+
+
+RealType
+MakeSignal (std::size_t n)
+{
+	RealType signal (n);
+
+	for (std::size_t i = 0; i < n; ++i)
+		signal[i] = std::sin(0.01 * i) + 0.25 * std::cos(0.37 * i);
+
+	return signal;
+}
+
+
+//!	The approach WelchPsd replaces: a Waveform (allocation and plans) per segment
+void
+LoopOfWaveforms (const RealType& record, const RealType& window, RealType& psd)
+{
+	const std::size_t bins = segmentLength / 2 + 1;
+	psd.assign(bins, 0.);
+
+	for (std::size_t first = 0; first + segmentLength <= record.size(); first += segmentLength - overlap) {
+		RealType segment (segmentLength);
+		for (std::size_t i = 0; i < segmentLength; ++i)
+			segment[i] = record[first + i] * window[i];
+
+		WaveformType wfm (segment);
+		const ComplexType& spectrum = wfm.GetConstFreqSpectrum();
+
+		for (std::size_t k = 0; k < bins; ++k)
+			psd[k] += std::norm(spectrum[k]);
+	}
+}
+
+
+void
+RunAll (Bench::Harness& harness, std::size_t n)
+{
+	if (n < 4 * segmentLength)
+		return;
+
+	const RealType record = MakeSignal(n);
+	const RealType window = PS::WelchPsd::Hann(segmentLength);
+	RealType psd;
+
+	harness.Run("LoopOfWaveforms", n, [&]{
+		LoopOfWaveforms(record, window, psd);
+		Bench::DoNotOptimize(psd.data());
+	});
+
+	const PS::WelchPsd single (segmentLength, overlap, window, 1., 1);
+
+	harness.Run("WelchPsd_1Thread", n, [&]{
+		single.Estimate(record, psd);
+		Bench::DoNotOptimize(psd.data());
+	});
+
+	const PS::WelchPsd parallel (segmentLength, overlap, window);
+
+	harness.Run("WelchPsd", n, [&]{
+		parallel.Estimate(record, psd);
+		Bench::DoNotOptimize(psd.data());
+	});
+}
+
+}	//	namespace
+
+
+int
+main (int argc, char** argv)
+{
+	Bench::Harness harness (argc, argv);
+
+	for (std::size_t n : harness.Sizes())
+		RunAll(harness, n);
+
+	harness.Report();
+
+	fftw_cleanup();
+
+	return 0;
+}
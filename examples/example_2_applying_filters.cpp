@@ -113,6 +113,7 @@ int main ()
 
 #include <Waveform/Waveform.hpp>		// the standard Waveform header file
 #include <Waveform/FftwTransform.hpp>	// the FFTW3 transform header file
+#include <Waveform/DatFile.hpp>		// fast .dat file parsing
 
 typedef Waveform < vector<double>				// The type of the real-valued array
 				, vector< complex<double> >		// The type of the complex-valued array
@@ -122,12 +123,14 @@ typedef Waveform < vector<double>				// The type of the real-valued array
 
 int main ()
 {
-	// Construct a Waveform instance from a vector filled by a file
-	WaveformType mySignal ( parse_dat_file<double>("signal_file.dat") );
+	// Construct a Waveform instance and parse the file straight into its time domain
+	PS::DatFile<double> signalFile ("signal_file.dat");
+	WaveformType mySignal (signalFile.size());
+	PS::ReadTimeSeries(signalFile, mySignal);
 
 	// Create two filters, read in from files
-	auto filter0 = parse_dat_file< complex<double> >("filter0_file.dat");
-	auto filter1 = parse_dat_file< complex<double> >("filter1_file.dat");
+	auto filter0 = PS::ParseDatFile< complex<double> >("filter0_file.dat");
+	auto filter1 = PS::ParseDatFile< complex<double> >("filter1_file.dat");
 
 	std::cout << "The original signal waveform:" << std::endl;
 	std::copy ( mySignal.GetConstTimeSeries().begin()
@@ -0,0 +1,192 @@
+#include <cstdint>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+
+#include <AdcIngest.hpp>
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+
+//!	A transform which does nothing, for a Waveform of floats
+struct NullTransform {
+	typedef InverseTypes::Inverse inverse_type;
+
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	NullTransform (RandomAccessRange1&, RandomAccessRange2&)
+	{ }
+
+	void
+	exec_transform (void)
+	{ }
+
+	void
+	exec_inverse_transform (void)
+	{ }
+};
+
+typedef PS::Waveform<std::vector<float>, std::vector< std::complex<float> >, NullTransform>	FloatWaveformType;
+
+
+//!	Every 12-bit code in turn, from -2048 up
+std::vector<std::int32_t>
+Codes12 (std::size_t count)
+{
+	std::vector<std::int32_t> codes (count);
+
+	for (std::size_t i = 0; i < count; ++i)
+		codes[i] = std::int32_t((i * 7) % 4096) - 2048;
+
+	return codes;
+}
+
+
+//!	Packs codes in the layout of AdcIngest.hpp, leaving junk in an unused final nibble
+std::vector<std::uint8_t>
+Pack12 (const std::vector<std::int32_t>& codes)
+{
+	std::vector<std::uint8_t> packed (PS::Packed12Bytes(codes.size()), 0xF0);
+
+	for (std::size_t i = 0; i < codes.size(); ++i) {
+		const std::uint32_t bits = std::uint32_t(codes[i]) & 0xFFF;
+		std::uint8_t* p = &packed[i / 2 * 3];
+
+		if (i % 2 == 0) {
+			p[0] = std::uint8_t(bits);
+			p[1] = std::uint8_t((p[1] & 0xF0) | bits >> 8);
+		}
+		else {
+			p[1] = std::uint8_t((p[1] & 0x0F) | (bits & 0xF) << 4);
+			p[2] = std::uint8_t(bits >> 4);
+		}
+	}
+
+	return packed;
+}
+
+
+
+TEST(AdcIngestTest, Int8AndInt16)
+{
+	PS::AdcCalibration cal;
+	cal.gain = 0.25;
+	cal.offset = -3.;
+
+	std::vector<std::int8_t> codes8;
+	for (int c = -128; c < 128; ++c)
+		codes8.push_back(std::int8_t(c));
+
+	std::vector<double> out (codes8.size());
+	PS::IngestAdc(codes8.data(), codes8.size(), out.data(), cal);
+
+	for (std::size_t i = 0; i < codes8.size(); ++i)
+		ASSERT_EQ(0.25 * codes8[i] - 3., out[i]) << i;
+
+	std::vector<std::int16_t> codes16 (1001);
+	for (std::size_t i = 0; i < codes16.size(); ++i)
+		codes16[i] = std::int16_t(i * 65 - 32768);
+
+	std::vector<float> outf (codes16.size());
+	PS::IngestAdc(codes16.data(), codes16.size(), outf.data(), cal);
+
+	for (std::size_t i = 0; i < codes16.size(); ++i)
+		ASSERT_EQ(0.25f * codes16[i] - 3.f, outf[i]) << i;
+}
+
+
+TEST(AdcIngestTest, Packed12)
+{
+	PS::AdcCalibration cal;
+	cal.gain = 1e-3;
+
+	for (std::size_t count : { 0, 1, 2, 7, 4096, 4097 }) {
+		const std::vector<std::int32_t> codes = Codes12(count);
+		const std::vector<std::uint8_t> packed = Pack12(codes);
+
+		std::vector<double> out (count);
+		PS::IngestAdcPacked12(packed.data(), count, out.data(), cal);
+
+		std::vector<float> outf (count);
+		PS::IngestAdcPacked12(packed.data(), count, outf.data(), cal);
+
+		for (std::size_t i = 0; i < count; ++i) {
+			ASSERT_EQ(1e-3 * codes[i], out[i]) << count << " " << i;
+			ASSERT_EQ(1e-3f * codes[i], outf[i]) << count << " " << i;
+		}
+	}
+}
+
+
+TEST(AdcIngestTest, SplitsLargeFrames)
+{
+	//	Odd, and long enough for three pieces
+	const std::size_t count = 3 * PS::detail::AdcSamplesPerThread + 5;
+
+	PS::AdcCalibration cal;
+	cal.gain = 0.5;
+	cal.offset = 1.;
+
+	const std::vector<std::int32_t> codes = Codes12(count);
+	const std::vector<std::uint8_t> packed = Pack12(codes);
+
+	std::vector<double> out (count);
+	PS::IngestAdcPacked12(packed.data(), count, out.data(), cal, 3);
+
+	for (std::size_t i = 0; i < count; ++i)
+		ASSERT_EQ(0.5 * codes[i] + 1., out[i]) << i;
+
+	std::vector<std::int16_t> codes16 (codes.begin(), codes.end());
+	std::vector<double> out16 (count);
+	PS::IngestAdc(codes16.data(), count, out16.data(), cal, 0);
+
+	EXPECT_EQ(out, out16);
+}
+
+
+TEST(AdcIngestTest, WritesTheTimeDomain)
+{
+	const std::vector<std::int32_t> codes = Codes12(64);
+	const std::vector<std::uint8_t> packed = Pack12(codes);
+
+	WaveformType wfm (RealType(64, 1.));
+	wfm.GetConstFreqSpectrum();
+
+	PS::AdcCalibration cal;
+	cal.gain = 2.;
+	PS::IngestAdcPacked12(wfm, packed.data(), codes.size(), cal);
+
+	EXPECT_EQ(WaveformType::DomainState::Time, wfm.GetValidDomain());
+	for (std::size_t i = 0; i < codes.size(); ++i)
+		ASSERT_EQ(2. * codes[i], wfm.GetConstTimeSeries()[i]);
+
+	FloatWaveformType wfmf (64);
+	const std::vector<std::int8_t> codes8 (64, -5);
+	PS::IngestAdc(wfmf, codes8.data(), codes8.size());
+
+	EXPECT_EQ(FloatWaveformType::DomainState::Time, wfmf.GetValidDomain());
+	EXPECT_EQ(std::vector<float>(64, -5.f), wfmf.GetConstTimeSeries());
+
+	EXPECT_THROW(PS::IngestAdc(wfmf, codes8.data(), 63), std::length_error);
+	EXPECT_THROW(PS::IngestAdcPacked12(wfm, packed.data(), 65), std::length_error);
+	EXPECT_EQ(FloatWaveformType::DomainState::Time, wfmf.GetValidDomain());
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,241 @@
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+
+#include <ApproxEqual.hpp>
+#include <FftwTransform.hpp>
+#include <SplitComplex.hpp>
+#include <Waveform.hpp>
+
+#include <gtest/gtest.h>
+
+#include "TestSignals.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+
+//!	A transform which only counts how often it runs
+struct CountingTransform {
+	typedef InverseTypes::Inverse inverse_type;
+
+	static inline int forward = 0;
+	static inline int inverse = 0;
+
+	static void
+	Reset (void)
+	{ forward = inverse = 0; }
+
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	CountingTransform (RandomAccessRange1&, RandomAccessRange2&)
+	{ }
+
+	void
+	exec_transform (void)
+	{ ++forward; }
+
+	void
+	exec_inverse_transform (void)
+	{ ++inverse; }
+};
+
+typedef PS::Waveform<RealType, ComplexType, CountingTransform>	CountingWaveformType;
+
+
+//!	A transform whose freq domain holds N bins rather than N/2+1
+struct FullSpectrumTransform : CountingTransform {
+	using CountingTransform::CountingTransform;
+
+	static std::size_t
+	freq_length (const std::size_t timeLength)
+	{ return timeLength; }
+
+	static std::size_t
+	time_length (const std::size_t freqLength)
+	{ return freqLength; }
+};
+
+typedef PS::Waveform<RealType, ComplexType, FullSpectrumTransform>	FullSpectrumWaveformType;
+
+
+
+TEST(ApproxEqualTest, RoundTripIsCloseButNotExact)
+{
+	const RealType signal = TestSignal(250);
+
+	const WaveformType original (signal);
+	WaveformType roundTrip (signal);
+	roundTrip.GetFreqSpectrum();
+	roundTrip.GetConstTimeSeries();
+
+	EXPECT_FALSE(original == roundTrip);
+	EXPECT_TRUE(PS::ApproxEqual(original, roundTrip, 1e-12, 1e-14));
+
+	PS::ApproxReport report;
+	EXPECT_TRUE(PS::ApproxEqual(original, roundTrip, PS::ApproxTolerance(), &report));
+	EXPECT_TRUE(report.timeDomain);
+	EXPECT_GT(report.maxDeviation, 0.);
+	EXPECT_LT(report.maxDeviation, 1e-14);
+	EXPECT_EQ(0u, report.mismatches);
+}
+
+
+TEST(ApproxEqualTest, TransformsOnlyWithoutACommonDomain)
+{
+	CountingWaveformType timeOnly (RealType(64, 1.));
+	CountingWaveformType both (RealType(64, 1.));
+	both.GetConstFreqSpectrum();
+	CountingWaveformType freqOnly (ComplexType(33, 1.));
+	CountingTransform::Reset();
+
+	PS::ApproxReport report;
+	EXPECT_TRUE(PS::ApproxEqual(timeOnly, both, PS::ApproxTolerance(), &report));
+	EXPECT_TRUE(report.timeDomain);
+
+	PS::ApproxEqual(freqOnly, both, PS::ApproxTolerance(), &report);
+	EXPECT_FALSE(report.timeDomain);
+	EXPECT_EQ(0, CountingTransform::forward + CountingTransform::inverse);
+
+	//	Opposite domains: the time side is transformed forward
+	PS::ApproxEqual(freqOnly, timeOnly, PS::ApproxTolerance(), &report);
+	EXPECT_FALSE(report.timeDomain);
+	EXPECT_EQ(1, CountingTransform::forward);
+	EXPECT_EQ(0, CountingTransform::inverse);
+	EXPECT_EQ(CountingWaveformType::DomainState::Both, timeOnly.GetValidDomain());
+
+	//	Neither has only a time domain, so the freq side is transformed back
+	const CountingWaveformType neither (64);
+	CountingWaveformType freqAgain (ComplexType(33, 1.));
+	CountingTransform::Reset();
+
+	PS::ApproxEqual(neither, freqAgain, PS::ApproxTolerance(), &report);
+	EXPECT_TRUE(report.timeDomain);
+	EXPECT_EQ(0, CountingTransform::forward);
+	EXPECT_EQ(1, CountingTransform::inverse);
+}
+
+
+TEST(ApproxEqualTest, TolerancesAndReport)
+{
+	RealType signal = TestSignal(1000);
+	const WaveformType a (signal);
+
+	signal[700] += 1e-6;
+	signal[710] += 2e-6;
+	const WaveformType b (signal);
+
+	EXPECT_FALSE(PS::ApproxEqual(a, b));
+	EXPECT_FALSE(PS::ApproxEqual(a, b, 1e-9));
+	EXPECT_TRUE(PS::ApproxEqual(a, b, 0., 3e-6));
+
+	PS::ApproxReport report;
+	EXPECT_FALSE(PS::ApproxEqual(a, b, PS::ApproxTolerance(), &report));
+	EXPECT_NEAR(2e-6, report.maxDeviation, 1e-12);
+	EXPECT_EQ(710u, report.index);
+	EXPECT_EQ(2u, report.mismatches);
+
+	//	Units in the last place, across zero as well, in a whole block and in the tail
+	RealType x (600, 1.);
+	RealType y (600, 1.);
+	y[301] = std::nextafter(std::nextafter(1., 2.), 2.);
+	x[302] = -0.;
+	y[302] = std::numeric_limits<double>::denorm_min();
+	y[599] = std::nextafter(1., 0.);
+
+	PS::ApproxTolerance ulps;
+	ulps.relative = 0.;
+	ulps.ulps = 2;
+	EXPECT_TRUE(PS::ApproxEqual(WaveformType(x), WaveformType(y), ulps));
+
+	ulps.ulps = 1;
+	EXPECT_FALSE(PS::ApproxEqual(WaveformType(x), WaveformType(y), ulps));
+}
+
+
+TEST(ApproxEqualTest, ComplexPartsNanAndLengths)
+{
+	const RealType signal = TestSignal(1024);
+	const WaveformType a (signal);
+	const WaveformType b (a.GetConstFreqSpectrum());
+
+	EXPECT_TRUE(PS::ApproxEqual(a, b));
+
+	//	One part of one bin, a few blocks in
+	ComplexType spectrum = b.GetConstFreqSpectrum();
+	spectrum[400] += std::complex<double>(0., 1e-3);
+
+	PS::ApproxReport report;
+	EXPECT_FALSE(PS::ApproxEqual(a, WaveformType(spectrum)));
+	EXPECT_FALSE(PS::ApproxEqual(a, WaveformType(spectrum), PS::ApproxTolerance(), &report));
+	EXPECT_FALSE(report.timeDomain);
+	EXPECT_EQ(400u, report.index);
+	EXPECT_EQ(1u, report.mismatches);
+
+	//	NaNs are never close, not even to themselves
+	RealType withNan (signal);
+	withNan[5] = std::numeric_limits<double>::quiet_NaN();
+	const WaveformType nan (withNan);
+
+	PS::ApproxTolerance loose;
+	loose.absolute = 1e300;
+	loose.ulps = 1000;
+	EXPECT_FALSE(PS::ApproxEqual(nan, nan, loose, &report));
+	EXPECT_TRUE(std::isnan(report.maxDeviation));
+	EXPECT_EQ(5u, report.index);
+
+	EXPECT_FALSE(PS::ApproxEqual(a, WaveformType(RealType(1022)), loose));
+}
+
+
+TEST(ApproxEqualTest, FreqDomainsOfDifferentLengths)
+{
+	const WaveformType half (ComplexType(5, 1.));
+	const FullSpectrumWaveformType full (ComplexType(8, 1.));
+	ASSERT_EQ(half.size(), full.size());
+
+	PS::ApproxReport report;
+	EXPECT_FALSE(PS::ApproxEqual(full, half));
+	EXPECT_FALSE(PS::ApproxEqual(full, half, PS::ApproxTolerance(), &report));
+	EXPECT_FALSE(report.timeDomain);
+	EXPECT_EQ(8u, report.mismatches);
+
+	EXPECT_FALSE(PS::ApproxEqual(half, full, PS::ApproxTolerance(), &report));
+	EXPECT_EQ(8u, report.mismatches);
+}
+
+
+TEST(ApproxEqualTest, SplitSpectra)
+{
+	typedef PS::Waveform<RealType, PS::SplitComplexVector<double>, Waveform::Transform::Fftw3_Dft_1d_Split_Normalized>	SplitWaveformType;
+
+	const RealType signal = TestSignal(128);
+	const SplitWaveformType a (signal);
+	const SplitWaveformType b (a.GetConstFreqSpectrum());
+
+	PS::ApproxReport report;
+	EXPECT_TRUE(PS::ApproxEqual(a, b, PS::ApproxTolerance(), &report));
+	EXPECT_FALSE(report.timeDomain);
+
+	PS::SplitComplexVector<double> spectrum (b.GetConstFreqSpectrum());
+	spectrum[3] = std::complex<double>(spectrum[3]) + std::complex<double>(1e-6, 0.);
+
+	EXPECT_FALSE(PS::ApproxEqual(a, SplitWaveformType(spectrum), PS::ApproxTolerance(), &report));
+	EXPECT_EQ(3u, report.index);
+	EXPECT_NEAR(1e-6, report.maxDeviation, 1e-12);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
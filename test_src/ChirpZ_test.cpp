@@ -0,0 +1,202 @@
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <ChirpZ.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+const double pi = std::acos(-1.);
+
+
+//!	Two tones between bins, at 0.1234 and 0.31 cycles per sample
+RealType
+Tones (std::size_t length)
+{
+	RealType signal (length);
+
+	for (std::size_t i = 0; i < length; ++i)
+		signal[i] = std::cos(2. * pi * 0.1234 * i) + 0.5 * std::sin(2. * pi * 0.31 * i + 0.3);
+
+	return signal;
+}
+
+
+//!	The DTFT of x at f cycles per sample, summed directly
+std::complex<double>
+Dtft (const RealType& x, double f)
+{
+	std::complex<double> sum = 0.;
+	for (std::size_t i = 0; i < x.size(); ++i)
+		sum += x[i] * std::polar(1., -2. * pi * f * i);
+	return sum;
+}
+
+
+
+TEST(ChirpZTest, MatchesDftBins)
+{
+	const std::size_t n = 96;
+	const WaveformType wfm (Tones(n));
+
+	//	Bins 10 ... 29
+	const PS::ChirpZ czt (n, 20, 10. / n, 1. / n);
+
+	ComplexType bins;
+	czt.Transform(wfm.GetConstTimeSeries(), bins);
+
+	const ComplexType& spectrum = wfm.GetConstFreqSpectrum();
+
+	ASSERT_EQ(20u, bins.size());
+	for (std::size_t k = 0; k < bins.size(); ++k)
+		EXPECT_NEAR(0., std::abs(spectrum[10 + k] - bins[k]), 1e-9);
+}
+
+
+TEST(ChirpZTest, ZoomMatchesDtft)
+{
+	const RealType x = Tones(300);
+
+	//	401 frequencies from 0.12 to 0.128, 2e-5 apart (a 50000 point FFT would be needed)
+	const PS::ChirpZ zoom = PS::ChirpZ::Band(x.size(), 0.12, 0.128, 401);
+	EXPECT_NEAR(2e-5, zoom.Frequency(1) - zoom.Frequency(0), 1e-15);
+	EXPECT_GE(zoom.FftLength(), x.size() + 401 - 1);
+
+	ComplexType band;
+	zoom.Transform(x, band);
+
+	for (std::size_t k = 0; k < band.size(); k += 20)
+		EXPECT_NEAR(0., std::abs(Dtft(x, zoom.Frequency(k)) - band[k]), 1e-8);
+
+	//	The peak is at the tone, to the resolution of the zoom
+	std::size_t peak = 0;
+	for (std::size_t k = 1; k < band.size(); ++k)
+		if (std::abs(band[k]) > std::abs(band[peak]))
+			peak = k;
+	EXPECT_NEAR(0.1234, zoom.Frequency(peak), 1e-4);
+}
+
+
+TEST(ChirpZTest, LongInputPhaseAccuracy)
+{
+	//	n^2 df is large here, so the chirps rely on the reduced phase
+	const RealType x = Tones(3000);
+	const PS::ChirpZ zoom (x.size(), 5, 0.3, 0.0037);
+
+	ComplexType band;
+	zoom.Transform(x, band);
+
+	for (std::size_t k = 0; k < band.size(); ++k)
+		EXPECT_NEAR(0., std::abs(Dtft(x, zoom.Frequency(k)) - band[k]), 1e-7);
+}
+
+
+TEST(ChirpZTest, TablesAreCached)
+{
+	const RealType x = Tones(128);
+
+	const PS::ChirpZ first (x.size(), 33, 0.05, 1e-3);
+	const std::size_t tables = PS::ChirpZ::CacheSize();
+
+	ComplexType a;
+	first.Transform(x, a);
+	const std::size_t plans = Waveform::Transform::FftwPlanCache::Size();
+
+	const PS::ChirpZ second (x.size(), 33, 0.05, 1e-3);
+	ComplexType b;
+	second.Transform(x, b);
+
+	EXPECT_EQ(tables, PS::ChirpZ::CacheSize());
+	EXPECT_EQ(plans, Waveform::Transform::FftwPlanCache::Size());
+	EXPECT_EQ(a, b);
+
+	const PS::ChirpZ other (x.size(), 33, 0.05, 2e-3);
+	EXPECT_EQ(std::min(tables + 1, PS::detail::ChirpZCacheCapacity), PS::ChirpZ::CacheSize());
+}
+
+
+TEST(ChirpZTest, CacheIsBounded)
+{
+	const RealType x = Tones(64);
+
+	PS::ChirpZ::ClearCache();
+	EXPECT_EQ(0u, PS::ChirpZ::CacheSize());
+
+	//	A band which moves every record
+	const PS::ChirpZ kept (x.size(), 16, 0.1, 1e-3);
+	ComplexType expected;
+	kept.Transform(x, expected);
+
+	for (std::size_t record = 0; record < 3 * PS::detail::ChirpZCacheCapacity; ++record) {
+		const PS::ChirpZ tracker (x.size(), 16, 0.2 + 1e-4 * double(record), 1e-3);
+		EXPECT_GE(PS::detail::ChirpZCacheCapacity, PS::ChirpZ::CacheSize());
+	}
+	EXPECT_EQ(PS::detail::ChirpZCacheCapacity, PS::ChirpZ::CacheSize());
+
+	//	Evicted tables stay with the ChirpZ which holds them
+	ComplexType band;
+	kept.Transform(x, band);
+	EXPECT_EQ(expected, band);
+
+	//	The least recently used configuration is the one evicted
+	PS::detail::ChirpZTableCache& cache = PS::detail::ChirpZTableCache::Get();
+	PS::ChirpZ::ClearCache();
+
+	const auto reused = cache.Find(64, 16, 0.1, 1e-3);
+	const auto stale = cache.Find(64, 16, 0.3, 1e-3);
+	for (std::size_t record = 0; record < PS::detail::ChirpZCacheCapacity - 1; ++record) {
+		EXPECT_EQ(reused, cache.Find(64, 16, 0.1, 1e-3));
+		cache.Find(64, 16, 0.2 + 1e-4 * double(record), 1e-3);
+	}
+	EXPECT_EQ(reused, cache.Find(64, 16, 0.1, 1e-3));
+	EXPECT_NE(stale, cache.Find(64, 16, 0.3, 1e-3));
+
+	PS::ChirpZ::ClearCache();
+	EXPECT_EQ(0u, PS::ChirpZ::CacheSize());
+}
+
+
+TEST(ChirpZTest, ComplexInput)
+{
+	ComplexType x (64);
+	for (std::size_t i = 0; i < x.size(); ++i)
+		x[i] = std::polar(1., 2. * pi * 0.2 * i);
+
+	const PS::ChirpZ czt (x.size(), 3, 0.19, 0.01);
+	ComplexType out;
+	czt.Transform(x, out);
+
+	//	A complex tone at exactly 0.2 sums to N there
+	EXPECT_NEAR(64., std::abs(out[1]), 1e-9);
+}
+
+
+TEST(ChirpZTest, BadLengths)
+{
+	EXPECT_THROW(PS::ChirpZ(0, 10, 0., 0.1), std::invalid_argument);
+	EXPECT_THROW(PS::ChirpZ(10, 0, 0., 0.1), std::invalid_argument);
+
+	const PS::ChirpZ czt (16, 4, 0., 0.1);
+	ComplexType out;
+	EXPECT_THROW(czt.Transform(RealType(15), out), std::length_error);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,138 @@
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <Correlation.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+
+//!	A Gaussian pulse centred on centre (which need not be a whole sample)
+RealType
+Pulse (std::size_t length, double centre, double width = 4.)
+{
+	RealType pulse (length);
+
+	for (std::size_t i = 0; i < length; ++i) {
+		const double t = (double(i) - centre) / width;
+		pulse[i] = std::exp(-t * t) + 0.1 * std::exp(-(t - 3.) * (t - 3.));
+	}
+
+	return pulse;
+}
+
+
+//!	r[k] = sum_n a[(n + k) mod N] b[n], term by term
+RealType
+DirectCorrelation (const RealType& a, const RealType& b)
+{
+	const std::size_t n = a.size();
+	RealType r (n);
+
+	for (std::size_t k = 0; k < n; ++k)
+		for (std::size_t i = 0; i < n; ++i)
+			r[k] += a[(i + k) % n] * b[i];
+
+	return r;
+}
+
+
+
+TEST(CorrelationTest, CrossCorrelateMatchesDirectSum)
+{
+	const RealType x = Pulse(128, 40.);
+	const RealType y = Pulse(128, 31., 6.);
+
+	WaveformType a (x);
+	WaveformType b (y);
+
+	RealType r;
+	PS::CrossCorrelate(a, b, r);
+
+	const RealType expected = DirectCorrelation(x, y);
+
+	ASSERT_EQ(128u, r.size());
+	for (std::size_t k = 0; k < r.size(); ++k)
+		EXPECT_NEAR(expected[k], r[k], 1e-9);
+
+	//	The spectra computed for the correlation stay cached in the Waveforms
+	EXPECT_EQ(WaveformType::DomainState::Both, a.GetValidDomain());
+	EXPECT_EQ(WaveformType::DomainState::Both, b.GetValidDomain());
+}
+
+
+TEST(CorrelationTest, AutoCorrelate)
+{
+	const RealType x = Pulse(64, 20.);
+	WaveformType a (x);
+
+	RealType r;
+	PS::AutoCorrelate(a, r);
+
+	const RealType expected = DirectCorrelation(x, x);
+
+	for (std::size_t k = 0; k < r.size(); ++k)
+		EXPECT_NEAR(expected[k], r[k], 1e-9);
+
+	const PS::CorrelationPeak peak = PS::FindCorrelationPeak(r);
+	EXPECT_DOUBLE_EQ(0., peak.lag);
+}
+
+
+TEST(CorrelationTest, PeakOfWholeSampleDelay)
+{
+	const RealType reference = Pulse(256, 100.);
+
+	//	Both ways round, and from Waveforms which only hold a spectrum
+	WaveformType ref (WaveformType(reference).GetConstFreqSpectrum());
+	WaveformType late (Pulse(256, 117.));
+	WaveformType early (Pulse(256, 88.));
+
+	EXPECT_NEAR(17., PS::CrossCorrelationPeak(late, ref).lag, 1e-9);
+	EXPECT_NEAR(-12., PS::CrossCorrelationPeak(early, ref).lag, 1e-9);
+	EXPECT_NEAR(12., PS::CrossCorrelationPeak(ref, early).lag, 1e-9);
+}
+
+
+TEST(CorrelationTest, PeakOfFractionalDelay)
+{
+	const RealType reference = Pulse(256, 100., 8.);
+	WaveformType ref (reference);
+
+	for (double delay : { 5.25, 10.5, -3.7 }) {
+		WaveformType delayed (Pulse(256, 100. + delay, 8.));
+		const PS::CorrelationPeak peak = PS::CrossCorrelationPeak(delayed, ref);
+
+		EXPECT_NEAR(delay, peak.lag, 0.02);
+	}
+}
+
+
+TEST(CorrelationTest, MismatchedLengths)
+{
+	WaveformType a (Pulse(64, 10.));
+	WaveformType b (Pulse(128, 10.));
+
+	RealType r;
+	EXPECT_THROW(PS::CrossCorrelate(a, b, r), std::invalid_argument);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,199 @@
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <complex>
+#include <cstdio>
+#include <cassert>
+#include <stdexcept>
+
+#include <Waveform.hpp>
+#include <DatFile.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::Waveform<RealType, ComplexType>	WaveformType;
+
+
+//!	The istream_iterator reader which DatFile replaces, used as the reference
+template <typename T>
+std::vector<T>
+parse_dat_file_reference (std::string fileName)
+{
+	std::ifstream ifs(fileName.c_str());
+	assert(ifs.good());
+
+	std::vector<T> result { std::istream_iterator<T>(ifs)
+						  , std::istream_iterator<T>() };
+
+	return result;
+}
+
+
+class DatFileTest : public ::testing::Test {
+  protected:
+
+	DatFileTest()
+	{
+
+	}
+
+	virtual
+	~DatFileTest()
+	{
+
+	}
+
+	virtual
+	void
+	SetUp()
+	{
+		dataFiles_.push_back("test_data/stepFn1024");
+		dataFiles_.push_back("test_data/diracFn1024");
+		dataFiles_.push_back("test_data/triangleFn1024");
+		dataFiles_.push_back("test_data/squareFn1024");
+	}
+
+	virtual
+	void
+	TearDown()
+	{
+		for (auto& fileName : tempFiles_)
+			std::remove(fileName.c_str());
+	}
+
+	std::string
+	WriteTempFile (const std::string& contents)
+	{
+		std::string fileName = "DatFileTest_" + std::to_string(tempFiles_.size()) + ".dat";
+		std::ofstream ofs (fileName.c_str(), std::ios::binary);
+		ofs << contents;
+		tempFiles_.push_back(fileName);
+		return fileName;
+	}
+
+	std::vector<std::string> dataFiles_;
+	std::vector<std::string> tempFiles_;
+};
+
+
+
+TEST_F(DatFileTest, RealFilesMatchStreamParser)
+{
+	for (auto& base : dataFiles_) {
+		const std::string fileName = base + "_real.dat";
+
+		EXPECT_EQ(parse_dat_file_reference<double>(fileName), PS::ParseDatFile<double>(fileName)) << fileName;
+	}
+}
+
+
+TEST_F(DatFileTest, ComplexFilesMatchStreamParser)
+{
+	for (auto& base : dataFiles_) {
+		const std::string fileName = base + "_complex.dat";
+
+		EXPECT_EQ( parse_dat_file_reference< std::complex<double> >(fileName)
+				 , PS::ParseDatFile< std::complex<double> >(fileName)) << fileName;
+	}
+}
+
+
+TEST_F(DatFileTest, ComplexForms)
+{
+	const std::string fileName = WriteTempFile("(1.5,-2)\n( 3 , 4e-1 )  (5)\n+6 -7.\n");
+
+	ComplexType expected { {1.5, -2.}, {3., 0.4}, {5., 0.}, {6., 0.}, {-7., 0.} };
+
+	EXPECT_EQ(expected, PS::ParseDatFile< std::complex<double> >(fileName));
+}
+
+
+TEST_F(DatFileTest, MalformedValueThrows)
+{
+	EXPECT_THROW(PS::ParseDatFile<double>(WriteTempFile("1\n2\nthree\n")), std::runtime_error);
+	EXPECT_THROW(PS::ParseDatFile<double>(WriteTempFile("1\n2,5\n")), std::runtime_error);
+	EXPECT_THROW(PS::ParseDatFile< std::complex<double> >(WriteTempFile("(1,2\n")), std::runtime_error);
+}
+
+
+TEST_F(DatFileTest, EmptyFile)
+{
+	PS::DatFile<double> dat (WriteTempFile(""));
+
+	EXPECT_EQ(0u, dat.size());
+	EXPECT_TRUE(dat.ReadVector().empty());
+}
+
+
+TEST_F(DatFileTest, ParallelMatchesSerial)
+{
+	//	Large enough to be split into several chunks
+	std::string contents;
+
+	for (int i = 0; i < 300000; ++i)
+		contents += "(" + std::to_string(i * 0.25) + "," + std::to_string(-i) + ")\n";
+
+	const std::string fileName = WriteTempFile(contents);
+
+	PS::DatFile< std::complex<double> > serial (fileName, 1);
+	PS::DatFile< std::complex<double> > parallel (fileName, 4);
+
+	ASSERT_EQ(300000u, serial.size());
+	ASSERT_EQ(serial.size(), parallel.size());
+
+	ComplexType parsed = parallel.ReadVector();
+
+	EXPECT_EQ(serial.ReadVector(), parsed);
+	EXPECT_EQ(std::complex<double>(299999 * 0.25, -299999.), parsed.back());
+}
+
+
+TEST_F(DatFileTest, ReadIntoWaveformTimeSeries)
+{
+	PS::DatFile<double> dat ("test_data/triangleFn1024_real.dat");
+
+	WaveformType wfm (dat.size());
+	PS::ReadTimeSeries(dat, wfm);
+
+	EXPECT_EQ(WaveformType::DomainState::Time, wfm.GetValidDomain());
+	EXPECT_EQ(parse_dat_file_reference<double>("test_data/triangleFn1024_real.dat"), wfm.PeekTimeSeries());
+}
+
+
+TEST_F(DatFileTest, ReadIntoWaveformFreqSpectrum)
+{
+	PS::DatFile< std::complex<double> > dat ("test_data/squareFn1024_complex.dat");
+
+	WaveformType wfm (ComplexType(dat.size()));
+	PS::ReadFreqSpectrum(dat, wfm);
+
+	EXPECT_EQ(WaveformType::DomainState::Freq, wfm.GetValidDomain());
+	EXPECT_EQ(parse_dat_file_reference< std::complex<double> >("test_data/squareFn1024_complex.dat"), wfm.PeekFreqSpectrum());
+}
+
+
+TEST_F(DatFileTest, WaveformLengthMismatchThrows)
+{
+	PS::DatFile<double> dat ("test_data/stepFn1024_real.dat");
+
+	WaveformType wfm (512);
+
+	EXPECT_THROW(PS::ReadTimeSeries(dat, wfm), std::length_error);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,172 @@
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <Waveform.hpp>
+#include <Dwt.hpp>
+
+#include <gtest/gtest.h>
+
+#include "TestSignals.hpp"
+
+
+namespace {
+
+namespace Wavelet = Waveform::Transform::Wavelet;
+
+typedef std::vector<double>					RealType;
+typedef PS::WaveletCoefficients<double>		CoeffType;
+
+typedef PS::Waveform<RealType, CoeffType, Waveform::Transform::Dwt<Wavelet::Daubechies4, 3> >	D4WaveformType;
+typedef PS::Waveform<RealType, CoeffType, Waveform::Transform::Dwt<Wavelet::Haar, 0> >			HaarWaveformType;
+
+
+double
+Energy (const double* x, std::size_t n)
+{
+	double sum = 0.;
+	for (std::size_t i = 0; i < n; ++i)
+		sum += x[i] * x[i];
+	return sum;
+}
+
+
+//!	Multi-level round trip, and energy preservation for the orthonormal wavelets
+template <typename WaveletT>
+void
+CheckRoundTrip (bool orthonormal)
+{
+	const RealType signal = TestSignal(256);
+
+	for (std::size_t levels = 0; levels <= PS::DwtMaxLevels<WaveletT>(signal.size()); ++levels) {
+		RealType x (signal);
+
+		PS::DwtForward<WaveletT>(x.data(), x.size(), levels);
+		if (orthonormal) {
+			EXPECT_NEAR(Energy(signal.data(), signal.size()), Energy(x.data(), x.size()), 1e-9);
+		}
+
+		PS::DwtInverse<WaveletT>(x.data(), x.size(), levels);
+		for (std::size_t i = 0; i < signal.size(); ++i)
+			ASSERT_NEAR(signal[i], x[i], 1e-10) << "levels " << levels << ", sample " << i;
+	}
+}
+
+
+//!	Away from the wrap-around, the finest details of a polynomial of degree < moments vanish
+template <typename WaveletT>
+void
+CheckVanishingMoments (std::size_t moments, std::size_t edge)
+{
+	const std::size_t n = 128;
+	RealType x (n);
+
+	for (std::size_t i = 0; i < n; ++i)
+		x[i] = std::pow(double(i) / n, double(moments - 1));
+
+	PS::DwtForward<WaveletT>(x.data(), n, 1);
+
+	for (std::size_t i = n / 2 + edge; i < n - edge; ++i)
+		EXPECT_NEAR(0., x[i], 1e-9) << "detail " << i - n / 2;
+
+	//	A constant gives sqrt(2) times itself in the approximation
+	RealType ones (n, 1.);
+	PS::DwtForward<WaveletT>(ones.data(), n, 1);
+	EXPECT_NEAR(std::sqrt(2.), ones[n / 4], 1e-9);
+}
+
+
+
+TEST(DwtTest, RoundTrip)
+{
+	CheckRoundTrip<Wavelet::Haar>(true);
+	CheckRoundTrip<Wavelet::Daubechies4>(true);
+	CheckRoundTrip<Wavelet::Daubechies8>(true);
+	CheckRoundTrip<Wavelet::Cdf97>(false);
+}
+
+
+TEST(DwtTest, VanishingMoments)
+{
+	CheckVanishingMoments<Wavelet::Haar>(1, 0);
+	CheckVanishingMoments<Wavelet::Daubechies4>(2, 1);
+	CheckVanishingMoments<Wavelet::Daubechies8>(4, 3);
+	CheckVanishingMoments<Wavelet::Cdf97>(4, 2);
+}
+
+
+TEST(DwtTest, HaarLayout)
+{
+	//	Two levels of Haar on 8 samples, worked by hand
+	RealType x { 1., 3., 5., 7., 2., 2., 0., 4. };
+	PS::DwtForward<Wavelet::Haar>(x.data(), x.size(), 2);
+
+	const double r2 = std::sqrt(2.);
+	const RealType expected { 8., 4., 4., 0., 2. / r2, 2. / r2, 0., 4. / r2 };
+
+	for (std::size_t i = 0; i < x.size(); ++i)
+		EXPECT_NEAR(expected[i], x[i], 1e-12) << "coefficient " << i;
+
+	CoeffType coeffs (x.begin(), x.end());
+	EXPECT_EQ(4u, coeffs.detail(1).size());
+	EXPECT_EQ(coeffs.data() + 4, coeffs.detail(1).data());
+	EXPECT_EQ(coeffs.data() + 2, coeffs.detail(2).data());
+	EXPECT_EQ(2u, coeffs.approximation(2).size());
+	EXPECT_DOUBLE_EQ(8., coeffs.approximation(2)[0]);
+}
+
+
+TEST(DwtTest, TooManyLevels)
+{
+	RealType x (24);
+
+	EXPECT_EQ(3u, PS::DwtMaxLevels<Wavelet::Haar>(x.size()));
+	EXPECT_EQ(2u, PS::DwtMaxLevels<Wavelet::Daubechies8>(x.size()));
+	EXPECT_THROW(PS::DwtForward<Wavelet::Daubechies8>(x.data(), x.size(), 3), std::length_error);
+	EXPECT_THROW(D4WaveformType{RealType(12)}, std::length_error);
+}
+
+
+TEST(DwtTest, TransformInWaveform)
+{
+	const RealType signal = TestSignal(64);
+
+	D4WaveformType wfm (signal);
+	const CoeffType& coeffs = wfm.GetConstFreqSpectrum();
+
+	RealType expected (signal);
+	PS::DwtForward<Wavelet::Daubechies4>(expected.data(), expected.size(), 3);
+
+	ASSERT_EQ(64u, coeffs.size());
+	for (std::size_t i = 0; i < coeffs.size(); ++i)
+		EXPECT_NEAR(expected[i], coeffs[i], 1e-12);
+
+	//	Denoising: zero the finest details and transform back
+	CoeffType& editable = wfm.GetFreqSpectrum();
+	for (double& c : editable.detail(1))
+		c = 0.;
+
+	const RealType& smoothed = wfm.GetConstTimeSeries();
+	EXPECT_NEAR(Energy(coeffs.data(), coeffs.size()), Energy(smoothed.data(), smoothed.size()), 1e-9);
+
+	//	Levels = 0 runs as many levels as the length allows
+	HaarWaveformType haar (signal);
+	haar.GetConstFreqSpectrum();
+	EXPECT_EQ(std::size_t(haar.size()), haar.PeekFreqSpectrum().size());
+
+	CoeffType fromCoeffs (haar.PeekFreqSpectrum());
+	HaarWaveformType back (fromCoeffs);
+	const RealType& roundTrip = back.GetConstTimeSeries();
+	for (std::size_t i = 0; i < signal.size(); ++i)
+		EXPECT_NEAR(signal[i], roundTrip[i], 1e-12);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
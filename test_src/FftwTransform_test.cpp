@@ -12,6 +12,7 @@
 
 #include <FftwTransform.hpp>
 #include <Waveform.hpp>
+#include <DatFile.hpp>
 
 #include <gtest/gtest.h>
 
@@ -36,21 +37,6 @@
 
 namespace {
 
-template <typename T>
-std::vector<T>
-parse_dat_file (std::string fileName)
-{
-	std::ifstream ifs(fileName.c_str());
-	assert(ifs.good());
-
-
-	std::vector<T> result { std::istream_iterator<T>(ifs)
-						  , std::istream_iterator<T>() };
-
-	return result;
-}
-
-
 class FftwTransformTest : public ::testing::Test {
 	protected:
 
@@ -91,17 +77,17 @@ class FftwTransformTest : public ::testing::Test {
 		iaf & fDomain_;
 
 
-		stepFn1024_real = parse_dat_file<double>("test_data/stepFn1024_real.dat");
-		stepFn1024_complex = parse_dat_file<std::complex<double> >("test_data/stepFn1024_complex.dat");
+		stepFn1024_real = PS::ParseDatFile<double>("test_data/stepFn1024_real.dat");
+		stepFn1024_complex = PS::ParseDatFile<std::complex<double> >("test_data/stepFn1024_complex.dat");
 
-		diracFn1024_real = parse_dat_file<double>("test_data/diracFn1024_real.dat");
-		diracFn1024_complex = parse_dat_file<std::complex<double> >("test_data/diracFn1024_complex.dat");
+		diracFn1024_real = PS::ParseDatFile<double>("test_data/diracFn1024_real.dat");
+		diracFn1024_complex = PS::ParseDatFile<std::complex<double> >("test_data/diracFn1024_complex.dat");
 
-		triangleFn1024_real = parse_dat_file<double>("test_data/triangleFn1024_real.dat");
-		triangleFn1024_complex = parse_dat_file<std::complex<double> >("test_data/triangleFn1024_complex.dat");
+		triangleFn1024_real = PS::ParseDatFile<double>("test_data/triangleFn1024_real.dat");
+		triangleFn1024_complex = PS::ParseDatFile<std::complex<double> >("test_data/triangleFn1024_complex.dat");
 
-		squareFn1024_real = parse_dat_file<double>("test_data/squareFn1024_real.dat");
-		squareFn1024_complex = parse_dat_file<std::complex<double> >("test_data/squareFn1024_complex.dat");
+		squareFn1024_real = PS::ParseDatFile<double>("test_data/squareFn1024_real.dat");
+		squareFn1024_complex = PS::ParseDatFile<std::complex<double> >("test_data/squareFn1024_complex.dat");
 
 
 		testArrays_real.push_back(stepFn1024_real);
@@ -403,6 +389,55 @@ TEST_F(FftwTransformTest, RvsTransformInWaveform)
 }
 
 
+TEST(FftwWaveformArithmeticTest, MatchesTheTimeDomain)
+{
+	typedef std::vector<double> RealType;
+	typedef PS::Waveform<RealType, std::vector< std::complex<double> >, Waveform::Transform::Fftw3_Dft_1d_Normalized> FftWaveformType;
+
+	const std::size_t n = 48;
+	RealType x (n), y (n);
+	for (std::size_t i = 0; i < n; ++i) {
+		x[i] = std::sin(0.3 * i) + (i % 7) * 0.1;
+		y[i] = std::cos(1.1 * i) - (i % 3) * 0.2;
+	}
+
+	//	x in the time domain, y only in the freq domain
+	FftWaveformType a (x);
+	const FftWaveformType b (FftWaveformType(y).GetConstFreqSpectrum());
+
+	a -= b;
+	a *= 3.;
+	a += b;
+
+	const RealType& sum = a.GetConstTimeSeries();
+	for (std::size_t i = 0; i < n; ++i)
+		EXPECT_NEAR(3. * (x[i] - y[i]) + y[i], sum[i], 1e-12);
+
+	//	The product of the spectra is the circular convolution
+	FftWaveformType c (x);
+	c *= b;
+
+	const RealType& conv = c.GetConstTimeSeries();
+	for (std::size_t i = 0; i < n; ++i) {
+		double expected = 0.;
+		for (std::size_t m = 0; m < n; ++m)
+			expected += x[m] * y[(i + n - m) % n];
+		EXPECT_NEAR(expected, conv[i], 1e-11);
+	}
+
+	//	With the unnormalized inverse of Fftw3_Dft_1d (ScaledInverse) the convolution comes out N times larger
+	typedef PS::Waveform<RealType, std::vector< std::complex<double> >, Waveform::Transform::Fftw3_Dft_1d> ScaledWaveformType;
+
+	ScaledWaveformType d (x);
+	d *= ScaledWaveformType(y);
+
+	const RealType& scaled = d.GetConstTimeSeries();
+	for (std::size_t i = 0; i < n; ++i)
+		EXPECT_NEAR(double(n) * conv[i], scaled[i], 1e-9);
+}
+
+
+
 }	// namespace
 
 int
@@ -0,0 +1,168 @@
+#include <array>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <FixedWaveform.hpp>
+
+#include <gtest/gtest.h>
+
+#include "TestSignals.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+const double pi = std::acos(-1.);
+
+
+//!	Checks the forward transform against a directly summed DFT, and the round trip
+template <std::size_t N>
+void
+CheckLength (void)
+{
+	const std::array<double, N> signal = TestSignal<N>();
+
+	PS::FixedWaveform<N> wfm (signal);
+	const auto& spectrum = wfm.GetConstFreqSpectrum();
+
+	double worst = 0.;
+	for (std::size_t k = 0; k <= N / 2; ++k) {
+		std::complex<double> sum = 0.;
+		for (std::size_t j = 0; j < N; ++j)
+			sum += signal[j] * std::polar(1., -2. * pi * double(j * k % N) / double(N));
+		worst = std::max(worst, std::abs(sum - spectrum[k]));
+	}
+	EXPECT_LT(worst, 1e-12 * N) << "N = " << N;
+
+	PS::FixedWaveform<N> back (spectrum);
+	const auto& time = back.GetConstTimeSeries();
+
+	worst = 0.;
+	for (std::size_t j = 0; j < N; ++j)
+		worst = std::max(worst, std::abs(signal[j] - time[j]));
+	EXPECT_LT(worst, 1e-14 * N) << "N = " << N;
+}
+
+
+
+TEST(FixedWaveformTest, ConstexprRoots)
+{
+	constexpr std::array<double, 2> quarter = Waveform::Transform::Fixed::Root(1, 4);
+	static_assert(quarter[0] == 0. && quarter[1] == -1., "exp(-i pi/2) is exact");
+
+	//	Within half an ulp of long double references (where the table is exact at 0, they are not)
+	const long double longPi = std::acos(-1.L);
+
+	for (std::size_t n : { 3, 7, 12, 100, 256 }) {
+		for (std::size_t k = 0; k < n; ++k) {
+			const std::array<double, 2> root = Waveform::Transform::Fixed::Root(k, n);
+			EXPECT_NEAR(std::cos(2.L * longPi * k / n), root[0], 1.2e-16) << k << " / " << n;
+			EXPECT_NEAR(-std::sin(2.L * longPi * k / n), root[1], 1.2e-16) << k << " / " << n;
+		}
+	}
+}
+
+
+TEST(FixedWaveformTest, MatchesDirectDft)
+{
+	//	Powers of 2 (radix 4, then 2), mixed lengths and a prime half-length
+	CheckLength<2>();
+	CheckLength<4>();
+	CheckLength<6>();
+	CheckLength<8>();
+	CheckLength<16>();
+	CheckLength<24>();
+	CheckLength<30>();
+	CheckLength<34>();
+	CheckLength<64>();
+	CheckLength<100>();
+	CheckLength<128>();
+	CheckLength<256>();
+}
+
+
+TEST(FixedWaveformTest, MatchesWaveform)
+{
+	const std::array<double, 64> signal = TestSignal<64>();
+
+	PS::FixedWaveform<64> fixed (signal);
+	WaveformType dynamic (RealType(signal.begin(), signal.end()));
+
+	const auto& expected = dynamic.GetConstFreqSpectrum();
+	const auto& spectrum = fixed.GetConstFreqSpectrum();
+
+	ASSERT_EQ(expected.size(), spectrum.size());
+	for (std::size_t k = 0; k < spectrum.size(); ++k)
+		EXPECT_NEAR(0., std::abs(expected[k] - spectrum[k]), 1e-12);
+}
+
+
+TEST(FixedWaveformTest, DomainStates)
+{
+	typedef PS::FixedWaveform<32>	FixedType;
+
+	FixedType wfm;
+	EXPECT_EQ(FixedType::DomainState::Neither, wfm.GetValidDomain());
+	EXPECT_EQ(32u, FixedType::size());
+
+	//	Nothing has been written, so there is nothing to read
+	EXPECT_THROW(wfm.GetConstTimeSeries(), std::logic_error);
+	EXPECT_THROW(wfm.GetConstFreqSpectrum(), std::logic_error);
+	EXPECT_EQ(FixedType::DomainState::Neither, wfm.GetValidDomain());
+
+	wfm.GetTimeSeries() = TestSignal<32>();
+	EXPECT_EQ(FixedType::DomainState::Time, wfm.GetValidDomain());
+
+	wfm.GetConstFreqSpectrum();
+	EXPECT_EQ(FixedType::DomainState::Both, wfm.GetValidDomain());
+
+	//	Writing the spectrum makes the time domain stale, and reading it transforms back
+	wfm.GetFreqSpectrum()[0] += 32.;
+	EXPECT_EQ(FixedType::DomainState::Freq, wfm.GetValidDomain());
+
+	const std::array<double, 32> signal = TestSignal<32>();
+	for (std::size_t j = 0; j < 32; ++j)
+		EXPECT_NEAR(signal[j] + 1., wfm.GetConstTimeSeries()[j], 1e-13);
+	EXPECT_TRUE(wfm.IsTimeValid() && wfm.IsFreqValid());
+}
+
+
+TEST(FixedWaveformTest, NoAllocations)
+{
+	typedef PS::FixedWaveform<128>	FixedType;
+
+	//	Both domains are std::arrays held inline, and nothing else is owned, so nothing can allocate
+	static_assert(std::is_same<FixedType::TimeContainer, std::array<double, 128> >::value, "FixedWaveform stores its time domain in a std::array");
+	static_assert(std::is_same<FixedType::FreqContainer, std::array<std::complex<double>, 65> >::value, "FixedWaveform stores its freq domain in a std::array");
+	static_assert(std::is_trivially_copyable<FixedType>::value, "FixedWaveform is trivially copyable");
+	static_assert(std::is_trivially_destructible<FixedType>::value, "FixedWaveform is trivially destructible");
+	static_assert(sizeof(FixedType) < sizeof(double) * (128 + 2 * 65 + 2), "FixedWaveform stores its domains inline");
+
+	//	A copy is independent of the original
+	FixedType wfm (TestSignal<128>());
+	wfm.GetFreqSpectrum()[3] = 0.;
+	FixedType copy = wfm;
+	copy.GetFreqSpectrum()[3] = 1.;
+
+	EXPECT_EQ(0., wfm.GetConstFreqSpectrum()[3]);
+	EXPECT_EQ(1., copy.GetConstFreqSpectrum()[3]);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
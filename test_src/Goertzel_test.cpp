@@ -0,0 +1,109 @@
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <Goertzel.hpp>
+
+#include <gtest/gtest.h>
+
+#include "TestSignals.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+
+
+TEST(GoertzelTest, MatchesFft)
+{
+	const RealType signal = TestSignal(512);
+	const WaveformType reference (signal);
+	const ComplexType& spectrum = reference.GetConstFreqSpectrum();
+
+	//	Includes DC, Nyquist, a repeat and a partial group of lanes
+	const std::vector<std::size_t> indices { 0, 1, 24, 25, 200, 256, 24 };
+
+	ComplexType bins;
+	PS::Goertzel(signal.data(), signal.size(), indices, bins);
+
+	ASSERT_EQ(indices.size(), bins.size());
+	for (std::size_t j = 0; j < indices.size(); ++j)
+		EXPECT_NEAR(0., std::abs(spectrum[indices[j]] - bins[j]), 1e-9) << "bin " << indices[j];
+}
+
+
+TEST(GoertzelTest, GetBinsChoosesMethod)
+{
+	const RealType signal = TestSignal(1024);
+	const std::vector<int> indices { 3, 50, 51, 400, 511 };
+
+	ComplexType expected;
+	PS::Goertzel(signal.data(), signal.size(), indices, expected);
+
+	//	Few bins of a time-domain Waveform: Goertzel, and the spectrum stays stale
+	{
+		WaveformType wfm (signal);
+		ComplexType bins;
+		PS::GetBins(wfm, indices, bins);
+
+		EXPECT_EQ(WaveformType::DomainState::Time, wfm.GetValidDomain());
+		for (std::size_t j = 0; j < indices.size(); ++j)
+			EXPECT_NEAR(0., std::abs(expected[j] - bins[j]), 1e-9);
+	}
+
+	//	Forcing the FFT computes and caches the whole spectrum
+	{
+		WaveformType wfm (signal);
+		ComplexType bins;
+		PS::GetBins(wfm, indices, bins, PS::BinMethod::Fft);
+
+		EXPECT_EQ(WaveformType::DomainState::Both, wfm.GetValidDomain());
+		for (std::size_t j = 0; j < indices.size(); ++j)
+			EXPECT_NEAR(0., std::abs(expected[j] - bins[j]), 1e-9);
+	}
+
+	//	A valid spectrum is read, even when Goertzel is asked for
+	{
+		const WaveformType source (signal);
+		WaveformType wfm (source.GetConstFreqSpectrum());
+		ComplexType bins;
+		PS::GetBins(wfm, indices, bins, PS::BinMethod::Goertzel);
+
+		EXPECT_EQ(WaveformType::DomainState::Freq, wfm.GetValidDomain());
+		for (std::size_t j = 0; j < indices.size(); ++j)
+			EXPECT_EQ(wfm.PeekFreqSpectrum()[indices[j]], bins[j]);
+	}
+}
+
+
+TEST(GoertzelTest, CostModel)
+{
+	EXPECT_TRUE(PS::GoertzelIsCheaper(1 << 20, 20));
+	EXPECT_FALSE(PS::GoertzelIsCheaper(1 << 20, 40));
+	EXPECT_FALSE(PS::GoertzelIsCheaper(64, 20));
+}
+
+
+TEST(GoertzelTest, IndexPastNyquist)
+{
+	const WaveformType wfm (TestSignal(64));
+	ComplexType bins;
+
+	EXPECT_THROW(PS::GetBins(wfm, std::vector<int> { 33 }, bins), std::out_of_range);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
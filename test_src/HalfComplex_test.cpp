@@ -0,0 +1,133 @@
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <HalfComplex.hpp>
+
+#include <gtest/gtest.h>
+
+#include "TestSignals.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::HalfComplexVector<double>		HalfComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	ComplexWaveformType;
+typedef PS::Waveform<RealType, HalfComplexType, Waveform::Transform::Fftw3_R2HC_1d_Normalized>	HalfComplexWaveformType;
+
+
+
+TEST(HalfComplexTest, BinAccessors)
+{
+	//	N = 6: r0 r1 r2 r3 i2 i1
+	HalfComplexType x { 1., 2., 3., 4., 5., 6. };
+
+	EXPECT_EQ(4u, x.bins());
+	EXPECT_EQ(std::complex<double>(1., 0.), x.bin(0));
+	EXPECT_EQ(std::complex<double>(2., 6.), x.bin(1));
+	EXPECT_EQ(std::complex<double>(3., 5.), x.bin(2));
+	EXPECT_EQ(std::complex<double>(4., 0.), x.bin(3));
+
+	x.set_bin(2, std::complex<double>(-3., -5.));
+	x.set_bin(3, std::complex<double>(7., 9.));
+	EXPECT_EQ(-5., x[4]);
+	EXPECT_EQ(std::complex<double>(7., 0.), x.bin(3));
+}
+
+
+TEST(HalfComplexTest, SpectrumMatchesR2C)
+{
+	const RealType signal = TestSignal(128);
+
+	ComplexWaveformType r2c (signal);
+	HalfComplexWaveformType r2hc (signal);
+
+	const ComplexType& expected = r2c.GetConstFreqSpectrum();
+	const HalfComplexType& spectrum = r2hc.GetConstFreqSpectrum();
+
+	ASSERT_EQ(128u, spectrum.size());
+	ASSERT_EQ(expected.size(), spectrum.bins());
+
+	for (std::size_t k = 0; k < expected.size(); ++k) {
+		EXPECT_NEAR(expected[k].real(), spectrum.real(k), 1e-9);
+		EXPECT_NEAR(expected[k].imag(), spectrum.imag(k), 1e-9);
+	}
+
+	//	Marks the time domain stale, so the next read runs HC2R
+	r2hc.GetFreqSpectrum();
+
+	const RealType& roundTrip = r2hc.GetConstTimeSeries();
+	for (std::size_t i = 0; i < signal.size(); ++i)
+		EXPECT_NEAR(signal[i], roundTrip[i], 1e-9);
+}
+
+
+TEST(HalfComplexTest, FiltersMatchComplexArithmetic)
+{
+	const RealType signal = TestSignal(64);
+
+	ComplexWaveformType r2c (signal);
+	HalfComplexWaveformType r2hc (signal);
+
+	RealType gain;
+	ComplexType response;
+
+	for (std::size_t k = 0; k < 33; ++k) {
+		gain.push_back(1. / (1. + k));
+		response.push_back(std::polar(1. - k / 64., -0.1 * k));
+	}
+
+	ComplexType& spectrum = r2c.GetFreqSpectrum();
+	for (std::size_t k = 0; k < spectrum.size(); ++k)
+		spectrum[k] *= gain[k] * response[k];
+
+	//	A real signal's spectrum must have real DC and Nyquist bins
+	spectrum[0].imag(0.);
+	spectrum[32].imag(0.);
+
+	PS::ApplyGain(r2hc.GetFreqSpectrum(), gain);
+	PS::Multiply(r2hc.GetFreqSpectrum(), response);
+
+	for (std::size_t k = 0; k < spectrum.size(); ++k) {
+		EXPECT_NEAR(spectrum[k].real(), r2hc.GetConstFreqSpectrum().real(k), 1e-9);
+		EXPECT_NEAR(spectrum[k].imag(), r2hc.GetConstFreqSpectrum().imag(k), 1e-9);
+	}
+
+	RealType magnitude;
+	PS::Magnitude(r2hc.GetConstFreqSpectrum(), magnitude);
+	ASSERT_EQ(33u, magnitude.size());
+	for (std::size_t k = 0; k < spectrum.size(); ++k)
+		EXPECT_NEAR(std::abs(spectrum[k]), magnitude[k], 1e-9);
+
+	const RealType& expected = r2c.GetConstTimeSeries();
+	const RealType& filtered = r2hc.GetConstTimeSeries();
+	for (std::size_t i = 0; i < signal.size(); ++i)
+		EXPECT_NEAR(expected[i], filtered[i], 1e-9);
+
+	EXPECT_THROW(PS::ApplyGain(r2hc.GetFreqSpectrum(), RealType(64)), std::length_error);
+}
+
+
+TEST(HalfComplexTest, ConstructorsUseTheHalfComplexLength)
+{
+	HalfComplexWaveformType filled (256);
+	EXPECT_EQ(256u, filled.PeekFreqSpectrum().size());
+
+	HalfComplexWaveformType fromSpectrum (HalfComplexType(32, 0.));
+	EXPECT_EQ(32u, fromSpectrum.size());
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <Hilbert.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Analytic_1d>		AnalyticWaveformType;
+
+const double pi = std::acos(-1.);
+
+
+//!	An amplitude-modulated carrier; both tones fall on exact bins, so the envelope is exact
+RealType
+ModulatedCarrier (std::size_t length, RealType& envelope)
+{
+	RealType signal (length);
+	envelope.resize(length);
+
+	for (std::size_t i = 0; i < length; ++i) {
+		envelope[i] = 1. + 0.5 * std::cos(2. * pi * 3. * i / length);
+		signal[i] = envelope[i] * std::cos(2. * pi * 40. * i / length);
+	}
+
+	return signal;
+}
+
+
+
+TEST(HilbertTest, EnvelopeOfModulatedCarrier)
+{
+	RealType expected;
+	WaveformType wfm (ModulatedCarrier(256, expected));
+
+	RealType envelope;
+	PS::Envelope(wfm, envelope);
+
+	ASSERT_EQ(256u, envelope.size());
+	for (std::size_t i = 0; i < envelope.size(); ++i)
+		EXPECT_NEAR(expected[i], envelope[i], 1e-9);
+
+	//	The spectrum computed for the envelope stays cached in the Waveform
+	EXPECT_EQ(WaveformType::DomainState::Both, wfm.GetValidDomain());
+}
+
+
+TEST(HilbertTest, EnvelopeFromSpectrumOnly)
+{
+	RealType expected;
+	const WaveformType source (ModulatedCarrier(128, expected));
+	WaveformType wfm (source.GetConstFreqSpectrum());
+
+	RealType envelope;
+	PS::Envelope(wfm, envelope);
+
+	for (std::size_t i = 0; i < envelope.size(); ++i)
+		EXPECT_NEAR(expected[i], envelope[i], 1e-9);
+}
+
+
+TEST(HilbertTest, AnalyticSignalOfCosineIsComplexExponential)
+{
+	RealType samples (64);
+	for (std::size_t i = 0; i < samples.size(); ++i)
+		samples[i] = std::cos(2. * pi * 5. * i / 64.);
+
+	WaveformType wfm (samples);
+
+	ComplexType analytic;
+	PS::AnalyticSignal(wfm, analytic);
+
+	ASSERT_EQ(64u, analytic.size());
+	for (std::size_t i = 0; i < analytic.size(); ++i) {
+		EXPECT_NEAR(std::cos(2. * pi * 5. * i / 64.), analytic[i].real(), 1e-9);
+		EXPECT_NEAR(std::sin(2. * pi * 5. * i / 64.), analytic[i].imag(), 1e-9);
+	}
+}
+
+
+TEST(HilbertTest, AnalyticTransformInWaveform)
+{
+	RealType expected;
+	const RealType signal = ModulatedCarrier(128, expected);
+
+	AnalyticWaveformType wfm (signal);
+	const ComplexType& analytic = wfm.GetConstFreqSpectrum();
+
+	ASSERT_EQ(128u, analytic.size());
+	for (std::size_t i = 0; i < analytic.size(); ++i) {
+		EXPECT_NEAR(signal[i], analytic[i].real(), 1e-9);
+		EXPECT_NEAR(expected[i], std::abs(analytic[i]), 1e-9);
+	}
+
+	//	The inverse recovers the signal from the analytic signal alone
+	AnalyticWaveformType fromAnalytic (analytic);
+	const RealType& roundTrip = fromAnalytic.GetConstTimeSeries();
+
+	for (std::size_t i = 0; i < signal.size(); ++i)
+		EXPECT_NEAR(signal[i], roundTrip[i], 1e-9);
+
+	//	The analytic signal is not a spectrum, so Waveform's *= (convolution) does not apply to it
+	static_assert(!PS::detail::SpectralProductIsConvolution<Waveform::Transform::Fftw3_Analytic_1d>::value
+			, "The product of analytic signals is not a convolution");
+	static_assert(PS::detail::SpectralProductIsConvolution<Waveform::Transform::Fftw3_Dft_1d_Normalized>::value
+			, "The product of r2c spectra is a convolution");
+}
+
+
+TEST(HilbertTest, PlansAreReused)
+{
+	RealType expected;
+	WaveformType first (ModulatedCarrier(512, expected));
+	WaveformType second (ModulatedCarrier(512, expected));
+
+	RealType envelope;
+	PS::Envelope(first, envelope);
+	const std::size_t plans = Waveform::Transform::FftwPlanCache::Size();
+
+	PS::Envelope(second, envelope);
+	EXPECT_EQ(plans, Waveform::Transform::FftwPlanCache::Size());
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,109 @@
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <InPlaceWaveform.hpp>
+
+#include <gtest/gtest.h>
+
+#include "TestSignals.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+typedef PS::InPlaceWaveform<Waveform::Transform::Fftw3_Dft_1d_InPlace_Normalized>			InPlaceWaveformType;
+
+
+
+TEST(InPlaceWaveformTest, DomainsShareOneBuffer)
+{
+	InPlaceWaveformType wfm (RealType(128));
+
+	EXPECT_EQ(128u, wfm.size());
+	EXPECT_EQ(65u * sizeof(std::complex<double>), wfm.BufferBytes());
+
+	const PS::Span<double> time = wfm.GetTimeSeries();
+	const PS::Span< std::complex<double> > freq = wfm.GetFreqSpectrum();
+
+	EXPECT_EQ(128u, time.size());
+	EXPECT_EQ(65u, freq.size());
+	EXPECT_EQ(static_cast<void*>(time.data()), static_cast<void*>(freq.data()));
+}
+
+
+TEST(InPlaceWaveformTest, MatchesOutOfPlaceTransform)
+{
+	const RealType signal = TestSignal(256);
+
+	WaveformType outOfPlace (signal);
+	InPlaceWaveformType inPlace (signal);
+
+	const ComplexType& expected = outOfPlace.GetConstFreqSpectrum();
+	const PS::Span< std::complex<double> > spectrum = inPlace.GetFreqSpectrum();
+
+	ASSERT_EQ(expected.size(), spectrum.size());
+	for (std::size_t k = 0; k < expected.size(); ++k) {
+		EXPECT_NEAR(expected[k].real(), spectrum[k].real(), 1e-9);
+		EXPECT_NEAR(expected[k].imag(), spectrum[k].imag(), 1e-9);
+	}
+
+	EXPECT_EQ(InPlaceWaveformType::DomainState::Freq, inPlace.GetValidDomain());
+
+	const PS::Span<double> roundTrip = inPlace.GetTimeSeries();
+	EXPECT_EQ(InPlaceWaveformType::DomainState::Time, inPlace.GetValidDomain());
+
+	for (std::size_t i = 0; i < signal.size(); ++i)
+		EXPECT_NEAR(signal[i], roundTrip[i], 1e-9);
+}
+
+
+TEST(InPlaceWaveformTest, NeitherNeedsNoTransform)
+{
+	InPlaceWaveformType wfm (64);
+	EXPECT_EQ(InPlaceWaveformType::DomainState::Neither, wfm.GetValidDomain());
+
+	//	Writing a spectrum straight away must not be transformed over
+	wfm.GetFreqSpectrum()[1] = std::complex<double>(32., 0.);
+	EXPECT_EQ(std::complex<double>(32., 0.), wfm.GetFreqSpectrum()[1]);
+
+	const PS::Span<double> time = wfm.GetTimeSeries();
+	for (std::size_t i = 0; i < time.size(); ++i)
+		EXPECT_NEAR(std::cos(2. * M_PI * i / 64.), time[i], 1e-9);
+}
+
+
+TEST(InPlaceWaveformTest, CopiesAreIndependentAndMovesKeepPlans)
+{
+	const RealType signal = TestSignal(64);
+
+	InPlaceWaveformType original (signal);
+	InPlaceWaveformType copy (original);
+
+	copy.GetFreqSpectrum();
+	EXPECT_EQ(InPlaceWaveformType::DomainState::Time, original.GetValidDomain());
+	EXPECT_EQ(signal[5], original.GetTimeSeries()[5]);
+
+	InPlaceWaveformType moved (std::move(copy));
+	const PS::Span<double> roundTrip = moved.GetTimeSeries();
+
+	for (std::size_t i = 0; i < signal.size(); ++i)
+		EXPECT_NEAR(signal[i], roundTrip[i], 1e-9);
+
+	EXPECT_THROW(InPlaceWaveformType (RealType(63)), std::length_error);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
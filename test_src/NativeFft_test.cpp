@@ -0,0 +1,187 @@
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <NativeFft.hpp>
+#include <Waveform.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Native_Dft_1d_Normalized>	NativeWaveform;
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	FftwWaveform;
+
+const double pi = std::acos(-1.);
+
+
+//!	Deterministic pseudo-random samples in [-0.5, 0.5)
+RealType
+Noise (std::size_t length, unsigned state = 12345)
+{
+	RealType signal (length);
+
+	for (std::size_t i = 0; i < length; ++i) {
+		state = state * 1664525u + 1013904223u;
+		signal[i] = double(state >> 8) / double(1u << 24) - 0.5;
+	}
+
+	return signal;
+}
+
+
+//!	Bins 0 ... N/2 of the DFT of x, summed directly
+ComplexType
+DirectDft (const RealType& x)
+{
+	const std::size_t n = x.size();
+	ComplexType X (n / 2 + 1);
+
+	for (std::size_t k = 0; k < X.size(); ++k)
+		for (std::size_t j = 0; j < n; ++j)
+			X[k] += x[j] * std::polar(1., -2. * pi * double((j * k) % n) / double(n));
+
+	return X;
+}
+
+
+
+TEST(NativeFftTest, MatchesDirectDft)
+{
+	//	Powers of 2 and 4, radix 3, the generic radix (5, 7, 11, 13, 97), primes and odd lengths;
+	//	Waveform only takes even lengths, so the plans are run directly
+	for (std::size_t n : { 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 18, 30, 32, 45, 64, 77, 97, 100
+						 , 128, 143, 194, 210, 256, 384, 1000, 1024, 1331, 2048 }) {
+		const RealType x = Noise(n);
+		const ComplexType expected = DirectDft(x);
+
+		ComplexType spectrum (n / 2 + 1);
+		Waveform::Transform::NativeFft::PlanCache::Find(n)->Forward(x.data(), spectrum.data());
+
+		for (std::size_t k = 0; k < spectrum.size(); ++k)
+			EXPECT_NEAR(0., std::abs(expected[k] - spectrum[k]), 1e-11 * n) << "n = " << n << ", k = " << k;
+
+		//	The inverse is normalized and leaves the spectrum as it was
+		const ComplexType before = spectrum;
+		RealType back (n);
+		Waveform::Transform::NativeFft::PlanCache::Find(n)->Inverse(spectrum.data(), back.data());
+
+		EXPECT_EQ(before, spectrum);
+		for (std::size_t i = 0; i < n; ++i)
+			EXPECT_NEAR(x[i], back[i], 1e-13) << "n = " << n << ", i = " << i;
+	}
+}
+
+
+TEST(NativeFftTest, WaveformRoundTrip)
+{
+	for (std::size_t n : { 2, 10, 64, 1024, 6000 }) {
+		const RealType x = Noise(n, 777);
+
+		const NativeWaveform source (x);
+		const NativeWaveform wfm (source.GetConstFreqSpectrum());
+
+		const RealType& back = wfm.GetConstTimeSeries();
+		for (std::size_t i = 0; i < n; ++i)
+			EXPECT_NEAR(x[i], back[i], 1e-13) << "n = " << n << ", i = " << i;
+	}
+}
+
+
+TEST(NativeFftTest, DropInForFftw)
+{
+	for (std::size_t n : { 48, 250, 512 }) {
+		const RealType x = Noise(n, 99);
+
+		const NativeWaveform native (x);
+		const FftwWaveform fftw (x);
+
+		const ComplexType& a = native.GetConstFreqSpectrum();
+		const ComplexType& b = fftw.GetConstFreqSpectrum();
+
+		ASSERT_EQ(b.size(), a.size());
+		for (std::size_t k = 0; k < a.size(); ++k)
+			EXPECT_NEAR(0., std::abs(a[k] - b[k]), 1e-10);
+
+		//	Both inverses agree from a spectrum alone
+		const NativeWaveform fromNative (a);
+		const FftwWaveform fromFftw (b);
+		for (std::size_t i = 0; i < n; ++i)
+			EXPECT_NEAR(fromFftw.GetConstTimeSeries()[i], fromNative.GetConstTimeSeries()[i], 1e-13);
+	}
+}
+
+
+TEST(NativeFftTest, FourStepMatchesStockham)
+{
+	using Waveform::Transform::NativeFft::Plan;
+
+	//	Blocked past 2^15: a power of 2, a mixed length and an odd one
+	for (std::size_t n : { std::size_t(1) << 16, std::size_t(3) << 15, std::size_t(59049) }) {
+		const RealType noise = Noise(2 * n, 31);
+
+		RealType blocked (2 * n), work (2 * n), plain (2 * n);
+		Plan(n, std::size_t(1) << 15).Execute(noise.data(), blocked.data(), work.data());
+		Plan(n, 0).Execute(noise.data(), plain.data(), work.data());
+
+		double worst = 0.;
+		for (std::size_t i = 0; i < 2 * n; ++i)
+			worst = std::max(worst, std::abs(blocked[i] - plain[i]));
+		EXPECT_LT(worst, 1e-9) << "n = " << n;
+	}
+}
+
+
+TEST(NativeFftTest, LongTone)
+{
+	const std::size_t n = std::size_t(1) << 18;
+	RealType x (n);
+	for (std::size_t i = 0; i < n; ++i)
+		x[i] = std::cos(2. * pi * 1234. * double(i) / double(n)) + 0.25;
+
+	NativeWaveform wfm (x);
+	const ComplexType& spectrum = wfm.GetConstFreqSpectrum();
+
+	double leak = 0.;
+	for (std::size_t k = 0; k < spectrum.size(); ++k)
+		if (k != 0 && k != 1234)
+			leak = std::max(leak, std::abs(spectrum[k]));
+
+	EXPECT_NEAR(0.25 * n, spectrum[0].real(), 1e-6);
+	EXPECT_NEAR(0.5 * n, std::abs(spectrum[1234]), 1e-6);
+	EXPECT_LT(leak, 1e-6);
+
+	wfm.GetFreqSpectrum();
+	const RealType& back = wfm.GetConstTimeSeries();
+	for (std::size_t i = 0; i < n; i += 997)
+		EXPECT_NEAR(x[i], back[i], 1e-12);
+}
+
+
+TEST(NativeFftTest, PlansAreShared)
+{
+	const NativeWaveform first (Noise(360));
+	const std::size_t plans = Waveform::Transform::NativeFft::PlanCache::Size();
+
+	const NativeWaveform second (Noise(360, 5));
+	const NativeWaveform copy (first);
+	EXPECT_EQ(plans, Waveform::Transform::NativeFft::PlanCache::Size());
+
+	const NativeWaveform other (Noise(362));
+	EXPECT_EQ(plans + 1, Waveform::Transform::NativeFft::PlanCache::Size());
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,299 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#include <Waveform.hpp>
+#include <NpyFile.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::Waveform<RealType, ComplexType>	WaveformType;
+
+
+class NpyFileTest : public ::testing::Test {
+  protected:
+
+	NpyFileTest()
+	{
+
+	}
+
+	virtual
+	~NpyFileTest()
+	{
+
+	}
+
+	virtual
+	void
+	SetUp()
+	{
+		tDomain_.resize(length_);
+		fDomain_.resize(length_ / 2 + 1);
+
+		for (std::size_t i = 0; i < tDomain_.size(); ++i)
+			tDomain_[i] = std::sin(0.1 * i) / 3.;
+
+		for (std::size_t i = 0; i < fDomain_.size(); ++i)
+			fDomain_[i] = std::complex<double>(1. / (i + 3.), -std::cos(0.2 * i) / 7.);
+	}
+
+	virtual
+	void
+	TearDown()
+	{
+		for (auto& fileName : tempFiles_)
+			std::remove(fileName.c_str());
+	}
+
+	std::string
+	TempFileName (const std::string& suffix)
+	{
+		tempFiles_.push_back("NpyFileTest_" + std::to_string(tempFiles_.size()) + suffix);
+		return tempFiles_.back();
+	}
+
+	const std::size_t length_ = 256;
+
+	RealType	tDomain_;
+	ComplexType	fDomain_;
+
+	std::vector<std::string> tempFiles_;
+};
+
+
+
+TEST_F(NpyFileTest, HeaderMatchesNumpyLayout)
+{
+	std::ostringstream os;
+	const double values[3] = {1., 2., 3.};
+	PS::SaveNpy(os, values, 3);
+
+	const std::string bytes = os.str();
+
+	//	The dict does not fit in 64 bytes, so the data starts at byte 128, right after the '\n'
+	ASSERT_EQ(128u + 3 * sizeof(double), bytes.size());
+	EXPECT_EQ(std::string("\x93NUMPY\x01\x00", 8), bytes.substr(0, 8));
+	EXPECT_EQ(118, static_cast<unsigned char>(bytes[8]) | static_cast<unsigned char>(bytes[9]) << 8);
+	EXPECT_EQ(10u, bytes.find("{'descr': '<f8', 'fortran_order': False, 'shape': (3,), }"));
+	EXPECT_EQ('\n', bytes[127]);
+}
+
+
+TEST_F(NpyFileTest, TimeSeriesRoundTrip)
+{
+	WaveformType wfm (tDomain_);
+
+	const std::string fileName = TempFileName(".npy");
+	PS::SaveNpyTimeSeries(fileName, wfm);
+
+	PS::NpyView<double> view (fileName);
+
+	ASSERT_EQ(tDomain_.size(), view.size());
+	EXPECT_EQ(std::vector<std::size_t>{length_}, view.shape());
+	EXPECT_EQ(tDomain_, RealType(view.begin(), view.end()));
+
+	WaveformType loaded (length_);
+	PS::ReadTimeSeries(view, loaded);
+
+	EXPECT_EQ(WaveformType::DomainState::Time, loaded.GetValidDomain());
+	EXPECT_EQ(tDomain_, loaded.PeekTimeSeries());
+}
+
+
+TEST_F(NpyFileTest, FreqSpectrumRoundTrip)
+{
+	WaveformType wfm (fDomain_);
+
+	const std::string fileName = TempFileName(".npy");
+	PS::SaveNpyFreqSpectrum(fileName, wfm);
+
+	PS::NpyView< std::complex<double> > view (fileName);
+
+	EXPECT_EQ(fDomain_, ComplexType(view.begin(), view.end()));
+
+	WaveformType loaded (ComplexType(fDomain_.size()));
+	PS::ReadFreqSpectrum(view, loaded);
+
+	EXPECT_EQ(WaveformType::DomainState::Freq, loaded.GetValidDomain());
+	EXPECT_EQ(fDomain_, loaded.PeekFreqSpectrum());
+}
+
+
+TEST_F(NpyFileTest, ViewIsZeroCopyAndAligned)
+{
+	const std::string fileName = TempFileName(".npy");
+	PS::SaveNpy(fileName, tDomain_);
+
+	PS::NpyView<double> view (fileName);
+
+	EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(view.data()) % 64);
+}
+
+
+TEST_F(NpyFileTest, DtypeMismatchThrows)
+{
+	const std::string fileName = TempFileName(".npy");
+	PS::SaveNpy(fileName, tDomain_);
+
+	EXPECT_THROW(PS::NpyView<float> view (fileName), std::runtime_error);
+	EXPECT_THROW(PS::NpyView< std::complex<double> > view (fileName), std::runtime_error);
+}
+
+
+TEST_F(NpyFileTest, NotNpyThrows)
+{
+	const std::string fileName = TempFileName(".npy");
+	std::ofstream (fileName.c_str()) << "this is not a numpy file";
+
+	EXPECT_THROW(PS::NpyView<double> view (fileName), std::runtime_error);
+}
+
+
+TEST_F(NpyFileTest, MalformedHeaderThrows)
+{
+	const std::vector<std::string> dicts {
+		"{'descr'",
+		"{'descr':   ",
+		"{'descr': '<f8",
+		"{'descr': <f8, 'fortran_order': False, 'shape': (256,), }",
+		"{'descr': '<f8', 'fortran_order': False",
+		"{'descr': '<f8', 'fortran_order': False, 'shape': (256,"
+	};
+
+	for (const std::string& dict : dicts) {
+		std::string header ("\x93NUMPY\x01\x00", 8);
+		header.push_back(static_cast<char>(dict.size()));
+		header.push_back(0);
+		header += dict;
+
+		std::string descr;
+		std::vector<std::size_t> shape;
+		EXPECT_THROW(PS::detail::ParseNpyHeader(header.data(), header.size(), descr, shape), std::runtime_error) << dict;
+	}
+}
+
+
+TEST_F(NpyFileTest, OversizedShapeThrows)
+{
+	//	2^61 doubles are 2^64 bytes, which wraps to 0
+	const std::string huge = PS::detail::MakeNpyHeader<double>(std::size_t(1) << 61);
+	std::string twoD = huge;
+	twoD.replace(twoD.find("(2305843009213693952,)"), 22, "(4294967296, 4294967296)");
+
+	const std::string tooLong = std::string("\x93NUMPY\x01\x00\x56\x00", 10)
+			+ "{'descr': '<f8', 'fortran_order': False, 'shape': (99999999999999999999999,), }\n";
+
+	for (const std::string& header : { huge, twoD, tooLong }) {
+		const std::string fileName = TempFileName(".npy");
+		{
+			std::ofstream ofs (fileName.c_str(), std::ios::binary);
+			ofs << header << std::string(16, '\0');
+		}
+
+		EXPECT_THROW(PS::NpyView<double> view (fileName), std::runtime_error) << header;
+	}
+}
+
+
+TEST_F(NpyFileTest, NpzRoundTrip)
+{
+	WaveformType wfm (tDomain_);
+	wfm.OverwriteFreqSpectrum() = fDomain_;
+	wfm.OverwriteTimeSeries() = tDomain_;
+	wfm.AssumeValidDomain(WaveformType::DomainState::Both);
+
+	const std::string fileName = TempFileName(".npz");
+	PS::SaveNpz(fileName, wfm);
+
+	PS::NpzFile npz (fileName);
+
+	EXPECT_EQ((std::vector<std::string>{"freq", "time"}), npz.Names());
+
+	PS::NpyView<double> time = npz.Get<double>("time");
+	PS::NpyView< std::complex<double> > freq = npz.Get< std::complex<double> >("freq");
+
+	EXPECT_EQ(tDomain_, RealType(time.begin(), time.end()));
+	EXPECT_EQ(fDomain_, ComplexType(freq.begin(), freq.end()));
+
+	EXPECT_THROW(npz.Get<double>("missing"), std::runtime_error);
+}
+
+
+TEST_F(NpyFileTest, NpzWriterMembersAreStoredZipEntries)
+{
+	const std::string fileName = TempFileName(".npz");
+	{
+		PS::NpzWriter npz (fileName);
+		npz.Add("a", tDomain_);
+		npz.Add("b", RealType(5, 2.5));
+	}
+
+	std::ifstream ifs (fileName.c_str(), std::ios::binary);
+	std::string bytes ((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+	//	Local file header signature, version 20, stored, then the member name
+	EXPECT_EQ(std::string("PK\x03\x04", 4), bytes.substr(0, 4));
+	EXPECT_EQ(0, bytes[8]);
+	EXPECT_EQ("a.npy", bytes.substr(30, 5));
+
+	PS::NpzFile npz (fileName);
+	PS::NpyView<double> b = npz.Get<double>("b");
+
+	EXPECT_EQ(RealType(5, 2.5), RealType(b.begin(), b.end()));
+}
+
+
+TEST_F(NpyFileTest, CorruptNpzThrows)
+{
+	const std::string fileName = TempFileName(".npz");
+	{
+		PS::NpzWriter npz (fileName);
+		npz.Add("a", tDomain_);
+		npz.Add("b", RealType(5, 2.5));
+	}
+
+	std::ifstream ifs (fileName.c_str(), std::ios::binary);
+	const std::string bytes ((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+	const std::size_t directory = bytes.find(std::string("PK\x01\x02", 4));
+	const std::size_t end = bytes.find(std::string("PK\x05\x06", 4));
+	ASSERT_NE(std::string::npos, directory);
+	ASSERT_NE(std::string::npos, end);
+
+	//	The central directory cut off after the first entry's fixed fields
+	const std::string truncated = bytes.substr(0, directory + 46) + bytes.substr(end);
+
+	//	A name length which runs past the end of the file
+	std::string longName = bytes;
+	longName[directory + 28] = '\xFF';
+	longName[directory + 29] = '\xFF';
+
+	for (const std::string& corrupt : { truncated, longName }) {
+		const std::string corruptName = TempFileName(".npz");
+		std::ofstream (corruptName.c_str(), std::ios::binary) << corrupt;
+
+		EXPECT_THROW(PS::NpzFile npz (corruptName), std::runtime_error);
+	}
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,157 @@
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <Resample.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Cached_Normalized>	ResampledType;
+
+static_assert(std::is_same<ResampledType, decltype(PS::Resample(std::declval<const WaveformType&>(), 2))>::value
+			  , "Resample() returns its result over cached plans");
+static_assert(std::is_same<ResampledType, decltype(PS::Resample(std::declval<const ResampledType&>(), 2))>::value
+			  , "Resample() of a resampled Waveform has the same type");
+
+const double pi = std::acos(-1.);
+
+
+//!	Two tones, at 3 and 5 cycles per record, sampled length times
+RealType
+Tones (std::size_t length)
+{
+	RealType signal (length);
+
+	for (std::size_t i = 0; i < length; ++i) {
+		const double t = double(i) / length;
+		signal[i] = 0.25 + std::cos(2. * pi * 3. * t) + 0.5 * std::sin(2. * pi * 5. * t + 0.3);
+	}
+
+	return signal;
+}
+
+
+
+TEST(ResampleTest, Upsample)
+{
+	const WaveformType wfm (Tones(32));
+	const ResampledType up = PS::Resample(wfm, 80);
+
+	ASSERT_EQ(80u, up.size());
+	EXPECT_EQ(ResampledType::DomainState::Both, up.GetValidDomain());
+
+	const RealType expected = Tones(80);
+	const RealType& samples = up.GetConstTimeSeries();
+
+	for (std::size_t i = 0; i < samples.size(); ++i)
+		EXPECT_NEAR(expected[i], samples[i], 1e-9);
+
+	//	The spectrum matches what the new Waveform's own transform gives
+	const WaveformType check (samples);
+	const ComplexType& spectrum = check.GetConstFreqSpectrum();
+	for (std::size_t k = 0; k < spectrum.size(); ++k)
+		EXPECT_NEAR(0., std::abs(spectrum[k] - up.PeekFreqSpectrum()[k]), 1e-9);
+}
+
+
+TEST(ResampleTest, Downsample)
+{
+	WaveformType wfm (Tones(128));
+	const ResampledType down = PS::Resample(wfm, 24);
+
+	const RealType expected = Tones(24);
+	const RealType& samples = down.GetConstTimeSeries();
+
+	ASSERT_EQ(24u, samples.size());
+	for (std::size_t i = 0; i < samples.size(); ++i)
+		EXPECT_NEAR(expected[i], samples[i], 1e-9);
+
+	//	Back up again recovers the original
+	const ResampledType back = PS::Resample(down, 128);
+	const RealType original = Tones(128);
+	for (std::size_t i = 0; i < original.size(); ++i)
+		EXPECT_NEAR(original[i], back.GetConstTimeSeries()[i], 1e-9);
+}
+
+
+TEST(ResampleTest, NyquistBin)
+{
+	//	Upsampling keeps a Nyquist cosine a cosine
+	RealType alternating (16);
+	for (std::size_t i = 0; i < alternating.size(); ++i)
+		alternating[i] = i % 2 ? -1. : 1.;
+
+	const ResampledType up = PS::Resample(WaveformType(alternating), 32);
+	for (std::size_t i = 0; i < up.size(); ++i)
+		EXPECT_NEAR(std::cos(pi * i / 2.), up.GetConstTimeSeries()[i], 1e-9);
+
+	//	Downsampling folds +M/2 and -M/2 onto the new Nyquist bin
+	RealType quarter (16);
+	for (std::size_t i = 0; i < quarter.size(); ++i)
+		quarter[i] = std::cos(2. * pi * 4. * i / 16.);
+
+	const ResampledType down = PS::Resample(WaveformType(quarter), 8);
+	for (std::size_t i = 0; i < down.size(); ++i)
+		EXPECT_NEAR(quarter[2 * i], down.GetConstTimeSeries()[i], 1e-9);
+	EXPECT_NEAR(0., down.PeekFreqSpectrum()[4].imag(), 1e-12);
+}
+
+
+TEST(ResampleTest, FromSpectrumOnlyAndPlansAreReused)
+{
+	const WaveformType source (Tones(64));
+	const WaveformType first (source.GetConstFreqSpectrum());
+	const WaveformType second (source.GetConstFreqSpectrum());
+
+	const ResampledType a = PS::Resample(first, 96);
+	const std::size_t plans = Waveform::Transform::FftwPlanCache::Size();
+
+	//	Neither the c2r nor the result's own transform makes a new plan
+	const ResampledType b = PS::Resample(second, 96);
+	EXPECT_EQ(plans, Waveform::Transform::FftwPlanCache::Size());
+	EXPECT_EQ(a, b);
+
+	//	Only the spectrum of the source was needed
+	EXPECT_EQ(WaveformType::DomainState::Freq, first.GetValidDomain());
+}
+
+
+TEST(ResampleTest, ExplicitResultType)
+{
+	const WaveformType wfm (Tones(32));
+	const ResampledType cached = PS::Resample(wfm, 48);
+	const WaveformType planned = PS::Resample<WaveformType>(wfm, 48);
+
+	EXPECT_EQ(WaveformType::DomainState::Both, planned.GetValidDomain());
+	for (std::size_t i = 0; i < planned.size(); ++i)
+		EXPECT_EQ(cached.GetConstTimeSeries()[i], planned.GetConstTimeSeries()[i]);
+}
+
+
+TEST(ResampleTest, BadLength)
+{
+	const WaveformType wfm (Tones(32));
+
+	EXPECT_THROW(PS::Resample(wfm, 33), std::length_error);
+	EXPECT_THROW(PS::Resample(wfm, 0), std::length_error);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
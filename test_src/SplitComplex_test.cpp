@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iterator>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <SplitComplex.hpp>
+
+#include <gtest/gtest.h>
+
+#include "TestSignals.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::SplitComplexVector<double>		SplitType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	InterleavedWaveformType;
+typedef PS::Waveform<RealType, SplitType, Waveform::Transform::Fftw3_Dft_1d_Split_Normalized>	SplitWaveformType;
+
+
+
+TEST(SplitComplexTest, StoresPartsSeparately)
+{
+	SplitType split (4);
+
+	split[1] = std::complex<double>(1., -2.);
+	split[2] *= std::complex<double>(3., 0.);
+	split[3] = split[1];
+
+	EXPECT_EQ(1., split.real_data()[1]);
+	EXPECT_EQ(-2., split.imag_data()[1]);
+	EXPECT_EQ(std::complex<double>(1., -2.), split[3]);
+	EXPECT_EQ(std::complex<double>(0., 0.), split[2]);
+
+	const SplitType& constSplit = split;
+	EXPECT_EQ(std::complex<double>(1., -2.), constSplit[1]);
+	EXPECT_EQ(4, std::distance(constSplit.begin(), constSplit.end()));
+	EXPECT_EQ(4u, split.real().size());
+
+	const ComplexType interleaved (split.begin(), split.end());
+	EXPECT_EQ(split, SplitType(interleaved.begin(), interleaved.end()));
+	EXPECT_TRUE(std::equal(interleaved.begin(), interleaved.end(), constSplit.begin(), constSplit.end()));
+}
+
+
+TEST(SplitComplexTest, SpectralOperationsMatchComplexArithmetic)
+{
+	ComplexType x, h;
+
+	for (int k = 0; k < 37; ++k) {
+		x.push_back(std::complex<double>(std::sin(0.1 * k), std::cos(0.2 * k)));
+		h.push_back(std::complex<double>(1. / (k + 1.), -0.5 * k));
+	}
+
+	SplitType sx (x.begin(), x.end());
+	const SplitType sh (h.begin(), h.end());
+
+	PS::Multiply(sx, sh);
+	PS::Rotate(sx, 0.7);
+
+	for (std::size_t k = 0; k < x.size(); ++k) {
+		const std::complex<double> expected = x[k] * h[k] * std::polar(1., 0.7);
+		EXPECT_NEAR(expected.real(), sx.real_data()[k], 1e-12);
+		EXPECT_NEAR(expected.imag(), sx.imag_data()[k], 1e-12);
+	}
+
+	RealType gain (x.size(), 2.), magnitude;
+	PS::ApplyGain(sx, gain);
+	PS::Magnitude(sx, magnitude);
+
+	ASSERT_EQ(x.size(), magnitude.size());
+	for (std::size_t k = 0; k < x.size(); ++k)
+		EXPECT_NEAR(2. * std::abs(x[k] * h[k]), magnitude[k], 1e-12);
+
+	EXPECT_THROW(PS::Multiply(sx, SplitType(3)), std::length_error);
+}
+
+
+TEST(SplitComplexTest, WaveformMatchesInterleavedTransform)
+{
+	const RealType signal = TestSignal(128);
+
+	InterleavedWaveformType interleaved (signal);
+	SplitWaveformType split (signal);
+
+	const ComplexType& expected = interleaved.GetConstFreqSpectrum();
+	const SplitType& spectrum = split.GetConstFreqSpectrum();
+
+	ASSERT_EQ(65u, spectrum.size());
+	for (std::size_t k = 0; k < expected.size(); ++k) {
+		EXPECT_NEAR(expected[k].real(), spectrum.real_data()[k], 1e-9);
+		EXPECT_NEAR(expected[k].imag(), spectrum.imag_data()[k], 1e-9);
+	}
+
+	//	Filter in the split domain, then transform back
+	RealType gain (spectrum.size(), 0.5);
+	PS::ApplyGain(split.GetFreqSpectrum(), gain);
+
+	const RealType& filtered = split.GetConstTimeSeries();
+	for (std::size_t i = 0; i < signal.size(); ++i)
+		EXPECT_NEAR(0.5 * signal[i], filtered[i], 1e-9);
+}
+
+
+TEST(SplitComplexTest, MovedWaveformKeepsItsPlans)
+{
+	const RealType signal = TestSignal(64);
+
+	SplitWaveformType original (signal);
+	SplitWaveformType moved (std::move(original));
+
+	moved.GetFreqSpectrum();
+	const RealType& roundTrip = moved.GetConstTimeSeries();
+
+	for (std::size_t i = 0; i < signal.size(); ++i)
+		EXPECT_NEAR(signal[i], roundTrip[i], 1e-9);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
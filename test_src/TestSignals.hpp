@@ -0,0 +1,50 @@
+/*
+ TestSignals.hpp
+ The test signal shared by the programs in test_src/: two tones at
+ unrelated frequencies and a small sawtooth, so that no bin of its
+ spectrum is zero and no two samples repeat.
+ */
+
+#ifndef TESTSIGNALS_HPP
+#define TESTSIGNALS_HPP 1
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+//!	Sample i of the test signal, with the first tone shifted by phase
+inline double
+TestSample (const std::size_t i, const double phase = 0.)
+{ return std::sin(0.3 * i + phase) + 0.25 * std::cos(1.7 * i) + (i % 5) * 0.01; }
+
+
+//!	length samples of the test signal
+inline std::vector<double>
+TestSignal (const std::size_t length, const double phase = 0.)
+{
+	std::vector<double> signal (length);
+
+	for (std::size_t i = 0; i < length; ++i)
+		signal[i] = TestSample(i, phase);
+
+	return signal;
+}
+
+
+//!	N samples of the test signal, in a std::array
+template <std::size_t N>
+inline std::array<double, N>
+TestSignal (void)
+{
+	std::array<double, N> signal;
+
+	for (std::size_t i = 0; i < N; ++i)
+		signal[i] = TestSample(i);
+
+	return signal;
+}
+
+#endif
@@ -0,0 +1,140 @@
+#define WAVEFORM_TRANSFORM_STATS 1
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <complex>
+
+#include <Waveform.hpp>
+#include <TransformStats.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+//!	A transform which does nothing; only its type is used to key the counters
+struct CountedTransform {
+	typedef InverseTypes::Inverse inverse_type;
+
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	CountedTransform (RandomAccessRange1&, RandomAccessRange2&)
+	{ }
+
+	void
+	exec_transform (void)
+	{ }
+
+	void
+	exec_inverse_transform (void)
+	{ }
+};
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::Waveform<RealType, ComplexType, CountedTransform>	WaveformType;
+
+//	Each test uses its own lengths, so that tests do not see each other's counts
+const std::string transformName = "(anonymous namespace)::CountedTransform";
+
+
+//!	Returns the entry for a transform name and length, or an all-zero entry
+PS::TransformStatsEntry
+Find (const std::string& transform, std::size_t length)
+{
+	for (const PS::TransformStatsEntry& e : PS::TransformStatsSnapshot())
+		if (e.transform == transform && e.length == length)
+			return e;
+
+	return PS::TransformStatsEntry { transform, length, 0, 0, 0, 0, 0., 0. };
+}
+
+
+
+TEST(TransformStatsTest, CountsTransformsAndPlansPerLength)
+{
+	{
+		WaveformType wfm (RealType(64));
+		wfm.GetFreqSpectrum();			//	forward
+		wfm.GetTimeSeries();			//	inverse
+		wfm.GetConstFreqSpectrum();		//	forward
+		wfm.GetConstTimeSeries();		//	none, both valid
+
+		WaveformType other (RealType(128));
+		other.GetFreqSpectrum();
+	}
+
+	const PS::TransformStatsEntry e64 = Find(transformName, 64);
+
+	EXPECT_EQ(2u, e64.forward);
+	EXPECT_EQ(1u, e64.inverse);
+	EXPECT_EQ(1u, e64.plans);
+	EXPECT_EQ(3u * (64 * sizeof(double) + 33 * sizeof(std::complex<double>)), e64.bytes);
+
+	const PS::TransformStatsEntry e128 = Find(transformName, 128);
+
+	EXPECT_EQ(1u, e128.forward);
+	EXPECT_EQ(0u, e128.inverse);
+	EXPECT_EQ(1u, e128.plans);
+}
+
+
+TEST(TransformStatsTest, CopyPlansAndMoveDoesNot)
+{
+	WaveformType wfm (RealType(32));
+	WaveformType copy (wfm);
+	WaveformType moved (std::move(copy));
+
+	EXPECT_EQ(2u, Find(transformName, 32).plans);
+}
+
+
+TEST(TransformStatsTest, AggregatesAcrossThreads)
+{
+	const std::uint64_t before = Find(transformName, 256).forward;
+
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([]{
+			WaveformType wfm (RealType(256));
+
+			for (int i = 0; i < 1000; ++i) {
+				wfm.GetTimeSeries();
+				wfm.GetFreqSpectrum();
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	//	The threads have exited, so their counts come from the retired totals
+	EXPECT_EQ(before + 4 * 1000, Find(transformName, 256).forward);
+}
+
+
+TEST(TransformStatsTest, PrometheusOutput)
+{
+	WaveformType wfm (RealType(16));
+	wfm.GetFreqSpectrum();
+
+	std::ostringstream os;
+	PS::WriteTransformStats(os);
+
+	EXPECT_NE(std::string::npos, os.str().find("# TYPE waveform_transforms_total counter\n"));
+	EXPECT_NE(std::string::npos, os.str().find(
+			"waveform_transforms_total{transform=\"" + transformName + "\",length=\"16\",direction=\"forward\"} 1\n"));
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,147 @@
+#define WAVEFORM_TRACE_TRANSITIONS 1
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <complex>
+
+#include <Waveform.hpp>
+#include <TransitionTrace.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::Waveform<RealType, ComplexType>	WaveformType;
+
+
+class TransitionTraceTest : public ::testing::Test {
+  protected:
+
+	virtual
+	void
+	SetUp()
+	{
+		PS::ResetTransitionTrace();
+	}
+};
+
+
+
+TEST_F(TransitionTraceTest, RecordsCallSites)
+{
+	WaveformType wfm (RealType(64));
+
+	const unsigned freqLine = __LINE__ + 1;
+	wfm.GetFreqSpectrum();
+	const unsigned timeLine = __LINE__ + 1;
+	wfm.GetTimeSeries();
+
+	const std::vector<PS::TransitionEvent> events = PS::TransitionTraceEvents();
+
+	ASSERT_EQ(2u, events.size());
+
+	EXPECT_EQ(PS::TransformDirection::Forward, events[0].direction);
+	EXPECT_EQ(freqLine, events[0].site.line);
+	EXPECT_NE(std::string::npos, std::string(events[0].site.file).find("TransitionTrace_test.cpp"));
+
+	EXPECT_EQ(PS::TransformDirection::Inverse, events[1].direction);
+	EXPECT_EQ(timeLine, events[1].site.line);
+	EXPECT_EQ(64u, events[1].length);
+}
+
+
+TEST_F(TransitionTraceTest, NoTransformNoEvent)
+{
+	WaveformType wfm (RealType(64));
+
+	wfm.GetTimeSeries();
+	wfm.GetTimeSeries();
+	wfm.ValidateDomain(WaveformType::Domain::Time);
+
+	EXPECT_TRUE(PS::TransitionTraceEvents().empty());
+}
+
+
+TEST_F(TransitionTraceTest, ReportsPingPong)
+{
+	WaveformType quiet (RealType(32));
+	quiet.GetConstFreqSpectrum();
+
+	WaveformType busy (RealType(32));
+
+	for (int i = 0; i < 10; ++i) {
+		busy.GetTimeSeries()[0] = i;
+		busy.GetFreqSpectrum()[0] *= 2.;
+	}
+
+	const PS::TransitionTraceReport report = PS::GetTransitionTraceReport(5);
+
+	//	Only the Waveform in the loop crosses the threshold
+	ASSERT_EQ(1u, report.waveforms.size());
+	EXPECT_EQ(19u, report.waveforms[0].transforms);
+	EXPECT_EQ(32u, report.waveforms[0].length);
+	ASSERT_EQ(2u, report.waveforms[0].sites.size());
+	EXPECT_EQ(10u, report.waveforms[0].sites[0].transforms());
+
+	//	Two sites in the loop, plus the const access
+	ASSERT_EQ(3u, report.sites.size());
+	EXPECT_EQ(10u, report.sites[0].forward);
+	EXPECT_EQ(9u, report.sites[1].inverse);
+	EXPECT_EQ(1u, report.sites[2].forward);
+
+	std::ostringstream os;
+	PS::WriteTransitionTraceReport(os, 5);
+	EXPECT_NE(std::string::npos, os.str().find("length 32: 19 transforms"));
+}
+
+
+TEST_F(TransitionTraceTest, CopyIsTracedSeparately)
+{
+	WaveformType wfm (RealType(16));
+	WaveformType copy (wfm);
+
+	wfm.GetFreqSpectrum();
+	copy.GetFreqSpectrum();
+
+	const std::vector<PS::TransitionEvent> events = PS::TransitionTraceEvents();
+
+	ASSERT_EQ(2u, events.size());
+	EXPECT_NE(events[0].waveform, events[1].waveform);
+}
+
+
+TEST_F(TransitionTraceTest, DestroyedWaveformsAreForgotten)
+{
+	WaveformType live (RealType(16));
+	live.GetFreqSpectrum();
+
+	for (int i = 0; i < 100; ++i) {
+		WaveformType temporary (RealType(16));
+		temporary.GetFreqSpectrum();
+	}
+
+	const PS::TransitionTraceReport report = PS::GetTransitionTraceReport(0);
+
+	//	Only the live Waveform is listed, but every transform is counted per site
+	ASSERT_EQ(1u, report.waveforms.size());
+	EXPECT_EQ(1u, report.waveforms[0].transforms);
+
+	ASSERT_EQ(2u, report.sites.size());
+	EXPECT_EQ(100u, report.sites[0].forward);
+	EXPECT_EQ(1u, report.sites[1].forward);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,225 @@
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <ParallelFor.hpp>
+#include <Waveform.hpp>
+#include <WaveformArena.hpp>
+
+#include <gtest/gtest.h>
+
+#include "TestSignals.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+typedef PS::PmrWaveform<Waveform::Transform::Fftw3_Dft_1d_Cached_Normalized>				ArenaWaveformType;
+
+
+//!	Counts what is asked of new_delete_resource()
+class CountingResource : public std::pmr::memory_resource {
+  public:
+	std::size_t allocations = 0;
+
+  private:
+	void*
+	do_allocate (std::size_t bytes, std::size_t alignment) override
+	{
+		++allocations;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	void
+	do_deallocate (void* p, std::size_t bytes, std::size_t alignment) override
+	{ std::pmr::new_delete_resource()->deallocate(p, bytes, alignment); }
+
+	bool
+	do_is_equal (const std::pmr::memory_resource& other) const noexcept override
+	{ return this == &other; }
+};
+
+
+bool
+SimdAligned (const void* p)
+{ return reinterpret_cast<std::uintptr_t>(p) % PS::SimdAlignment == 0; }
+
+
+
+TEST(WaveformArenaTest, DomainsComeFromTheArena)
+{
+	PS::EventArena arena (1 << 16);
+
+	const RealType signal = TestSignal(250);
+	const PS::PmrRealVector samples (signal.begin(), signal.end());
+
+	ArenaWaveformType wfm (samples, arena.Allocator<double>());
+
+	EXPECT_EQ(arena.Resource(), wfm.GetTimeAllocator().resource());
+	EXPECT_EQ(arena.Resource(), wfm.GetFreqAllocator().resource());
+	EXPECT_GE(arena.BytesAllocated(), 250 * sizeof(double) + 126 * sizeof(std::complex<double>));
+
+	//	Every block is aligned for SIMD, even after odd-sized ones
+	EXPECT_TRUE(SimdAligned(wfm.PeekTimeSeries().data()));
+	EXPECT_TRUE(SimdAligned(wfm.PeekFreqSpectrum().data()));
+
+	ArenaWaveformType other (std::size_t(6), arena.Allocator<double>());
+	EXPECT_TRUE(SimdAligned(other.PeekTimeSeries().data()));
+	EXPECT_TRUE(SimdAligned(other.PeekFreqSpectrum().data()));
+}
+
+
+TEST(WaveformArenaTest, MatchesDefaultAllocation)
+{
+	PS::EventArena arena;
+
+	const RealType signal = TestSignal(256);
+
+	WaveformType expected (signal);
+	ArenaWaveformType wfm (std::size_t(256), arena.Allocator<double>());
+	std::copy(signal.begin(), signal.end(), wfm.GetTimeSeries().begin());
+
+	const ComplexType& a = expected.GetConstFreqSpectrum();
+	const PS::PmrComplexVector& b = wfm.GetConstFreqSpectrum();
+
+	ASSERT_EQ(a.size(), b.size());
+	for (std::size_t k = 0; k < a.size(); ++k)
+		EXPECT_NEAR(0., std::abs(a[k] - b[k]), 1e-12);
+
+	//	The inverse leaves the spectrum as it was and is normalized
+	wfm.GetFreqSpectrum();
+	const PS::PmrRealVector& time = wfm.GetConstTimeSeries();
+	for (std::size_t i = 0; i < signal.size(); ++i)
+		EXPECT_NEAR(signal[i], time[i], 1e-12);
+	for (std::size_t k = 0; k < a.size(); ++k)
+		EXPECT_NEAR(0., std::abs(a[k] - wfm.PeekFreqSpectrum()[k]), 1e-12);
+}
+
+
+TEST(WaveformArenaTest, EventsReuseTheArena)
+{
+	CountingResource upstream;
+	PS::EventArena arena (1 << 17, &upstream);
+
+	const RealType signal = TestSignal(512);
+	const PS::PmrRealVector samples (signal.begin(), signal.end());
+
+	const std::size_t plans = Waveform::Transform::FftwPlanCache::Size();
+	const void* first = nullptr;
+
+	for (int event = 0; event < 5; ++event) {
+		{
+			std::vector<ArenaWaveformType> waveforms;
+			waveforms.reserve(8);
+
+			for (int i = 0; i < 8; ++i) {
+				waveforms.emplace_back(samples, arena.Allocator<double>());
+				waveforms.back().GetConstFreqSpectrum();
+			}
+
+			if (event == 0)
+				first = waveforms.front().PeekTimeSeries().data();
+			else
+				EXPECT_EQ(first, waveforms.front().PeekTimeSeries().data());
+		}
+
+		arena.Reset();
+		EXPECT_EQ(0u, arena.BytesAllocated());
+	}
+
+	//	Everything fit in the initial buffer, and the plans (one forward, one inverse) were shared
+	EXPECT_EQ(0u, upstream.allocations);
+	EXPECT_LE(Waveform::Transform::FftwPlanCache::Size(), plans + 2);
+}
+
+
+TEST(WaveformArenaTest, AssignmentKeepsTheArena)
+{
+	PS::EventArena arena;
+
+	const RealType signal = TestSignal(64);
+	const PS::PmrRealVector samples (signal.begin(), signal.end());
+
+	ArenaWaveformType inArena (std::size_t(64), arena.Allocator<double>());
+	ArenaWaveformType onHeap (samples);
+	onHeap.GetConstFreqSpectrum();
+
+	EXPECT_NE(arena.Resource(), onHeap.GetTimeAllocator().resource());
+
+	inArena = ArenaWaveformType(onHeap);
+
+	EXPECT_EQ(arena.Resource(), inArena.GetTimeAllocator().resource());
+	EXPECT_EQ(arena.Resource(), inArena.GetFreqAllocator().resource());
+	EXPECT_EQ(ArenaWaveformType::DomainState::Both, inArena.GetValidDomain());
+	EXPECT_EQ(onHeap, inArena);
+
+	//	The assigned Waveform transforms its own arrays
+	inArena.GetFreqSpectrum()[0] = 0.;
+	EXPECT_NE(onHeap.GetConstTimeSeries()[0], inArena.GetConstTimeSeries()[0]);
+}
+
+
+TEST(WaveformArenaTest, CachedPlansRunOnSeveralThreads)
+{
+	const RealType signal = TestSignal(256);
+	const PS::PmrRealVector samples (signal.begin(), signal.end());
+	WaveformType expected (signal);
+	expected.GetFreqSpectrum()[1] *= 2.;
+	expected.GetConstTimeSeries();
+
+	std::vector<ArenaWaveformType> waveforms;
+	for (int i = 0; i < 8; ++i)
+		waveforms.emplace_back(samples);
+
+	const std::size_t plans = Waveform::Transform::FftwPlanCache::Size();
+
+	PS::ParallelFor(waveforms.size(), 4, [&](std::size_t i) {
+		waveforms[i].GetFreqSpectrum()[1] *= 2.;
+		waveforms[i].GetConstTimeSeries();
+	});
+
+	//	Every plan was looked up when the Waveforms were constructed
+	EXPECT_EQ(plans, Waveform::Transform::FftwPlanCache::Size());
+
+	for (const ArenaWaveformType& wfm : waveforms)
+		for (std::size_t k = 0; k < wfm.size(); ++k)
+			EXPECT_NEAR(expected.PeekTimeSeries()[k], wfm.PeekTimeSeries()[k], 1e-12);
+}
+
+
+TEST(WaveformArenaTest, ClearingThePlanCache)
+{
+	const RealType signal = TestSignal(128);
+	const PS::PmrRealVector samples (signal.begin(), signal.end());
+	const WaveformType expected (signal);
+
+	{
+		ArenaWaveformType wfm (samples);
+		wfm.GetConstFreqSpectrum();
+	}
+
+	Waveform::Transform::FftwPlanCache::Clear();
+	EXPECT_EQ(0u, Waveform::Transform::FftwPlanCache::Size());
+
+	//	Waveforms made afterwards plan again
+	ArenaWaveformType wfm (samples);
+	for (std::size_t k = 0; k < wfm.GetConstFreqSpectrum().size(); ++k)
+		EXPECT_NEAR(0., std::abs(expected.GetConstFreqSpectrum()[k] - wfm.PeekFreqSpectrum()[k]), 1e-12);
+	EXPECT_LT(0u, Waveform::Transform::FftwPlanCache::Size());
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,217 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <stdexcept>
+
+#include <Waveform.hpp>
+#include <WaveformBinary.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+typedef PS::Waveform<RealType, ComplexType>	WaveformType;
+typedef WaveformType::DomainState			DomainState;
+
+
+class WaveformBinaryTest : public ::testing::Test {
+  protected:
+
+	WaveformBinaryTest()
+	{
+
+	}
+
+	virtual
+	~WaveformBinaryTest()
+	{
+
+	}
+
+	virtual
+	void
+	SetUp()
+	{
+		tDomain_.resize(length_);
+		fDomain_.resize(length_ / 2 + 1);
+
+		//	Values which do not survive a round trip through decimal text
+		for (std::size_t i = 0; i < tDomain_.size(); ++i)
+			tDomain_[i] = std::sin(0.1 * i) / 3.;
+
+		for (std::size_t i = 0; i < fDomain_.size(); ++i)
+			fDomain_[i] = std::complex<double>(1. / (i + 3.), -std::cos(0.2 * i) / 7.);
+	}
+
+	virtual
+	void
+	TearDown()
+	{
+
+	}
+
+	const std::size_t length_ = 256;
+
+	RealType	tDomain_;
+	ComplexType	fDomain_;
+};
+
+
+
+TEST_F(WaveformBinaryTest, TimeDomainRoundTrip)
+{
+	WaveformType original (tDomain_);
+
+	std::stringstream buffer;
+	PS::Save(buffer, original);
+
+	WaveformType loaded (length_);
+	PS::Load(buffer, loaded);
+
+	EXPECT_EQ(DomainState::Time, loaded.GetValidDomain());
+	EXPECT_EQ(tDomain_, loaded.PeekTimeSeries());
+}
+
+
+TEST_F(WaveformBinaryTest, FreqDomainRoundTrip)
+{
+	WaveformType original (fDomain_);
+
+	std::stringstream buffer;
+	PS::Save(buffer, original);
+
+	WaveformType loaded (ComplexType(fDomain_.size()));
+	PS::Load(buffer, loaded);
+
+	EXPECT_EQ(DomainState::Freq, loaded.GetValidDomain());
+	EXPECT_EQ(fDomain_, loaded.PeekFreqSpectrum());
+}
+
+
+TEST_F(WaveformBinaryTest, BothDomainsRoundTrip)
+{
+	WaveformType original (tDomain_);
+	original.OverwriteFreqSpectrum() = fDomain_;
+	original.OverwriteTimeSeries() = tDomain_;
+	original.AssumeValidDomain(DomainState::Both);
+
+	std::stringstream buffer;
+	PS::Save(buffer, original);
+
+	WaveformType loaded (tDomain_);
+	PS::Load(buffer, loaded);
+
+	EXPECT_EQ(DomainState::Both, loaded.GetValidDomain());
+	EXPECT_EQ(tDomain_, loaded.PeekTimeSeries());
+	EXPECT_EQ(fDomain_, loaded.PeekFreqSpectrum());
+}
+
+
+TEST_F(WaveformBinaryTest, HeaderDescribesContents)
+{
+	WaveformType original (tDomain_);
+
+	std::stringstream buffer;
+	PS::Save(buffer, original);
+
+	PS::WaveformBinaryHeader header = PS::ReadWaveformBinaryHeader(buffer);
+
+	EXPECT_EQ(PS::WaveformBinaryVersion, header.version);
+	EXPECT_TRUE(header.timeValid);
+	EXPECT_FALSE(header.freqValid);
+	EXPECT_EQ(length_, header.timeLength);
+	EXPECT_EQ(length_ / 2 + 1, header.freqLength);
+
+	//	The stream is left at the data, so loading can continue from here
+	WaveformType loaded (header.timeLength);
+	PS::Load(buffer, header, loaded);
+
+	EXPECT_EQ(tDomain_, loaded.PeekTimeSeries());
+}
+
+
+TEST_F(WaveformBinaryTest, CorruptDataIsRejected)
+{
+	WaveformType original (tDomain_);
+
+	std::stringstream buffer;
+	PS::Save(buffer, original);
+
+	std::string bytes = buffer.str();
+	bytes[bytes.size() / 2] ^= 0x10;
+
+	std::stringstream corrupted (bytes);
+	WaveformType loaded (length_);
+
+	EXPECT_THROW(PS::Load(corrupted, loaded), std::runtime_error);
+}
+
+
+TEST_F(WaveformBinaryTest, CorruptHeaderIsRejected)
+{
+	WaveformType original (tDomain_);
+
+	std::stringstream buffer;
+	PS::Save(buffer, original);
+
+	std::string bytes = buffer.str();
+	bytes[17] ^= 0x01;
+
+	std::stringstream corrupted (bytes);
+	WaveformType loaded (length_);
+
+	EXPECT_THROW(PS::Load(corrupted, loaded), std::runtime_error);
+}
+
+
+TEST_F(WaveformBinaryTest, TruncatedFileIsRejected)
+{
+	WaveformType original (tDomain_);
+
+	std::stringstream buffer;
+	PS::Save(buffer, original);
+
+	std::stringstream truncated (buffer.str().substr(0, 100));
+	WaveformType loaded (length_);
+
+	EXPECT_THROW(PS::Load(truncated, loaded), std::runtime_error);
+}
+
+
+TEST_F(WaveformBinaryTest, LengthMismatchIsRejected)
+{
+	WaveformType original (tDomain_);
+
+	std::stringstream buffer;
+	PS::Save(buffer, original);
+
+	WaveformType loaded (length_ / 2);
+
+	EXPECT_THROW(PS::Load(buffer, loaded), std::length_error);
+}
+
+
+TEST_F(WaveformBinaryTest, Crc32KnownValue)
+{
+	//	The standard CRC-32 check value
+	const std::string check ("123456789");
+
+	EXPECT_EQ(0xCBF43926u, PS::Crc32(check.data(), check.size()));
+	EXPECT_EQ(0xCBF43926u, PS::Crc32Update(PS::Crc32(check.data(), 4), check.data() + 4, 5));
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,226 @@
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <WaveformPool.hpp>
+
+#include <gtest/gtest.h>
+
+#include "TestSignals.hpp"
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+typedef PS::WaveformPool<WaveformType>														PoolType;
+
+
+//!	Bytes of both domains of a Waveform of the given length
+std::size_t
+WaveformBytes (std::size_t length)
+{ return length * sizeof(double) + (length / 2 + 1) * sizeof(std::complex<double>); }
+
+
+
+TEST(WaveformPoolTest, RecyclesByLength)
+{
+	PoolType pool;
+
+	const WaveformType* first = nullptr;
+	{
+		PoolType::Handle wfm = pool.Acquire(256);
+		first = wfm.get();
+
+		wfm->GetTimeSeries() = TestSignal(256);
+		wfm->GetConstFreqSpectrum();
+		EXPECT_EQ(WaveformType::DomainState::Both, wfm->GetValidDomain());
+	}
+
+	PoolType::Handle same = pool.Acquire(256);
+	PoolType::Handle other = pool.Acquire(512);
+
+	//	The recycled Waveform is back in the Neither state
+	EXPECT_EQ(first, same.get());
+	EXPECT_EQ(WaveformType::DomainState::Neither, same->GetValidDomain());
+	EXPECT_NE(first, other.get());
+	EXPECT_EQ(512u, other->size());
+
+	const PS::WaveformPoolStats stats = pool.Stats();
+	EXPECT_EQ(3u, stats.acquires);
+	EXPECT_EQ(1u, stats.hits);
+	EXPECT_EQ(2u, stats.constructed);
+	EXPECT_EQ(1u, stats.releases);
+	EXPECT_EQ(0u, stats.idle);
+	EXPECT_EQ(2u, stats.outstanding);
+	EXPECT_EQ(WaveformBytes(256) + WaveformBytes(512), stats.liveBytes);
+}
+
+
+TEST(WaveformPoolTest, RecycledWaveformsTransform)
+{
+	PoolType pool;
+
+	for (int i = 0; i < 4; ++i) {
+		const RealType signal = TestSignal(128, i);
+		const WaveformType expected (signal);
+
+		PoolType::Handle wfm = pool.Acquire(128);
+		std::copy(signal.begin(), signal.end(), wfm->GetTimeSeries().begin());
+
+		const ComplexType& a = expected.GetConstFreqSpectrum();
+		const ComplexType& b = wfm->GetConstFreqSpectrum();
+
+		ASSERT_EQ(a.size(), b.size());
+		for (std::size_t k = 0; k < a.size(); ++k)
+			EXPECT_NEAR(0., std::abs(a[k] - b[k]), 1e-12);
+	}
+
+	EXPECT_EQ(1u, pool.Stats().constructed);
+	EXPECT_EQ(3u, pool.Stats().hits);
+}
+
+
+TEST(WaveformPoolTest, LimitsBoundTheFreeLists)
+{
+	PoolType::Limits limits;
+	limits.maxIdlePerLength = 2;
+	limits.maxIdleBytes = WaveformBytes(64) * 3;
+
+	PoolType pool (limits);
+
+	{
+		std::vector<PoolType::Handle> handles;
+		for (int i = 0; i < 4; ++i)
+			handles.push_back(pool.Acquire(64));
+	}
+
+	PS::WaveformPoolStats stats = pool.Stats();
+	EXPECT_EQ(2u, stats.idle);
+	EXPECT_EQ(2u, stats.destroyed);
+	EXPECT_EQ(2 * WaveformBytes(64), stats.idleBytes);
+	EXPECT_EQ(stats.idleBytes, stats.liveBytes);
+
+	{
+		PoolType::Handle a = pool.Acquire(64);
+		PoolType::Handle b = pool.Acquire(64);
+		PoolType::Handle c = pool.Acquire(64);
+	}
+
+	stats = pool.Stats();
+	EXPECT_EQ(2u, stats.idle);
+	EXPECT_EQ(3u, stats.destroyed);
+
+	//	Another length fits one more under the byte limit
+	EXPECT_EQ(1u, pool.Reserve(32, 10));
+	EXPECT_EQ(3u, pool.Stats().idle);
+}
+
+
+TEST(WaveformPoolTest, ReserveAndTrim)
+{
+	PoolType pool;
+
+	EXPECT_EQ(5u, pool.Reserve(1024, 5));
+	EXPECT_EQ(5u, pool.Stats().idle);
+	EXPECT_EQ(5 * WaveformBytes(1024), pool.Stats().idleBytes);
+
+	{
+		std::vector<PoolType::Handle> handles;
+		for (int i = 0; i < 5; ++i)
+			handles.push_back(pool.Acquire(1024));
+
+		EXPECT_EQ(5u, pool.Stats().hits);
+		EXPECT_EQ(5u, pool.Stats().outstanding);
+	}
+
+	pool.Trim();
+
+	const PS::WaveformPoolStats stats = pool.Stats();
+	EXPECT_EQ(0u, stats.idle);
+	EXPECT_EQ(0u, stats.outstanding);
+	EXPECT_EQ(5u, stats.destroyed);
+	EXPECT_EQ(0u, stats.liveBytes);
+}
+
+
+TEST(WaveformPoolTest, OddLengthThrows)
+{
+	PoolType pool;
+
+	EXPECT_THROW(pool.Acquire(7), std::length_error);
+	EXPECT_EQ(0u, pool.Stats().constructed);
+}
+
+
+TEST(WaveformPoolTest, ThreadsKeepTheirOwnFreeLists)
+{
+	PoolType pool;
+
+	const std::size_t threads = 4;
+	std::vector<std::thread> workers;
+
+	for (std::size_t t = 0; t < threads; ++t)
+		workers.emplace_back([&pool]{
+			for (int i = 0; i < 100; ++i) {
+				PoolType::Handle wfm = pool.Acquire(64);
+				wfm->GetTimeSeries()[0] = i;
+				wfm->GetConstFreqSpectrum();
+			}
+		});
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	PS::WaveformPoolStats stats = pool.Stats();
+	EXPECT_EQ(threads * 100, stats.acquires);
+	EXPECT_EQ(threads, stats.constructed);
+	EXPECT_EQ(threads * 99, stats.hits);
+	EXPECT_EQ(threads, stats.idle);
+	EXPECT_EQ(0u, stats.outstanding);
+
+	//	A new thread adopts the cache of one which exited, with its idle Waveform
+	std::thread([&pool]{
+		PoolType::Handle wfm = pool.Acquire(64);
+	}).join();
+
+	stats = pool.Stats();
+	EXPECT_EQ(threads, stats.constructed);
+	EXPECT_EQ(threads * 99 + 1, stats.hits);
+}
+
+
+TEST(WaveformPoolTest, ReleasedOnAnotherThread)
+{
+	PoolType pool;
+
+	PoolType::Handle wfm = pool.Acquire(64);
+
+	std::thread([&wfm]{
+		wfm.reset();
+	}).join();
+
+	//	It went to the other thread's free list, which this thread does not see
+	PoolType::Handle again = pool.Acquire(64);
+
+	const PS::WaveformPoolStats stats = pool.Stats();
+	EXPECT_EQ(2u, stats.constructed);
+	EXPECT_EQ(1u, stats.idle);
+	EXPECT_EQ(1u, stats.outstanding);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
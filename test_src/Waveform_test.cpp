@@ -29,6 +29,7 @@
 #include <complex>
 
 #include <Waveform.hpp>
+#include <DatFile.hpp>
 #include <gtest/gtest.h>
 
 #include <boost/archive/text_iarchive.hpp>
@@ -130,19 +131,41 @@ typedef std::vector< std::complex<double> > ComplexType;
 typedef Waveform<std::vector<double>, std::vector< std::complex<double> > > WaveformType;
 
 
-template <typename T>
-std::vector<T>
-parse_dat_file (std::string fileName)
-{
-	std::ifstream ifs(fileName.c_str());
-	assert(ifs.good());
+//!	A transform which only counts how often it runs
+struct CountingTransform {
+	typedef InverseTypes::Inverse inverse_type;
 
+	static inline int forward = 0;
+	static inline int inverse = 0;
 
-	std::vector<T> result { std::istream_iterator<T>(ifs)
-						  , std::istream_iterator<T>() };
+	static void
+	Reset (void)
+	{ forward = inverse = 0; }
 
-	return result;
-}
+	template <typename RandomAccessRange1, typename RandomAccessRange2>
+	CountingTransform (RandomAccessRange1&, RandomAccessRange2&)
+	{ }
+
+	void
+	exec_transform (void)
+	{ ++forward; }
+
+	void
+	exec_inverse_transform (void)
+	{ ++inverse; }
+};
+
+typedef Waveform<RealType, ComplexType, CountingTransform> CountingWaveformType;
+
+
+//!	The same, for a transform which does not declare itself linear
+struct CountingOtherTransform : CountingTransform {
+	typedef InverseTypes::Other inverse_type;
+
+	using CountingTransform::CountingTransform;
+};
+
+typedef Waveform<RealType, ComplexType, CountingOtherTransform> CountingOtherWaveformType;
 
 
 class WaveformTest : public ::testing::Test {
@@ -182,17 +205,17 @@ class WaveformTest : public ::testing::Test {
 		ia_fDomain >> fDomainExampleData_;
 
 
-		stepFn1024_real = parse_dat_file<double>("test_data/stepFn1024_real.dat");
-		stepFn1024_complex = parse_dat_file<std::complex<double> >("test_data/stepFn1024_complex.dat");
+		stepFn1024_real = PS::ParseDatFile<double>("test_data/stepFn1024_real.dat");
+		stepFn1024_complex = PS::ParseDatFile<std::complex<double> >("test_data/stepFn1024_complex.dat");
 
-		diracFn1024_real = parse_dat_file<double>("test_data/diracFn1024_real.dat");
-		diracFn1024_complex = parse_dat_file<std::complex<double> >("test_data/diracFn1024_complex.dat");
+		diracFn1024_real = PS::ParseDatFile<double>("test_data/diracFn1024_real.dat");
+		diracFn1024_complex = PS::ParseDatFile<std::complex<double> >("test_data/diracFn1024_complex.dat");
 
-		triangleFn1024_real = parse_dat_file<double>("test_data/triangleFn1024_real.dat");
-		triangleFn1024_complex = parse_dat_file<std::complex<double> >("test_data/triangleFn1024_complex.dat");
+		triangleFn1024_real = PS::ParseDatFile<double>("test_data/triangleFn1024_real.dat");
+		triangleFn1024_complex = PS::ParseDatFile<std::complex<double> >("test_data/triangleFn1024_complex.dat");
 
-		squareFn1024_real = parse_dat_file<double>("test_data/squareFn1024_real.dat");
-		squareFn1024_complex = parse_dat_file<std::complex<double> >("test_data/squareFn1024_complex.dat");
+		squareFn1024_real = PS::ParseDatFile<double>("test_data/squareFn1024_real.dat");
+		squareFn1024_complex = PS::ParseDatFile<std::complex<double> >("test_data/squareFn1024_complex.dat");
 
 
 		testArrays_real.push_back(stepFn1024_real);
@@ -249,8 +272,7 @@ TEST_F(WaveformTest,FillConstructor)
 	WaveformType filltest (512);
 
 	EXPECT_EQ(512, filltest.size());
-
-
+	EXPECT_EQ(257, filltest.PeekFreqSpectrum().size());
 }
 
 TEST_F(WaveformTest,CopyConstructor)
@@ -338,6 +360,241 @@ TEST_F(WaveformTest,CopyAssignOperator)
 	ADD_FAILURE() << "Not Yet Implemented!";
 }
 
+
+TEST(WaveformEditTest, WritesDoNotTransform)
+{
+	CountingWaveformType wfm (RealType(64));
+	CountingTransform::Reset();
+
+	{
+		auto e = wfm.Edit(CountingWaveformType::Domain::Freq);
+		EXPECT_EQ(1, CountingTransform::forward);		//	bringing the freq domain up to date
+
+		Span< std::complex<double> > spectrum = e.Freq();
+		ASSERT_EQ(33u, spectrum.size());
+
+		for (int pass = 0; pass < 3; ++pass)
+			for (std::size_t i = 0; i < spectrum.size(); ++i)
+				spectrum[i] *= 0.5;
+
+		EXPECT_EQ(CountingWaveformType::DomainState::Both, wfm.GetValidDomain());
+	}
+
+	EXPECT_EQ(CountingWaveformType::DomainState::Freq, wfm.GetValidDomain());
+	EXPECT_EQ(1, CountingTransform::forward);
+	EXPECT_EQ(0, CountingTransform::inverse);
+
+	wfm.GetConstTimeSeries();
+	EXPECT_EQ(1, CountingTransform::inverse);
+}
+
+
+TEST(WaveformEditTest, ValidDomainNeedsNoTransform)
+{
+	CountingWaveformType wfm (RealType(64));
+	CountingTransform::Reset();
+
+	{
+		auto e = wfm.Edit(CountingWaveformType::Domain::Time);
+		e.Time()[3] = 1.;
+	}
+
+	EXPECT_EQ(0, CountingTransform::forward + CountingTransform::inverse);
+	EXPECT_EQ(CountingWaveformType::DomainState::Time, wfm.GetValidDomain());
+	EXPECT_EQ(1., wfm.PeekTimeSeries()[3]);
+}
+
+
+TEST(WaveformEditTest, EagerPolicyTransformsOnCommit)
+{
+	CountingWaveformType wfm (ComplexType(33));
+	CountingTransform::Reset();
+
+	auto e = wfm.Edit(CountingWaveformType::Domain::Time, EditPolicy::Eager);
+	e.Time()[0] = 2.;
+	EXPECT_EQ(1, CountingTransform::inverse);
+
+	e.Commit();
+	EXPECT_EQ(1, CountingTransform::forward);
+	EXPECT_EQ(CountingWaveformType::DomainState::Both, wfm.GetValidDomain());
+
+	//	Committing again, or the end of the scope, changes nothing
+	e.Commit();
+	EXPECT_EQ(1, CountingTransform::forward);
+}
+
+
+TEST(WaveformEditTest, EitherIsRejected)
+{
+	CountingWaveformType wfm (RealType(64));
+
+	EXPECT_THROW(wfm.Edit(CountingWaveformType::Domain::Either), std::invalid_argument);
+}
+
+
+TEST(WaveformDomainStateTest, FillConstructorHoldsNeither)
+{
+	CountingWaveformType wfm (64);
+	CountingTransform::Reset();
+
+	EXPECT_EQ(CountingWaveformType::DomainState::Neither, wfm.GetValidDomain());
+
+	//	Nothing to compute from: reads and writes of either domain are free
+	wfm.GetConstFreqSpectrum();
+	wfm.GetConstTimeSeries();
+	EXPECT_EQ(CountingWaveformType::DomainState::Neither, wfm.GetValidDomain());
+
+	wfm.GetFreqSpectrum()[0] = 1.;
+	EXPECT_EQ(0, CountingTransform::forward + CountingTransform::inverse);
+	EXPECT_EQ(CountingWaveformType::DomainState::Freq, wfm.GetValidDomain());
+}
+
+
+TEST(WaveformDomainStateTest, ConstReadsOnlyFillTheRequestedDomain)
+{
+	CountingWaveformType wfm (RealType(64));
+	CountingTransform::Reset();
+
+	wfm.GetConstTimeSeries();
+	wfm.GetConstTimeSeries();
+	EXPECT_EQ(0, CountingTransform::forward + CountingTransform::inverse);
+	EXPECT_EQ(CountingWaveformType::DomainState::Time, wfm.GetValidDomain());
+
+	wfm.GetConstFreqSpectrum();
+	wfm.GetConstFreqSpectrum();
+	wfm.GetConstTimeSeries();
+	EXPECT_EQ(1, CountingTransform::forward);
+	EXPECT_EQ(0, CountingTransform::inverse);
+	EXPECT_EQ(CountingWaveformType::DomainState::Both, wfm.GetValidDomain());
+
+	//	Writing from Both needs no transform, and only then is the freq domain stale
+	wfm.GetTimeSeries()[0] = 1.;
+	EXPECT_EQ(1, CountingTransform::forward + CountingTransform::inverse);
+	EXPECT_EQ(CountingWaveformType::DomainState::Time, wfm.GetValidDomain());
+
+	EXPECT_EQ(64u, wfm.size());
+	EXPECT_EQ(1, CountingTransform::forward + CountingTransform::inverse);
+}
+
+
+TEST(WaveformDomainStateTest, AlternatingWritesTransformEachTime)
+{
+	CountingWaveformType wfm (RealType(64));
+	CountingTransform::Reset();
+
+	for (int i = 0; i < 5; ++i) {
+		wfm.GetTimeSeries()[0] = i;
+		wfm.GetFreqSpectrum()[0] *= 2.;
+	}
+
+	EXPECT_EQ(5, CountingTransform::forward);
+	EXPECT_EQ(4, CountingTransform::inverse);
+}
+
+
+TEST(WaveformDomainStateTest, EqualityTransformsAtMostOnce)
+{
+	const RealType samples (64, 1.);
+
+	CountingWaveformType timeOnly (samples);
+	CountingWaveformType both (samples);
+	both.GetConstFreqSpectrum();
+	CountingTransform::Reset();
+
+	//	A common valid domain: no transform
+	EXPECT_TRUE(timeOnly == both);
+	EXPECT_TRUE(both == timeOnly);
+	EXPECT_EQ(0, CountingTransform::forward + CountingTransform::inverse);
+
+	//	Opposite domains: rhs is transformed once, and then both are valid
+	CountingWaveformType freqOnly (ComplexType(33, 1.));
+	const CountingWaveformType& constRef = freqOnly;
+	EXPECT_FALSE(constRef == timeOnly);
+	EXPECT_EQ(1, CountingTransform::forward);
+	EXPECT_EQ(CountingWaveformType::DomainState::Both, timeOnly.GetValidDomain());
+
+	EXPECT_FALSE(constRef == timeOnly);
+	EXPECT_EQ(1, CountingTransform::forward + CountingTransform::inverse);
+
+	//	Different lengths are unequal without looking at either domain
+	CountingWaveformType shorter (ComplexType(17));
+	EXPECT_TRUE(shorter != freqOnly);
+	EXPECT_EQ(1, CountingTransform::forward + CountingTransform::inverse);
+}
+
+
+TEST(WaveformArithmeticTest, SumTakesEveryCommonDomain)
+{
+	CountingWaveformType a (RealType(8, 1.));
+	CountingWaveformType b (RealType(8, 2.));
+	a.OverwriteFreqSpectrum() = ComplexType(5, 3.);
+	b.OverwriteFreqSpectrum() = ComplexType(5, 4.);
+	a.AssumeValidDomain(CountingWaveformType::DomainState::Both);
+	b.AssumeValidDomain(CountingWaveformType::DomainState::Both);
+	CountingTransform::Reset();
+
+	a += b;
+	EXPECT_EQ(CountingWaveformType::DomainState::Both, a.GetValidDomain());
+	EXPECT_EQ(3., a.PeekTimeSeries()[7]);
+	EXPECT_EQ(std::complex<double>(7.), a.PeekFreqSpectrum()[4]);
+
+	a -= b;
+	a -= b;
+	EXPECT_EQ(-1., a.PeekTimeSeries()[0]);
+	EXPECT_EQ(std::complex<double>(-1.), a.PeekFreqSpectrum()[0]);
+
+	a *= -2.;
+	EXPECT_EQ(CountingWaveformType::DomainState::Both, a.GetValidDomain());
+	EXPECT_EQ(2., a.PeekTimeSeries()[3]);
+	EXPECT_EQ(std::complex<double>(2.), a.PeekFreqSpectrum()[3]);
+
+	EXPECT_EQ(0, CountingTransform::forward + CountingTransform::inverse);
+}
+
+
+TEST(WaveformArithmeticTest, SumAvoidsTransforms)
+{
+	CountingWaveformType both (RealType(8, 1.));
+	both.GetConstFreqSpectrum();
+	CountingWaveformType timeOnly (RealType(8, 1.));
+	CountingWaveformType freqOnly (ComplexType(5, 1.));
+	CountingTransform::Reset();
+
+	//	Only the time domain is common, and only it is kept
+	both += timeOnly;
+	EXPECT_EQ(CountingWaveformType::DomainState::Time, both.GetValidDomain());
+	EXPECT_EQ(0, CountingTransform::forward + CountingTransform::inverse);
+
+	//	No common domain: rhs is transformed once, and keeps both
+	timeOnly += freqOnly;
+	EXPECT_EQ(1, CountingTransform::inverse);
+	EXPECT_EQ(CountingWaveformType::DomainState::Both, freqOnly.GetValidDomain());
+	EXPECT_EQ(CountingWaveformType::DomainState::Time, timeOnly.GetValidDomain());
+
+	timeOnly += freqOnly;
+	EXPECT_EQ(1, CountingTransform::forward + CountingTransform::inverse);
+
+	EXPECT_THROW(timeOnly += CountingWaveformType(RealType(16)), std::length_error);
+}
+
+
+TEST(WaveformArithmeticTest, OtherTransformsUseTheTimeDomain)
+{
+	CountingOtherWaveformType a (ComplexType(5, 1.));
+	const CountingOtherWaveformType b (RealType(8, 2.));
+	CountingTransform::Reset();
+
+	a += b;
+	EXPECT_EQ(1, CountingTransform::inverse);
+	EXPECT_EQ(CountingOtherWaveformType::DomainState::Time, a.GetValidDomain());
+
+	a.GetConstFreqSpectrum();
+	a *= 0.5;
+	EXPECT_EQ(CountingOtherWaveformType::DomainState::Time, a.GetValidDomain());
+	EXPECT_EQ(1, CountingTransform::forward);
+}
+
+
 };	//	namespace
 
 int
@@ -0,0 +1,152 @@
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <FftwTransform.hpp>
+#include <Waveform.hpp>
+#include <WelchPsd.hpp>
+
+#include <gtest/gtest.h>
+
+
+namespace {
+
+typedef std::vector<double>					RealType;
+typedef std::vector< std::complex<double> >	ComplexType;
+
+typedef PS::Waveform<RealType, ComplexType, Waveform::Transform::Fftw3_Dft_1d_Normalized>	WaveformType;
+
+const double pi = std::acos(-1.);
+
+
+//!	A tone in deterministic pseudo-random noise
+RealType
+NoisyTone (std::size_t length)
+{
+	RealType record (length);
+	unsigned state = 12345;
+
+	for (std::size_t i = 0; i < length; ++i) {
+		state = state * 1664525u + 1013904223u;
+		const double noise = double(state >> 8) / double(1u << 24) - 0.5;
+		record[i] = std::sin(2. * pi * 0.1 * i) + 0.2 * noise;
+	}
+
+	return record;
+}
+
+
+//!	The same estimate made the slow way, one Waveform per segment
+RealType
+LoopOfWaveforms (const RealType& record, std::size_t length, std::size_t overlap, double sampleRate)
+{
+	const RealType window = PS::WelchPsd::Hann(length);
+	const std::size_t bins = length / 2 + 1;
+
+	double windowPower = 0.;
+	for (double w : window)
+		windowPower += w * w;
+
+	RealType psd (bins);
+	std::size_t segments = 0;
+
+	for (std::size_t first = 0; first + length <= record.size(); first += length - overlap, ++segments) {
+		RealType segment (length);
+		for (std::size_t i = 0; i < length; ++i)
+			segment[i] = record[first + i] * window[i];
+
+		WaveformType wfm (segment);
+		const ComplexType& spectrum = wfm.GetConstFreqSpectrum();
+
+		for (std::size_t k = 0; k < bins; ++k)
+			psd[k] += std::norm(spectrum[k]);
+	}
+
+	for (std::size_t k = 0; k < bins; ++k)
+		psd[k] *= (k == 0 || k == bins - 1 ? 1. : 2.) / (sampleRate * windowPower * segments);
+
+	return psd;
+}
+
+
+
+TEST(WelchPsdTest, MatchesLoopOfWaveforms)
+{
+	const RealType record = NoisyTone(5000);
+
+	//	38 segments: two full batches of 16 and one of 6
+	const PS::WelchPsd welch (256, 128, 100.);
+	EXPECT_EQ(38u, welch.Segments(record.size()));
+
+	RealType psd;
+	welch.Estimate(record, psd);
+
+	const RealType expected = LoopOfWaveforms(record, 256, 128, 100.);
+
+	ASSERT_EQ(129u, psd.size());
+	for (std::size_t k = 0; k < psd.size(); ++k)
+		EXPECT_NEAR(expected[k], psd[k], 1e-12 * (1. + expected[k]));
+
+	EXPECT_DOUBLE_EQ(100. / 256., welch.Frequency(1));
+}
+
+
+TEST(WelchPsdTest, IndependentOfThreadCount)
+{
+	const RealType record = NoisyTone(20000);
+
+	const PS::WelchPsd one (128, 96, PS::WelchPsd::Hann(128), 1., 1, 4);
+	const PS::WelchPsd many (128, 96, PS::WelchPsd::Hann(128), 1., 7, 4);
+
+	RealType a;
+	RealType b;
+	one.Estimate(record, a);
+	many.Estimate(record, b);
+
+	EXPECT_EQ(a, b);
+}
+
+
+TEST(WelchPsdTest, PowerOfTone)
+{
+	//	The integral of the density is the mean square: 1/2 for the tone, 0.2^2/12 for the noise
+	const RealType record = NoisyTone(1 << 14);
+	const PS::WelchPsd welch (512, 256, 2.);
+
+	RealType psd;
+	welch.Estimate(record, psd);
+
+	double power = 0.;
+	for (double p : psd)
+		power += p * welch.Frequency(1);
+
+	EXPECT_NEAR(0.5 + 0.04 / 12., power, 0.005);
+
+	//	The tone is at 0.1 cycles per sample, which is 0.2 Hz
+	std::size_t peak = 0;
+	for (std::size_t k = 1; k < psd.size(); ++k)
+		if (psd[k] > psd[peak])
+			peak = k;
+	EXPECT_NEAR(0.2, welch.Frequency(peak), welch.Frequency(1));
+}
+
+
+TEST(WelchPsdTest, BadParameters)
+{
+	EXPECT_THROW(PS::WelchPsd(256, 256), std::invalid_argument);
+	EXPECT_THROW(PS::WelchPsd(256, 0, RealType(255, 1.)), std::invalid_argument);
+
+	const PS::WelchPsd welch (256, 0);
+	RealType psd;
+	EXPECT_THROW(welch.Estimate(RealType(255), psd), std::length_error);
+}
+
+
+}	//	namespace
+
+int
+main (int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}